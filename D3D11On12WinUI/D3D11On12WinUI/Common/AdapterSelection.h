@@ -0,0 +1,139 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// The policy for choosing which adapter (GPU) to create the device on. The choice is made over
+// plain descriptions of the adapters, so that it can be exercised with made-up adapter lists;
+// D3D12Adapters.h builds the descriptions from DXGI.
+
+#include <cstddef>
+#include <cstdint>
+#include <cwchar>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "CommandLine.h"
+
+namespace DX
+{
+    enum class AdapterPreference
+    {
+        First, // The first adapter that can run the renderer, in DXGI's enumeration order.
+        HighPerformance, // The most capable adapter (on a hybrid laptop, the discrete GPU).
+        LowPower, // The adapter that uses the least power (on a hybrid laptop, the integrated GPU).
+        Luid, // The adapter with a given LUID, if it's present; otherwise, as HighPerformance.
+        Warp, // The WARP software rasterizer.
+    };
+
+    struct AdapterPolicy final
+    {
+        AdapterPreference preference{ AdapterPreference::HighPerformance };
+        uint64_t luid{ 0 }; // For AdapterPreference::Luid.
+
+        // Reads `--adapter first|high-performance|low-power|warp|<LUID, in hex>` from a command
+        // line; anything else is ignored.
+        static AdapterPolicy Parse(std::wstring_view commandLine)
+        {
+            AdapterPolicy policy;
+            std::vector<std::wstring_view> const tokens{ SplitCommandLine(commandLine) };
+            for (size_t tokenIndex{ 0 }; tokenIndex + 1 < tokens.size(); ++tokenIndex)
+            {
+                if (tokens[tokenIndex] != L"--adapter") continue;
+
+                std::wstring_view const value{ tokens[tokenIndex + 1] };
+                if (value == L"first") policy.preference = AdapterPreference::First;
+                else if (value == L"high-performance") policy.preference = AdapterPreference::HighPerformance;
+                else if (value == L"low-power") policy.preference = AdapterPreference::LowPower;
+                else if (value == L"warp") policy.preference = AdapterPreference::Warp;
+                else
+                {
+                    std::wstring const valueText{ value };
+                    wchar_t* pEnd{ nullptr };
+                    unsigned long long const luid{ std::wcstoull(valueText.c_str(), &pEnd, 16) };
+                    if (pEnd != valueText.c_str() && *pEnd == L'\0')
+                    {
+                        policy.preference = AdapterPreference::Luid;
+                        policy.luid = luid;
+                    }
+                }
+            }
+            return policy;
+        }
+    };
+
+    // What the policy knows about an adapter.
+    struct AdapterCandidate final
+    {
+        uint32_t enumerationIndex{ 0 }; // Its position in the order that DXGI listed the adapters in.
+        uint64_t luid{ 0 };
+        std::wstring description;
+        bool software{ false }; // WARP (or another software adapter).
+        uint64_t dedicatedVideoMemory{ 0 }; // In bytes. Integrated GPUs have little or none.
+        uint32_t maxFeatureLevel{ 0 }; // A D3D_FEATURE_LEVEL value (for example, 0xc100 for 12_1); 0 if a device couldn't be created.
+    };
+
+    class AdapterSelector final
+    {
+    public:
+        static constexpr uint32_t s_minFeatureLevel{ 0xb000 }; // D3D_FEATURE_LEVEL_11_0, which the renderer needs.
+
+        // Returns the index (into `candidates`) of the adapter to use, or nothing if none of them
+        // can run the renderer.
+        static std::optional<size_t> Select(std::vector<AdapterCandidate> const& candidates, AdapterPolicy const& policy)
+        {
+            AdapterPreference preference{ policy.preference };
+            if (preference == AdapterPreference::Luid)
+            {
+                for (size_t candidateIndex{ 0 }; candidateIndex < candidates.size(); ++candidateIndex)
+                {
+                    if (candidates[candidateIndex].luid == policy.luid && Eligible(candidates[candidateIndex])) return candidateIndex;
+                }
+                preference = AdapterPreference::HighPerformance;
+            }
+
+            std::optional<size_t> best;
+            for (size_t candidateIndex{ 0 }; candidateIndex < candidates.size(); ++candidateIndex)
+            {
+                if (!Eligible(candidates[candidateIndex])) continue;
+                if (!best || Score(candidates[candidateIndex], preference) > Score(candidates[*best], preference)) best = candidateIndex;
+            }
+            return best;
+        }
+
+    private:
+        static bool Eligible(AdapterCandidate const& candidate) { return candidate.maxFeatureLevel >= s_minFeatureLevel; }
+
+        // Higher is better, compared element by element. Software adapters come last (or, for
+        // Warp, first); then memory decides between hardware adapters, since dedicated video
+        // memory is what sets a discrete GPU apart from an integrated one; then feature level;
+        // and then DXGI's order.
+        static std::tuple<int, int64_t, uint32_t, int64_t> Score(AdapterCandidate const& candidate, AdapterPreference preference)
+        {
+            int const kind{ (preference == AdapterPreference::Warp) == candidate.software ? 1 : 0 };
+            int64_t const memory{ static_cast<int64_t>(candidate.dedicatedVideoMemory >> 20) }; // In MB.
+            int64_t const order{ -static_cast<int64_t>(candidate.enumerationIndex) };
+
+            switch (preference)
+            {
+            case AdapterPreference::HighPerformance:
+                return { kind, memory, candidate.maxFeatureLevel, order };
+            case AdapterPreference::LowPower:
+                return { kind, -memory, candidate.maxFeatureLevel, order };
+            default:
+                return { kind, 0, 0, order };
+            }
+        }
+    };
+}
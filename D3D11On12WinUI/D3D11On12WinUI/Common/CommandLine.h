@@ -0,0 +1,58 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cwchar>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace DX
+{
+    // Splits a command line into its arguments, at spaces and tabs. Quotes are dropped rather
+    // than honored, which is enough for the options that the settings structs read.
+    inline std::vector<std::wstring_view> SplitCommandLine(std::wstring_view commandLine)
+    {
+        std::vector<std::wstring_view> tokens;
+        while (!commandLine.empty())
+        {
+            size_t const start{ commandLine.find_first_not_of(L" \t\"") };
+            if (start == std::wstring_view::npos) break;
+            commandLine.remove_prefix(start);
+            size_t const end{ std::min(commandLine.find_first_of(L" \t\""), commandLine.size()) };
+            tokens.push_back(commandLine.substr(0, end));
+            commandLine.remove_prefix(end);
+        }
+        return tokens;
+    }
+
+    // The value of the last `name N` option on a command line, if there is one and N is a number.
+    inline std::optional<uint32_t> UnsignedOption(std::wstring_view commandLine, std::wstring_view name)
+    {
+        std::optional<uint32_t> option;
+        std::vector<std::wstring_view> const tokens{ SplitCommandLine(commandLine) };
+        for (size_t tokenIndex{ 0 }; tokenIndex + 1 < tokens.size(); ++tokenIndex)
+        {
+            if (tokens[tokenIndex] != name) continue;
+
+            std::wstring const valueText{ tokens[tokenIndex + 1] };
+            wchar_t* pEnd{ nullptr };
+            unsigned long const value{ std::wcstoul(valueText.c_str(), &pEnd, 10) };
+            if (pEnd != valueText.c_str()) option = static_cast<uint32_t>(value);
+        }
+        return option;
+    }
+}
@@ -0,0 +1,202 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "pch.h"
+
+namespace DX
+{
+    CopyUploadQueue::CopyUploadQueue(winrt::com_ptr<::ID3D12Device> const& pD3D12Device, UINT64 stagingCapacity) :
+        m_pD3D12Device{ pD3D12Device }
+    {
+        D3D12_COMMAND_QUEUE_DESC queueDesc{};
+        queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+        queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+
+        winrt::com_ptr<::ID3D12CommandQueue> pD3D12CommandQueue;
+        winrt::check_hresult(m_pD3D12Device->CreateCommandQueue(&queueDesc, __uuidof(pD3D12CommandQueue), pD3D12CommandQueue.put_void()));
+        pD3D12CommandQueue->SetName(L"CopyUploadQueue");
+        m_pRenderCommandQueue = std::make_unique<D3D12RenderCommandQueue>(pD3D12CommandQueue);
+
+        // The fence counts tickets; nothing has been submitted yet, so it starts at 0, and the first ticket is 1.
+        winrt::com_ptr<::ID3D12Fence> pD3D12Fence;
+        winrt::check_hresult(m_pD3D12Device->CreateFence(0, D3D12_FENCE_FLAG_NONE, __uuidof(pD3D12Fence), pD3D12Fence.put_void()));
+        m_pRenderFence = std::make_unique<D3D12RenderFence>(pD3D12Fence);
+
+        D3D12_HEAP_PROPERTIES heapPropertiesUpload{ CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD) };
+        D3D12_RESOURCE_DESC stagingBufferDesc{ CD3DX12_RESOURCE_DESC::Buffer(stagingCapacity) };
+        winrt::check_hresult(m_pD3D12Device->CreateCommittedResource(
+            &heapPropertiesUpload,
+            D3D12_HEAP_FLAG_NONE,
+            &stagingBufferDesc,
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            __uuidof(m_pD3D12StagingBuffer),
+            m_pD3D12StagingBuffer.put_void()));
+        m_pD3D12StagingBuffer->SetName(L"CopyUploadQueue staging");
+
+        // Keep the staging buffer mapped for its lifetime.
+        D3D12_RANGE readRange{ 0, 0 }; // We don't intend to read from this resource on the CPU.
+        winrt::check_hresult(m_pD3D12StagingBuffer->Map(0, &readRange, reinterpret_cast<void**>(&m_pMappedStagingBuffer)));
+        m_batcher.Reset(stagingCapacity, 1);
+    }
+
+    CopyUploadQueue::~CopyUploadQueue()
+    {
+        // The staging buffer and command allocators mustn't be released while the copy queue is
+        // still reading them. (If the device has been removed, the fence reads as complete.)
+        m_pRenderFence->WaitForValue(m_batcher.LastSubmittedTicket());
+    }
+
+    // Returns the staging offset of an upload that joins the open batch. If the staging ring is
+    // full, then what's been staged is submitted, and the CPU waits for the oldest batch.
+    uint64_t CopyUploadQueue::AllocateStaging(UINT64 sizeInBytes, UINT64 alignment)
+    {
+        std::optional<uint64_t> offset{ m_batcher.AllocateStaging(sizeInBytes, alignment) };
+        while (!offset)
+        {
+            Flush();
+            std::optional<uint64_t> oldestTicket{ m_batcher.OldestPendingTicket() };
+            if (!oldestTicket) winrt::throw_hresult(E_OUTOFMEMORY); // It wouldn't fit even in an empty ring.
+
+            m_batcher.StagingWaited();
+            m_pRenderFence->WaitForValue(*oldestTicket);
+            Reclaim();
+            offset = m_batcher.AllocateStaging(sizeInBytes, alignment);
+        }
+        return *offset;
+    }
+
+    uint64_t CopyUploadQueue::Flush()
+    {
+        if (!m_batcher.HasOpenBatch()) return m_batcher.LastSubmittedTicket();
+
+        D3D12RenderCommandList commandList{ m_pD3D12CommandList.get() };
+        commandList.Close();
+        m_pRenderCommandQueue->ExecuteCommandList(commandList);
+
+        uint64_t const ticket{ m_batcher.Submit(QpcNowNanoseconds()) };
+        m_pRenderCommandQueue->Signal(*m_pRenderFence, ticket);
+        m_pD3D12CommandAllocators.emplace_back(ticket, std::move(m_pD3D12OpenCommandAllocator));
+        return ticket;
+    }
+
+    // Returns the command list of the open batch, which is reset for recording if the batch has just opened.
+    ::ID3D12GraphicsCommandList* CopyUploadQueue::OpenBatch()
+    {
+        if (m_pD3D12OpenCommandAllocator) return m_pD3D12CommandList.get();
+
+        // Reuse the oldest batch's allocator if that batch has completed; otherwise, make another.
+        if (!m_pD3D12CommandAllocators.empty() && IsComplete(m_pD3D12CommandAllocators.front().first))
+        {
+            m_pD3D12OpenCommandAllocator = std::move(m_pD3D12CommandAllocators.front().second);
+            m_pD3D12CommandAllocators.pop_front();
+            winrt::check_hresult(m_pD3D12OpenCommandAllocator->Reset());
+        }
+        else
+        {
+            winrt::check_hresult(
+                m_pD3D12Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, __uuidof(m_pD3D12OpenCommandAllocator), m_pD3D12OpenCommandAllocator.put_void())
+            );
+        }
+
+        if (m_pD3D12CommandList)
+        {
+            winrt::check_hresult(m_pD3D12CommandList->Reset(m_pD3D12OpenCommandAllocator.get(), nullptr));
+        }
+        else
+        {
+            winrt::check_hresult(m_pD3D12Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, m_pD3D12OpenCommandAllocator.get(), nullptr, __uuidof(m_pD3D12CommandList), m_pD3D12CommandList.put_void()));
+            m_pD3D12CommandList->SetName(L"CopyUploadQueue");
+        }
+        return m_pD3D12CommandList.get();
+    }
+
+    void CopyUploadQueue::Reclaim()
+    {
+        m_batcher.Reclaim(m_pRenderFence->CompletedValue(), QpcNowNanoseconds());
+    }
+
+    uint64_t CopyUploadQueue::UploadBuffer(::ID3D12Resource* pDestination, UINT64 destinationOffset, void const* pData, UINT64 sizeInBytes)
+    {
+        // A buffer that's too big for the staging ring goes in pieces, which may end up in
+        // different batches. Batches complete in ticket order, so the last piece's ticket covers them all.
+        auto const* pBytes{ static_cast<uint8_t const*>(pData) };
+        for (UINT64 copiedBytes{ 0 }; copiedBytes < sizeInBytes;)
+        {
+            UINT64 const pieceSize{ std::min(sizeInBytes - copiedBytes, m_batcher.MaxStagingSize()) };
+            uint64_t const stagingOffset{ AllocateStaging(pieceSize, s_bufferStagingAlignment) };
+            StreamingCopy(m_pMappedStagingBuffer + stagingOffset, pBytes + copiedBytes, static_cast<size_t>(pieceSize));
+            OpenBatch()->CopyBufferRegion(pDestination, destinationOffset + copiedBytes, m_pD3D12StagingBuffer.get(), stagingOffset, pieceSize);
+            copiedBytes += pieceSize;
+        }
+        return m_batcher.LatestTicket();
+    }
+
+    uint64_t CopyUploadQueue::UploadTexture(::ID3D12Resource* pDestination, UINT firstSubresource, UINT numSubresources, D3D12_SUBRESOURCE_DATA const* pSubresourceData)
+    {
+        D3D12_RESOURCE_DESC const destinationDesc{ pDestination->GetDesc() };
+        for (UINT subresourceIndex{ 0 }; subresourceIndex < numSubresources; ++subresourceIndex)
+        {
+            UINT const subresource{ firstSubresource + subresourceIndex };
+            D3D12_SUBRESOURCE_DATA const& subresourceData{ pSubresourceData[subresourceIndex] };
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout{};
+            UINT numRows{ 0 };
+            UINT64 rowSizeInBytes{ 0 };
+            m_pD3D12Device->GetCopyableFootprints(&destinationDesc, subresource, 1, 0, &layout, &numRows, &rowSizeInBytes, nullptr);
+
+            // A 2D subresource that's too big for the staging ring goes in pieces of whole rows (of
+            // blocks, for a compressed format). A 3D one has to fit in one piece.
+            UINT const rowPitch{ layout.Footprint.RowPitch };
+            UINT const depth{ layout.Footprint.Depth };
+            UINT const rowHeight{ numRows ? layout.Footprint.Height / numRows : 1 };
+            UINT const rowsPerPiece{ depth == 1 ? static_cast<UINT>(std::clamp<UINT64>(m_batcher.MaxStagingSize() / rowPitch, 1, numRows)) : numRows };
+            for (UINT firstRow{ 0 }; firstRow < numRows; firstRow += rowsPerPiece)
+            {
+                UINT const pieceRows{ std::min(rowsPerPiece, numRows - firstRow) };
+                uint64_t const stagingOffset{ AllocateStaging(UINT64{ rowPitch } * pieceRows * depth, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT) };
+                for (UINT slice{ 0 }; slice < depth; ++slice)
+                {
+                    for (UINT row{ 0 }; row < pieceRows; ++row)
+                    {
+                        StreamingCopy(
+                            m_pMappedStagingBuffer + stagingOffset + (UINT64{ slice } * pieceRows + row) * rowPitch,
+                            static_cast<uint8_t const*>(subresourceData.pData) + slice * subresourceData.SlicePitch + (firstRow + row) * subresourceData.RowPitch,
+                            static_cast<size_t>(rowSizeInBytes));
+                    }
+                }
+
+                D3D12_TEXTURE_COPY_LOCATION source{};
+                source.pResource = m_pD3D12StagingBuffer.get();
+                source.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+                source.PlacedFootprint.Offset = stagingOffset;
+                source.PlacedFootprint.Footprint = layout.Footprint;
+                source.PlacedFootprint.Footprint.Height = pieceRows * rowHeight;
+                CD3DX12_TEXTURE_COPY_LOCATION const destination{ pDestination, subresource };
+                OpenBatch()->CopyTextureRegion(&destination, 0, firstRow * rowHeight, 0, &source, nullptr);
+            }
+        }
+        return m_batcher.LatestTicket();
+    }
+
+    // Waits (on the CPU) until everything that's been uploaded so far has arrived.
+    void CopyUploadQueue::WaitForIdle()
+    {
+        m_pRenderFence->WaitForValue(Flush());
+        Reclaim();
+    }
+
+    void CopyUploadQueue::WaitOnGpu(::ID3D12CommandQueue* pD3D12CommandQueue, uint64_t ticket)
+    {
+        if (IsComplete(ticket)) return;
+        if (ticket > m_batcher.LastSubmittedTicket()) Flush();
+        winrt::check_hresult(pD3D12CommandQueue->Wait(m_pRenderFence->ID3D12Fence(), ticket));
+    }
+}
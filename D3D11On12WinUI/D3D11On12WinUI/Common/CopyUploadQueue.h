@@ -0,0 +1,74 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+namespace DX
+{
+    // Uploads buffers and textures on a Direct3D 12 copy queue, so that the direct queue goes on
+    // rendering while assets arrive. Uploads are batched (see UploadBatcher) into one command
+    // list per Flush, and each returns a ticket; before the direct queue first uses a resource,
+    // call WaitOnGpu with its ticket.
+    //
+    // A destination must be in D3D12_RESOURCE_STATE_COMMON (create it in that state). On the
+    // copy queue it's promoted to COPY_DEST, and it decays back to COMMON when the batch
+    // completes; on the direct queue, buffers (and textures, for shader-resource reads) are then
+    // promoted implicitly on first use, so neither queue needs a barrier.
+    class CopyUploadQueue final
+    {
+        static constexpr UINT64 s_bufferStagingAlignment{ 16 }; // For StreamingCopy.
+
+        // data members
+
+        UploadBatcher m_batcher;
+        std::deque<std::pair<uint64_t, winrt::com_ptr<::ID3D12CommandAllocator>>> m_pD3D12CommandAllocators; // (ticket, allocator) of each batch in flight, in ticket order.
+        winrt::com_ptr<::ID3D12Device> m_pD3D12Device{ nullptr };
+        winrt::com_ptr<::ID3D12CommandAllocator> m_pD3D12OpenCommandAllocator{ nullptr }; // Recording into, while a batch is open.
+        winrt::com_ptr<::ID3D12GraphicsCommandList> m_pD3D12CommandList{ nullptr };
+        winrt::com_ptr<::ID3D12Resource> m_pD3D12StagingBuffer{ nullptr };
+        uint8_t* m_pMappedStagingBuffer{ nullptr };
+        std::unique_ptr<D3D12RenderCommandQueue> m_pRenderCommandQueue{ nullptr };
+        std::unique_ptr<D3D12RenderFence> m_pRenderFence{ nullptr };
+
+        // member functions
+
+        uint64_t AllocateStaging(UINT64 sizeInBytes, UINT64 alignment);
+        ::ID3D12GraphicsCommandList* OpenBatch();
+
+    public:
+        CopyUploadQueue(winrt::com_ptr<::ID3D12Device> const& pD3D12Device, UINT64 stagingCapacity);
+        ~CopyUploadQueue();
+
+        // member functions
+
+        // Submits the open batch, if there is one. Returns the ticket of the last batch submitted.
+        uint64_t Flush();
+
+        bool IsComplete(uint64_t ticket) const { return m_pRenderFence->CompletedValue() >= ticket; }
+
+        // Makes the staging memory of completed batches available again. Call this once a frame.
+        void Reclaim();
+
+        // Returns the ticket of the batch that the copy joins. `pData` can be freed on return.
+        uint64_t UploadBuffer(::ID3D12Resource* pDestination, UINT64 destinationOffset, void const* pData, UINT64 sizeInBytes);
+        uint64_t UploadTexture(::ID3D12Resource* pDestination, UINT firstSubresource, UINT numSubresources, D3D12_SUBRESOURCE_DATA const* pSubresourceData);
+
+        void WaitForIdle();
+
+        // Makes work that's subsequently submitted to `pD3D12CommandQueue` wait, GPU-side, for
+        // `ticket`. If the ticket's batch is still open, it's flushed first.
+        void WaitOnGpu(::ID3D12CommandQueue* pD3D12CommandQueue, uint64_t ticket);
+
+        // accessors
+
+        UploadBatcherStatistics const& Statistics() const { return m_batcher.Statistics(); }
+    };
+}
@@ -0,0 +1,152 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "pch.h"
+
+namespace DX
+{
+    namespace
+    {
+        uint64_t LuidToUInt64(LUID const& luid)
+        {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(luid.HighPart)) << 32) | luid.LowPart;
+        }
+    }
+
+    DeviceCapabilities DeviceCapabilities::Query(::ID3D12Device* pD3D12Device)
+    {
+        DeviceCapabilities capabilities;
+        capabilities.adapterLuid = LuidToUInt64(pD3D12Device->GetAdapterLuid());
+
+        D3D_FEATURE_LEVEL featureLevelsRequested[]{
+            D3D_FEATURE_LEVEL_12_1,
+            D3D_FEATURE_LEVEL_12_0,
+            D3D_FEATURE_LEVEL_11_1,
+            D3D_FEATURE_LEVEL_11_0
+        };
+        D3D12_FEATURE_DATA_FEATURE_LEVELS d3d12FeatureLevels{ sizeof(featureLevelsRequested) / sizeof(D3D_FEATURE_LEVEL), featureLevelsRequested, D3D_FEATURE_LEVEL_9_1 };
+        winrt::check_hresult(pD3D12Device->CheckFeatureSupport(D3D12_FEATURE_FEATURE_LEVELS, &d3d12FeatureLevels, sizeof(d3d12FeatureLevels)));
+        capabilities.maxFeatureLevel = d3d12FeatureLevels.MaxSupportedFeatureLevel;
+
+        // For the shader model and root signature version, the device reports the highest that it
+        // supports up to the one asked about; a runtime too old to know the one asked about fails.
+        D3D12_FEATURE_DATA_SHADER_MODEL shaderModel{ D3D_SHADER_MODEL_6_5 };
+        while (FAILED(pD3D12Device->CheckFeatureSupport(D3D12_FEATURE_SHADER_MODEL, &shaderModel, sizeof(shaderModel))) && shaderModel.HighestShaderModel > D3D_SHADER_MODEL_5_1)
+        {
+            shaderModel.HighestShaderModel = static_cast<D3D_SHADER_MODEL>(shaderModel.HighestShaderModel - 1);
+        }
+        capabilities.highestShaderModel = shaderModel.HighestShaderModel;
+
+        D3D12_FEATURE_DATA_ROOT_SIGNATURE rootSignature{ D3D_ROOT_SIGNATURE_VERSION_1_1 };
+        if (SUCCEEDED(pD3D12Device->CheckFeatureSupport(D3D12_FEATURE_ROOT_SIGNATURE, &rootSignature, sizeof(rootSignature))))
+        {
+            capabilities.highestRootSignatureVersion = rootSignature.HighestVersion;
+        }
+
+        D3D12_FEATURE_DATA_D3D12_OPTIONS options{};
+        winrt::check_hresult(pD3D12Device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options)));
+        capabilities.resourceBindingTier = options.ResourceBindingTier;
+        capabilities.resourceHeapTier = options.ResourceHeapTier;
+        capabilities.typedUavLoadAdditionalFormats = options.TypedUAVLoadAdditionalFormats;
+
+        D3D12_FEATURE_DATA_ARCHITECTURE architecture{};
+        winrt::check_hresult(pD3D12Device->CheckFeatureSupport(D3D12_FEATURE_ARCHITECTURE, &architecture, sizeof(architecture)));
+        capabilities.uma = architecture.UMA;
+        capabilities.cacheCoherentUma = architecture.CacheCoherentUMA;
+
+        D3D12_FEATURE_DATA_D3D12_OPTIONS3 options3{};
+        if (SUCCEEDED(pD3D12Device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS3, &options3, sizeof(options3))))
+        {
+            capabilities.copyQueueTimestampQueries = options3.CopyQueueTimestampQueriesSupported;
+        }
+
+        return capabilities;
+    }
+
+    DeviceCapabilities const& DeviceCapabilitiesCache::Capabilities(::IDXGIAdapter1* pDXGIAdapter1)
+    {
+        DXGI_ADAPTER_DESC1 adapterDesc{};
+        winrt::check_hresult(pDXGIAdapter1->GetDesc1(&adapterDesc));
+        uint64_t const luid{ LuidToUInt64(adapterDesc.AdapterLuid) };
+
+        // The user-mode driver version changes when the driver is updated (which is one cause of device loss).
+        LARGE_INTEGER umdVersion{};
+        uint64_t const driverVersion{ SUCCEEDED(pDXGIAdapter1->CheckInterfaceSupport(__uuidof(::IDXGIDevice), &umdVersion)) ? static_cast<uint64_t>(umdVersion.QuadPart) : 0 };
+
+        for (auto const& entry : m_entries)
+        {
+            if (entry.adapterLuid == luid && entry.driverVersion == driverVersion) return entry;
+        }
+
+        DeviceCapabilities capabilities;
+        winrt::com_ptr<::ID3D12Device> pD3D12Device;
+        if (SUCCEEDED(::D3D12CreateDevice(pDXGIAdapter1, D3D_FEATURE_LEVEL_11_0, __uuidof(pD3D12Device), pD3D12Device.put_void())))
+        {
+            capabilities = DeviceCapabilities::Query(pD3D12Device.get());
+        }
+        capabilities.adapterLuid = luid;
+        capabilities.driverVersion = driverVersion;
+        m_entries.push_back(capabilities);
+        return m_entries.back();
+    }
+
+    D3D12AdapterList::D3D12AdapterList(::IDXGIFactory4* pDXGIFactory4, AdapterPreference preference, DeviceCapabilitiesCache& capabilitiesCache)
+    {
+        // Where DXGI can order the adapters by GPU preference, that order honors the user's
+        // per-app graphics settings, so it's the enumeration order that the policy falls back on.
+        winrt::com_ptr<::IDXGIFactory6> pDXGIFactory6;
+        pDXGIFactory6.try_copy_from(pDXGIFactory4);
+        DXGI_GPU_PREFERENCE const gpuPreference{ preference == AdapterPreference::LowPower ? DXGI_GPU_PREFERENCE_MINIMUM_POWER : DXGI_GPU_PREFERENCE_HIGH_PERFORMANCE };
+
+        for (UINT adapterIndex{ 0 }; ; ++adapterIndex)
+        {
+            winrt::com_ptr<::IDXGIAdapter1> pDXGIAdapter1;
+            HRESULT const hr{ pDXGIFactory6 && preference != AdapterPreference::First ?
+                pDXGIFactory6->EnumAdapterByGpuPreference(adapterIndex, gpuPreference, __uuidof(pDXGIAdapter1), pDXGIAdapter1.put_void()) :
+                pDXGIFactory4->EnumAdapters1(adapterIndex, pDXGIAdapter1.put()) };
+            if (hr == DXGI_ERROR_NOT_FOUND) break;
+            winrt::check_hresult(hr);
+
+            // The Basic Render Driver is listed too; WARP is added, once, below.
+            DXGI_ADAPTER_DESC1 adapterDesc{};
+            winrt::check_hresult(pDXGIAdapter1->GetDesc1(&adapterDesc));
+            if (adapterDesc.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) continue;
+
+            Add(pDXGIAdapter1, capabilitiesCache);
+        }
+
+        winrt::com_ptr<::IDXGIAdapter1> pWarpAdapter;
+        if (SUCCEEDED(pDXGIFactory4->EnumWarpAdapter(__uuidof(pWarpAdapter), pWarpAdapter.put_void())))
+        {
+            Add(pWarpAdapter, capabilitiesCache);
+            m_candidates.back().software = true;
+        }
+    }
+
+    void D3D12AdapterList::Add(winrt::com_ptr<::IDXGIAdapter1> const& pDXGIAdapter1, DeviceCapabilitiesCache& capabilitiesCache)
+    {
+        DXGI_ADAPTER_DESC1 adapterDesc{};
+        winrt::check_hresult(pDXGIAdapter1->GetDesc1(&adapterDesc));
+        DeviceCapabilities const& capabilities{ capabilitiesCache.Capabilities(pDXGIAdapter1.get()) };
+
+        AdapterCandidate candidate;
+        candidate.enumerationIndex = static_cast<uint32_t>(m_candidates.size());
+        candidate.luid = LuidToUInt64(adapterDesc.AdapterLuid);
+        candidate.description = adapterDesc.Description;
+        candidate.software = (adapterDesc.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) != 0;
+        candidate.dedicatedVideoMemory = adapterDesc.DedicatedVideoMemory;
+        candidate.maxFeatureLevel = static_cast<uint32_t>(capabilities.maxFeatureLevel);
+
+        m_candidates.push_back(std::move(candidate));
+        m_capabilities.push_back(capabilities);
+        m_pDXGIAdapter1s.push_back(pDXGIAdapter1);
+    }
+}
@@ -0,0 +1,74 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+namespace DX
+{
+    // A snapshot of what a Direct3D 12 device supports (the results of CheckFeatureSupport),
+    // taken once per adapter and driver, so that the rest of the code can consult it rather than
+    // query the device again.
+    struct DeviceCapabilities final
+    {
+        uint64_t adapterLuid{ 0 };
+        uint64_t driverVersion{ 0 };
+
+        D3D_FEATURE_LEVEL maxFeatureLevel{ static_cast<D3D_FEATURE_LEVEL>(0) }; // 0 if no device could be created on the adapter.
+        D3D_SHADER_MODEL highestShaderModel{ D3D_SHADER_MODEL_5_1 };
+        D3D_ROOT_SIGNATURE_VERSION highestRootSignatureVersion{ D3D_ROOT_SIGNATURE_VERSION_1_0 };
+        D3D12_RESOURCE_BINDING_TIER resourceBindingTier{ D3D12_RESOURCE_BINDING_TIER_1 };
+        D3D12_RESOURCE_HEAP_TIER resourceHeapTier{ D3D12_RESOURCE_HEAP_TIER_1 };
+        bool typedUavLoadAdditionalFormats{ false };
+        bool uma{ false }; // The GPU shares memory with the CPU (typically, an integrated GPU).
+        bool cacheCoherentUma{ false };
+        bool copyQueueTimestampQueries{ false };
+
+        static DeviceCapabilities Query(::ID3D12Device* pD3D12Device);
+    };
+
+    // Remembers DeviceCapabilities by adapter LUID and driver version. Finding the capabilities
+    // of an adapter takes a device, so a device-lost rebuild (which usually finds the same
+    // adapters) uses what's remembered, and only a new adapter or driver is queried.
+    class DeviceCapabilitiesCache final
+    {
+        // data members
+
+        std::vector<DeviceCapabilities> m_entries;
+
+    public:
+        // member functions
+
+        DeviceCapabilities const& Capabilities(::IDXGIAdapter1* pDXGIAdapter1);
+    };
+
+    // The adapters that the device could be created on: the hardware adapters (in DXGI's order
+    // of preference for `preference`, where DXGI supports that) and then WARP, described for
+    // AdapterSelector.
+    class D3D12AdapterList final
+    {
+        // data members
+
+        std::vector<AdapterCandidate> m_candidates;
+        std::vector<DeviceCapabilities> m_capabilities;
+        std::vector<winrt::com_ptr<::IDXGIAdapter1>> m_pDXGIAdapter1s;
+
+        void Add(winrt::com_ptr<::IDXGIAdapter1> const& pDXGIAdapter1, DeviceCapabilitiesCache& capabilitiesCache);
+
+    public:
+        D3D12AdapterList(::IDXGIFactory4* pDXGIFactory4, AdapterPreference preference, DeviceCapabilitiesCache& capabilitiesCache);
+
+        // accessors
+
+        ::IDXGIAdapter1* Adapter(size_t index) const { return m_pDXGIAdapter1s[index].get(); }
+        std::vector<AdapterCandidate> const& Candidates() const { return m_candidates; }
+        DeviceCapabilities const& Capabilities(size_t index) const { return m_capabilities[index]; }
+    };
+}
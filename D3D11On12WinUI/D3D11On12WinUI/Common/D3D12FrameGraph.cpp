@@ -0,0 +1,188 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "pch.h"
+
+namespace DX
+{
+    // Field by field, as the structures have padding.
+    static bool operator==(D3D12TransientDesc const& a, D3D12TransientDesc const& b)
+    {
+        D3D12_RESOURCE_DESC const& ra{ a.resourceDesc };
+        D3D12_RESOURCE_DESC const& rb{ b.resourceDesc };
+        bool const sameResource{ ra.Dimension == rb.Dimension && ra.Alignment == rb.Alignment && ra.Width == rb.Width && ra.Height == rb.Height &&
+            ra.DepthOrArraySize == rb.DepthOrArraySize && ra.MipLevels == rb.MipLevels && ra.Format == rb.Format &&
+            ra.SampleDesc.Count == rb.SampleDesc.Count && ra.SampleDesc.Quality == rb.SampleDesc.Quality && ra.Layout == rb.Layout && ra.Flags == rb.Flags };
+        if (!sameResource || a.hasClearValue != b.hasClearValue) return false;
+        return !a.hasClearValue || (a.clearValue.Format == b.clearValue.Format && std::memcmp(a.clearValue.Color, b.clearValue.Color, sizeof(a.clearValue.Color)) == 0);
+    }
+
+    D3D12TransientDesc D3D12TransientDesc::DepthStencil(DXGI_FORMAT format, UINT width, UINT height)
+    {
+        D3D12TransientDesc desc;
+        desc.resourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(format, width, height, 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
+        desc.clearValue = CD3DX12_CLEAR_VALUE{ format, 1.f, 0 };
+        desc.hasClearValue = true;
+        return desc;
+    }
+
+    D3D12TransientDesc D3D12TransientDesc::RenderTarget(DXGI_FORMAT format, UINT width, UINT height, float const (&clearColor)[4])
+    {
+        D3D12TransientDesc desc;
+        desc.resourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(format, width, height, 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+        desc.clearValue = CD3DX12_CLEAR_VALUE{ format, clearColor };
+        desc.hasClearValue = true;
+        return desc;
+    }
+
+    D3D12TransientResources::D3D12TransientResources(DeviceResources& deviceResources) :
+        m_deviceResources{ deviceResources }
+    {
+        winrt::com_ptr<::ID3D12Device> const pD3D12Device{ m_deviceResources.ID3D12Device() };
+        D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc{ D3D12_DESCRIPTOR_HEAP_TYPE_RTV, s_viewCapacity, D3D12_DESCRIPTOR_HEAP_FLAG_NONE, 0 };
+        winrt::check_hresult(pD3D12Device->CreateDescriptorHeap(&descriptorHeapDesc, __uuidof(m_pD3D12RtvHeap), m_pD3D12RtvHeap.put_void()));
+        descriptorHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
+        winrt::check_hresult(pD3D12Device->CreateDescriptorHeap(&descriptorHeapDesc, __uuidof(m_pD3D12DsvHeap), m_pD3D12DsvHeap.put_void()));
+        m_rtvDescriptorSize = pD3D12Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+        m_dsvDescriptorSize = pD3D12Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+
+        // Handed out from the back, so the first view is the heap's first descriptor.
+        for (UINT view{ s_viewCapacity }; view-- > 0;)
+        {
+            m_freeRtvs.push_back(CD3DX12_CPU_DESCRIPTOR_HANDLE(m_pD3D12RtvHeap->GetCPUDescriptorHandleForHeapStart(), view, m_rtvDescriptorSize));
+            m_freeDsvs.push_back(CD3DX12_CPU_DESCRIPTOR_HANDLE(m_pD3D12DsvHeap->GetCPUDescriptorHandleForHeapStart(), view, m_dsvDescriptorSize));
+        }
+    }
+
+    // The device is asked once for each description; a graph asks every frame.
+    D3D12_RESOURCE_ALLOCATION_INFO D3D12TransientResources::AllocationInfo(D3D12TransientDesc const& desc) const
+    {
+        for (auto const& [knownDesc, allocationInfo] : m_allocationInfos)
+        {
+            if (knownDesc == desc) return allocationInfo;
+        }
+        D3D12_RESOURCE_ALLOCATION_INFO const allocationInfo{ m_deviceResources.ID3D12Device()->GetResourceAllocationInfo(0, 1, &desc.resourceDesc) };
+        if (allocationInfo.SizeInBytes == UINT64_MAX) winrt::throw_hresult(E_INVALIDARG);
+        m_allocationInfos.emplace_back(desc, allocationInfo);
+        return allocationInfo;
+    }
+
+    // A transient that was just created may be placed where one that it replaced was (the depth
+    // buffer, when the window is resized), which the frames before this one used.
+    void D3D12TransientResources::BeginPass(D3D12FrameGraph::PassContext const& context, D3D12CommandListStates& states)
+    {
+        auto activate = [&](::ID3D12Resource* pResource)
+            {
+                states.Aliasing(pResource);
+                if (Transient* pTransient{ Find(pResource) }) pTransient->isNew = false;
+            };
+        context.ForEachActivation(activate);
+        context.ForEachTransition([&](::ID3D12Resource* pResource, ResourceStates state)
+            {
+                Transient const* pTransient{ Find(pResource) };
+                if (pTransient && pTransient->isNew) activate(pResource);
+                states.Transition(pResource, static_cast<D3D12_RESOURCE_STATES>(state));
+            });
+    }
+
+    void D3D12TransientResources::EndPass(D3D12FrameGraph::PassContext const& context, D3D12CommandListStates& states)
+    {
+        context.ForEachBeginTransition([&](::ID3D12Resource* pResource, ResourceStates state) { states.BeginTransition(pResource, static_cast<D3D12_RESOURCE_STATES>(state)); });
+    }
+
+    D3D12TransientResources::Transient* D3D12TransientResources::Find(::ID3D12Resource* pResource)
+    {
+        for (Transient& transient : m_transients)
+        {
+            if (transient.pResource.get() == pResource) return &transient;
+        }
+        return nullptr;
+    }
+
+    ::ID3D12Resource* D3D12TransientResources::Place(D3D12TransientDesc const& desc, uint64_t heapOffset)
+    {
+        for (Transient& transient : m_transients)
+        {
+            if (transient.isUsed || transient.heapOffset != heapOffset || !(transient.desc == desc)) continue;
+            transient.isUsed = true;
+            return transient.pResource.get();
+        }
+
+        bool const isDepthStencil{ (desc.resourceDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL) != 0 };
+        if ((desc.resourceDesc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL | D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET)) == 0) winrt::throw_hresult(E_INVALIDARG);
+        std::vector<D3D12_CPU_DESCRIPTOR_HANDLE>& freeViews{ isDepthStencil ? m_freeDsvs : m_freeRtvs };
+        if (freeViews.empty()) winrt::throw_hresult(E_OUTOFMEMORY);
+
+        // Created in COMMON; the first pass to use it declares the state it needs, and the tracker resolves that.
+        Transient transient;
+        transient.desc = desc;
+        transient.heapOffset = heapOffset;
+        winrt::com_ptr<::ID3D12Device> const pD3D12Device{ m_deviceResources.ID3D12Device() };
+        winrt::check_hresult(pD3D12Device->CreatePlacedResource(
+            m_range.pD3D12Heap,
+            m_range.allocation.range.offset + heapOffset,
+            &desc.resourceDesc,
+            D3D12_RESOURCE_STATE_COMMON,
+            desc.hasClearValue ? &desc.clearValue : nullptr,
+            __uuidof(transient.pResource),
+            transient.pResource.put_void()));
+        transient.pResource->SetName(L"Frame graph transient");
+        m_deviceResources.ResourceStates().Register(transient.pResource.get(), D3D12_RESOURCE_STATE_COMMON);
+
+        transient.view = freeViews.back();
+        freeViews.pop_back();
+        if (isDepthStencil) pD3D12Device->CreateDepthStencilView(transient.pResource.get(), nullptr, transient.view);
+        else pD3D12Device->CreateRenderTargetView(transient.pResource.get(), nullptr, transient.view);
+
+        transient.isNew = transient.isUsed = true;
+        m_transients.push_back(std::move(transient));
+        return m_transients.back().pResource.get();
+    }
+
+    void D3D12TransientResources::Realize(D3D12FrameGraph& frameGraph)
+    {
+        // A graph that needs more memory than the range has gets a new range; what was placed in the old one goes with it.
+        if (frameGraph.HeapSize() > m_rangeSize)
+        {
+            for (Transient& transient : m_transients) Release(transient);
+            m_transients.clear();
+            if (m_rangeSize > 0) m_deviceResources.FreePlacedRange(m_range);
+            m_range = m_deviceResources.AllocatePlacedRange(D3D12_HEAP_TYPE_DEFAULT, PlacedResourceClass::RenderTargetOrDepthStencil, frameGraph.HeapSize());
+            m_rangeSize = frameGraph.HeapSize();
+        }
+
+        for (Transient& transient : m_transients) transient.isUsed = false;
+        frameGraph.Realize([this](D3D12TransientDesc const& desc, uint64_t heapOffset) { return Place(desc, heapOffset); });
+
+        auto const unused{ std::partition(m_transients.begin(), m_transients.end(), [](Transient const& transient) { return transient.isUsed; }) };
+        for (auto it{ unused }; it != m_transients.end(); ++it) Release(*it);
+        m_transients.erase(unused, m_transients.end());
+    }
+
+    // Views are read when a command list is recorded, so a view's descriptor can be reused at once;
+    // the resource is released once the frames in flight are done with it.
+    void D3D12TransientResources::Release(Transient& transient)
+    {
+        bool const isDepthStencil{ (transient.desc.resourceDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL) != 0 };
+        (isDepthStencil ? m_freeDsvs : m_freeRtvs).push_back(transient.view);
+        m_deviceResources.ResourceStates().Unregister(transient.pResource.get());
+        m_deviceResources.DeferRelease(transient.pResource);
+    }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE D3D12TransientResources::View(::ID3D12Resource* pResource) const
+    {
+        for (Transient const& transient : m_transients)
+        {
+            if (transient.pResource.get() == pResource) return transient.view;
+        }
+        winrt::throw_hresult(E_INVALIDARG);
+    }
+}
@@ -0,0 +1,102 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+namespace DX
+{
+    class DeviceResources;
+
+    // What D3D12TransientResources creates a frame graph's transient from.
+    struct D3D12TransientDesc final
+    {
+        D3D12_RESOURCE_DESC resourceDesc{};
+        D3D12_CLEAR_VALUE clearValue{};
+        bool hasClearValue{ false };
+
+        static D3D12TransientDesc DepthStencil(DXGI_FORMAT format, UINT width, UINT height);
+        static D3D12TransientDesc RenderTarget(DXGI_FORMAT format, UINT width, UINT height, float const (&clearColor)[4]);
+    };
+
+    using D3D12FrameGraph = FrameGraph<::ID3D12Resource*, D3D12TransientDesc>;
+
+    // Realizes a D3D12FrameGraph's transients (render targets and depth stencils) as resources
+    // placed in one range of the device's shared heaps (see PlacedResourceAllocator), at the
+    // offsets that the graph gave them; so transients that the graph aliases share memory. A
+    // transient that's placed as it was last frame is the same resource, so resources (and
+    // their views) are created only when the graph changes (when the window is resized, say).
+    class D3D12TransientResources final
+    {
+        static constexpr UINT s_viewCapacity{ 16 }; // Each of render target and depth stencil views.
+
+        struct Transient final
+        {
+            D3D12TransientDesc desc;
+            uint64_t heapOffset{ 0 };
+            winrt::com_ptr<::ID3D12Resource> pResource{ nullptr };
+            D3D12_CPU_DESCRIPTOR_HANDLE view{};
+            bool isNew{ false }; // Not yet used; its memory may have been another resource's.
+            bool isUsed{ false }; // By the graph that's being realized.
+        };
+
+        // data members
+
+        mutable std::vector<std::pair<D3D12TransientDesc, D3D12_RESOURCE_ALLOCATION_INFO>> m_allocationInfos;
+        DeviceResources& m_deviceResources;
+        UINT m_dsvDescriptorSize{ 0 };
+        std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_freeDsvs;
+        std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_freeRtvs;
+        winrt::com_ptr<::ID3D12DescriptorHeap> m_pD3D12DsvHeap{ nullptr };
+        winrt::com_ptr<::ID3D12DescriptorHeap> m_pD3D12RtvHeap{ nullptr };
+        PlacedHeapRange m_range;
+        UINT64 m_rangeSize{ 0 };
+        UINT m_rtvDescriptorSize{ 0 };
+        std::vector<Transient> m_transients;
+
+        // member functions
+
+        Transient* Find(::ID3D12Resource* pResource);
+        ::ID3D12Resource* Place(D3D12TransientDesc const& desc, uint64_t heapOffset);
+        void Release(Transient& transient);
+
+    public:
+        explicit D3D12TransientResources(DeviceResources& deviceResources);
+
+        // member functions
+
+        // The size and alignment to give FrameGraph::Builder::Create.
+        D3D12_RESOURCE_ALLOCATION_INFO AllocationInfo(D3D12TransientDesc const& desc) const;
+
+        // Records what a pass needs into `states`: aliasing barriers to the transients that take
+        // over memory at this pass (those the graph aliases, and those just created), and the
+        // states of everything it uses. FlushBarriers (after declaring anything else) before
+        // recording the pass's work; and clear (or discard) those transients, as what they
+        // hold is undefined.
+        void BeginPass(D3D12FrameGraph::PassContext const& context, D3D12CommandListStates& states);
+
+        // Begins the split barriers that the graph starts after the pass. Call once the pass's work is recorded.
+        static void EndPass(D3D12FrameGraph::PassContext const& context, D3D12CommandListStates& states);
+
+        // Call between compiling and executing `frameGraph`. Transients that aren't placed as they
+        // were last frame are released (once the frames in flight are done with them).
+        void Realize(D3D12FrameGraph& frameGraph);
+
+        // accessors
+
+        UINT64 HeapSize() const { return m_rangeSize; }
+
+        // The render target or depth stencil view of a transient of the graph last realized.
+        D3D12_CPU_DESCRIPTOR_HANDLE View(::ID3D12Resource* pResource) const;
+    };
+}
@@ -0,0 +1,274 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "pch.h"
+
+namespace DX
+{
+    namespace
+    {
+        // What DrawTextLayout passes through IDWriteTextLayout::Draw, as the client drawing context.
+        struct GlyphDrawingContext final
+        {
+            D3D12GlyphRenderer* pRenderer{ nullptr };
+            uint32_t color{ 0 };
+            float pixelsPerDip{ 1.f };
+        };
+
+        // Hands each glyph run that a layout draws to the D3D12GlyphRenderer in the drawing
+        // context. Underlines, strikethroughs and inline objects aren't drawn.
+        struct GlyphRunSink : winrt::implements<GlyphRunSink, ::IDWriteTextRenderer>
+        {
+            HRESULT __stdcall IsPixelSnappingDisabled(void*, BOOL* pIsDisabled) noexcept override
+            {
+                *pIsDisabled = FALSE;
+                return S_OK;
+            }
+
+            HRESULT __stdcall GetCurrentTransform(void*, DWRITE_MATRIX* pTransform) noexcept override
+            {
+                *pTransform = DWRITE_MATRIX{ 1.f, 0.f, 0.f, 1.f, 0.f, 0.f };
+                return S_OK;
+            }
+
+            HRESULT __stdcall GetPixelsPerDip(void* pClientDrawingContext, FLOAT* pPixelsPerDip) noexcept override
+            {
+                *pPixelsPerDip = static_cast<GlyphDrawingContext*>(pClientDrawingContext)->pixelsPerDip;
+                return S_OK;
+            }
+
+            HRESULT __stdcall DrawGlyphRun(void* pClientDrawingContext, FLOAT baselineOriginX, FLOAT baselineOriginY, DWRITE_MEASURING_MODE measuringMode,
+                DWRITE_GLYPH_RUN const* pGlyphRun, DWRITE_GLYPH_RUN_DESCRIPTION const*, ::IUnknown*) noexcept override
+            {
+                try
+                {
+                    auto const* pContext{ static_cast<GlyphDrawingContext*>(pClientDrawingContext) };
+                    pContext->pRenderer->AddGlyphRun(baselineOriginX, baselineOriginY, measuringMode, *pGlyphRun, pContext->color);
+                    return S_OK;
+                }
+                catch (...)
+                {
+                    return winrt::to_hresult();
+                }
+            }
+
+            HRESULT __stdcall DrawUnderline(void*, FLOAT, FLOAT, DWRITE_UNDERLINE const*, ::IUnknown*) noexcept override { return S_OK; }
+            HRESULT __stdcall DrawStrikethrough(void*, FLOAT, FLOAT, DWRITE_STRIKETHROUGH const*, ::IUnknown*) noexcept override { return S_OK; }
+            HRESULT __stdcall DrawInlineObject(void*, FLOAT, FLOAT, ::IDWriteInlineObject*, BOOL, BOOL, ::IUnknown*) noexcept override { return S_OK; }
+        };
+
+        // Each instance is a DX::GlyphQuad.
+        D3D12_INPUT_ELEMENT_DESC const s_glyphInputElements[]
+        {
+            { "GLYPHRECT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, offsetof(GlyphQuad, x), D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+            { "GLYPHTEXRECT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, offsetof(GlyphQuad, u0), D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+            { "GLYPHCOLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, offsetof(GlyphQuad, color), D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 }
+        };
+
+        UINT64 AlignUp(UINT64 value, UINT64 alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+    }
+
+    D3D12GlyphRenderer::D3D12GlyphRenderer(DeviceResources& deviceResources) :
+        m_deviceResources{ deviceResources },
+        m_pDWriteGlyphRunSink{ winrt::make_self<GlyphRunSink>().as<::IDWriteTextRenderer>() }
+    {
+    }
+
+    // Glyphs are rasterized as DirectWrite would draw them in grayscale: a glyph at a time, at
+    // the device's DPI, with the bitmap's origin on the pen (so on a whole pixel).
+    void D3D12GlyphRenderer::AddGlyphRun(float baselineOriginX, float baselineOriginY, DWRITE_MEASURING_MODE measuringMode, DWRITE_GLYPH_RUN const& glyphRun, uint32_t color)
+    {
+        float const pixelsPerDip{ m_deviceResources.Dpi().x / 96.f };
+        bool const isRightToLeft{ (glyphRun.bidiLevel & 1) != 0 };
+        m_positions.clear();
+        float penX{ baselineOriginX };
+        for (UINT32 glyph{ 0 }; glyph < glyphRun.glyphCount; ++glyph)
+        {
+            float const advance{ glyphRun.glyphAdvances ? glyphRun.glyphAdvances[glyph] : 0.f };
+            DWRITE_GLYPH_OFFSET const offset{ glyphRun.glyphOffsets ? glyphRun.glyphOffsets[glyph] : DWRITE_GLYPH_OFFSET{} };
+            float const x{ isRightToLeft ? penX - advance - offset.advanceOffset : penX + offset.advanceOffset };
+            m_positions.push_back(GlyphPosition{ glyphRun.glyphIndices[glyph], x * pixelsPerDip, (baselineOriginY - offset.ascenderOffset) * pixelsPerDip });
+            penX += isRightToLeft ? -advance : advance;
+        }
+
+        auto rasterize = [&](uint32_t glyphIndex, std::vector<uint8_t>& pixels)
+            {
+                UINT16 const index{ static_cast<UINT16>(glyphIndex) };
+                FLOAT const advance{ 0.f };
+                DWRITE_GLYPH_RUN const glyph{ glyphRun.fontFace, glyphRun.fontEmSize, 1, &index, &advance, nullptr, glyphRun.isSideways, 0 };
+                DWRITE_MATRIX const transform{ pixelsPerDip, 0.f, 0.f, pixelsPerDip, 0.f, 0.f };
+                winrt::com_ptr<::IDWriteGlyphRunAnalysis> pDWriteGlyphRunAnalysis;
+                winrt::check_hresult(m_deviceResources.IDWriteFactory2()->CreateGlyphRunAnalysis(&glyph, &transform, DWRITE_RENDERING_MODE_NATURAL_SYMMETRIC,
+                    measuringMode, DWRITE_GRID_FIT_MODE_DEFAULT, DWRITE_TEXT_ANTIALIAS_MODE_GRAYSCALE, 0.f, 0.f, pDWriteGlyphRunAnalysis.put()));
+
+                RECT bounds{};
+                winrt::check_hresult(pDWriteGlyphRunAnalysis->GetAlphaTextureBounds(DWRITE_TEXTURE_ALIASED_1x1, &bounds));
+                if (bounds.right <= bounds.left || bounds.bottom <= bounds.top) return GlyphBitmap{};
+                GlyphBitmap const bitmap{ static_cast<uint32_t>(bounds.right - bounds.left), static_cast<uint32_t>(bounds.bottom - bounds.top), bounds.left, bounds.top };
+                pixels.resize(size_t{ bitmap.width } * bitmap.height);
+                winrt::check_hresult(pDWriteGlyphRunAnalysis->CreateAlphaTexture(DWRITE_TEXTURE_ALIASED_1x1, &bounds, pixels.data(), static_cast<UINT32>(pixels.size())));
+                return bitmap;
+            };
+        m_batcher.AddGlyphRun(FontFace(glyphRun.fontFace), glyphRun.fontEmSize * pixelsPerDip, m_positions.data(), m_positions.size(), color, rasterize);
+    }
+
+    // Created when it's first drawn from. It's in COMMON, from which the first copy promotes it.
+    void D3D12GlyphRenderer::CreateAtlas()
+    {
+        D3D12_RESOURCE_DESC const atlasDesc{ CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8_UNORM, s_atlasSize, s_atlasSize, 1, 1) };
+        m_d3d12Atlas = m_deviceResources.CreatePlacedResource(D3D12_HEAP_TYPE_DEFAULT, atlasDesc, D3D12_RESOURCE_STATE_COMMON);
+        m_d3d12Atlas.pResource->SetName(L"Glyph atlas");
+        m_d3d12AtlasView = m_deviceResources.AllocatePersistentDescriptor();
+        m_deviceResources.ID3D12Device()->CreateShaderResourceView(m_d3d12Atlas.pResource.get(), nullptr, m_d3d12AtlasView.cpu);
+    }
+
+    void D3D12GlyphRenderer::DrawTextLayout(::IDWriteTextLayout* pDWriteTextLayout, float x, float y, uint32_t color)
+    {
+        GlyphDrawingContext context{ this, color, m_deviceResources.Dpi().x / 96.f };
+        winrt::check_hresult(pDWriteTextLayout->Draw(&context, m_pDWriteGlyphRunSink.get(), x, y));
+    }
+
+    // The atlas knows font faces by number; this holds a reference to each, so that a number is
+    // never reused for another face while the atlas has its glyphs.
+    uint32_t D3D12GlyphRenderer::FontFace(::IDWriteFontFace* pFontFace)
+    {
+        for (size_t face{ 0 }; face < m_fontFaces.size(); ++face)
+        {
+            if (m_fontFaces[face].get() == pFontFace) return static_cast<uint32_t>(face);
+        }
+        m_fontFaces.emplace_back().copy_from(pFontFace);
+        return static_cast<uint32_t>(m_fontFaces.size() - 1);
+    }
+
+    void D3D12GlyphRenderer::PipelineSetup(ShaderBlob const& vertexShader, ShaderBlob const& pixelShader)
+    {
+        // The render target's size in the vertex shader's constants, and the atlas in the pixel shader's table.
+        {
+            CD3DX12_DESCRIPTOR_RANGE range;
+            range.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
+            CD3DX12_ROOT_PARAMETER parameters[2];
+            parameters[0].InitAsConstants(2, 0, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+            parameters[1].InitAsDescriptorTable(1, &range, D3D12_SHADER_VISIBILITY_PIXEL);
+            CD3DX12_STATIC_SAMPLER_DESC const sampler{ 0, D3D12_FILTER_MIN_MAG_MIP_POINT, D3D12_TEXTURE_ADDRESS_MODE_CLAMP, D3D12_TEXTURE_ADDRESS_MODE_CLAMP,
+                D3D12_TEXTURE_ADDRESS_MODE_CLAMP, 0.f, 1, D3D12_COMPARISON_FUNC_ALWAYS, D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK, 0.f, 0.f, D3D12_SHADER_VISIBILITY_PIXEL };
+
+            D3D12_ROOT_SIGNATURE_FLAGS const rootSignatureFlags{
+                D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT |
+                D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS |
+                D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS |
+                D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS };
+
+            CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc;
+            rootSignatureDesc.Init(2, parameters, 1, &sampler, rootSignatureFlags);
+            m_pD3D12RootSignature = m_deviceResources.Pipelines().RootSignature(rootSignatureDesc);
+        }
+
+        // Quads over the back buffer, with no depth buffer, blended with premultiplied alpha.
+        CD3DX12_BLEND_DESC blendDesc(D3D12_DEFAULT);
+        D3D12_RENDER_TARGET_BLEND_DESC& blend{ blendDesc.RenderTarget[0] };
+        blend.BlendEnable = TRUE;
+        blend.SrcBlend = blend.SrcBlendAlpha = D3D12_BLEND_ONE;
+        blend.DestBlend = blend.DestBlendAlpha = D3D12_BLEND_INV_SRC_ALPHA;
+        CD3DX12_RASTERIZER_DESC rasterizerDesc(D3D12_DEFAULT);
+        rasterizerDesc.CullMode = D3D12_CULL_MODE_NONE;
+        CD3DX12_DEPTH_STENCIL_DESC depthStencilDesc(D3D12_DEFAULT);
+        depthStencilDesc.DepthEnable = FALSE;
+
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC d3d12GraphicsPipelineStateDesc{};
+        d3d12GraphicsPipelineStateDesc.InputLayout = { s_glyphInputElements, static_cast<UINT>(std::size(s_glyphInputElements)) };
+        d3d12GraphicsPipelineStateDesc.pRootSignature = m_pD3D12RootSignature.get();
+        d3d12GraphicsPipelineStateDesc.VS = { vertexShader.pData, vertexShader.sizeInBytes };
+        d3d12GraphicsPipelineStateDesc.PS = { pixelShader.pData, pixelShader.sizeInBytes };
+        d3d12GraphicsPipelineStateDesc.RasterizerState = rasterizerDesc;
+        d3d12GraphicsPipelineStateDesc.BlendState = blendDesc;
+        d3d12GraphicsPipelineStateDesc.DepthStencilState = depthStencilDesc;
+        d3d12GraphicsPipelineStateDesc.SampleMask = UINT_MAX;
+        d3d12GraphicsPipelineStateDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+        d3d12GraphicsPipelineStateDesc.NumRenderTargets = 1;
+        d3d12GraphicsPipelineStateDesc.RTVFormats[0] = m_deviceResources.RTVFormat();
+        d3d12GraphicsPipelineStateDesc.SampleDesc.Count = 1;
+        m_pD3D12PipelineState = m_deviceResources.Pipelines().GraphicsPipelineState(d3d12GraphicsPipelineStateDesc);
+    }
+
+    void D3D12GlyphRenderer::Render(::ID3D12GraphicsCommandList* pD3D12GraphicsCommandList, D3D12CommandListStates& states)
+    {
+        std::vector<GlyphQuad> const& quads{ m_batcher.Quads() };
+        if (quads.empty()) return;
+        if (!m_d3d12Atlas.pResource) CreateAtlas();
+
+        // Copy the glyphs that were rasterized this frame into the atlas, from one allocation in
+        // the upload ring: each glyph's rows start on a placement boundary, and are a pitch apart,
+        // as CopyTextureRegion requires. The copies wait (at the barrier) for earlier frames' draws.
+        std::vector<GlyphUpload> const& uploads{ m_batcher.Uploads() };
+        if (!uploads.empty())
+        {
+            UINT64 stagingSize{ 0 };
+            for (GlyphUpload const& upload : uploads)
+            {
+                stagingSize = AlignUp(stagingSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT) + AlignUp(upload.rect.width, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT) * upload.rect.height;
+            }
+            UploadAllocation const staging{ m_deviceResources.AllocateUpload(stagingSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT) };
+
+            states.Transition(m_d3d12Atlas.pResource.get(), D3D12_RESOURCE_STATE_COPY_DEST);
+            states.FlushBarriers();
+            CD3DX12_TEXTURE_COPY_LOCATION const destination{ m_d3d12Atlas.pResource.get(), 0 };
+            uint8_t const* pBytes{ m_batcher.UploadBytes().data() };
+            UINT64 offset{ 0 };
+            for (GlyphUpload const& upload : uploads)
+            {
+                offset = AlignUp(offset, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+                UINT const rowPitch{ static_cast<UINT>(AlignUp(upload.rect.width, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT)) };
+                for (uint32_t row{ 0 }; row < upload.rect.height; ++row)
+                {
+                    StreamingCopy(staging.pCpu + offset + UINT64{ row } * rowPitch, pBytes + upload.offset + size_t{ row } * upload.rect.width, upload.rect.width);
+                }
+                D3D12_PLACED_SUBRESOURCE_FOOTPRINT const footprint{ staging.offset + offset, { DXGI_FORMAT_R8_UNORM, upload.rect.width, upload.rect.height, 1, rowPitch } };
+                CD3DX12_TEXTURE_COPY_LOCATION const source{ staging.pResource, footprint };
+                pD3D12GraphicsCommandList->CopyTextureRegion(&destination, upload.rect.x, upload.rect.y, 0, &source, nullptr);
+                offset += UINT64{ rowPitch } * upload.rect.height;
+            }
+        }
+        states.Transition(m_d3d12Atlas.pResource.get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        states.FlushBarriers();
+
+        // The quads are this frame's instance data.
+        UINT const instancesSize{ static_cast<UINT>(quads.size() * sizeof(GlyphQuad)) };
+        UploadAllocation const instances{ m_deviceResources.AllocateUpload(instancesSize, 16) };
+        StreamingCopy(instances.pCpu, quads.data(), instancesSize);
+        D3D12_VERTEX_BUFFER_VIEW const instanceView{ instances.gpuAddress, instancesSize, sizeof(GlyphQuad) };
+
+        SIZE const& renderTargetSize{ m_deviceResources.RenderTargetSize() };
+        float const inverseTargetSize[]{ 1.f / renderTargetSize.cx, 1.f / renderTargetSize.cy };
+        D3D12_CPU_DESCRIPTOR_HANDLE const& renderTargetView{ m_deviceResources.D3D12RenderTargetView() };
+
+        ::PIXBeginEvent(pD3D12GraphicsCommandList, 0, L"Glyphs");
+        pD3D12GraphicsCommandList->SetGraphicsRootSignature(m_pD3D12RootSignature.get());
+        pD3D12GraphicsCommandList->SetPipelineState(m_pD3D12PipelineState.get());
+        pD3D12GraphicsCommandList->SetGraphicsRoot32BitConstants(0, 2, inverseTargetSize, 0);
+        pD3D12GraphicsCommandList->SetGraphicsRootDescriptorTable(1, m_d3d12AtlasView.gpu);
+        pD3D12GraphicsCommandList->OMSetRenderTargets(1, &renderTargetView, false, nullptr);
+        pD3D12GraphicsCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+        pD3D12GraphicsCommandList->IASetVertexBuffers(0, 1, &instanceView);
+        pD3D12GraphicsCommandList->DrawInstanced(4, static_cast<UINT>(quads.size()), 0, 0);
+        ::PIXEndEvent(pD3D12GraphicsCommandList);
+    }
+
+    void D3D12GlyphRenderer::Reset()
+    {
+        m_deviceResources.FreePlacedResource(m_d3d12Atlas);
+        if (m_d3d12AtlasView.cpu.ptr) m_deviceResources.FreePersistentDescriptor(m_d3d12AtlasView);
+        m_d3d12AtlasView = DescriptorHandle{};
+        m_pD3D12PipelineState = nullptr;
+        m_pD3D12RootSignature = nullptr;
+        m_fontFaces.clear();
+        m_batcher.ResetAtlas();
+    }
+}
@@ -0,0 +1,74 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <vector>
+
+namespace DX
+{
+    class DeviceResources;
+
+    // Draws DirectWrite text layouts with Direct3D 12, into the frame's own command list: no
+    // 11On12 device, Direct2D, or flush. Each glyph run that a layout draws is rasterized a glyph
+    // at a time into an R8 atlas texture (see GlyphBatcher and GlyphAtlas), and every glyph of
+    // the frame is drawn with one instanced draw of a quad.
+    class D3D12GlyphRenderer final
+    {
+        static constexpr UINT s_atlasSize{ 1024 }; // Square; 1 MB.
+
+        // data members
+
+        GlyphBatcher m_batcher{ s_atlasSize, s_atlasSize };
+        DescriptorHandle m_d3d12AtlasView{};
+        PlacedResource m_d3d12Atlas;
+        DeviceResources& m_deviceResources;
+        std::vector<winrt::com_ptr<::IDWriteFontFace>> m_fontFaces; // Their indices are the atlas's font faces.
+        winrt::com_ptr<::IDWriteTextRenderer> m_pDWriteGlyphRunSink{ nullptr }; // What text layouts are drawn through.
+        winrt::com_ptr<::ID3D12PipelineState> m_pD3D12PipelineState{ nullptr };
+        winrt::com_ptr<::ID3D12RootSignature> m_pD3D12RootSignature{ nullptr };
+        std::vector<GlyphPosition> m_positions; // Of the glyph run being added.
+
+        // member functions
+
+        void CreateAtlas();
+        uint32_t FontFace(::IDWriteFontFace* pFontFace);
+
+    public:
+        explicit D3D12GlyphRenderer(DeviceResources& deviceResources);
+
+        // member functions
+
+        // For the IDWriteTextRenderer that DrawTextLayout draws through: adds a run's glyphs (at a
+        // baseline origin in DIPs) to the frame's batch, in the color that's being drawn in.
+        void AddGlyphRun(float baselineOriginX, float baselineOriginY, DWRITE_MEASURING_MODE measuringMode, DWRITE_GLYPH_RUN const& glyphRun, uint32_t color);
+
+        // Starts the frame's batch.
+        void Begin() { m_batcher.Begin(); }
+
+        // Adds a layout's glyphs, with its top left at (x, y) in DIPs, in an RGBA color (red in the low byte).
+        void DrawTextLayout(::IDWriteTextLayout* pDWriteTextLayout, float x, float y, uint32_t color);
+
+        // Creates the root signature and pipeline state, from the glyph shaders.
+        void PipelineSetup(ShaderBlob const& vertexShader, ShaderBlob const& pixelShader);
+
+        // Records the frame's batch into a command list whose render target is the back buffer:
+        // copies the glyphs that were rasterized into the atlas, and draws every glyph.
+        void Render(::ID3D12GraphicsCommandList* pD3D12GraphicsCommandList, D3D12CommandListStates& states);
+
+        // Releases the device's objects (and so empties the atlas).
+        void Reset();
+
+        // accessors
+
+        GlyphBatcher const& Batcher() const { return m_batcher; }
+    };
+}
@@ -0,0 +1,141 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "pch.h"
+
+namespace DX
+{
+    D3D12OverlayLayer::D3D12OverlayLayer(DeviceResources& deviceResources) :
+        m_deviceResources{ deviceResources }
+    {
+    }
+
+    // The layer is recreated when the back buffer's size or the DPI changes, which OverlayLayer
+    // counts as a resize; it has to be rasterized again either way.
+    bool D3D12OverlayLayer::BeginFrame(uint64_t contentHash)
+    {
+        SIZE const& renderTargetSize{ m_deviceResources.RenderTargetSize() };
+        float const dpi{ m_deviceResources.Dpi().x };
+        if (!m_d3d12Layer.pResource || renderTargetSize.cx != m_layerSize.cx || renderTargetSize.cy != m_layerSize.cy || dpi != m_layerDpi)
+        {
+            ReleaseLayer();
+            CreateLayer();
+        }
+        return m_layer.BeginFrame(contentHash, static_cast<uint32_t>(m_layerSize.cx), static_cast<uint32_t>(m_layerSize.cy), m_layerDpi);
+    }
+
+    ::ID2D1DeviceContext1* D3D12OverlayLayer::BeginRasterize()
+    {
+        m_deviceResources.AcquireDirect2DTarget(m_d2dTarget);
+        return m_deviceResources.ID2D1DeviceContext1();
+    }
+
+    // A quad over the whole back buffer, a pixel of the layer to a pixel of the target.
+    void D3D12OverlayLayer::Composite(::ID3D12GraphicsCommandList* pD3D12GraphicsCommandList)
+    {
+        D3D12_CPU_DESCRIPTOR_HANDLE const& renderTargetView{ m_deviceResources.D3D12RenderTargetView() };
+
+        ::PIXBeginEvent(pD3D12GraphicsCommandList, 0, L"Overlay");
+        pD3D12GraphicsCommandList->SetGraphicsRootSignature(m_pD3D12RootSignature.get());
+        pD3D12GraphicsCommandList->SetPipelineState(m_pD3D12PipelineState.get());
+        pD3D12GraphicsCommandList->SetGraphicsRootDescriptorTable(0, m_d3d12LayerView.gpu);
+        pD3D12GraphicsCommandList->OMSetRenderTargets(1, &renderTargetView, false, nullptr);
+        pD3D12GraphicsCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+        pD3D12GraphicsCommandList->DrawInstanced(4, 1, 0, 0);
+        ::PIXEndEvent(pD3D12GraphicsCommandList);
+    }
+
+    // The layer lives in PIXEL_SHADER_RESOURCE, in which the composite reads it; the 11On12
+    // device takes it from there to draw into, and leaves it there.
+    void D3D12OverlayLayer::CreateLayer()
+    {
+        m_layerSize = m_deviceResources.RenderTargetSize();
+        m_layerDpi = m_deviceResources.Dpi().x;
+        D3D12_RESOURCE_DESC const layerDesc{ CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_B8G8R8A8_UNORM, static_cast<UINT64>(m_layerSize.cx), static_cast<UINT>(m_layerSize.cy), 1, 1,
+            1, 0, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET) };
+        m_d3d12Layer = m_deviceResources.CreatePlacedResource(D3D12_HEAP_TYPE_DEFAULT, layerDesc, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        m_d3d12Layer.pResource->SetName(L"Overlay layer");
+        m_d3d12LayerView = m_deviceResources.AllocatePersistentDescriptor();
+        m_deviceResources.ID3D12Device()->CreateShaderResourceView(m_d3d12Layer.pResource.get(), nullptr, m_d3d12LayerView.cpu);
+        m_d2dTarget = m_deviceResources.CreateDirect2DTarget(m_d3d12Layer.pResource.get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    }
+
+    void D3D12OverlayLayer::EndRasterize()
+    {
+        m_deviceResources.ReleaseDirect2DTarget(m_d2dTarget);
+    }
+
+    void D3D12OverlayLayer::PipelineSetup(ShaderBlob const& vertexShader, ShaderBlob const& pixelShader)
+    {
+        // The layer in the pixel shader's table; the vertex shader makes the quad from SV_VertexID.
+        {
+            CD3DX12_DESCRIPTOR_RANGE range;
+            range.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
+            CD3DX12_ROOT_PARAMETER parameters[1];
+            parameters[0].InitAsDescriptorTable(1, &range, D3D12_SHADER_VISIBILITY_PIXEL);
+
+            D3D12_ROOT_SIGNATURE_FLAGS const rootSignatureFlags{
+                D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS |
+                D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS |
+                D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS };
+
+            CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc;
+            rootSignatureDesc.Init(1, parameters, 0, nullptr, rootSignatureFlags);
+            m_pD3D12RootSignature = m_deviceResources.Pipelines().RootSignature(rootSignatureDesc);
+        }
+
+        // A quad over the back buffer, with no depth buffer, blended with premultiplied alpha (as Direct2D draws).
+        CD3DX12_BLEND_DESC blendDesc(D3D12_DEFAULT);
+        D3D12_RENDER_TARGET_BLEND_DESC& blend{ blendDesc.RenderTarget[0] };
+        blend.BlendEnable = TRUE;
+        blend.SrcBlend = blend.SrcBlendAlpha = D3D12_BLEND_ONE;
+        blend.DestBlend = blend.DestBlendAlpha = D3D12_BLEND_INV_SRC_ALPHA;
+        CD3DX12_RASTERIZER_DESC rasterizerDesc(D3D12_DEFAULT);
+        rasterizerDesc.CullMode = D3D12_CULL_MODE_NONE;
+        CD3DX12_DEPTH_STENCIL_DESC depthStencilDesc(D3D12_DEFAULT);
+        depthStencilDesc.DepthEnable = FALSE;
+
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC d3d12GraphicsPipelineStateDesc{};
+        d3d12GraphicsPipelineStateDesc.pRootSignature = m_pD3D12RootSignature.get();
+        d3d12GraphicsPipelineStateDesc.VS = { vertexShader.pData, vertexShader.sizeInBytes };
+        d3d12GraphicsPipelineStateDesc.PS = { pixelShader.pData, pixelShader.sizeInBytes };
+        d3d12GraphicsPipelineStateDesc.RasterizerState = rasterizerDesc;
+        d3d12GraphicsPipelineStateDesc.BlendState = blendDesc;
+        d3d12GraphicsPipelineStateDesc.DepthStencilState = depthStencilDesc;
+        d3d12GraphicsPipelineStateDesc.SampleMask = UINT_MAX;
+        d3d12GraphicsPipelineStateDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+        d3d12GraphicsPipelineStateDesc.NumRenderTargets = 1;
+        d3d12GraphicsPipelineStateDesc.RTVFormats[0] = m_deviceResources.RTVFormat();
+        d3d12GraphicsPipelineStateDesc.SampleDesc.Count = 1;
+        m_pD3D12PipelineState = m_deviceResources.Pipelines().GraphicsPipelineState(d3d12GraphicsPipelineStateDesc);
+    }
+
+    // Earlier frames may still be compositing the layer, so its objects are released once they've completed.
+    void D3D12OverlayLayer::ReleaseLayer()
+    {
+        m_deviceResources.DeferRelease(m_d2dTarget.pD2D1Bitmap1);
+        m_deviceResources.DeferRelease(m_d2dTarget.pD3D11Resource);
+        m_d2dTarget = Direct2DTarget{};
+        m_deviceResources.FreePlacedResource(m_d3d12Layer);
+        if (m_d3d12LayerView.cpu.ptr) m_deviceResources.FreePersistentDescriptor(m_d3d12LayerView);
+        m_d3d12LayerView = DescriptorHandle{};
+        m_layerSize = SIZE{ 0L, 0L };
+        m_layerDpi = 0.f;
+    }
+
+    void D3D12OverlayLayer::Reset()
+    {
+        ReleaseLayer();
+        m_pD3D12PipelineState = nullptr;
+        m_pD3D12RootSignature = nullptr;
+        m_layer.Invalidate();
+    }
+}
@@ -0,0 +1,73 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+namespace DX
+{
+    class DeviceResources;
+
+    // A persistent, premultiplied texture the size of the back buffer, that Direct2D draws the
+    // overlay into (through the 11On12 device) only when the overlay has changed (see
+    // OverlayLayer); every frame, it's composited over the scene with one alpha-blended quad, in
+    // the frame's own command list. So most frames pay nothing for Direct2D: no wrapped back
+    // buffer, no 11On12 flush, and no second submit.
+    class D3D12OverlayLayer final
+    {
+        // data members
+
+        Direct2DTarget m_d2dTarget;
+        DescriptorHandle m_d3d12LayerView{};
+        PlacedResource m_d3d12Layer;
+        DeviceResources& m_deviceResources;
+        OverlayLayer m_layer;
+        float m_layerDpi{ 0.f };
+        SIZE m_layerSize{ 0L, 0L };
+        winrt::com_ptr<::ID3D12PipelineState> m_pD3D12PipelineState{ nullptr };
+        winrt::com_ptr<::ID3D12RootSignature> m_pD3D12RootSignature{ nullptr };
+
+        // member functions
+
+        void CreateLayer();
+        void ReleaseLayer();
+
+    public:
+        explicit D3D12OverlayLayer(DeviceResources& deviceResources);
+
+        // member functions
+
+        // Call once a frame, with a hash of what the overlay draws. Returns `true` if it must be
+        // rasterized: then draw it between BeginRasterize and EndRasterize, before the composite.
+        bool BeginFrame(uint64_t contentHash);
+
+        // Makes the layer the Direct2D context's target, and returns the context (to BeginDraw).
+        ::ID2D1DeviceContext1* BeginRasterize();
+
+        // Records the layer's composite into a command list whose render target is the back
+        // buffer; the layer must be in PIXEL_SHADER_RESOURCE.
+        void Composite(::ID3D12GraphicsCommandList* pD3D12GraphicsCommandList);
+
+        // Submits what Direct2D drew (after EndDraw) to the direct queue, ahead of the frame's command list.
+        void EndRasterize();
+
+        // Creates the root signature and pipeline state, from the overlay shaders.
+        void PipelineSetup(ShaderBlob const& vertexShader, ShaderBlob const& pixelShader);
+
+        // Releases the device's objects (and so invalidates the layer).
+        void Reset();
+
+        // accessors
+
+        // This frame's layer; between frames, it's in PIXEL_SHADER_RESOURCE.
+        ::ID3D12Resource* Layer() const { return m_d3d12Layer.pResource.get(); }
+        OverlayLayerStatistics const& Statistics() const { return m_layer.Statistics(); }
+    };
+}
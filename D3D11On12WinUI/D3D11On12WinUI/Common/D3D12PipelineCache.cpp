@@ -0,0 +1,291 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "pch.h"
+
+namespace DX
+{
+    D3D12PipelineCache::D3D12PipelineCache(winrt::com_ptr<::ID3D12Device> const& pD3D12Device, uint64_t deviceHash, std::wstring const& path) :
+        m_archive{ deviceHash },
+        m_path{ path },
+        m_pD3D12Device{ pD3D12Device }
+    {
+        std::vector<uint8_t> fileBytes;
+        std::ifstream file{ m_path, std::ios::binary };
+        if (file)
+        {
+            fileBytes.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+        }
+        m_archive.Load(file ? fileBytes.data() : nullptr, fileBytes.size());
+
+        // The driver validates a library blob too; if it's rejected (say, because the driver has
+        // been updated since), start an empty library.
+        if (auto pD3D12Device1{ m_pD3D12Device.try_as<::ID3D12Device1>() })
+        {
+            if (std::vector<uint8_t> const* pLibraryBlob{ m_archive.Find(PipelineCacheEntryKind::PipelineLibrary, 0) }) m_libraryBlob = *pLibraryBlob;
+            if (m_libraryBlob.empty() ||
+                FAILED(pD3D12Device1->CreatePipelineLibrary(m_libraryBlob.data(), m_libraryBlob.size(), __uuidof(m_pD3D12PipelineLibrary), m_pD3D12PipelineLibrary.put_void())))
+            {
+                m_libraryBlob.clear();
+                m_pD3D12PipelineLibrary = nullptr;
+                if (FAILED(pD3D12Device1->CreatePipelineLibrary(nullptr, 0, __uuidof(m_pD3D12PipelineLibrary), m_pD3D12PipelineLibrary.put_void())))
+                {
+                    m_pD3D12PipelineLibrary = nullptr; // DXGI_ERROR_UNSUPPORTED: keep each pipeline's cached blob instead.
+                }
+            }
+        }
+    }
+
+    winrt::com_ptr<::ID3D12PipelineState> D3D12PipelineCache::GraphicsPipelineState(D3D12_GRAPHICS_PIPELINE_STATE_DESC const& pipelineStateDesc)
+    {
+        std::unique_lock<std::mutex> lock{ m_mutex };
+        auto rootSignature{ std::find_if(m_rootSignatures.begin(), m_rootSignatures.end(), [&](auto const& entry) { return entry.second.get() == pipelineStateDesc.pRootSignature; }) };
+        if (rootSignature == m_rootSignatures.end()) winrt::throw_hresult(E_INVALIDARG);
+        uint64_t const key{ HashGraphicsPipelineDesc(pipelineStateDesc, rootSignature->first) };
+
+        winrt::com_ptr<::ID3D12PipelineState> pD3D12PipelineState;
+        wchar_t name[17]{};
+        ::swprintf_s(name, L"%016llx", static_cast<unsigned long long>(key));
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC cachedDesc{ pipelineStateDesc };
+        std::vector<uint8_t> cachedBlob;
+        if (m_pD3D12PipelineLibrary)
+        {
+            bool const hit{ SUCCEEDED(m_pD3D12PipelineLibrary->LoadGraphicsPipeline(name, &pipelineStateDesc, __uuidof(pD3D12PipelineState), pD3D12PipelineState.put_void())) };
+            m_archive.CountLookup(PipelineCacheEntryKind::PipelineBlob, hit);
+            if (hit) return pD3D12PipelineState;
+            pD3D12PipelineState = nullptr;
+        }
+        else if (std::vector<uint8_t> const* pCachedBlob{ m_archive.Find(PipelineCacheEntryKind::PipelineBlob, key) })
+        {
+            cachedBlob = *pCachedBlob; // Copied, since another thread may replace the entry.
+            cachedDesc.CachedPSO = { cachedBlob.data(), cachedBlob.size() };
+        }
+
+        // Compile without the lock, so that other threads' compiles run alongside. Without a
+        // library, a cached blob that the driver rejects is simply not used.
+        lock.unlock();
+        if (cachedDesc.CachedPSO.pCachedBlob &&
+            SUCCEEDED(m_pD3D12Device->CreateGraphicsPipelineState(&cachedDesc, __uuidof(pD3D12PipelineState), pD3D12PipelineState.put_void())))
+        {
+            return pD3D12PipelineState;
+        }
+        pD3D12PipelineState = nullptr;
+        winrt::check_hresult(m_pD3D12Device->CreateGraphicsPipelineState(&pipelineStateDesc, __uuidof(pD3D12PipelineState), pD3D12PipelineState.put_void()));
+        lock.lock();
+
+        if (m_pD3D12PipelineLibrary)
+        {
+            // E_INVALIDARG means that another thread stored the same pipeline first.
+            if (SUCCEEDED(m_pD3D12PipelineLibrary->StorePipeline(name, pD3D12PipelineState.get()))) m_libraryChanged = true;
+            return pD3D12PipelineState;
+        }
+        winrt::com_ptr<::ID3DBlob> pCachedBlob;
+        if (SUCCEEDED(pD3D12PipelineState->GetCachedBlob(pCachedBlob.put())))
+        {
+            m_archive.Insert(PipelineCacheEntryKind::PipelineBlob, key, pCachedBlob->GetBufferPointer(), pCachedBlob->GetBufferSize());
+        }
+        return pD3D12PipelineState;
+    }
+
+    // Hashes what the description describes, field by field (some of its structs have padding),
+    // and the root signature by its key. CachedPSO is left out: it's what's being looked up.
+    uint64_t D3D12PipelineCache::HashGraphicsPipelineDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC const& pipelineStateDesc, uint64_t rootSignatureKey)
+    {
+        StableHasher hasher;
+        hasher.Add(rootSignatureKey);
+        for (D3D12_SHADER_BYTECODE const& shader : { pipelineStateDesc.VS, pipelineStateDesc.PS, pipelineStateDesc.DS, pipelineStateDesc.HS, pipelineStateDesc.GS })
+        {
+            hasher.Add(static_cast<uint64_t>(shader.BytecodeLength));
+            if (shader.pShaderBytecode) hasher.Add(shader.pShaderBytecode, shader.BytecodeLength);
+        }
+
+        D3D12_STREAM_OUTPUT_DESC const& streamOutput{ pipelineStateDesc.StreamOutput };
+        hasher.Add(streamOutput.NumEntries);
+        for (UINT entryIndex{ 0 }; entryIndex < streamOutput.NumEntries; ++entryIndex)
+        {
+            D3D12_SO_DECLARATION_ENTRY const& entry{ streamOutput.pSODeclaration[entryIndex] };
+            hasher.Add(entry.Stream);
+            hasher.AddString(entry.SemanticName);
+            hasher.Add(entry.SemanticIndex);
+            hasher.Add(entry.StartComponent);
+            hasher.Add(entry.ComponentCount);
+            hasher.Add(entry.OutputSlot);
+        }
+        hasher.Add(streamOutput.NumStrides);
+        if (streamOutput.NumStrides) hasher.Add(streamOutput.pBufferStrides, streamOutput.NumStrides * sizeof(UINT));
+        hasher.Add(streamOutput.RasterizedStream);
+
+        D3D12_BLEND_DESC const& blend{ pipelineStateDesc.BlendState };
+        hasher.Add(blend.AlphaToCoverageEnable);
+        hasher.Add(blend.IndependentBlendEnable);
+        for (D3D12_RENDER_TARGET_BLEND_DESC const& renderTarget : blend.RenderTarget)
+        {
+            hasher.Add(renderTarget.BlendEnable);
+            hasher.Add(renderTarget.LogicOpEnable);
+            hasher.Add(renderTarget.SrcBlend);
+            hasher.Add(renderTarget.DestBlend);
+            hasher.Add(renderTarget.BlendOp);
+            hasher.Add(renderTarget.SrcBlendAlpha);
+            hasher.Add(renderTarget.DestBlendAlpha);
+            hasher.Add(renderTarget.BlendOpAlpha);
+            hasher.Add(renderTarget.LogicOp);
+            hasher.Add(renderTarget.RenderTargetWriteMask);
+        }
+        hasher.Add(pipelineStateDesc.SampleMask);
+
+        D3D12_RASTERIZER_DESC const& rasterizer{ pipelineStateDesc.RasterizerState };
+        hasher.Add(rasterizer.FillMode);
+        hasher.Add(rasterizer.CullMode);
+        hasher.Add(rasterizer.FrontCounterClockwise);
+        hasher.Add(rasterizer.DepthBias);
+        hasher.Add(rasterizer.DepthBiasClamp);
+        hasher.Add(rasterizer.SlopeScaledDepthBias);
+        hasher.Add(rasterizer.DepthClipEnable);
+        hasher.Add(rasterizer.MultisampleEnable);
+        hasher.Add(rasterizer.AntialiasedLineEnable);
+        hasher.Add(rasterizer.ForcedSampleCount);
+        hasher.Add(rasterizer.ConservativeRaster);
+
+        D3D12_DEPTH_STENCIL_DESC const& depthStencil{ pipelineStateDesc.DepthStencilState };
+        hasher.Add(depthStencil.DepthEnable);
+        hasher.Add(depthStencil.DepthWriteMask);
+        hasher.Add(depthStencil.DepthFunc);
+        hasher.Add(depthStencil.StencilEnable);
+        hasher.Add(depthStencil.StencilReadMask);
+        hasher.Add(depthStencil.StencilWriteMask);
+        for (D3D12_DEPTH_STENCILOP_DESC const& face : { depthStencil.FrontFace, depthStencil.BackFace })
+        {
+            hasher.Add(face.StencilFailOp);
+            hasher.Add(face.StencilDepthFailOp);
+            hasher.Add(face.StencilPassOp);
+            hasher.Add(face.StencilFunc);
+        }
+
+        D3D12_INPUT_LAYOUT_DESC const& inputLayout{ pipelineStateDesc.InputLayout };
+        hasher.Add(inputLayout.NumElements);
+        for (UINT elementIndex{ 0 }; elementIndex < inputLayout.NumElements; ++elementIndex)
+        {
+            D3D12_INPUT_ELEMENT_DESC const& element{ inputLayout.pInputElementDescs[elementIndex] };
+            hasher.AddString(element.SemanticName);
+            hasher.Add(element.SemanticIndex);
+            hasher.Add(element.Format);
+            hasher.Add(element.InputSlot);
+            hasher.Add(element.AlignedByteOffset);
+            hasher.Add(element.InputSlotClass);
+            hasher.Add(element.InstanceDataStepRate);
+        }
+
+        hasher.Add(pipelineStateDesc.IBStripCutValue);
+        hasher.Add(pipelineStateDesc.PrimitiveTopologyType);
+        hasher.Add(pipelineStateDesc.NumRenderTargets);
+        for (DXGI_FORMAT const format : pipelineStateDesc.RTVFormats) hasher.Add(format);
+        hasher.Add(pipelineStateDesc.DSVFormat);
+        hasher.Add(pipelineStateDesc.SampleDesc.Count);
+        hasher.Add(pipelineStateDesc.SampleDesc.Quality);
+        hasher.Add(pipelineStateDesc.NodeMask);
+        hasher.Add(pipelineStateDesc.Flags);
+        return hasher.Hash();
+    }
+
+    uint64_t D3D12PipelineCache::HashRootSignatureDesc(D3D12_ROOT_SIGNATURE_DESC const& rootSignatureDesc)
+    {
+        StableHasher hasher;
+        hasher.Add(D3D_ROOT_SIGNATURE_VERSION_1); // The version that RootSignature serializes with.
+        hasher.Add(rootSignatureDesc.NumParameters);
+        for (UINT parameterIndex{ 0 }; parameterIndex < rootSignatureDesc.NumParameters; ++parameterIndex)
+        {
+            D3D12_ROOT_PARAMETER const& parameter{ rootSignatureDesc.pParameters[parameterIndex] };
+            hasher.Add(parameter.ParameterType);
+            hasher.Add(parameter.ShaderVisibility);
+            switch (parameter.ParameterType)
+            {
+            case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+                hasher.Add(parameter.DescriptorTable.NumDescriptorRanges);
+                for (UINT rangeIndex{ 0 }; rangeIndex < parameter.DescriptorTable.NumDescriptorRanges; ++rangeIndex)
+                {
+                    D3D12_DESCRIPTOR_RANGE const& range{ parameter.DescriptorTable.pDescriptorRanges[rangeIndex] };
+                    hasher.Add(range.RangeType);
+                    hasher.Add(range.NumDescriptors);
+                    hasher.Add(range.BaseShaderRegister);
+                    hasher.Add(range.RegisterSpace);
+                    hasher.Add(range.OffsetInDescriptorsFromTableStart);
+                }
+                break;
+            case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+                hasher.Add(parameter.Constants.ShaderRegister);
+                hasher.Add(parameter.Constants.RegisterSpace);
+                hasher.Add(parameter.Constants.Num32BitValues);
+                break;
+            default:
+                hasher.Add(parameter.Descriptor.ShaderRegister);
+                hasher.Add(parameter.Descriptor.RegisterSpace);
+                break;
+            }
+        }
+
+        // A static sampler's fields are all four bytes, so it has no padding.
+        hasher.Add(rootSignatureDesc.NumStaticSamplers);
+        if (rootSignatureDesc.NumStaticSamplers) hasher.Add(rootSignatureDesc.pStaticSamplers, rootSignatureDesc.NumStaticSamplers * sizeof(D3D12_STATIC_SAMPLER_DESC));
+        hasher.Add(rootSignatureDesc.Flags);
+        return hasher.Hash();
+    }
+
+    winrt::com_ptr<::ID3D12RootSignature> D3D12PipelineCache::RootSignature(D3D12_ROOT_SIGNATURE_DESC const& rootSignatureDesc)
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        uint64_t const key{ HashRootSignatureDesc(rootSignatureDesc) };
+        for (auto const& rootSignature : m_rootSignatures)
+        {
+            if (rootSignature.first != key) continue;
+            m_archive.CountLookup(PipelineCacheEntryKind::RootSignature, true);
+            return rootSignature.second;
+        }
+
+        std::vector<uint8_t> const* pSerialized{ m_archive.Find(PipelineCacheEntryKind::RootSignature, key) };
+        if (!pSerialized)
+        {
+            winrt::com_ptr<::ID3DBlob> pSignature;
+            winrt::com_ptr<::ID3DBlob> pError;
+            winrt::check_hresult(::D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, pSignature.put(), pError.put()));
+            m_archive.Insert(PipelineCacheEntryKind::RootSignature, key, pSignature->GetBufferPointer(), pSignature->GetBufferSize());
+            pSerialized = m_archive.Find(PipelineCacheEntryKind::RootSignature, key);
+        }
+
+        winrt::com_ptr<::ID3D12RootSignature> pD3D12RootSignature;
+        winrt::check_hresult(m_pD3D12Device->CreateRootSignature(0, pSerialized->data(), pSerialized->size(), __uuidof(pD3D12RootSignature), pD3D12RootSignature.put_void()));
+        m_rootSignatures.emplace_back(key, pD3D12RootSignature);
+        return pD3D12RootSignature;
+    }
+
+    void D3D12PipelineCache::Save()
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        if (m_libraryChanged)
+        {
+            std::vector<uint8_t> libraryBlob(m_pD3D12PipelineLibrary->GetSerializedSize());
+            if (SUCCEEDED(m_pD3D12PipelineLibrary->Serialize(libraryBlob.data(), libraryBlob.size())))
+            {
+                m_archive.Insert(PipelineCacheEntryKind::PipelineLibrary, 0, libraryBlob.data(), libraryBlob.size());
+            }
+            m_libraryChanged = false;
+        }
+        if (!m_archive.Dirty()) return;
+
+        // Write a whole new file, and then replace the old one with it, so that a crash midway leaves one or the other.
+        std::vector<uint8_t> const bytes{ m_archive.Serialize() };
+        std::wstring const temporaryPath{ m_path + L".tmp" };
+        {
+            std::ofstream file{ temporaryPath, std::ios::binary | std::ios::trunc };
+            if (!file.write(reinterpret_cast<char const*>(bytes.data()), static_cast<std::streamsize>(bytes.size()))) return;
+        }
+        ::MoveFileExW(temporaryPath.c_str(), m_path.c_str(), MOVEFILE_REPLACE_EXISTING);
+    }
+}
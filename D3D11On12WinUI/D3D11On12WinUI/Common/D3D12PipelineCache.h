@@ -0,0 +1,71 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace DX
+{
+    using D3D12PipelineCompiler = PipelineCompiler<winrt::com_ptr<::ID3D12PipelineState>>;
+
+    // Creates root signatures and graphics pipeline states through a cache that's kept on disk
+    // (see PipelineCacheArchive), so that a warm start, or a rebuild after device loss, doesn't
+    // compile them from scratch. Pipelines are kept in an ID3D12PipelineLibrary, named by the
+    // stable hash of their description; where the driver has no pipeline libraries, each
+    // pipeline's cached blob is kept instead. Root signatures are kept serialized. Pipelines
+    // may be created from any thread (see PipelineCompiler); compiles run in parallel.
+    class D3D12PipelineCache final
+    {
+        // data members
+
+        PipelineCacheArchive m_archive;
+        std::vector<uint8_t> m_libraryBlob; // The pipeline library reads from this for as long as it lives.
+        bool m_libraryChanged{ false };
+        mutable std::mutex m_mutex; // Guards everything but compiling.
+        std::wstring m_path;
+        winrt::com_ptr<::ID3D12Device> m_pD3D12Device{ nullptr };
+        winrt::com_ptr<::ID3D12PipelineLibrary> m_pD3D12PipelineLibrary{ nullptr }; // Null if the driver doesn't support them.
+        std::vector<std::pair<uint64_t, winrt::com_ptr<::ID3D12RootSignature>>> m_rootSignatures; // (key, root signature) of each created.
+
+        // member functions
+
+        static uint64_t HashGraphicsPipelineDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC const& pipelineStateDesc, uint64_t rootSignatureKey);
+        static uint64_t HashRootSignatureDesc(D3D12_ROOT_SIGNATURE_DESC const& rootSignatureDesc);
+
+    public:
+        // `deviceHash` identifies the adapter and driver; the file at `path` is used only if it was saved with the same one.
+        D3D12PipelineCache(winrt::com_ptr<::ID3D12Device> const& pD3D12Device, uint64_t deviceHash, std::wstring const& path);
+
+        // member functions
+
+        // The root signature must have come from RootSignature.
+        winrt::com_ptr<::ID3D12PipelineState> GraphicsPipelineState(D3D12_GRAPHICS_PIPELINE_STATE_DESC const& pipelineStateDesc);
+
+        winrt::com_ptr<::ID3D12RootSignature> RootSignature(D3D12_ROOT_SIGNATURE_DESC const& rootSignatureDesc);
+
+        // Writes the cache to disk, if anything has been added since it was loaded. A cache that
+        // can't be written is no worse than no cache, so this doesn't throw.
+        void Save();
+
+        // accessors
+
+        PipelineCacheStatistics Statistics() const
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            return m_archive.Statistics();
+        }
+    };
+}
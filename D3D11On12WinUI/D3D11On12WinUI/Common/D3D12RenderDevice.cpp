@@ -0,0 +1,121 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "pch.h"
+
+namespace DX
+{
+    D3D12RenderFence::D3D12RenderFence(winrt::com_ptr<::ID3D12Fence> const& pD3D12Fence) :
+        m_pD3D12Fence{ pD3D12Fence }
+    {
+        m_fenceEventHandle.attach(::CreateEvent(nullptr, false, false, nullptr));
+        winrt::check_bool(bool{ m_fenceEventHandle });
+    }
+
+    void D3D12RenderFence::WaitForValue(uint64_t value)
+    {
+        if (m_pD3D12Fence->GetCompletedValue() >= value) return;
+
+        // Tell the fence what event to signal when that value is reached.
+        winrt::check_hresult(m_pD3D12Fence->SetEventOnCompletion(value, m_fenceEventHandle.get()));
+        // Wait for the event.
+        ::WaitForSingleObjectEx(m_fenceEventHandle.get(), INFINITE, FALSE);
+    }
+
+    void D3D12RenderCommandQueue::ExecuteCommandList(IRenderCommandList& commandList)
+    {
+        ::ID3D12CommandList* pCommandList{ static_cast<D3D12RenderCommandList&>(commandList).ID3D12GraphicsCommandList() };
+        m_pD3D12CommandQueue->ExecuteCommandLists(1, &pCommandList);
+    }
+
+    void D3D12RenderCommandQueue::Signal(IRenderFence& fence, uint64_t value)
+    {
+        winrt::check_hresult(m_pD3D12CommandQueue->Signal(static_cast<D3D12RenderFence&>(fence).ID3D12Fence(), value));
+    }
+
+    void D3D12RenderCommandQueue::Wait(IRenderFence& fence, uint64_t value)
+    {
+        winrt::check_hresult(m_pD3D12CommandQueue->Wait(static_cast<D3D12RenderFence&>(fence).ID3D12Fence(), value));
+    }
+
+    D3D12RenderSwapChain::D3D12RenderSwapChain(winrt::com_ptr<::IDXGISwapChain3> const& pDXGISwapChain3, winrt::com_ptr<::ID3D12Device> const& pD3D12Device, uint32_t maximumFrameLatency) :
+        m_pD3D12Device{ pD3D12Device },
+        m_pDXGISwapChain3{ pDXGISwapChain3 }
+    {
+        // Present no longer blocks once maximumFrameLatency frames are queued; instead, the
+        // render thread waits on the waitable object before it starts recording a frame.
+        winrt::check_hresult(m_pDXGISwapChain3->SetMaximumFrameLatency(maximumFrameLatency));
+        m_frameLatencyWaitableObject.attach(m_pDXGISwapChain3->GetFrameLatencyWaitableObject());
+        winrt::check_bool(bool{ m_frameLatencyWaitableObject });
+    }
+
+    uint32_t D3D12RenderSwapChain::BufferCount() const
+    {
+        DXGI_SWAP_CHAIN_DESC1 swapChainDesc{};
+        winrt::check_hresult(m_pDXGISwapChain3->GetDesc1(&swapChainDesc));
+        return swapChainDesc.BufferCount;
+    }
+
+    RenderPresentResult D3D12RenderSwapChain::Present(uint32_t syncInterval)
+    {
+        DXGI_PRESENT_PARAMETERS parameters{};
+        parameters.DirtyRectsCount = 0;
+        parameters.pDirtyRects = nullptr;
+        parameters.pScrollRect = nullptr;
+        parameters.pScrollOffset = nullptr;
+
+        HRESULT hr{ m_pDXGISwapChain3->Present1(syncInterval, 0, &parameters) };
+
+        // If the device was removed either by a disconnection or a driver upgrade, we
+        // must recreate all device resources.
+        if (hr == DXGI_ERROR_DEVICE_REMOVED)
+        {
+            hr = m_pD3D12Device->GetDeviceRemovedReason();
+            return RenderPresentResult::DeviceLost;
+        }
+        else if (hr == DXGI_ERROR_DEVICE_RESET)
+        {
+            return RenderPresentResult::DeviceLost;
+        }
+        else if (hr == DXGI_STATUS_OCCLUDED)
+        {
+            return RenderPresentResult::Occluded;
+        }
+
+        winrt::check_hresult(hr);
+        return RenderPresentResult::Ok;
+    }
+
+    uint64_t D3D12RenderSwapChain::PresentCount() const
+    {
+        UINT presentCount{ 0 };
+        winrt::check_hresult(m_pDXGISwapChain3->GetLastPresentCount(&presentCount));
+        return presentCount;
+    }
+
+    bool D3D12RenderSwapChain::TryGetLastDisplayedFrame(RenderDisplayedFrame& frame)
+    {
+        // This fails (for example, with DXGI_ERROR_FRAME_STATISTICS_DISJOINT) until the
+        // compositor has statistics to report, and after a mode change; no frame is reported then.
+        DXGI_FRAME_STATISTICS frameStatistics{};
+        if (FAILED(m_pDXGISwapChain3->GetFrameStatistics(&frameStatistics)) || frameStatistics.PresentCount == 0) return false;
+
+        frame.presentCount = frameStatistics.PresentCount;
+        frame.displayNanoseconds = QpcToNanoseconds(frameStatistics.SyncQPCTime.QuadPart);
+        return true;
+    }
+
+    void D3D12RenderSwapChain::WaitForFrameLatency()
+    {
+        // Wait for at most a second, so that a swap chain that's no longer being composed can't hang the render loop.
+        ::WaitForSingleObjectEx(m_frameLatencyWaitableObject.get(), 1000, TRUE);
+    }
+}
@@ -0,0 +1,119 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+namespace DX
+{
+    // Direct3D 12 implementations of the RenderDevice.h interfaces. Each one wraps an object
+    // that DeviceResources has already created.
+
+    // Converts a QueryPerformanceCounter value (for example, DXGI_FRAME_STATISTICS::SyncQPCTime) to nanoseconds.
+    inline uint64_t QpcToNanoseconds(int64_t qpcTicks)
+    {
+        static int64_t const qpcFrequency{ [] { LARGE_INTEGER frequency{}; ::QueryPerformanceFrequency(&frequency); return frequency.QuadPart; }() };
+        return static_cast<uint64_t>(qpcTicks / qpcFrequency) * 1'000'000'000ull + static_cast<uint64_t>(qpcTicks % qpcFrequency) * 1'000'000'000ull / qpcFrequency;
+    }
+
+    // The current time, on the same clock as the display times that D3D12RenderSwapChain reports.
+    inline uint64_t QpcNowNanoseconds()
+    {
+        LARGE_INTEGER now{};
+        ::QueryPerformanceCounter(&now);
+        return QpcToNanoseconds(now.QuadPart);
+    }
+
+    class D3D12RenderFence final : public IRenderFence
+    {
+        // data members
+
+        winrt::handle m_fenceEventHandle{ 0 };
+        winrt::com_ptr<::ID3D12Fence> m_pD3D12Fence{ nullptr };
+
+    public:
+        D3D12RenderFence(winrt::com_ptr<::ID3D12Fence> const& pD3D12Fence);
+
+        // member functions
+
+        uint64_t CompletedValue() const override { return m_pD3D12Fence->GetCompletedValue(); }
+        void WaitForValue(uint64_t value) override;
+
+        // accessors
+
+        ::ID3D12Fence* ID3D12Fence() const { return m_pD3D12Fence.get(); }
+    };
+
+    class D3D12RenderCommandList final : public IRenderCommandList
+    {
+        // data members
+
+        ::ID3D12GraphicsCommandList* m_pD3D12GraphicsCommandList{ nullptr };
+
+    public:
+        D3D12RenderCommandList(::ID3D12GraphicsCommandList* pD3D12GraphicsCommandList) :
+            m_pD3D12GraphicsCommandList{ pD3D12GraphicsCommandList }
+        {
+        }
+
+        // member functions
+
+        void Close() override { winrt::check_hresult(m_pD3D12GraphicsCommandList->Close()); }
+
+        // accessors
+
+        ::ID3D12GraphicsCommandList* ID3D12GraphicsCommandList() const { return m_pD3D12GraphicsCommandList; }
+    };
+
+    class D3D12RenderCommandQueue final : public IRenderCommandQueue
+    {
+        // data members
+
+        winrt::com_ptr<::ID3D12CommandQueue> m_pD3D12CommandQueue{ nullptr };
+
+    public:
+        D3D12RenderCommandQueue(winrt::com_ptr<::ID3D12CommandQueue> const& pD3D12CommandQueue) :
+            m_pD3D12CommandQueue{ pD3D12CommandQueue }
+        {
+        }
+
+        // member functions
+
+        void ExecuteCommandList(IRenderCommandList& commandList) override;
+        void Signal(IRenderFence& fence, uint64_t value) override;
+        void Wait(IRenderFence& fence, uint64_t value) override;
+
+        // accessors
+
+        ::ID3D12CommandQueue* ID3D12CommandQueue() const { return m_pD3D12CommandQueue.get(); }
+    };
+
+    class D3D12RenderSwapChain final : public IRenderSwapChain
+    {
+        // data members
+
+        winrt::handle m_frameLatencyWaitableObject{ 0 };
+        winrt::com_ptr<::ID3D12Device> m_pD3D12Device{ nullptr };
+        winrt::com_ptr<::IDXGISwapChain3> m_pDXGISwapChain3{ nullptr };
+
+    public:
+        // The swap chain must have been created with DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT.
+        D3D12RenderSwapChain(winrt::com_ptr<::IDXGISwapChain3> const& pDXGISwapChain3, winrt::com_ptr<::ID3D12Device> const& pD3D12Device, uint32_t maximumFrameLatency);
+
+        // member functions
+
+        uint32_t BufferCount() const override;
+        uint32_t CurrentBackBufferIndex() const override { return m_pDXGISwapChain3->GetCurrentBackBufferIndex(); }
+        RenderPresentResult Present(uint32_t syncInterval) override;
+        uint64_t PresentCount() const override;
+        bool TryGetLastDisplayedFrame(RenderDisplayedFrame& frame) override;
+        void WaitForFrameLatency() override;
+    };
+}
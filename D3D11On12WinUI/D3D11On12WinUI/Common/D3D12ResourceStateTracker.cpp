@@ -0,0 +1,125 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "pch.h"
+
+namespace DX
+{
+    static_assert(static_cast<uint32_t>(ResourceStates::VertexAndConstantBuffer) == D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER &&
+        static_cast<uint32_t>(ResourceStates::IndexBuffer) == D3D12_RESOURCE_STATE_INDEX_BUFFER &&
+        static_cast<uint32_t>(ResourceStates::RenderTarget) == D3D12_RESOURCE_STATE_RENDER_TARGET &&
+        static_cast<uint32_t>(ResourceStates::UnorderedAccess) == D3D12_RESOURCE_STATE_UNORDERED_ACCESS &&
+        static_cast<uint32_t>(ResourceStates::DepthWrite) == D3D12_RESOURCE_STATE_DEPTH_WRITE &&
+        static_cast<uint32_t>(ResourceStates::DepthRead) == D3D12_RESOURCE_STATE_DEPTH_READ &&
+        static_cast<uint32_t>(ResourceStates::NonPixelShaderResource) == D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE &&
+        static_cast<uint32_t>(ResourceStates::PixelShaderResource) == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE &&
+        static_cast<uint32_t>(ResourceStates::IndirectArgument) == D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT &&
+        static_cast<uint32_t>(ResourceStates::CopyDest) == D3D12_RESOURCE_STATE_COPY_DEST &&
+        static_cast<uint32_t>(ResourceStates::CopySource) == D3D12_RESOURCE_STATE_COPY_SOURCE &&
+        static_cast<uint32_t>(ResourceStates::ResolveDest) == D3D12_RESOURCE_STATE_RESOLVE_DEST &&
+        static_cast<uint32_t>(ResourceStates::ResolveSource) == D3D12_RESOURCE_STATE_RESOLVE_SOURCE &&
+        static_cast<uint32_t>(ResourceStates::Present) == D3D12_RESOURCE_STATE_PRESENT,
+        "ResourceStates must match D3D12_RESOURCE_STATES.");
+
+    static void ToD3D12Barriers(ResourceBarrier<::ID3D12Resource*> const* pBarriers, uint32_t count, std::vector<D3D12_RESOURCE_BARRIER>& d3d12Barriers)
+    {
+        d3d12Barriers.clear();
+        for (uint32_t barrier{ 0 }; barrier < count; ++barrier)
+        {
+            ResourceBarrier<::ID3D12Resource*> const& b{ pBarriers[barrier] };
+            D3D12_RESOURCE_BARRIER_FLAGS const flags{ b.split == ResourceBarrierSplit::BeginOnly ? D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY :
+                b.split == ResourceBarrierSplit::EndOnly ? D3D12_RESOURCE_BARRIER_FLAG_END_ONLY : D3D12_RESOURCE_BARRIER_FLAG_NONE };
+            d3d12Barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(b.resource, static_cast<D3D12_RESOURCE_STATES>(b.before), static_cast<D3D12_RESOURCE_STATES>(b.after),
+                D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, flags));
+        }
+    }
+
+    void D3D12CommandListStates::Aliasing(::ID3D12Resource* pResource)
+    {
+        D3D12_RESOURCE_BARRIER const barrier{ CD3DX12_RESOURCE_BARRIER::Aliasing(nullptr, pResource) };
+        m_pD3D12GraphicsCommandList->ResourceBarrier(1, &barrier);
+    }
+
+    void D3D12CommandListStates::Begin(::ID3D12GraphicsCommandList* pD3D12GraphicsCommandList)
+    {
+        m_pD3D12GraphicsCommandList = pD3D12GraphicsCommandList;
+        m_states.Reset();
+    }
+
+    void D3D12CommandListStates::Close()
+    {
+        m_states.Close([this](auto const* pBarriers, uint32_t count) { IssueBarriers(pBarriers, count); });
+        winrt::check_hresult(m_pD3D12GraphicsCommandList->Close());
+    }
+
+    void D3D12CommandListStates::FlushBarriers()
+    {
+        m_states.Flush([this](auto const* pBarriers, uint32_t count) { IssueBarriers(pBarriers, count); });
+    }
+
+    void D3D12CommandListStates::IssueBarriers(ResourceBarrier<::ID3D12Resource*> const* pBarriers, uint32_t count)
+    {
+        ToD3D12Barriers(pBarriers, count, m_d3d12Barriers);
+        m_pD3D12GraphicsCommandList->ResourceBarrier(count, m_d3d12Barriers.data());
+    }
+
+    D3D12ResourceStateTracker::D3D12ResourceStateTracker(::ID3D12Device* pD3D12Device, ::ID3D12CommandAllocator* pD3D12CommandAllocator)
+    {
+        winrt::check_hresult(
+            pD3D12Device->CreateCommandList(
+                0,
+                D3D12_COMMAND_LIST_TYPE_DIRECT,
+                pD3D12CommandAllocator,
+                nullptr,
+                __uuidof(m_pD3D12FixUpCommandList),
+                m_pD3D12FixUpCommandList.put_void()
+            )
+        );
+        winrt::check_hresult(m_pD3D12FixUpCommandList->Close());
+        m_pD3D12FixUpCommandList->SetName(L"Resource state fix-ups");
+    }
+
+    void D3D12ResourceStateTracker::ExecuteCommandList(::ID3D12CommandQueue* pD3D12CommandQueue, ::ID3D12CommandAllocator* pD3D12CommandAllocator, D3D12CommandListStates const& commandListStates)
+    {
+        std::lock_guard<std::mutex> lock{ m_submitMutex };
+        m_fixUps.clear();
+        m_tracker.Resolve(commandListStates.States(), m_fixUps);
+
+        ::ID3D12CommandList* pCommandLists[]{ m_pD3D12FixUpCommandList.get(), commandListStates.CommandList() };
+        if (m_fixUps.empty())
+        {
+            pD3D12CommandQueue->ExecuteCommandLists(1, pCommandLists + 1);
+            return;
+        }
+
+        // The fix-up list is executed in the same call as the list, so the queue sees them as one submission.
+        winrt::check_hresult(m_pD3D12FixUpCommandList->Reset(pD3D12CommandAllocator, nullptr));
+        ToD3D12Barriers(m_fixUps.data(), static_cast<uint32_t>(m_fixUps.size()), m_d3d12Barriers);
+        m_pD3D12FixUpCommandList->ResourceBarrier(static_cast<UINT>(m_d3d12Barriers.size()), m_d3d12Barriers.data());
+        winrt::check_hresult(m_pD3D12FixUpCommandList->Close());
+        pD3D12CommandQueue->ExecuteCommandLists(2, pCommandLists);
+    }
+
+    void D3D12ResourceStateTracker::Register(::ID3D12Resource* pResource, D3D12_RESOURCE_STATES state)
+    {
+        D3D12_RESOURCE_DESC const resourceDesc{ pResource->GetDesc() };
+        bool const followsBufferRules{ resourceDesc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER || (resourceDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_SIMULTANEOUS_ACCESS) != 0 };
+        m_tracker.Register(pResource, static_cast<ResourceStates>(state), followsBufferRules ? ResourceKind::Buffer : ResourceKind::Texture);
+    }
+
+    bool D3D12ResourceStateTracker::TryGetState(::ID3D12Resource* pResource, D3D12_RESOURCE_STATES& state) const
+    {
+        ResourceStates trackedState{ ResourceStates::Common };
+        if (!m_tracker.TryGetState(pResource, trackedState)) return false;
+        state = static_cast<D3D12_RESOURCE_STATES>(trackedState);
+        return true;
+    }
+}
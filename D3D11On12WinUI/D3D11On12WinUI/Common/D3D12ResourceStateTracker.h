@@ -0,0 +1,94 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+namespace DX
+{
+    // Declares the states that a Direct3D 12 command list needs its resources in (see
+    // CommandListResourceStates); each FlushBarriers is at most one ResourceBarrier call.
+    class D3D12CommandListStates final
+    {
+        // data members
+
+        std::vector<D3D12_RESOURCE_BARRIER> m_d3d12Barriers;
+        ::ID3D12GraphicsCommandList* m_pD3D12GraphicsCommandList{ nullptr };
+        CommandListResourceStates<::ID3D12Resource*> m_states;
+
+        // member functions
+
+        void IssueBarriers(ResourceBarrier<::ID3D12Resource*> const* pBarriers, uint32_t count);
+
+    public:
+        // member functions
+
+        // Records an aliasing barrier, at once, to `pResource`: a placed resource that takes over
+        // memory that other resources may have used (see D3D12TransientResources).
+        void Aliasing(::ID3D12Resource* pResource);
+
+        // Call once the command list has been reset, and record into it until Close.
+        void Begin(::ID3D12GraphicsCommandList* pD3D12GraphicsCommandList);
+
+        void BeginTransition(::ID3D12Resource* pResource, D3D12_RESOURCE_STATES state) { m_states.BeginTransition(pResource, static_cast<ResourceStates>(state)); }
+
+        // Ends any split barriers still open, issues the batched barriers, and closes the command list.
+        void Close();
+
+        // Call before recording the work that needs the states that were asked for.
+        void FlushBarriers();
+
+        void Transition(::ID3D12Resource* pResource, D3D12_RESOURCE_STATES state) { m_states.Transition(pResource, static_cast<ResourceStates>(state)); }
+
+        // accessors
+
+        ::ID3D12GraphicsCommandList* CommandList() const { return m_pD3D12GraphicsCommandList; }
+        CommandListResourceStates<::ID3D12Resource*> const& States() const { return m_states; }
+        ResourceBarrierStatistics const& Statistics() const { return m_states.Statistics(); }
+    };
+
+    // The direct queue's resource states (see ResourceStateTracker). Command lists recorded with
+    // D3D12CommandListStates are submitted through ExecuteCommandList, which records the fix-up
+    // barriers that a list needs (if any) into a small list that's executed just before it.
+    class D3D12ResourceStateTracker final
+    {
+        // data members
+
+        std::vector<D3D12_RESOURCE_BARRIER> m_d3d12Barriers;
+        std::vector<ResourceBarrier<::ID3D12Resource*>> m_fixUps;
+        winrt::com_ptr<::ID3D12GraphicsCommandList> m_pD3D12FixUpCommandList{ nullptr };
+        std::mutex m_submitMutex; // Guards the fix-up list.
+        ResourceStateTracker<::ID3D12Resource*> m_tracker;
+
+    public:
+        D3D12ResourceStateTracker(::ID3D12Device* pD3D12Device, ::ID3D12CommandAllocator* pD3D12CommandAllocator);
+
+        // member functions
+
+        void Assume(::ID3D12Resource* pResource, D3D12_RESOURCE_STATES state) { m_tracker.Assume(pResource, static_cast<ResourceStates>(state)); }
+
+        // Submits the (closed) command list of `commandListStates` to `pD3D12CommandQueue`. The
+        // fix-up list is recorded with `pD3D12CommandAllocator`, which mustn't be reset until the
+        // GPU has finished with it (so, pass the current frame's).
+        void ExecuteCommandList(::ID3D12CommandQueue* pD3D12CommandQueue, ::ID3D12CommandAllocator* pD3D12CommandAllocator, D3D12CommandListStates const& commandListStates);
+
+        // Buffers, and textures that allow simultaneous access, follow the buffer rules for implicit promotion and decay.
+        void Register(::ID3D12Resource* pResource, D3D12_RESOURCE_STATES state);
+        void Unregister(::ID3D12Resource* pResource) { m_tracker.Unregister(pResource); }
+
+        // accessors
+
+        uint64_t FixUpBarrierCount() const { return m_tracker.FixUpBarrierCount(); }
+        bool TryGetState(::ID3D12Resource* pResource, D3D12_RESOURCE_STATES& state) const;
+    };
+}
@@ -0,0 +1,68 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+namespace DX
+{
+    // Holds objects (com_ptrs, in DeviceResources) that the GPU may still be using, each tagged
+    // with the fence value that's signaled after its last use, and releases them once the fence
+    // has reached that value. That lets the render thread drop a resource without first
+    // waiting for the GPU to go idle.
+    template <typename T>
+    class DeferredReleaseQueue final
+    {
+        // data members
+
+        std::deque<std::pair<uint64_t, T>> m_entries; // (fence value, object), in fence-value order.
+
+    public:
+        // member functions
+
+        // Takes ownership of `object`, to be released once the fence reaches `fenceValue`.
+        void Enqueue(uint64_t fenceValue, T object)
+        {
+            // Values almost always arrive in order, so this is nearly always an append.
+            auto it{ std::upper_bound(m_entries.begin(), m_entries.end(), fenceValue,
+                [](uint64_t value, std::pair<uint64_t, T> const& entry) { return value < entry.first; }) };
+            m_entries.insert(it, { fenceValue, std::move(object) });
+        }
+
+        // Releases the objects whose fence values have been reached. Returns how many were released.
+        size_t ReleaseCompleted(uint64_t completedFenceValue)
+        {
+            size_t released{ 0 };
+            while (!m_entries.empty() && m_entries.front().first <= completedFenceValue)
+            {
+                m_entries.pop_front();
+                ++released;
+            }
+            return released;
+        }
+
+        // Releases everything. Only for when the GPU is idle, or the device is gone.
+        void ReleaseAll()
+        {
+            m_entries.clear();
+        }
+
+        // accessors
+
+        bool Empty() const { return m_entries.empty(); }
+        size_t Size() const { return m_entries.size(); }
+    };
+}
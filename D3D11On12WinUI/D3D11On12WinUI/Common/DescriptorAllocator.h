@@ -0,0 +1,146 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// The bookkeeping for one device-wide, shader-visible descriptor heap, so that a frame binds
+// the same heap however many objects it draws. The heap's first part holds long-lived
+// (persistent) descriptors, allocated one at a time from a free list; the rest is a ring of
+// transient descriptors, allocated in contiguous runs for the current frame. Both kinds are
+// reused only once the fence value of the last frame that could use them is reached. It deals
+// only in indices, so the same code runs against a D3D12 heap (in DeviceResources) and against
+// the headless backend.
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "UploadRing.h"
+
+namespace DX
+{
+    struct DescriptorAllocatorStatistics final
+    {
+        uint64_t persistentAllocations{ 0 };
+        uint64_t persistentFailures{ 0 }; // Allocations that found the persistent region full.
+        uint32_t persistentInUse{ 0 }; // Including freed descriptors that the GPU may still be reading.
+        uint32_t persistentPeak{ 0 };
+        uint64_t transientAllocations{ 0 }; // Runs, not descriptors.
+        uint64_t transientDescriptors{ 0 };
+        uint64_t transientFailures{ 0 }; // Allocations that found the transient ring full.
+    };
+
+    class DescriptorAllocator final
+    {
+        // data members
+
+        std::vector<uint32_t> m_freePersistent; // Indices that can be reused now.
+        uint32_t m_persistentCapacity{ 0 };
+        uint32_t m_persistentHighWater{ 0 }; // Indices at and above this (and below the capacity) have never been used.
+        std::deque<std::pair<uint64_t, uint32_t>> m_retiredPersistent; // (fence value, index), in fence-value order.
+        DescriptorAllocatorStatistics m_statistics;
+        UploadRing m_transientRing; // In units of descriptors, rather than bytes.
+
+    public:
+        DescriptorAllocator(uint32_t persistentCapacity = 0, uint32_t transientCapacity = 0)
+        {
+            Reset(persistentCapacity, transientCapacity);
+        }
+
+        // member functions
+
+        // Returns the index of a descriptor that stays allocated until FreePersistent, or nothing if the persistent region is full.
+        std::optional<uint32_t> AllocatePersistent()
+        {
+            uint32_t index{ 0 };
+            if (!m_freePersistent.empty())
+            {
+                index = m_freePersistent.back();
+                m_freePersistent.pop_back();
+            }
+            else if (m_persistentHighWater < m_persistentCapacity)
+            {
+                index = m_persistentHighWater++;
+            }
+            else
+            {
+                ++m_statistics.persistentFailures;
+                return std::nullopt;
+            }
+
+            ++m_statistics.persistentAllocations;
+            if (++m_statistics.persistentInUse > m_statistics.persistentPeak) m_statistics.persistentPeak = m_statistics.persistentInUse;
+            return index;
+        }
+
+        // Returns the index of the first of `count` contiguous descriptors that are valid until
+        // the end of the current frame, or nothing if the transient ring is full.
+        std::optional<uint32_t> AllocateTransient(uint32_t count)
+        {
+            std::optional<uint64_t> offset{ m_transientRing.Allocate(count, 1) };
+            if (!offset)
+            {
+                ++m_statistics.transientFailures;
+                return std::nullopt;
+            }
+
+            ++m_statistics.transientAllocations;
+            m_statistics.transientDescriptors += count;
+            return m_persistentCapacity + static_cast<uint32_t>(*offset);
+        }
+
+        // Ends the current frame: its transient descriptors are reused once the fence reaches `fenceValue`.
+        void FinishFrame(uint64_t fenceValue)
+        {
+            m_transientRing.FinishFrame(fenceValue);
+        }
+
+        // Frees a persistent descriptor, to be reused once the fence reaches `fenceValue`.
+        void FreePersistent(uint32_t index, uint64_t fenceValue)
+        {
+            m_retiredPersistent.emplace_back(fenceValue, index);
+        }
+
+        // Makes the descriptors whose fence values have been reached available again.
+        void Reclaim(uint64_t completedFenceValue)
+        {
+            while (!m_retiredPersistent.empty() && m_retiredPersistent.front().first <= completedFenceValue)
+            {
+                m_freePersistent.push_back(m_retiredPersistent.front().second);
+                m_retiredPersistent.pop_front();
+                --m_statistics.persistentInUse;
+            }
+            m_transientRing.Reclaim(completedFenceValue);
+        }
+
+        // Frees everything. Only for when the GPU is idle, or the heap is being replaced.
+        void Reset(uint32_t persistentCapacity, uint32_t transientCapacity)
+        {
+            m_freePersistent.clear();
+            m_persistentCapacity = persistentCapacity;
+            m_persistentHighWater = 0;
+            m_retiredPersistent.clear();
+            m_statistics.persistentInUse = 0;
+            m_transientRing.Reset(transientCapacity);
+        }
+
+        // accessors
+
+        uint32_t Capacity() const { return m_persistentCapacity + static_cast<uint32_t>(m_transientRing.Capacity()); }
+        uint32_t PersistentCapacity() const { return m_persistentCapacity; }
+        DescriptorAllocatorStatistics const& Statistics() const { return m_statistics; }
+        uint32_t TransientCapacity() const { return static_cast<uint32_t>(m_transientRing.Capacity()); }
+        uint32_t TransientInUse() const { return static_cast<uint32_t>(m_transientRing.UsedBytes()); }
+        uint32_t TransientPeak() const { return static_cast<uint32_t>(m_transientRing.PeakUsedBytes()); }
+    };
+}
@@ -13,78 +13,279 @@
 
 namespace DX
 {
-    DeviceResources::DeviceResources()
+    void DeviceResources::AcquireDirect2DTarget(Direct2DTarget const& target)
     {
-        DeviceIndependentSetup();
-    };
+        ::ID3D11Resource* pD3D11Resource{ target.pD3D11Resource.get() };
+        winrt::com_ptr<::ID2D1Multithread> const pD2D1Multithread{ m_pD2D1Factory3.as<::ID2D1Multithread>() };
+        pD2D1Multithread->Enter(); // See ReleaseDirect2DTarget.
+        m_pD3D11On12Device->AcquireWrappedResources(&pD3D11Resource, 1);
+        pD2D1Multithread->Leave();
+        m_pD2D1DeviceContext1->SetTarget(target.pD2D1Bitmap1.get());
+    }
+
+    // Returns a descriptor in the shared heap that stays allocated until FreePersistentDescriptor.
+    DescriptorHandle DeviceResources::AllocatePersistentDescriptor()
+    {
+        std::optional<uint32_t> index{ m_descriptorAllocator.AllocatePersistent() };
+        if (!index) winrt::throw_hresult(E_OUTOFMEMORY);
+        return Descriptor(*index);
+    }
 
-    ::ID3D11Resource* DeviceResources::AcquireWrappedRenderTarget()
+    // Returns `count` contiguous descriptors in the shared heap (for a descriptor table, say)
+    // that stay valid until the GPU has finished the current frame.
+    DescriptorHandle DeviceResources::AllocateTransientDescriptors(UINT count)
     {
-        // Acquire our wrapped render target resource for the current back buffer.
-        ::ID3D11Resource* pWrappedRenderTarget{ m_pD3D11WrappedRenderTargets[m_currentBufferIndex].get() };
-        m_pD3D11On12Device->AcquireWrappedResources(&pWrappedRenderTarget, 1);
+        std::optional<uint32_t> index{ m_descriptorAllocator.AllocateTransient(count) };
+        if (!index) winrt::throw_hresult(E_OUTOFMEMORY);
+        return Descriptor(*index);
+    }
 
-        // Set the Direct2D target bitmap as the current target.
-        m_pD2D1DeviceContext1->SetTarget(m_pD2D1TargetBitmap1s[m_currentBufferIndex].get());
+    // Returns upload memory that stays valid until the GPU has finished the current frame. It's
+    // sub-allocated from a ring that's shared by everything that renders; when the ring is full,
+    // it's replaced with one twice the size (and the old one is released once its frames are done).
+    UploadAllocation DeviceResources::AllocateUpload(UINT64 sizeInBytes, UINT64 alignment)
+    {
+        std::optional<uint64_t> offset{ m_uploadRing.Allocate(sizeInBytes, alignment) };
+        if (!offset)
+        {
+            UINT64 const minimumCapacity{ (sizeInBytes + alignment) * NumFramebuffers() };
+            UINT64 capacity{ std::max(m_uploadRing.Capacity(), s_initialUploadRingCapacity) * 2 };
+            while (capacity < minimumCapacity) capacity *= 2;
+            CreateUploadRing(capacity);
+            offset = m_uploadRing.Allocate(sizeInBytes, alignment);
+        }
+        return UploadAllocation{ m_pMappedUploadRing + *offset, m_d3d12UploadRing.pResource->GetGPUVirtualAddress() + *offset, m_d3d12UploadRing.pResource.get(), *offset };
+    }
 
-        return pWrappedRenderTarget;
+    // Timestamps the start of the current frame's Direct3D 12 work, for frame pacing.
+    void DeviceResources::BeginGpuFrame(::ID3D12GraphicsCommandList* pD3D12GraphicsCommandList) const
+    {
+        if (m_pGpuFrameTimer) m_pGpuFrameTimer->Begin(pD3D12GraphicsCommandList, CurrentFrameIndex());
     }
 
-    // Returns `true` if successful; returns `false` if device lost.
-    bool DeviceResources::CreateSwapChain()
+    // Creates the 11On12 device on the D3D12 device's direct queue, and the Direct2D device and
+    // context on that.
+    void DeviceResources::CreateD2DDevice()
+    {
+        TraceSpan const span{ m_trace, "DeviceResources::CreateD2DDevice" };
+
+        // Create an 11On12 device using the Direct3D 12 device and the command queue.
+
+        // D3D11_CREATE_DEVICE_BGRA_SUPPORT supports surfaces with a different color channel ordering
+        // than the API default. It's required for Direct2D interoperability with Direct3D resources.
+        // The device is single-threaded unless Direct2D is used from more than one thread.
+        uint32_t createDeviceFlags{ D3D11_CREATE_DEVICE_BGRA_SUPPORT };
+        if (!m_multithreadedDirect2D) createDeviceFlags |= D3D11_CREATE_DEVICE_SINGLETHREADED;
+
+#if defined (_DEBUG)
+        if (DX::SdkLayersAvailable())
+        {
+            // If the project is in a debug build, then enable debugging via SDK Layers with this flag.
+            createDeviceFlags |= D3D11_CREATE_DEVICE_DEBUG;
+        }
+#endif
+
+        winrt::com_ptr<::ID3D11Device> pD3D11Device;
+
+        ::IUnknown* pCommandQueues{ m_pD3D12CommandQueue.get() };
+        winrt::check_hresult(::D3D11On12CreateDevice(
+            m_pD3D12Device.get(),
+            createDeviceFlags,
+            nullptr,
+            0,
+            &pCommandQueues,
+            1,
+            0,
+            pD3D11Device.put(),
+            m_pD3D11DeviceContext.put(),
+            nullptr
+        ));
+        // Query the 11On12 device from the 11 device.
+        m_pD3D11On12Device = pD3D11Device.as<::ID3D11On12Device>();
+
+        // Create the Direct2D device object, and a corresponding context.
+        winrt::com_ptr<::IDXGIDevice> pDXGIDevice{ m_pD3D11On12Device.as<::IDXGIDevice>() };
+
+        winrt::check_hresult(
+            m_pD2D1Factory3->CreateDevice(pDXGIDevice.get(), m_pD2D1Device1.put())
+        );
+
+        winrt::check_hresult(
+            m_pD2D1Device1->CreateDeviceContext(
+                D2D1_DEVICE_CONTEXT_OPTIONS_NONE,
+                m_pD2D1DeviceContext1.put()
+            )
+        );
+    }
+
+    // Chooses the adapter, and creates the D3D12 device and its direct queue. The pipeline
+    // cache is read from disk here too, as it's good only for this device.
+    void DeviceResources::CreateDevice()
     {
-        if (m_pDXGISwapChain3 == nullptr)
+        TraceSpan const span{ m_trace, "DeviceResources::CreateDevice" };
+
+#if defined(_DEBUG)
+        // If the project is in a debug build, enable debugging via SDK Layers.
+        if (SUCCEEDED(::D3D12GetDebugInterface(__uuidof(m_pD3DDebugger), m_pD3DDebugger.put_void())))
         {
-            DXGI_SWAP_CHAIN_DESC1 swapChainDesc{};
-            swapChainDesc.Width = (UINT)m_d3dRenderTargetSize.cx; // Match the size of the window.
-            swapChainDesc.Height = (UINT)m_d3dRenderTargetSize.cy;
-            swapChainDesc.Format = m_rtvFormat;
-            swapChainDesc.Stereo = false;
-            swapChainDesc.SampleDesc.Count = 1; // Don't use multi-sampling (we're not allowed to with DXGI_SWAP_EFFECT_FLIP_*).
-            swapChainDesc.SampleDesc.Quality = 0;
-            swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-            swapChainDesc.BufferCount = NumFramebuffers(); // Use triple-buffering to minimize latency.
-            swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD; // a Direct3D 12 app must use DXGI_SWAP_EFFECT_FLIP_*.
-            swapChainDesc.Flags = 0;
-            swapChainDesc.Scaling = DXGI_SCALING_STRETCH;
-            swapChainDesc.AlphaMode = DXGI_ALPHA_MODE_IGNORE;
-
-            winrt::com_ptr<::IDXGISwapChain1> pDXGISwapChain1;
+            m_pD3DDebugger->EnableDebugLayer();
+        }
+#endif
+
+        winrt::check_hresult(::CreateDXGIFactory1(__uuidof(m_pDXGIFactory4), m_pDXGIFactory4.put_void()));
+
+        // Choose the adapter according to the policy. Adapters seen before (for example, when
+        // rebuilding after device loss) aren't queried again; see DeviceCapabilitiesCache.
+        D3D12AdapterList const adapters{ m_pDXGIFactory4.get(), m_adapterPolicy.preference, m_capabilitiesCache };
+        std::optional<size_t> const adapterIndex{ AdapterSelector::Select(adapters.Candidates(), m_adapterPolicy) };
+        if (!adapterIndex) winrt::throw_hresult(DXGI_ERROR_UNSUPPORTED);
+        m_adapter = adapters.Candidates()[*adapterIndex];
+        m_deviceCapabilities = adapters.Capabilities(*adapterIndex);
+
+        m_pD3D12Device = nullptr;
+        winrt::check_hresult(::D3D12CreateDevice(adapters.Adapter(*adapterIndex), D3D_FEATURE_LEVEL_11_0, __uuidof(m_pD3D12Device), m_pD3D12Device.put_void()));
+
+        // Cached pipelines are good only for the adapter and driver that made them. (An
+        // adapter's LUID changes from boot to boot, so it's identified by its description.)
+        StableHasher deviceHasher;
+        deviceHasher.Add(m_adapter.description.data(), m_adapter.description.size() * sizeof(wchar_t));
+        deviceHasher.Add(m_deviceCapabilities.driverVersion);
+        std::wstring const pipelineCachePath{ std::wstring{ winrt::ApplicationData::Current().LocalCacheFolder().Path() } + L"\\PipelineCache.bin" };
+        m_pPipelineCache = std::make_unique<D3D12PipelineCache>(m_pD3D12Device, deviceHasher.Hash(), pipelineCachePath);
+        m_pPipelineCompiler = std::make_unique<D3D12PipelineCompiler>();
+
+        // Describe and create the command queue.
+        D3D12_COMMAND_QUEUE_DESC commandQueueDesc{};
+        commandQueueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+        commandQueueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+
+        winrt::check_hresult(
+            m_pD3D12Device->CreateCommandQueue(
+                &commandQueueDesc,
+                _uuidof(m_pD3D12CommandQueue),
+                m_pD3D12CommandQueue.put_void())
+        );
+        m_pRenderCommandQueue = std::make_unique<D3D12RenderCommandQueue>(m_pD3D12CommandQueue);
+    }
+
+    // Creates what the frames need from the device: descriptor heaps, command allocators, the
+    // fence, the GPU timer, the shared heaps, and the upload paths.
+    void DeviceResources::CreateDeviceObjects()
+    {
+        TraceSpan const span{ m_trace, "DeviceResources::CreateDeviceObjects" };
+
+        // Create a descriptor heap for the render target view.
+        D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc{};
+        rtvHeapDesc.NumDescriptors = NumFramebuffers();
+        rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+        rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+
+        winrt::check_hresult(
+            m_pD3D12Device->CreateDescriptorHeap(
+                &rtvHeapDesc,
+                _uuidof(m_pD3D12RtvHeap),
+                m_pD3D12RtvHeap.put_void())
+        );
+
+        m_rtvDescriptorSize = m_pD3D12Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+
+        // Create the one shader-visible descriptor heap that every frame binds. Its first
+        // s_persistentDescriptorCount descriptors are long-lived; the rest are a ring of
+        // per-frame ones (see DescriptorAllocator).
+        D3D12_DESCRIPTOR_HEAP_DESC cbvSrvUavHeapDesc{};
+        cbvSrvUavHeapDesc.NumDescriptors = s_persistentDescriptorCount + s_transientDescriptorCount;
+        cbvSrvUavHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+        cbvSrvUavHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+
+        winrt::check_hresult(
+            m_pD3D12Device->CreateDescriptorHeap(
+                &cbvSrvUavHeapDesc,
+                _uuidof(m_pD3D12CbvSrvUavHeap),
+                m_pD3D12CbvSrvUavHeap.put_void())
+        );
+        m_cbvSrvUavDescriptorSize = m_pD3D12Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        m_descriptorAllocator.Reset(s_persistentDescriptorCount, s_transientDescriptorCount);
+
+        // Create a command allocator for each frame buffer.
+        for (UINT frameBufferIndex{ 0 }; frameBufferIndex < NumFramebuffers(); ++frameBufferIndex)
+        {
+            auto& pD3D12CommandAllocator{ m_pD3D12CommandAllocators[frameBufferIndex] };
             winrt::check_hresult(
-                m_pDXGIFactory4->CreateSwapChainForComposition(
-                    m_pD3D12CommandQueue.get(),
-                    &swapChainDesc,
-                    nullptr,
-                    pDXGISwapChain1.put()
-                )
+                m_pD3D12Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, __uuidof(pD3D12CommandAllocator), pD3D12CommandAllocator.put_void())
             );
-            m_pDXGISwapChain3 = pDXGISwapChain1.as<::IDXGISwapChain3>();
+        }
+
+        // Command lists declare the states that they need their resources in, and are submitted through the tracker.
+        m_pResourceStateTracker = std::make_unique<D3D12ResourceStateTracker>(m_pD3D12Device.get(), m_pD3D12CommandAllocators[0].get());
+
+        // Create synchronization objects.
+        winrt::check_hresult(m_pD3D12Device->CreateFence(m_frameSynchronizer.BeginFenceTimeline(), D3D12_FENCE_FLAG_NONE, _uuidof(m_pD3D12Fence), m_pD3D12Fence.put_void()));
+        m_pRenderFence = std::make_unique<D3D12RenderFence>(m_pD3D12Fence);
+
+        m_pGpuFrameTimer = std::make_unique<GpuFrameTimer>(m_pD3D12Device.get(), m_pD3D12CommandQueue.get(), NumFramebuffers());
+
+        // Buffers and textures that come and go (the upload ring, the frame graph's transients,
+        // and the like) are placed in shared heaps, rather than each being committed in a heap of its own.
+        m_pPlacedResourceAllocator = std::make_unique<PlacedResourceAllocator>(m_pD3D12Device, s_placedResourceHeapSize);
+        m_pTransientResources = std::make_unique<D3D12TransientResources>(*this);
+
+        CreateUploadRing(s_initialUploadRingCapacity);
+
+        // Assets are uploaded on a copy queue of their own, so that uploading them doesn't hold up rendering.
+        m_pCopyUploadQueue = std::make_unique<CopyUploadQueue>(m_pD3D12Device, s_copyQueueStagingCapacity);
+    }
+
+    // Creates a new swap chain, rather than resizing the old one, because IDXGISwapChain::ResizeBuffers
+    // requires that the GPU has finished with all of the old buffers. The old swap chain and its
+    // buffers are released (by ReleaseSwapChain) once the frames in flight have completed.
+    // Returns `true` if successful; returns `false` if device lost.
+    bool DeviceResources::CreateSwapChain()
+    {
+        TraceSpan const span{ m_trace, "DeviceResources::CreateSwapChain" };
+
+        DXGI_SWAP_CHAIN_DESC1 swapChainDesc{};
+        swapChainDesc.Width = (UINT)m_d3dRenderTargetSize.cx; // Match the size of the window.
+        swapChainDesc.Height = (UINT)m_d3dRenderTargetSize.cy;
+        swapChainDesc.Format = m_rtvFormat;
+        swapChainDesc.Stereo = false;
+        swapChainDesc.SampleDesc.Count = 1; // Don't use multi-sampling (we're not allowed to with DXGI_SWAP_EFFECT_FLIP_*).
+        swapChainDesc.SampleDesc.Quality = 0;
+        swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+        swapChainDesc.BufferCount = NumFramebuffers(); // Two to four, according to the frame latency settings.
+        swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD; // a Direct3D 12 app must use DXGI_SWAP_EFFECT_FLIP_*.
+        swapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT; // See WaitForNextFrame.
+        swapChainDesc.Scaling = DXGI_SCALING_STRETCH;
+        swapChainDesc.AlphaMode = DXGI_ALPHA_MODE_IGNORE;
+
+        winrt::com_ptr<::IDXGISwapChain1> pDXGISwapChain1;
+        HRESULT hr{ m_pDXGIFactory4->CreateSwapChainForComposition(
+            m_pD3D12CommandQueue.get(),
+            &swapChainDesc,
+            nullptr,
+            pDXGISwapChain1.put()
+        ) };
+
+        if (hr == DXGI_ERROR_DEVICE_REMOVED)
+        {
+            hr = m_pD3D12Device->GetDeviceRemovedReason();
+            return false;
+        }
+        else if (hr == DXGI_ERROR_DEVICE_RESET)
+        {
+            return false;
         }
         else
         {
-            HRESULT hr{ m_pDXGISwapChain3->ResizeBuffers(
-                0, // 0 preserves the existing number of buffers in the swap chain.
-                (UINT)m_d3dRenderTargetSize.cx, // Match the size of the window.
-                (UINT)m_d3dRenderTargetSize.cy,
-                DXGI_FORMAT_UNKNOWN, // DXGI_FORMAT_UNKNOWN preserves the existing format of the back buffer.
-                0
-            ) };
-
-            if (hr == DXGI_ERROR_DEVICE_REMOVED)
-            {
-                hr = m_pD3D12Device->GetDeviceRemovedReason();
-                return false;
-            }
-            else if (hr == DXGI_ERROR_DEVICE_RESET)
-            {
-                return false;
-            }
-            else
-            {
-                winrt::check_hresult(hr);
-            }
+            winrt::check_hresult(hr);
         }
 
+        m_pDXGISwapChain3 = pDXGISwapChain1.as<::IDXGISwapChain3>();
+        m_pRenderSwapChain = std::make_unique<D3D12RenderSwapChain>(m_pDXGISwapChain3, m_pD3D12Device, m_frameLatencySettings.maximumFrameLatency);
+        // Present counts start again with the new swap chain.
+        m_framePacer.Reset();
+        m_latencyMeter.Reset();
+        m_swapChainDpi = m_dpi;
+
         // When the user sets the dpi higher than 96, the CompositionScaleX and
         // CompositionScaleY properties of the SwapChainPanel are set to a value
         // higher than 1. That doesn't affect the layout size of the SwapChainPanel,
@@ -102,16 +303,11 @@ namespace DX
             pDXGISwapChain2->SetMatrixTransform(&inverseScale)
         );
 
-        // Create one render target view of the swap chain back buffer for each frame buffer.
-        m_currentBufferIndex = m_pDXGISwapChain3->GetCurrentBackBufferIndex();
+        // The new swap chain's current buffer index needn't match the old one's.
+        m_frameSynchronizer.SwitchToBuffer(*m_pRenderFence, m_pRenderSwapChain->CurrentBackBufferIndex());
 
-        D2D1_BITMAP_PROPERTIES1 bitmapProperties{
-            D2D1::BitmapProperties1(
-                D2D1_BITMAP_OPTIONS_TARGET | D2D1_BITMAP_OPTIONS_CANNOT_DRAW,
-                D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED),
-                m_dpi.x,
-                m_dpi.y
-            ) };
+        // Create one render target view of the swap chain back buffer for each frame buffer.
+        // (Direct2D doesn't draw into them; it draws into an overlay layer, which is composited.)
 
         CD3DX12_CPU_DESCRIPTOR_HANDLE rtvDescriptorHandle(m_pD3D12RtvHeap->GetCPUDescriptorHandleForHeapStart());
         CD3DX12_CPU_DESCRIPTOR_HANDLE rtvDescriptorHandleForOffset{ rtvDescriptorHandle };
@@ -121,6 +317,7 @@ namespace DX
             winrt::check_hresult(
                 m_pDXGISwapChain3->GetBuffer(frameBufferIndex, __uuidof(m_pD3D12RenderTargets[frameBufferIndex]), m_pD3D12RenderTargets[frameBufferIndex].put_void())
             );
+            m_pResourceStateTracker->Register(m_pD3D12RenderTargets[frameBufferIndex].get(), D3D12_RESOURCE_STATE_PRESENT);
 
             m_pD3D12Device->CreateRenderTargetView(
                 m_pD3D12RenderTargets[frameBufferIndex].get(),
@@ -129,69 +326,9 @@ namespace DX
             );
             rtvDescriptorHandleForOffset.Offset(m_rtvDescriptorSize);
 
-            // Create a wrapped 11On12 resource of this back buffer. Since we're rendering
-            // all Direct3D 12 content first, and then all Direct2D content, we specify
-            // the In resource state as RENDER_TARGET (because Direct3D 12 will have last
-            // used it in that state) and the Out resource state as PRESENT. When
-            // ReleaseWrappedResources is called on the 11On12 device, the resource
-            // transitions to the PRESENT state.
-            D3D11_RESOURCE_FLAGS d3d11ResourceFlags{ D3D11_BIND_RENDER_TARGET };
-            winrt::check_hresult(m_pD3D11On12Device->CreateWrappedResource(
-                m_pD3D12RenderTargets[frameBufferIndex].get(),
-                &d3d11ResourceFlags,
-                D3D12_RESOURCE_STATE_RENDER_TARGET,
-                D3D12_RESOURCE_STATE_PRESENT,
-                __uuidof(m_pD3D11WrappedRenderTargets[frameBufferIndex]),
-                m_pD3D11WrappedRenderTargets[frameBufferIndex].put_void()
-            ));
-
-            // Create a render target for Direct2D to draw directly to this back buffer.
-            auto pDXGISurface{ m_pD3D11WrappedRenderTargets[frameBufferIndex].as<::IDXGISurface>() };
-            winrt::check_hresult(
-                m_pD2D1DeviceContext1->CreateBitmapFromDxgiSurface(
-                    pDXGISurface.get(),
-                    &bitmapProperties,
-                    m_pD2D1TargetBitmap1s[frameBufferIndex].put()
-                )
-            );
-
             m_d3d12RenderTargetViews[frameBufferIndex] = CD3DX12_CPU_DESCRIPTOR_HANDLE(rtvDescriptorHandle, frameBufferIndex, m_rtvDescriptorSize);
         }
 
-        // Create a depth stencil and view.
-        {
-            D3D12_HEAP_PROPERTIES depthHeapProperties{ CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT) };
-
-            D3D12_RESOURCE_DESC depthResourceDesc{ CD3DX12_RESOURCE_DESC::Tex2D(
-                m_dsvFormat,
-                (UINT)m_d3dRenderTargetSize.cx,
-                (UINT)m_d3dRenderTargetSize.cy,
-                1,
-                1) };
-            depthResourceDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
-
-            CD3DX12_CLEAR_VALUE depthOptimizedClearValue{ m_dsvFormat, 1.f, 0 };
-
-            m_pD3D12DepthStencil = nullptr; // Clear before calling `put_void` again.
-
-            winrt::check_hresult(m_pD3D12Device->CreateCommittedResource(
-                &depthHeapProperties,
-                D3D12_HEAP_FLAG_NONE,
-                &depthResourceDesc,
-                D3D12_RESOURCE_STATE_DEPTH_WRITE,
-                &depthOptimizedClearValue,
-                __uuidof(m_pD3D12DepthStencil),
-                m_pD3D12DepthStencil.put_void()
-            ));
-
-            D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc{};
-            dsvDesc.Format = m_dsvFormat;
-            dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
-            dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
-
-            m_pD3D12Device->CreateDepthStencilView(m_pD3D12DepthStencil.get(), &dsvDesc, m_d3d12DepthStencilView);
-        }
-
         // Set the 3D rendering viewport and scissor rect to target the entire window.
         m_d3d12Viewport = {
             0.f,
@@ -212,21 +349,94 @@ namespace DX
         return true;
     }
 
+    PlacedHeapRange DeviceResources::AllocatePlacedRange(D3D12_HEAP_TYPE heapType, PlacedResourceClass resourceClass, UINT64 sizeInBytes)
+    {
+        return m_pPlacedResourceAllocator->AllocateRange(heapType, resourceClass, sizeInBytes);
+    }
+
+    // The wrapped resource's In and Out states are the same, so that whatever uses the texture
+    // outside Direct2D's drawing finds it as it left it.
+    Direct2DTarget DeviceResources::CreateDirect2DTarget(::ID3D12Resource* pD3D12Resource, D3D12_RESOURCE_STATES state)
+    {
+        Direct2DTarget target{ nullptr, nullptr, pD3D12Resource, state };
+        D3D11_RESOURCE_FLAGS d3d11ResourceFlags{ D3D11_BIND_RENDER_TARGET };
+        winrt::check_hresult(m_pD3D11On12Device->CreateWrappedResource(
+            pD3D12Resource,
+            &d3d11ResourceFlags,
+            state,
+            state,
+            __uuidof(target.pD3D11Resource),
+            target.pD3D11Resource.put_void()
+        ));
+
+        D2D1_BITMAP_PROPERTIES1 bitmapProperties{
+            D2D1::BitmapProperties1(
+                D2D1_BITMAP_OPTIONS_TARGET | D2D1_BITMAP_OPTIONS_CANNOT_DRAW,
+                D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED),
+                m_dpi.x,
+                m_dpi.y
+            ) };
+        auto pDXGISurface{ target.pD3D11Resource.as<::IDXGISurface>() };
+        winrt::check_hresult(
+            m_pD2D1DeviceContext1->CreateBitmapFromDxgiSurface(
+                pDXGISurface.get(),
+                &bitmapProperties,
+                target.pD2D1Bitmap1.put()
+            )
+        );
+        return target;
+    }
+
+    PlacedResource DeviceResources::CreatePlacedResource(D3D12_HEAP_TYPE heapType, D3D12_RESOURCE_DESC const& resourceDesc, D3D12_RESOURCE_STATES initialState, D3D12_CLEAR_VALUE const* pOptimizedClearValue)
+    {
+        PlacedResource resource{ m_pPlacedResourceAllocator->CreateResource(heapType, resourceDesc, initialState, pOptimizedClearValue) };
+        m_pResourceStateTracker->Register(resource.pResource.get(), initialState);
+        return resource;
+    }
+
+    // The frames in flight may still be using the swap chain's buffers, so they're released once
+    // those frames have completed. (The depth buffer is the frame graph's; see D3D12TransientResources.)
     void DeviceResources::ReleaseSwapChain()
     {
-        m_pD3D12DepthStencil = nullptr;
-        for (UINT frameBufferIndex{ 0 }; frameBufferIndex < NumFramebuffers(); ++frameBufferIndex)
+        for (UINT frameBufferIndex{ 0 }; frameBufferIndex < s_maxNumFramebuffers; ++frameBufferIndex)
         {
-            m_pD2D1TargetBitmap1s[frameBufferIndex] = nullptr;
-            m_pD3D11WrappedRenderTargets[frameBufferIndex] = nullptr;
-            m_pD3D12RenderTargets[frameBufferIndex] = nullptr;
+            if (m_pResourceStateTracker) m_pResourceStateTracker->Unregister(m_pD3D12RenderTargets[frameBufferIndex].get());
+            DeferRelease(m_pD3D12RenderTargets[frameBufferIndex]);
         }
-        m_pDXGISwapChain3 = nullptr;
+        m_pRenderSwapChain = nullptr;
+        DeferRelease(m_pDXGISwapChain3);
+    }
+
+    // Replaces the upload ring with an empty one. The old one's memory may still be in use by
+    // frames in flight, so it's handed to DeferRelease, and stays mapped until it's released.
+    void DeviceResources::CreateUploadRing(UINT64 capacity)
+    {
+        FreePlacedResource(m_d3d12UploadRing);
+
+        D3D12_RESOURCE_DESC uploadRingDesc{ CD3DX12_RESOURCE_DESC::Buffer(capacity) };
+        m_d3d12UploadRing = CreatePlacedResource(D3D12_HEAP_TYPE_UPLOAD, uploadRingDesc, D3D12_RESOURCE_STATE_GENERIC_READ);
+
+        // It stays mapped for its lifetime. We don't intend to read it on the CPU, and the ring
+        // never hands out memory that hasn't been written, so it needn't be cleared either.
+        D3D12_RANGE readRange{ CD3DX12_RANGE(0, 0) };
+        winrt::check_hresult(m_d3d12UploadRing.pResource->Map(0, &readRange, reinterpret_cast<void**>(&m_pMappedUploadRing)));
+        m_uploadRing.Reset(capacity);
     }
 
-    // Performs setup work that doesn't depend on the Direct3D device.
+    DescriptorHandle DeviceResources::Descriptor(uint32_t index) const
+    {
+        return DescriptorHandle{
+            CD3DX12_CPU_DESCRIPTOR_HANDLE(m_pD3D12CbvSrvUavHeap->GetCPUDescriptorHandleForHeapStart(), static_cast<INT>(index), m_cbvSrvUavDescriptorSize),
+            CD3DX12_GPU_DESCRIPTOR_HANDLE(m_pD3D12CbvSrvUavHeap->GetGPUDescriptorHandleForHeapStart(), static_cast<INT>(index), m_cbvSrvUavDescriptorSize),
+            index };
+    }
+
+    // Creates the Direct2D factory, which outlives the device. The DirectWrite and WIC factories
+    // are created on first use (see IDWriteFactory2 and IWICImagingFactory2), as not every run needs them.
     void DeviceResources::DeviceIndependentSetup()
     {
+        TraceSpan const span{ m_trace, "DeviceResources::DeviceIndependentSetup" };
+
         // Initialize Direct2D resources.
         D2D1_FACTORY_OPTIONS d2d1FactoryOptions{ D2D1_DEBUG_LEVEL_NONE };
 
@@ -238,32 +448,12 @@ namespace DX
         // Initialize the Direct2D Factory.
         winrt::check_hresult(
             ::D2D1CreateFactory(
-                D2D1_FACTORY_TYPE_SINGLE_THREADED,
+                m_multithreadedDirect2D ? D2D1_FACTORY_TYPE_MULTI_THREADED : D2D1_FACTORY_TYPE_SINGLE_THREADED,
                 __uuidof(m_pD2D1Factory3),
                 &d2d1FactoryOptions,
                 m_pD2D1Factory3.put_void()
             )
         );
-
-        // Initialize the DirectWrite Factory.
-        winrt::check_hresult(
-            ::DWriteCreateFactory(
-                DWRITE_FACTORY_TYPE_SHARED,
-                __uuidof(m_pDWriteFactory2),
-                reinterpret_cast<::IUnknown**>(m_pDWriteFactory2.put())
-            )
-        );
-
-        // Initialize the Windows Imaging Component (WIC) factory.
-        winrt::check_hresult(
-            ::CoCreateInstance(
-                CLSID_WICImagingFactory2,
-                nullptr,
-                CLSCTX_INPROC_SERVER,
-                __uuidof(m_pWICImagingFactory2),
-                m_pWICImagingFactory2.put_void()
-            )
-        );
     }
 
     // Gets and sets dpi; stores output size.
@@ -280,30 +470,122 @@ namespace DX
         }
     }
 
+    // Timestamps the end of the current frame's Direct3D 12 work. Direct2D's work on the
+    // frame comes after this, so it isn't included.
+    void DeviceResources::EndGpuFrame(::ID3D12GraphicsCommandList* pD3D12GraphicsCommandList) const
+    {
+        if (m_pGpuFrameTimer) m_pGpuFrameTimer->End(pD3D12GraphicsCommandList, CurrentFrameIndex());
+    }
+
+    // The descriptor is reused once the GPU has finished the current frame.
+    void DeviceResources::FreePersistentDescriptor(DescriptorHandle const& descriptor)
+    {
+        m_descriptorAllocator.FreePersistent(descriptor.index, m_frameSynchronizer.CurrentFenceValue());
+    }
+
+    // The range is reused once the GPU has finished the current frame.
+    void DeviceResources::FreePlacedRange(PlacedHeapRange& range)
+    {
+        m_pPlacedResourceAllocator->Free(range, m_frameSynchronizer.CurrentFenceValue());
+        range = PlacedHeapRange{};
+    }
+
+    // Releases the resource, and frees its range of its heap, once the GPU has finished the current frame.
+    void DeviceResources::FreePlacedResource(PlacedResource& resource)
+    {
+        if (!resource.pResource) return;
+        if (m_pResourceStateTracker) m_pResourceStateTracker->Unregister(resource.pResource.get());
+        m_pPlacedResourceAllocator->Free(resource, m_frameSynchronizer.CurrentFenceValue());
+        DeferRelease(resource.pResource);
+    }
+
+    void DeviceResources::FrameLatency(FrameLatencySettings const& frameLatencySettings)
+    {
+        m_frameLatencySettings = frameLatencySettings.Clamped();
+        m_frameSynchronizer = FrameSynchronizer{ m_frameLatencySettings.numFramebuffers };
+    }
+
+    ::IDWriteFactory2* DeviceResources::IDWriteFactory2() const
+    {
+        std::call_once(m_dwriteFactoryCreated, [this]
+            {
+                TraceSpan const span{ m_trace, "DeviceResources::IDWriteFactory2" };
+                winrt::check_hresult(
+                    ::DWriteCreateFactory(
+                        DWRITE_FACTORY_TYPE_SHARED,
+                        __uuidof(m_pDWriteFactory2),
+                        reinterpret_cast<::IUnknown**>(m_pDWriteFactory2.put())
+                    )
+                );
+            });
+        return m_pDWriteFactory2.get();
+    }
+
+    // The calling thread must be in an apartment; a thread that hasn't joined one (such as a
+    // startup task's) is in the process's multithreaded apartment, which the render thread, from
+    // the thread pool, keeps in being.
+    ::IWICImagingFactory2* DeviceResources::IWICImagingFactory2() const
+    {
+        std::call_once(m_wicFactoryCreated, [this]
+            {
+                TraceSpan const span{ m_trace, "DeviceResources::IWICImagingFactory2" };
+                winrt::check_hresult(
+                    ::CoCreateInstance(
+                        CLSID_WICImagingFactory2,
+                        nullptr,
+                        CLSCTX_INPROC_SERVER,
+                        __uuidof(m_pWICImagingFactory2),
+                        m_pWICImagingFactory2.put_void()
+                    )
+                );
+            });
+        return m_pWICImagingFactory2.get();
+    }
+
+    // The render loop slept for `nanoseconds` rather than render frames that would have shown nothing new.
+    void DeviceResources::Idled(uint64_t nanoseconds)
+    {
+        m_renderLoopStatistics.Idled(nanoseconds, m_framePacer.RefreshPeriodNanoseconds());
+    }
+
     // Prepare to render the next frame.
     void DeviceResources::MoveToNextFrame()
     {
-        // Put a signal on the queue for the old current frame's fence value.
-        UINT64 const& fenceValueForOldCurrentBuffer{ m_fenceValues[m_currentBufferIndex] };
-        winrt::check_hresult(m_pD3D12CommandQueue->Signal(m_pD3D12Fence.get(), fenceValueForOldCurrentBuffer));
+        // The upload memory and transient descriptors allocated for the old current frame are free once its fence value is reached.
+        m_descriptorAllocator.FinishFrame(m_frameSynchronizer.CurrentFenceValue());
+        m_uploadRing.FinishFrame(m_frameSynchronizer.CurrentFenceValue());
 
-        // From here on, "current" means "new current".
-        m_currentBufferIndex = m_pDXGISwapChain3->GetCurrentBackBufferIndex();
-        UINT64& fenceValueForNewCurrentBuffer{ m_fenceValues[m_currentBufferIndex] };
+        // Signal the old current frame's fence value, then wait (if necessary) until the
+        // new current frame's buffer is no longer in use by the GPU.
+        m_frameSynchronizer.MoveToNextFrame(*m_pRenderCommandQueue, *m_pRenderFence, m_pRenderSwapChain->CurrentBackBufferIndex());
 
-        // If the fence values of all the frames are still queued, then wait for the
-        // oldest frame to become free (the value of fenceValueForNewCurrentBuffer
-        // represents that oldest value, since we haven't updated that value yet).
-        if (m_pD3D12Fence->GetCompletedValue() < fenceValueForNewCurrentBuffer)
+        // The GPU has finished the new current buffer's previous frame, so its GPU time can be read.
+        uint64_t gpuFrameNanoseconds{ 0 };
+        if (m_pGpuFrameTimer && m_pGpuFrameTimer->TryGetNanoseconds(CurrentFrameIndex(), gpuFrameNanoseconds))
         {
-            // Tell the fence what event to signal when that oldest value is reached.
-            winrt::check_hresult(m_pD3D12Fence->SetEventOnCompletion(fenceValueForNewCurrentBuffer, m_fenceEventHandle.get()));
-            // Wait for the event.
-            WaitForSingleObjectEx(m_fenceEventHandle.get(), INFINITE, FALSE);
+            m_framePacer.GpuFrameMeasured(gpuFrameNanoseconds);
+            m_renderLoopStatistics.GpuFrameMeasured(gpuFrameNanoseconds);
         }
 
-        // Set the fence value for the "new current" frame (which we'll signal the next time through this function).
-        fenceValueForNewCurrentBuffer = fenceValueForOldCurrentBuffer + 1;
+        // Release whatever the GPU has now finished with.
+        m_deferredReleaseQueue.ReleaseCompleted(m_pRenderFence->CompletedValue());
+        m_descriptorAllocator.Reclaim(m_pRenderFence->CompletedValue());
+        m_uploadRing.Reclaim(m_pRenderFence->CompletedValue());
+        m_pPlacedResourceAllocator->Reclaim(m_pRenderFence->CompletedValue());
+        m_pCopyUploadQueue->Reclaim();
+    }
+
+    // Returns `true` while nothing that's presented would be seen: the window is minimized, or
+    // the last present reported the swap chain occluded. In the latter case, this tests (with
+    // DXGI_PRESENT_TEST, which presents nothing) whether it still is.
+    bool DeviceResources::Occluded()
+    {
+        if (m_hWnd && ::IsIconic(m_hWnd)) return true;
+        if (m_occluded && m_pDXGISwapChain3)
+        {
+            m_occluded = m_pDXGISwapChain3->Present(0, DXGI_PRESENT_TEST) == DXGI_STATUS_OCCLUDED;
+        }
+        return m_occluded;
     }
 
     // Takes and stores an output size in either DIPs or raw pixels.
@@ -333,50 +615,66 @@ namespace DX
     // Returns `true` if successful; returns `false` if device lost.
     bool DeviceResources::Present()
     {
-        DXGI_PRESENT_PARAMETERS parameters{};
-        parameters.DirtyRectsCount = 0;
-        parameters.pDirtyRects = nullptr;
-        parameters.pScrollRect = nullptr;
-        parameters.pScrollOffset = nullptr;
-
-        // The first argument instructs DXGI to block until vertical sync, putting the application
+        // A sync interval of 1 instructs DXGI to block until vertical sync, putting the application
         // to sleep until the next vertical sync. This ensures that we don't waste any cycles rendering
         // frames that will never be displayed to the screen.
-        HRESULT hr{ m_pDXGISwapChain3->Present1(1, 0, &parameters) };
+        RenderPresentResult const result{ m_pRenderSwapChain->Present(1) };
+        bool deviceLost{ result == RenderPresentResult::DeviceLost };
 
-        // If the device was removed either by a disconnection or a driver upgrade, we 
-        // must recreate all device resources.
-        bool deviceLost{ false };
-        if (hr == DXGI_ERROR_DEVICE_REMOVED)
-        {
-            deviceLost = true;
-            hr = m_pD3D12Device->GetDeviceRemovedReason();
-        }
-        else if (hr == DXGI_ERROR_DEVICE_RESET)
-        {
-            deviceLost = true;
-        }
-        else
+        // While the swap chain is occluded, the render loop stops presenting (see Occluded).
+        m_occluded = result == RenderPresentResult::Occluded;
+
+        if (!deviceLost)
         {
-            winrt::check_hresult(hr);
+            // The display time of this frame isn't known yet; that of an earlier frame may be.
+            uint64_t const presentCount{ m_pRenderSwapChain->PresentCount() };
+            uint64_t const cpuFrameNanoseconds{ QpcNowNanoseconds() - m_frameStartNanoseconds };
+            m_framePacer.FramePresented(presentCount, cpuFrameNanoseconds);
+            m_renderLoopStatistics.FrameRendered(cpuFrameNanoseconds);
+            m_latencyMeter.FramePresented(presentCount, m_frameStartNanoseconds);
+            RenderDisplayedFrame displayedFrame;
+            if (m_pRenderSwapChain->TryGetLastDisplayedFrame(displayedFrame))
+            {
+                m_framePacer.FrameDisplayed(displayedFrame.presentCount, displayedFrame.displayNanoseconds);
+                m_latencyMeter.FrameDisplayed(displayedFrame.presentCount, displayedFrame.displayNanoseconds);
+            }
         }
 
         MoveToNextFrame();
         return !deviceLost;
     }
 
-    // Returns `true` if successful; returns `false` if device lost.
-    bool DeviceResources::ReleaseWrappedRenderTargetAndPresent(::ID3D11Resource* pWrappedRenderTargets)
+    void DeviceResources::ReleaseDirect2DTarget(Direct2DTarget const& target)
     {
-        // Release our wrapped render target resource. The act of releasing causes
-        // the back buffer resource to transition to PRESENT, which is the state we
-        // specified as the Out resource state when we created the wrapped resource.
-        m_pD3D11On12Device->ReleaseWrappedResources(&pWrappedRenderTargets, 1);
+        // Releasing the wrapped resource leaves the texture in its Out state. That's outside the
+        // lists that the state tracker resolves, so it's told.
+        m_pD2D1DeviceContext1->SetTarget(nullptr);
+        ::ID3D11Resource* pD3D11Resource{ target.pD3D11Resource.get() };
+
+        // A multithreaded Direct2D factory uses the Direct3D 11 device under its own lock, so
+        // this takes it too (for a single-threaded factory, Enter and Leave do nothing).
+        winrt::com_ptr<::ID2D1Multithread> const pD2D1Multithread{ m_pD2D1Factory3.as<::ID2D1Multithread>() };
+        pD2D1Multithread->Enter();
+        m_pD3D11On12Device->ReleaseWrappedResources(&pD3D11Resource, 1);
 
         // Flush to submit the Direct3D 11 command list to the shared command queue.
         m_pD3D11DeviceContext->Flush();
+        pD2D1Multithread->Leave();
+        m_pResourceStateTracker->Assume(target.pD3D12Resource, target.state);
+    }
 
-        return Present();
+    // Writes the trace (see TraceRecorder) to Trace.json in the app's local cache folder, for
+    // chrome://tracing or Perfetto to open.
+    void DeviceResources::SaveTrace() const
+    {
+        std::string const json{ m_trace.ToChromeJson() };
+        std::wstring const path{ std::wstring{ winrt::ApplicationData::Current().LocalCacheFolder().Path() } + L"\\Trace.json" };
+        std::wstring const temporaryPath{ path + L".tmp" };
+        {
+            std::ofstream file{ temporaryPath, std::ios::binary | std::ios::trunc };
+            if (!file.write(json.data(), static_cast<std::streamsize>(json.size()))) return;
+        }
+        ::MoveFileExW(temporaryPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING);
     }
 
     // The XAML SwapChainPanel is the UI element through which the swap chain's
@@ -392,6 +690,26 @@ namespace DX
         );
     }
 
+    // Sleeps until the given QueryPerformanceCounter time, with a high-resolution timer where
+    // there is one (the default timer resolution, 15.6ms, is no good for pacing frames).
+    void DeviceResources::SleepUntil(uint64_t qpcNanoseconds)
+    {
+        uint64_t const nowNanoseconds{ QpcNowNanoseconds() };
+        if (qpcNanoseconds <= nowNanoseconds) return;
+
+        if (!m_pacingTimer)
+        {
+            m_pacingTimer.attach(::CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS));
+            if (!m_pacingTimer) m_pacingTimer.attach(::CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS));
+            winrt::check_bool(bool{ m_pacingTimer });
+        }
+
+        LARGE_INTEGER dueTime{};
+        dueTime.QuadPart = -static_cast<LONGLONG>((qpcNanoseconds - nowNanoseconds) / 100); // Relative, in 100ns units.
+        winrt::check_bool(::SetWaitableTimerEx(m_pacingTimer.get(), &dueTime, 0, nullptr, nullptr, nullptr, 0));
+        ::WaitForSingleObjectEx(m_pacingTimer.get(), INFINITE, FALSE);
+    }
+
     // Takes and stores the window object, its HWND, and the swap chain panel.
     void DeviceResources::SetWindowAndSwapChainPanel(winrt::Window const& window, HWND hWnd, winrt::SwapChainPanel const& swapChainPanel)
     {
@@ -414,25 +732,33 @@ namespace DX
     // Wait for the GPU to drain its work queue.
     void DeviceResources::WaitForGpu() const
     {
-        // This function is called in two situations. The first, and simplest, situation is when uploading geometry to
-        // the GPU (Sample3DSceneRenderer::WindowIndependentSetup). In that case, we use the current buffer's frame value
-        // as a signal value, and then wait for the GPU to reach that signal. That way we know that the GPU has done all
-        // the work we've asked it to do up to that point in time.
-        // The other situation is when the window size changes (DeviceResources::WindowDependentSetup).
-        // In that case, there's cleanup work to do after calling WaitForGpu(). See comments in DeviceResources::WindowDependentSetup.
-        UINT64 const& fenceValueForCurrentBuffer{ m_fenceValues[m_currentBufferIndex] };
+        // We use the current buffer's frame value as a signal value, and then wait for the GPU to reach that
+        // signal. That way we know that the GPU has done all the work we've asked it to do up to that point in
+        // time. The render loop doesn't need to do this; resources that the GPU may still be using are handed
+        // to DeferRelease instead.
+        m_frameSynchronizer.WaitForGpu(*m_pRenderCommandQueue, *m_pRenderFence);
+    }
+
+    // Wait until the swap chain can take another frame, before the frame samples its input and
+    // starts recording. Waiting here, rather than inside Present, means that the frame's input is
+    // as recent as it can be when the frame is displayed.
+    void DeviceResources::WaitForNextFrame()
+    {
+        if (m_pRenderSwapChain) m_pRenderSwapChain->WaitForFrameLatency();
 
-        // Put a signal on the queue for the current buffer's fence value.
-        winrt::check_hresult(m_pD3D12CommandQueue->Signal(m_pD3D12Fence.get(), fenceValueForCurrentBuffer));
-        // Tell the fence what event to signal when that value is reached.
-        winrt::check_hresult(m_pD3D12Fence->SetEventOnCompletion(fenceValueForCurrentBuffer, m_fenceEventHandle.get()));
-        // Wait for the event.
-        ::WaitForSingleObjectEx(m_fenceEventHandle.get(), INFINITE, FALSE);
+        // Then wait until the frame is predicted to finish just before its vblank.
+        if (m_frameLatencySettings.framePacing)
+        {
+            SleepUntil(m_framePacer.PlanFrame(QpcNowNanoseconds()));
+        }
+        m_frameStartNanoseconds = QpcNowNanoseconds();
     }
 
     // Release window-dependent resources.
     void DeviceResources::WindowDependentReset()
     {
+        TraceSpan const span{ m_trace, "DeviceResources::WindowDependentReset" };
+
         ReleaseSwapChain();
 
         m_pD2D1DeviceContext1->SetTarget(nullptr);
@@ -443,31 +769,24 @@ namespace DX
     // Returns `true` if successful; returns `false` if device lost.
     bool DeviceResources::WindowDependentSetup()
     {
-        // Clear the previous window-size-dependent content.
-        m_pD2D1DeviceContext1->SetTarget(nullptr);
-        for (UINT frameBufferIndex = 0; frameBufferIndex < NumFramebuffers(); ++frameBufferIndex)
-        {
-            m_pD2D1TargetBitmap1s[frameBufferIndex] = nullptr;
-            m_pD3D11WrappedRenderTargets[frameBufferIndex] = nullptr;
-            m_pD3D12RenderTargets[frameBufferIndex] = nullptr;
-        }
-        m_pD3D11DeviceContext->Flush();
+        TraceSpan const span{ m_trace, "DeviceResources::WindowDependentSetup" };
 
-        // We wait for the GPU to complete all the work we've asked it to do. That's done by using the
-        // current buffer's frame value as a signal value, and then waiting for the GPU to reach that signal.
-        // After that, we increment that fence value and set all the fence values in the array to that.
-        // This gives us a clean slate of fence values that haven't yet been signaled.
-        WaitForGpu();
-        UINT64& fenceValueForCurrentBuffer{ m_fenceValues[m_currentBufferIndex] };
-        ++fenceValueForCurrentBuffer;
+        if (m_outputSizeInRawPixels.x == 0 || m_outputSizeInRawPixels.y == 0) return true;
 
-        // Update the tracked fence values.
-        for (UINT frameBufferIndex = 0; frameBufferIndex < NumFramebuffers(); ++frameBufferIndex)
+        // If neither the size in pixels nor the dpi has changed, then the swap chain can stay as it is.
+        if (m_pDXGISwapChain3 &&
+            m_d3dRenderTargetSize.cx == (LONG)m_outputSizeInRawPixels.x &&
+            m_d3dRenderTargetSize.cy == (LONG)m_outputSizeInRawPixels.y &&
+            m_swapChainDpi.x == m_dpi.x && m_swapChainDpi.y == m_dpi.y)
         {
-            m_fenceValues[frameBufferIndex] = fenceValueForCurrentBuffer;
+            return true;
         }
 
-        if (m_outputSizeInRawPixels.x == 0 || m_outputSizeInRawPixels.y == 0) return true;
+        // Clear the previous window-size-dependent content. Rather than waiting for the GPU to finish
+        // with it, we hand it to the deferred-release queue, and carry on with a new swap chain.
+        m_pD2D1DeviceContext1->SetTarget(nullptr);
+        ReleaseSwapChain();
+        m_pD3D11DeviceContext->Flush();
 
         m_d3dRenderTargetSize.cx = (UINT)m_outputSizeInRawPixels.x;
         m_d3dRenderTargetSize.cy = (UINT)m_outputSizeInRawPixels.y;
@@ -479,14 +798,31 @@ namespace DX
     // Release window-independent (device-dependent) resources.
     void DeviceResources::WindowIndependentReset()
     {
+        TraceSpan const span{ m_trace, "DeviceResources::WindowIndependentReset" };
+
+        // The device is going away, so there's nothing left for deferred releases to wait for.
+        m_deferredReleaseQueue.ReleaseAll();
+        m_pMappedUploadRing = nullptr;
+        m_d3d12UploadRing = PlacedResource{};
+        m_uploadRing.Reset(0);
+        m_descriptorAllocator.Reset(0, 0);
+        m_pD3D12CbvSrvUavHeap = nullptr;
         Trim();
-        ::CloseHandle(m_fenceEventHandle.get());
+        m_pGpuFrameTimer = nullptr;
+        m_pPipelineCompiler = nullptr; // Its compiles in progress use the pipeline cache, and the device.
+        if (m_pPipelineCache) m_pPipelineCache->Save();
+        m_pPipelineCache = nullptr;
+        m_pCopyUploadQueue = nullptr;
+        m_pTransientResources = nullptr; // Its range is in the placed resource allocator's heaps.
+        m_pPlacedResourceAllocator = nullptr;
+        m_pResourceStateTracker = nullptr;
+        m_pRenderFence = nullptr;
+        m_pRenderCommandQueue = nullptr;
         m_pD3D12Fence = nullptr;
         for (auto& pD3D12CommandAllocator : m_pD3D12CommandAllocators)
         {
             pD3D12CommandAllocator = nullptr;
         }
-        m_pD3D12DsvHeap = nullptr;
         m_pD3D12RtvHeap = nullptr;
         m_pD2D1DeviceContext1 = nullptr;
         m_pD2D1Device1 = nullptr;
@@ -499,144 +835,23 @@ namespace DX
 #endif
     }
 
-    // Does setup work that depends on the D3D device, but doesn't depend on the window.
-    void DeviceResources::WindowIndependentSetup()
+    // Does setup work that depends on the D3D device, but doesn't depend on the window; by adding
+    // tasks to `startupGraph`, which the caller runs (see StartupGraph). The Direct2D factory is
+    // created only the first time; it outlives the device.
+    DeviceSetupTasks DeviceResources::WindowIndependentSetup(StartupGraph& startupGraph)
     {
-#if defined(_DEBUG)
-        // If the project is in a debug build, enable debugging via SDK Layers.
-        if (SUCCEEDED(::D3D12GetDebugInterface(__uuidof(m_pD3DDebugger), m_pD3DDebugger.put_void())))
-        {
-            m_pD3DDebugger->EnableDebugLayer();
-        }
-#endif
-
-        winrt::check_hresult(::CreateDXGIFactory1(__uuidof(m_pDXGIFactory4), m_pDXGIFactory4.put_void()));
-
-        winrt::com_ptr<::IDXGIAdapter> pIDXGIAdapter;
-        UINT adapterIndex{};
-        HRESULT hr{ S_OK };
-
-        do
+        DeviceSetupTasks tasks;
+        tasks.device = startupGraph.Add("Device", [this] { CreateDevice(); });
+        if (m_pD2D1Factory3)
         {
-            winrt::check_hresult(m_pDXGIFactory4->EnumAdapters(adapterIndex, pIDXGIAdapter.put()));
-            ++adapterIndex;
-
-            m_pD3D12Device = nullptr;
-            hr = ::D3D12CreateDevice(pIDXGIAdapter.get(), D3D_FEATURE_LEVEL_11_0, __uuidof(m_pD3D12Device), m_pD3D12Device.put_void());
-            if (hr == DXGI_ERROR_UNSUPPORTED) continue;
-            winrt::check_hresult(hr);
-        } while (hr != S_OK);
-
-        // Describe and create the command queue.
-        D3D12_COMMAND_QUEUE_DESC commandQueueDesc{};
-        commandQueueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
-        commandQueueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
-
-        winrt::check_hresult(
-            m_pD3D12Device->CreateCommandQueue(
-                &commandQueueDesc,
-                _uuidof(m_pD3D12CommandQueue),
-                m_pD3D12CommandQueue.put_void())
-        );
-
-        // Create an 11On12 device using the Direct3D 12 device and the command queue.
-
-        // D3D11_CREATE_DEVICE_BGRA_SUPPORT supports surfaces with a different color channel ordering
-        // than the API default. It's required for Direct2D interoperability with Direct3D resources.
-        uint32_t createDeviceFlags{ D3D11_CREATE_DEVICE_BGRA_SUPPORT | D3D11_CREATE_DEVICE_SINGLETHREADED };
-
-#if defined (_DEBUG)
-        if (DX::SdkLayersAvailable())
-        {
-            // If the project is in a debug build, then enable debugging via SDK Layers with this flag.
-            createDeviceFlags |= D3D11_CREATE_DEVICE_DEBUG;
+            tasks.d2dDevice = startupGraph.Add("D2DDevice", [this] { CreateD2DDevice(); }, { tasks.device });
         }
-#endif
-
-        // Array with hardware feature levels in order of preference.
-        D3D_FEATURE_LEVEL featureLevelsRequested[]{
-            D3D_FEATURE_LEVEL_12_1,
-            D3D_FEATURE_LEVEL_12_0,
-            D3D_FEATURE_LEVEL_11_1,
-            D3D_FEATURE_LEVEL_11_0
-        };
-        D3D12_FEATURE_DATA_FEATURE_LEVELS d3d12FeatureLevels{ sizeof(featureLevelsRequested) / sizeof(D3D_FEATURE_LEVEL), featureLevelsRequested, D3D_FEATURE_LEVEL_9_1 };
-        winrt::check_hresult(m_pD3D12Device->CheckFeatureSupport(D3D12_FEATURE_FEATURE_LEVELS, &d3d12FeatureLevels, sizeof(d3d12FeatureLevels)));
-
-        winrt::com_ptr<::ID3D11Device> pD3D11Device;
-
-        ::IUnknown* pCommandQueues{ m_pD3D12CommandQueue.get() };
-        winrt::check_hresult(::D3D11On12CreateDevice(
-            m_pD3D12Device.get(),
-            createDeviceFlags,
-            nullptr,
-            0,
-            &pCommandQueues,
-            1,
-            0,
-            pD3D11Device.put(),
-            m_pD3D11DeviceContext.put(),
-            nullptr
-        ));
-        // Query the 11On12 device from the 11 device.
-        m_pD3D11On12Device = pD3D11Device.as<::ID3D11On12Device>();
-
-        // Create the Direct2D device object, and a corresponding context.
-        winrt::com_ptr<::IDXGIDevice> pDXGIDevice{ m_pD3D11On12Device.as<::IDXGIDevice>() };
-
-        winrt::check_hresult(
-            m_pD2D1Factory3->CreateDevice(pDXGIDevice.get(), m_pD2D1Device1.put())
-        );
-
-        winrt::check_hresult(
-            m_pD2D1Device1->CreateDeviceContext(
-                D2D1_DEVICE_CONTEXT_OPTIONS_NONE,
-                m_pD2D1DeviceContext1.put()
-            )
-        );
-
-        // Create a descriptor heap for the render target view.
-        D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc{};
-        rtvHeapDesc.NumDescriptors = NumFramebuffers();
-        rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-        rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-
-        winrt::check_hresult(
-            m_pD3D12Device->CreateDescriptorHeap(
-                &rtvHeapDesc,
-                _uuidof(m_pD3D12RtvHeap),
-                m_pD3D12RtvHeap.put_void())
-        );
-
-        m_rtvDescriptorSize = m_pD3D12Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-
-        // Create a descriptor heap for the depth stencil view.
-        D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc{};
-        dsvHeapDesc.NumDescriptors = 1;
-        dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
-        dsvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-
-        winrt::check_hresult(
-            m_pD3D12Device->CreateDescriptorHeap(
-                &dsvHeapDesc,
-                _uuidof(m_pD3D12DsvHeap),
-                m_pD3D12DsvHeap.put_void())
-        );
-        m_d3d12DepthStencilView = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_pD3D12DsvHeap->GetCPUDescriptorHandleForHeapStart());
-
-        // Create a command allocator for each frame buffer.
-        for (auto& pD3D12CommandAllocator : m_pD3D12CommandAllocators)
+        else
         {
-            winrt::check_hresult(
-                m_pD3D12Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, __uuidof(pD3D12CommandAllocator), pD3D12CommandAllocator.put_void())
-            );
+            StartupGraph::TaskId const d2dFactory{ startupGraph.Add("D2DFactory", [this] { DeviceIndependentSetup(); }) };
+            tasks.d2dDevice = startupGraph.Add("D2DDevice", [this] { CreateD2DDevice(); }, { tasks.device, d2dFactory });
         }
-
-        // Create synchronization objects.
-        winrt::check_hresult(m_pD3D12Device->CreateFence(m_fenceValues[m_currentBufferIndex], D3D12_FENCE_FLAG_NONE, _uuidof(m_pD3D12Fence), m_pD3D12Fence.put_void()));
-        ++m_fenceValues[m_currentBufferIndex];
-
-        m_fenceEventHandle.attach(::CreateEvent(nullptr, false, false, nullptr));
-        winrt::check_bool(bool{ m_fenceEventHandle });
+        tasks.deviceObjects = startupGraph.Add("DeviceObjects", [this] { CreateDeviceObjects(); }, { tasks.device });
+        return tasks;
     }
-}
+}
\ No newline at end of file
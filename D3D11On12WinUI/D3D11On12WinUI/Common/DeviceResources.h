@@ -13,108 +13,264 @@
 
 namespace DX
 {
+    // Upload memory for one use in the current frame, from DeviceResources::AllocateUpload.
+    struct UploadAllocation final
+    {
+        uint8_t* pCpu{ nullptr }; // Write-combined: write it (with StreamingCopy, say), but don't read it.
+        D3D12_GPU_VIRTUAL_ADDRESS gpuAddress{ 0 };
+        ::ID3D12Resource* pResource{ nullptr }; // The ring, and the offset in it; for copies (of texture data, say).
+        UINT64 offset{ 0 };
+    };
+
+    // A descriptor in the device's shader-visible CBV/SRV/UAV heap (or the first of a run of them).
+    struct DescriptorHandle final
+    {
+        D3D12_CPU_DESCRIPTOR_HANDLE cpu{};
+        D3D12_GPU_DESCRIPTOR_HANDLE gpu{};
+        uint32_t index{ 0 };
+    };
+
+    // A Direct3D 12 texture wrapped for Direct2D to draw into, through the 11On12 device (see
+    // DeviceResources::CreateDirect2DTarget).
+    struct Direct2DTarget final
+    {
+        winrt::com_ptr<::ID3D11Resource> pD3D11Resource{ nullptr };
+        winrt::com_ptr<::ID2D1Bitmap1> pD2D1Bitmap1{ nullptr };
+        ::ID3D12Resource* pD3D12Resource{ nullptr };
+        D3D12_RESOURCE_STATES state{ D3D12_RESOURCE_STATE_COMMON }; // The 11On12 device takes it in this state, and leaves it in it.
+    };
+
+    // The tasks that DeviceResources::WindowIndependentSetup adds to a startup graph, for the
+    // caller's tasks to depend on.
+    struct DeviceSetupTasks final
+    {
+        StartupGraph::TaskId device{ 0 }; // The D3D12 device, its direct queue, and the pipeline cache.
+        StartupGraph::TaskId d2dDevice{ 0 }; // The 11On12 device, and the Direct2D device and context.
+        StartupGraph::TaskId deviceObjects{ 0 }; // Descriptor heaps, command allocators, the fence, and the upload paths.
+    };
+
     class DeviceResources final
     {
-        static constexpr UINT s_numFramebuffers{ 3 }; // Use triple-buffering.
+        static constexpr UINT s_persistentDescriptorCount{ 1024 };
+        static constexpr UINT s_transientDescriptorCount{ 8192 };
+        static constexpr UINT64 s_initialUploadRingCapacity{ 1 << 20 };
+        static constexpr UINT64 s_copyQueueStagingCapacity{ 8 << 20 };
+        static constexpr UINT64 s_placedResourceHeapSize{ 16 << 20 };
+        static constexpr UINT s_maxNumFramebuffers{ FrameLatencySettings::s_maxNumFramebuffers }; // The per-frame arrays are sized for this many; NumFramebuffers() of them are used.
 
         // data members
 
-        UINT m_currentBufferIndex{ 0 };
         SIZE m_d3dRenderTargetSize{ 0L, 0L };
+        AdapterCandidate m_adapter; // The adapter that the device was created on.
+        AdapterPolicy m_adapterPolicy;
+        DeviceCapabilitiesCache m_capabilitiesCache;
+        UINT m_cbvSrvUavDescriptorSize{ 0 };
+        DeferredReleaseQueue<winrt::com_ptr<::IUnknown>> m_deferredReleaseQueue;
+        DescriptorAllocator m_descriptorAllocator;
+        DeviceCapabilities m_deviceCapabilities;
         DirectX::XMFLOAT2 m_dpi{ 96.f, 96.f };
-        winrt::handle m_fenceEventHandle{ 0 };
-        std::array<UINT64, s_numFramebuffers> m_fenceValues{};
+        FrameLatencySettings m_frameLatencySettings;
+        FramePacer m_framePacer;
+        uint64_t m_frameStartNanoseconds{ 0 };
+        FrameSynchronizer m_frameSynchronizer{ m_frameLatencySettings.numFramebuffers };
         HWND m_hWnd{ 0 };
+        LatencyMeter m_latencyMeter;
+        bool m_multithreadedDirect2D{ false }; // Direct2D is drawn with from more than the render thread (see MultithreadedDirect2D).
+        bool m_occluded{ false };
         DirectX::XMFLOAT2 m_outputSizeInDIPs{ 0.f, 0.f };
         DirectX::XMFLOAT2 m_outputSizeInRawPixels{ 0.f, 0.f };
+        winrt::handle m_pacingTimer;
+        std::unique_ptr<CopyUploadQueue> m_pCopyUploadQueue{ nullptr };
+        std::unique_ptr<GpuFrameTimer> m_pGpuFrameTimer{ nullptr };
+        std::unique_ptr<D3D12PipelineCache> m_pPipelineCache{ nullptr };
+        std::unique_ptr<D3D12PipelineCompiler> m_pPipelineCompiler{ nullptr };
+        std::unique_ptr<PlacedResourceAllocator> m_pPlacedResourceAllocator{ nullptr };
+        std::unique_ptr<D3D12ResourceStateTracker> m_pResourceStateTracker{ nullptr };
+        std::unique_ptr<D3D12TransientResources> m_pTransientResources{ nullptr };
+        RenderLoopStatistics m_renderLoopStatistics;
         UINT m_rtvDescriptorSize{ 0 };
+        DirectX::XMFLOAT2 m_swapChainDpi{ 0.f, 0.f };
         winrt::SwapChainPanel m_swapChainPanel{ nullptr };
+        mutable TraceRecorder m_trace; // Recorded into by const member functions too.
+        UploadRing m_uploadRing;
         winrt::Window m_window{ nullptr };
 
         // Direct3D and DXGI data members
 
-        D3D12_CPU_DESCRIPTOR_HANDLE m_d3d12DepthStencilView{};
-        std::array<D3D12_CPU_DESCRIPTOR_HANDLE, DeviceResources::s_numFramebuffers> m_d3d12RenderTargetViews{};
+        std::array<D3D12_CPU_DESCRIPTOR_HANDLE, DeviceResources::s_maxNumFramebuffers> m_d3d12RenderTargetViews{};
         D3D12_VIEWPORT m_d3d12Viewport{};
         D3D12_RECT m_d3d12ScissorRect{};
         DXGI_FORMAT m_dsvFormat{ DXGI_FORMAT_D32_FLOAT };
+        winrt::com_ptr<::ID3D12DescriptorHeap> m_pD3D12CbvSrvUavHeap{ nullptr };
         winrt::com_ptr<::ID3D11DeviceContext> m_pD3D11DeviceContext{ nullptr };
         winrt::com_ptr<::ID3D11On12Device> m_pD3D11On12Device{ nullptr };
-        std::array< winrt::com_ptr<::ID3D11Resource>, s_numFramebuffers> m_pD3D11WrappedRenderTargets{};
-        std::array<winrt::com_ptr<::ID3D12CommandAllocator>, s_numFramebuffers> m_pD3D12CommandAllocators{};
+        std::array<winrt::com_ptr<::ID3D12CommandAllocator>, s_maxNumFramebuffers> m_pD3D12CommandAllocators{};
         winrt::com_ptr<::ID3D12CommandQueue> m_pD3D12CommandQueue{ nullptr };
         winrt::com_ptr<::ID3D12Fence> m_pD3D12Fence{ nullptr };
 #if defined (_DEBUG)
         winrt::com_ptr<::ID3D12Debug> m_pD3DDebugger{ nullptr };
 #endif
-        winrt::com_ptr<::ID3D12Resource> m_pD3D12DepthStencil{ nullptr };
         winrt::com_ptr<::ID3D12Device> m_pD3D12Device{ nullptr };
-        winrt::com_ptr<::ID3D12DescriptorHeap> m_pD3D12DsvHeap{ nullptr };
-        std::array<winrt::com_ptr<::ID3D12Resource>, DeviceResources::s_numFramebuffers> m_pD3D12RenderTargets{};
+        std::array<winrt::com_ptr<::ID3D12Resource>, DeviceResources::s_maxNumFramebuffers> m_pD3D12RenderTargets{};
         winrt::com_ptr<::ID3D12DescriptorHeap> m_pD3D12RtvHeap{ nullptr };
+        PlacedResource m_d3d12UploadRing;
+        uint8_t* m_pMappedUploadRing{ nullptr };
         winrt::com_ptr<::IDXGIFactory4> m_pDXGIFactory4{ nullptr };
         winrt::com_ptr<::IDXGISwapChain3> m_pDXGISwapChain3{ nullptr };
         DXGI_FORMAT m_rtvFormat{ DXGI_FORMAT_B8G8R8A8_UNORM };
 
+        // Backend-neutral wrappers, through which frames are synchronized and presented.
+
+        std::unique_ptr<D3D12RenderCommandQueue> m_pRenderCommandQueue{ nullptr };
+        std::unique_ptr<D3D12RenderFence> m_pRenderFence{ nullptr };
+        std::unique_ptr<D3D12RenderSwapChain> m_pRenderSwapChain{ nullptr };
+
         // Direct2D and DirectWrite data members
 
         winrt::com_ptr<::ID2D1Device1> m_pD2D1Device1{ nullptr };
         winrt::com_ptr<::ID2D1DeviceContext1> m_pD2D1DeviceContext1{ nullptr };
         winrt::com_ptr<::ID2D1Factory3> m_pD2D1Factory3{ nullptr };
-        winrt::com_ptr<::IDWriteFactory2> m_pDWriteFactory2{ nullptr };
-        std::array< winrt::com_ptr<::ID2D1Bitmap1>, DeviceResources::s_numFramebuffers> m_pD2D1TargetBitmap1s{};
-        winrt::com_ptr<::IWICImagingFactory2> m_pWICImagingFactory2{ nullptr };
+        mutable winrt::com_ptr<::IDWriteFactory2> m_pDWriteFactory2{ nullptr }; // Created on first use, as is the WIC factory.
+        mutable std::once_flag m_dwriteFactoryCreated;
+        mutable winrt::com_ptr<::IWICImagingFactory2> m_pWICImagingFactory2{ nullptr };
+        mutable std::once_flag m_wicFactoryCreated;
 
         // member functions
 
+        void CreateD2DDevice();
+        void CreateDevice();
+        void CreateDeviceObjects();
+        void CreateUploadRing(UINT64 capacity);
         bool CreateSwapChain();
+        DescriptorHandle Descriptor(uint32_t index) const;
         void DeviceIndependentSetup();
-        bool Present();
         void ReleaseSwapChain();
+        void SleepUntil(uint64_t qpcNanoseconds);
 
     public:
-        DeviceResources();
+        DeviceResources() = default;
 
         // member functions
 
-        ::ID3D11Resource* AcquireWrappedRenderTarget();
+        // Makes the target the Direct2D context's, until ReleaseDirect2DTarget.
+        void AcquireDirect2DTarget(Direct2DTarget const& target);
+        DescriptorHandle AllocatePersistentDescriptor();
+
+        // A range of one of the device's shared heaps, to place resources in (see PlacedHeapRange). Free it with FreePlacedRange.
+        PlacedHeapRange AllocatePlacedRange(D3D12_HEAP_TYPE heapType, PlacedResourceClass resourceClass, UINT64 sizeInBytes);
+
+        DescriptorHandle AllocateTransientDescriptors(UINT count = 1);
+        UploadAllocation AllocateUpload(UINT64 sizeInBytes, UINT64 alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+        void BeginGpuFrame(::ID3D12GraphicsCommandList* pD3D12GraphicsCommandList) const;
+
+        // Creates a resource placed in one of the device's shared heaps (see PlacedResourceAllocator). Free it with FreePlacedResource.
+        PlacedResource CreatePlacedResource(D3D12_HEAP_TYPE heapType, D3D12_RESOURCE_DESC const& resourceDesc, D3D12_RESOURCE_STATES initialState, D3D12_CLEAR_VALUE const* pOptimizedClearValue = nullptr);
+
+        // Wraps a B8G8R8A8 texture (that allows render targets) for Direct2D to draw into, at the
+        // current DPI. It's used in `state` outside Acquire/ReleaseDirect2DTarget; DeferRelease its objects.
+        Direct2DTarget CreateDirect2DTarget(::ID3D12Resource* pD3D12Resource, D3D12_RESOURCE_STATES state);
+
+        // Takes ownership of pObject (and sets it to nullptr), and releases it once the GPU has
+        // finished the current frame. Use this for anything that the GPU may still be using.
+        template <typename T>
+        void DeferRelease(winrt::com_ptr<T>& pObject)
+        {
+            if (!pObject) return;
+            winrt::com_ptr<::IUnknown> pUnknown;
+            pUnknown.attach(pObject.detach());
+            m_deferredReleaseQueue.Enqueue(m_frameSynchronizer.CurrentFenceValue(), std::move(pUnknown));
+        }
+
         void DpiAndOutputSize(DirectX::XMFLOAT2 const& outputSize);
+        void FreePersistentDescriptor(DescriptorHandle const& descriptor);
+        void FreePlacedRange(PlacedHeapRange& range);
+        void FreePlacedResource(PlacedResource& resource);
+        void EndGpuFrame(::ID3D12GraphicsCommandList* pD3D12GraphicsCommandList) const;
+        void Idled(uint64_t nanoseconds);
         void MoveToNextFrame();
+        bool Occluded();
         void OutputSize(DirectX::XMFLOAT2 const& outputSize, bool isInDIPs);
-        bool ReleaseWrappedRenderTargetAndPresent(::ID3D11Resource* pWrappedRenderTargets);
+        bool Present();
+
+        // Submits what Direct2D drew into the target to the direct queue, ahead of the frame's command list.
+        void ReleaseDirect2DTarget(Direct2DTarget const& target);
+        void SaveTrace() const;
         winrt::fire_and_forget SetSwapChainOnSwapChainPanelAsync();
         void SetWindowAndSwapChainPanel(winrt::Window const& window, HWND hWnd, winrt::SwapChainPanel const& swapChainPanel);
         void Trim();
         void WaitForGpu() const;
+        void WaitForNextFrame();
         void WindowDependentReset();
         bool WindowDependentSetup();
         void WindowIndependentReset();
-        void WindowIndependentSetup();
+        DeviceSetupTasks WindowIndependentSetup(StartupGraph& startupGraph);
 
         // accessors
 
-        unsigned int CurrentFrameIndex() const { return m_currentBufferIndex; }
+        AdapterCandidate const& Adapter() const { return m_adapter; }
+        DeviceCapabilities const& Capabilities() const { return m_deviceCapabilities; }
+        unsigned int CurrentFrameIndex() const { return m_frameSynchronizer.CurrentBufferIndex(); }
         DirectX::XMFLOAT2 const& Dpi() const { return m_dpi; }
-        static constexpr UINT NumFramebuffers(){ return DeviceResources::s_numFramebuffers; }
+        DescriptorAllocator const& Descriptors() const { return m_descriptorAllocator; }
+        FrameLatencySettings const& FrameLatency() const { return m_frameLatencySettings; }
+        FramePacer const& FramePacing() const { return m_framePacer; }
+        LatencySummary InputToDisplayLatency() const { return m_latencyMeter.Summary(); }
+        PlacedResourceAllocator const& PlacedResources() const { return *m_pPlacedResourceAllocator; }
+        UINT NumFramebuffers() const { return m_frameLatencySettings.numFramebuffers; }
         DirectX::XMFLOAT2 const& OutputSizeInDIPs() const { return m_outputSizeInDIPs; }
+        RenderLoopStatistics const& RenderLoop() const { return m_renderLoopStatistics; }
+        UploadRing const& UploadMemory() const { return m_uploadRing; }
+
+        // Spans and instants for the lifecycle phases (see TraceRecorder); SaveTrace writes them out.
+        TraceRecorder& Trace() const { return m_trace; }
+
+        // Creates root signatures and pipeline states through the on-disk cache (see D3D12PipelineCache).
+        D3D12PipelineCache& Pipelines() const { return *m_pPipelineCache; }
+
+        // Compiles pipeline states on background threads (see PipelineCompiler), through Pipelines().
+        D3D12PipelineCompiler& PipelineCompiles() const { return *m_pPipelineCompiler; }
+
+        // Uploads buffers and textures on the copy queue (see CopyUploadQueue).
+        CopyUploadQueue& Uploads() const { return *m_pCopyUploadQueue; }
+
+        // The direct queue's resource states; submit command lists recorded with D3D12CommandListStates through this.
+        // Placed resources and the swap chain's buffers are registered with it as they're created.
+        D3D12ResourceStateTracker& ResourceStates() const { return *m_pResourceStateTracker; }
+
+        // Realizes the frame graph's transient render targets and depth stencils (see D3D12TransientResources).
+        D3D12TransientResources& TransientResources() const { return *m_pTransientResources; }
 
         // Direct3D and DXGI accessors
 
         ID3D12CommandQueue* ID3D12CommandQueue() const { return m_pD3D12CommandQueue.get(); }
-        ID3D12CommandAllocator* ID3D12CommandAllocator() const { return m_pD3D12CommandAllocators[m_currentBufferIndex].get(); }
+        ::ID3D12DescriptorHeap* CbvSrvUavHeap() const { return m_pD3D12CbvSrvUavHeap.get(); }
+        ID3D12CommandAllocator* ID3D12CommandAllocator() const { return m_pD3D12CommandAllocators[CurrentFrameIndex()].get(); }
         DXGI_FORMAT DSVFormat() const { return m_dsvFormat; }
-        D3D12_CPU_DESCRIPTOR_HANDLE const& D3D12DepthStencilView() const { return m_d3d12DepthStencilView; }
         winrt::com_ptr<::ID3D12Device> ID3D12Device() const { return m_pD3D12Device; };
         DXGI_FORMAT RTVFormat() const { return m_rtvFormat; }
-        D3D12_CPU_DESCRIPTOR_HANDLE const& D3D12RenderTargetView() const { return m_d3d12RenderTargetViews[m_currentBufferIndex]; }
+        SIZE const& RenderTargetSize() const { return m_d3dRenderTargetSize; }
+        D3D12_CPU_DESCRIPTOR_HANDLE const& D3D12RenderTargetView() const { return m_d3d12RenderTargetViews[CurrentFrameIndex()]; }
         D3D12_RECT const& D3D12ScissorRect() const { return m_d3d12ScissorRect; }
         D3D12_VIEWPORT const& D3D12Viewport() const { return m_d3d12Viewport; }
-        ::ID3D12Resource* ID3D12RenderTarget() const { return m_pD3D12RenderTargets[m_currentBufferIndex].get(); }
+        ::ID3D12Resource* ID3D12RenderTarget() const { return m_pD3D12RenderTargets[CurrentFrameIndex()].get(); }
 
         // Direct2D accessors
 
-        ::ID2D1DeviceContext1* ID2D1DeviceContext1() const { return m_pD2D1DeviceContext1.get(); }
+        ::ID2D1Device1* ID2D1Device1() const { return m_pD2D1Device1.get(); } // For other threads' contexts, when Direct2D is multithreaded.
+        ::ID2D1DeviceContext1* ID2D1DeviceContext1() const { return m_pD2D1DeviceContext1.get(); } // The render thread's.
         ::ID2D1Factory3* ID2D1Factory3() const { return m_pD2D1Factory3.get(); }
-        ::IDWriteFactory2* IDWriteFactory2() const { return m_pDWriteFactory2.get(); }
+        ::IDWriteFactory2* IDWriteFactory2() const; // Created on first use, by whichever thread asks first; as is the WIC factory.
+        ::IWICImagingFactory2* IWICImagingFactory2() const;
+
+        // mutators
+
+        // These take effect when the device is next created, so call them before WindowIndependentSetup.
+        void AdapterSelection(AdapterPolicy const& adapterPolicy) { m_adapterPolicy = adapterPolicy; }
+        void FrameLatency(FrameLatencySettings const& frameLatencySettings);
+
+        // Creates the Direct2D factory multithreaded, and the 11On12 device without
+        // D3D11_CREATE_DEVICE_SINGLETHREADED, so that threads other than the render thread can
+        // record with Direct2D contexts of their own. Call before the first WindowIndependentSetup.
+        void MultithreadedDirect2D(bool multithreaded) { m_multithreadedDirect2D = multithreaded; }
     };
 }
@@ -0,0 +1,554 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// A frame as a graph of passes (the 3D scene, the 2D overlay, presenting, and so on), each of
+// which declares the resources that it reads and writes, and in which states, rather than as
+// a sequence of calls that each know what the one before them left behind. The graph is
+// rebuilt each frame, and compiled (on the CPU alone) before it runs:
+//
+//   - Passes whose results nothing uses are culled. A pass is kept if it has side effects
+//     (presenting, say), if it writes an imported resource (one that outlives the frame), or
+//     if a kept pass uses what it writes.
+//   - The kept passes are ordered so that, where there's a choice, a pass doesn't run straight
+//     after one that it depends on (whose work the GPU would have to drain first).
+//   - Transient resources (created by the graph, and used only within the frame) are given
+//     offsets in one heap; those whose lifetimes don't overlap share memory.
+//   - The state that each pass needs each resource in follows from the declarations; so does
+//     where to begin a split barrier, when passes that don't use a resource come between two
+//     that need it in different states. Reads in different read-only states, one after
+//     another, are combined into one state, so they need one transition rather than several.
+//
+// Passes record their barriers themselves (through CommandListResourceStates, say), from the
+// PassContext that they're run with; the graph neither records nor submits anything. The
+// Resource type is the backend's handle (ID3D12Resource*, say), and Description whatever the
+// backend needs to create a transient (the graph only copies it); nothing here dereferences either.
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ResourceStateTracker.h"
+
+namespace DX
+{
+    // A resource, as the graph's passes refer to it.
+    struct FrameGraphResource final
+    {
+        uint32_t index{ UINT32_MAX };
+
+        bool IsValid() const { return index != UINT32_MAX; }
+    };
+
+    struct FrameGraphStatistics final
+    {
+        uint32_t passes{ 0 };
+        uint32_t culledPasses{ 0 };
+        uint32_t transientResources{ 0 }; // That a kept pass uses (so that are placed).
+        uint64_t heapBytes{ 0 }; // What the transients need, aliased.
+        uint64_t unaliasedBytes{ 0 }; // What they'd need, each with memory of its own.
+        uint32_t transitions{ 0 }; // State changes over the frame.
+        uint32_t splitTransitions{ 0 }; // Of those, begun after the resource's previous use, with passes in between.
+        uint32_t aliasingBarriers{ 0 }; // Transients that share memory, so need an aliasing barrier before their first use.
+        uint32_t adjacentDependencies{ 0 }; // Passes that run straight after one that they depend on.
+        uint32_t declaredAdjacentDependencies{ 0 }; // The same, had the kept passes run in the order in which they were added.
+    };
+
+    template <typename Resource, typename Description>
+    class FrameGraph final
+    {
+    public:
+        class Builder;
+        class PassContext;
+
+    private:
+        static constexpr uint32_t s_none{ UINT32_MAX };
+
+        struct Access final
+        {
+            uint32_t resource{ 0 };
+            ResourceStates state{ ResourceStates::Common }; // As declared.
+            ResourceStates compiledState{ ResourceStates::Common }; // Combined with the neighbouring reads.
+            bool isWrite{ false };
+        };
+
+        struct Pass final
+        {
+            std::string name;
+            std::function<void(PassContext const&)> execute;
+            std::vector<Access> accesses;
+            std::vector<uint32_t> dependencies; // Passes that must run before this one.
+            std::vector<uint32_t> producers; // Of those, the ones whose results this one uses (reads, or writes over).
+            bool hasSideEffects{ false };
+
+            // Compiled
+            bool isCulled{ true };
+            std::vector<std::pair<uint32_t, ResourceStates>> beginTransitions; // To begin once this pass's work is recorded.
+            std::vector<uint32_t> activations; // Transients that this pass uses first, that share memory with others.
+        };
+
+        struct Node final
+        {
+            std::string name;
+            Resource resource{};
+            Description description{};
+            uint64_t sizeInBytes{ 0 };
+            uint64_t alignment{ 1 };
+            ResourceStates importedState{ ResourceStates::Common };
+            bool isImported{ false };
+            uint32_t lastWriter{ s_none }; // While passes are added.
+            std::vector<uint32_t> readersSinceWrite; // While passes are added.
+
+            // Compiled
+            uint32_t firstPosition{ s_none }; // In the schedule; s_none if no kept pass uses it.
+            uint32_t lastPosition{ s_none };
+            uint64_t heapOffset{ 0 };
+            bool isAliased{ false };
+        };
+
+        // data members
+
+        bool m_compiled{ false };
+        std::vector<Node> m_nodes;
+        std::vector<Pass> m_passes;
+        bool m_realized{ false };
+        std::vector<uint32_t> m_schedule; // Kept passes, in the order in which they run.
+        FrameGraphStatistics m_statistics;
+
+        // member functions
+
+        static constexpr uint64_t AlignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+        // As CommandListResourceStates does: a read-only state covers any of the states combined in it.
+        static constexpr bool Satisfies(ResourceStates current, ResourceStates required)
+        {
+            return current == required || (IsReadOnlyState(current) && IsReadOnlyState(required) && (current & required) == required);
+        }
+
+        static void AddUnique(std::vector<uint32_t>& passes, uint32_t pass)
+        {
+            if (std::find(passes.begin(), passes.end(), pass) == passes.end()) passes.push_back(pass);
+        }
+
+        void Declare(uint32_t pass, FrameGraphResource resource, ResourceStates state, bool isWrite)
+        {
+            if (m_compiled) throw std::logic_error{ "A frame graph can't change once it's compiled; Reset it." };
+            if (!resource.IsValid() || resource.index >= m_nodes.size()) throw std::invalid_argument{ "Not a resource of this frame graph." };
+            Pass& p{ m_passes[pass] };
+            for (Access const& access : p.accesses)
+            {
+                if (access.resource == resource.index) throw std::invalid_argument{ "A pass may declare a resource once (declare a write, for both)." };
+            }
+            Node& node{ m_nodes[resource.index] };
+            if (!isWrite && node.lastWriter == s_none && !node.isImported) throw std::invalid_argument{ "A transient resource is read before any pass writes it." };
+
+            // Reading (or writing over) what a pass wrote depends on it; writing also waits for
+            // the passes that read the old contents.
+            if (node.lastWriter != s_none)
+            {
+                AddUnique(p.dependencies, node.lastWriter);
+                AddUnique(p.producers, node.lastWriter);
+            }
+            if (isWrite)
+            {
+                for (uint32_t const reader : node.readersSinceWrite) AddUnique(p.dependencies, reader);
+                node.readersSinceWrite.clear();
+                node.lastWriter = pass;
+            }
+            else node.readersSinceWrite.push_back(pass);
+            p.accesses.push_back(Access{ resource.index, state, state, isWrite });
+        }
+
+        void Cull()
+        {
+            std::vector<uint32_t> stack;
+            for (uint32_t pass{ 0 }; pass < m_passes.size(); ++pass)
+            {
+                Pass& p{ m_passes[pass] };
+                p.isCulled = true;
+                bool isRoot{ p.hasSideEffects };
+                for (Access const& access : p.accesses) isRoot |= access.isWrite && m_nodes[access.resource].isImported;
+                if (isRoot) stack.push_back(pass);
+            }
+            while (!stack.empty())
+            {
+                Pass& p{ m_passes[stack.back()] };
+                stack.pop_back();
+                if (!p.isCulled) continue;
+                p.isCulled = false;
+                for (uint32_t const producer : p.producers)
+                {
+                    if (m_passes[producer].isCulled) stack.push_back(producer);
+                }
+            }
+        }
+
+        // Of the passes whose dependencies have run, runs next the one whose last dependency ran
+        // longest ago (then, the one added first); so dependent passes are spread apart.
+        void Schedule()
+        {
+            std::vector<uint32_t> unscheduled(m_passes.size(), 0);
+            std::vector<std::vector<uint32_t>> dependents(m_passes.size());
+            std::vector<uint32_t> position(m_passes.size(), s_none);
+            using Ready = std::pair<int64_t, uint32_t>; // The position of the last dependency (-1 for none), and the pass.
+            std::priority_queue<Ready, std::vector<Ready>, std::greater<Ready>> ready;
+            for (uint32_t pass{ 0 }; pass < m_passes.size(); ++pass)
+            {
+                if (m_passes[pass].isCulled) continue;
+                for (uint32_t const dependency : m_passes[pass].dependencies)
+                {
+                    if (m_passes[dependency].isCulled) continue; // Only a reader (of what this pass overwrites) can be culled.
+                    ++unscheduled[pass];
+                    dependents[dependency].push_back(pass);
+                }
+                if (unscheduled[pass] == 0) ready.push({ -1, pass });
+            }
+
+            m_schedule.clear();
+            while (!ready.empty())
+            {
+                uint32_t const pass{ ready.top().second };
+                ready.pop();
+                position[pass] = static_cast<uint32_t>(m_schedule.size());
+                m_schedule.push_back(pass);
+                for (uint32_t const dependent : dependents[pass])
+                {
+                    if (--unscheduled[dependent] > 0) continue;
+                    int64_t last{ -1 };
+                    for (uint32_t const dependency : m_passes[dependent].dependencies)
+                    {
+                        if (!m_passes[dependency].isCulled) last = std::max<int64_t>(last, position[dependency]);
+                    }
+                    ready.push({ last, dependent });
+                }
+            }
+
+            auto adjacentDependencies = [&](std::vector<uint32_t> const& order)
+                {
+                    uint32_t count{ 0 };
+                    for (size_t at{ 1 }; at < order.size(); ++at)
+                    {
+                        std::vector<uint32_t> const& dependencies{ m_passes[order[at]].dependencies };
+                        if (std::find(dependencies.begin(), dependencies.end(), order[at - 1]) != dependencies.end()) ++count;
+                    }
+                    return count;
+                };
+            std::vector<uint32_t> declared;
+            for (uint32_t pass{ 0 }; pass < m_passes.size(); ++pass)
+            {
+                if (!m_passes[pass].isCulled) declared.push_back(pass);
+            }
+            m_statistics.adjacentDependencies = adjacentDependencies(m_schedule);
+            m_statistics.declaredAdjacentDependencies = adjacentDependencies(declared);
+        }
+
+        // Places each transient at the lowest offset that no transient whose lifetime overlaps
+        // its own occupies; the largest are placed first, as they're the hardest to fit.
+        void Place()
+        {
+            std::vector<uint32_t> transients;
+            for (uint32_t resource{ 0 }; resource < m_nodes.size(); ++resource)
+            {
+                Node& node{ m_nodes[resource] };
+                node.isAliased = false;
+                if (node.isImported || node.firstPosition == s_none) continue;
+                transients.push_back(resource);
+                m_statistics.unaliasedBytes = AlignUp(m_statistics.unaliasedBytes, node.alignment) + node.sizeInBytes;
+            }
+            std::sort(transients.begin(), transients.end(), [&](uint32_t a, uint32_t b)
+                {
+                    return m_nodes[a].sizeInBytes != m_nodes[b].sizeInBytes ? m_nodes[a].sizeInBytes > m_nodes[b].sizeInBytes : a < b;
+                });
+
+            std::vector<uint32_t> placed;
+            std::vector<uint32_t> live; // Placed ones whose lifetimes overlap the one being placed.
+            std::vector<uint64_t> candidates;
+            for (uint32_t const resource : transients)
+            {
+                Node& node{ m_nodes[resource] };
+                live.clear();
+                candidates.assign(1, 0);
+                for (uint32_t const other : placed)
+                {
+                    Node const& o{ m_nodes[other] };
+                    if (o.lastPosition < node.firstPosition || node.lastPosition < o.firstPosition) continue;
+                    live.push_back(other);
+                    candidates.push_back(AlignUp(o.heapOffset + o.sizeInBytes, node.alignment));
+                }
+                std::sort(candidates.begin(), candidates.end());
+                for (uint64_t const offset : candidates)
+                {
+                    bool const fits{ std::none_of(live.begin(), live.end(), [&](uint32_t other)
+                        {
+                            Node const& o{ m_nodes[other] };
+                            return offset < o.heapOffset + o.sizeInBytes && o.heapOffset < offset + node.sizeInBytes;
+                        }) };
+                    if (!fits) continue;
+                    node.heapOffset = offset;
+                    break;
+                }
+                m_statistics.heapBytes = std::max(m_statistics.heapBytes, node.heapOffset + node.sizeInBytes);
+                placed.push_back(resource);
+            }
+
+            // A transient that shares memory with another (used earlier this frame, or later last
+            // frame) needs an aliasing barrier before its first use, and its contents are undefined then.
+            for (uint32_t const resource : placed)
+            {
+                Node& node{ m_nodes[resource] };
+                for (uint32_t const other : placed)
+                {
+                    Node const& o{ m_nodes[other] };
+                    if (other == resource || node.heapOffset >= o.heapOffset + o.sizeInBytes || o.heapOffset >= node.heapOffset + node.sizeInBytes) continue;
+                    node.isAliased = true;
+                    break;
+                }
+                if (!node.isAliased) continue;
+                m_passes[m_schedule[node.firstPosition]].activations.push_back(resource);
+                ++m_statistics.aliasingBarriers;
+            }
+        }
+
+        // Walks each resource's uses in the order scheduled: a run of reads is combined into one
+        // state, each change of state is a transition, and one with passes between it and the
+        // resource's previous use is begun right after that use.
+        void ScheduleTransitions()
+        {
+            std::vector<std::vector<std::pair<uint32_t, uint32_t>>> uses(m_nodes.size()); // (position, access), per resource.
+            for (uint32_t position{ 0 }; position < m_schedule.size(); ++position)
+            {
+                std::vector<Access>& accesses{ m_passes[m_schedule[position]].accesses };
+                for (uint32_t access{ 0 }; access < accesses.size(); ++access) uses[accesses[access].resource].push_back({ position, access });
+            }
+            auto accessOf = [&](std::pair<uint32_t, uint32_t> const& use) -> Access& { return m_passes[m_schedule[use.first]].accesses[use.second]; };
+
+            for (uint32_t resource{ 0 }; resource < m_nodes.size(); ++resource)
+            {
+                Node& node{ m_nodes[resource] };
+                std::vector<std::pair<uint32_t, uint32_t>> const& resourceUses{ uses[resource] };
+                if (resourceUses.empty()) continue;
+                node.firstPosition = resourceUses.front().first;
+                node.lastPosition = resourceUses.back().first;
+
+                for (size_t run{ 0 }; run < resourceUses.size();)
+                {
+                    size_t end{ run + 1 };
+                    if (!accessOf(resourceUses[run]).isWrite && IsReadOnlyState(accessOf(resourceUses[run]).state))
+                    {
+                        ResourceStates combined{ accessOf(resourceUses[run]).state };
+                        for (; end < resourceUses.size() && !accessOf(resourceUses[end]).isWrite && IsReadOnlyState(accessOf(resourceUses[end]).state); ++end)
+                        {
+                            combined = combined | accessOf(resourceUses[end]).state;
+                        }
+                        for (size_t use{ run }; use < end; ++use) accessOf(resourceUses[use]).compiledState = combined;
+                    }
+                    run = end;
+                }
+
+                for (size_t use{ 0 }; use < resourceUses.size(); ++use)
+                {
+                    ResourceStates const state{ accessOf(resourceUses[use]).compiledState };
+                    if (use == 0)
+                    {
+                        // A transient's state at its first use is whatever it was left in last frame; the tracker resolves that.
+                        if (node.isImported && !Satisfies(node.importedState, state)) ++m_statistics.transitions;
+                        continue;
+                    }
+                    ResourceStates const previous{ accessOf(resourceUses[use - 1]).compiledState };
+                    if (Satisfies(previous, state)) continue;
+                    ++m_statistics.transitions;
+                    uint32_t const previousPosition{ resourceUses[use - 1].first };
+                    if (resourceUses[use].first - previousPosition < 2) continue;
+                    m_passes[m_schedule[previousPosition]].beginTransitions.push_back({ resource, state });
+                    ++m_statistics.splitTransitions;
+                }
+            }
+        }
+
+    public:
+        // Declares what a pass uses; passed to its setup function, as it's added.
+        class Builder final
+        {
+            // data members
+
+            FrameGraph& m_graph;
+            uint32_t m_pass{ 0 };
+
+        public:
+            Builder(FrameGraph& graph, uint32_t pass) : m_graph{ graph }, m_pass{ pass } {}
+
+            // member functions
+
+            // A transient resource, that this pass writes first (in `state`). The backend creates it
+            // (see Realize), in `sizeInBytes` of heap at an offset that's a multiple of `alignment`.
+            FrameGraphResource Create(std::string name, Description const& description, uint64_t sizeInBytes, uint64_t alignment, ResourceStates state)
+            {
+                if (alignment == 0 || sizeInBytes == 0) throw std::invalid_argument{ "A transient resource needs a size and an alignment." };
+                Node node;
+                node.name = std::move(name);
+                node.description = description;
+                node.sizeInBytes = sizeInBytes;
+                node.alignment = alignment;
+                FrameGraphResource const resource{ static_cast<uint32_t>(m_graph.m_nodes.size()) };
+                m_graph.m_nodes.push_back(std::move(node));
+                m_graph.Declare(m_pass, resource, state, true);
+                return resource;
+            }
+
+            void Read(FrameGraphResource resource, ResourceStates state) { m_graph.Declare(m_pass, resource, state, false); }
+
+            // The pass has effects outside the graph (presenting, say), so isn't culled.
+            void SideEffects() { m_graph.m_passes[m_pass].hasSideEffects = true; }
+
+            // Overwriting a resource, or adding to its contents (drawing over what's there, say).
+            void Write(FrameGraphResource resource, ResourceStates state) { m_graph.Declare(m_pass, resource, state, true); }
+        };
+
+        // What a pass is run with: its resources, and the barriers that it's to record.
+        class PassContext final
+        {
+            // data members
+
+            FrameGraph const& m_graph;
+            uint32_t m_pass{ 0 };
+
+        public:
+            PassContext(FrameGraph const& graph, uint32_t pass) : m_graph{ graph }, m_pass{ pass } {}
+
+            // member functions
+
+            // Calls activate(Resource) for each transient that the pass uses first, and that shares
+            // memory with others: record an aliasing barrier to it, and then clear (or discard) it,
+            // as its contents are undefined.
+            template <typename Activate>
+            void ForEachActivation(Activate&& activate) const
+            {
+                for (uint32_t const resource : m_graph.m_passes[m_pass].activations) activate(m_graph.m_nodes[resource].resource);
+            }
+
+            // Calls beginTransition(Resource, ResourceStates) for each resource that a later pass
+            // needs in another state, with passes that don't use it in between. Call once the
+            // pass's work is recorded.
+            template <typename BeginTransition>
+            void ForEachBeginTransition(BeginTransition&& beginTransition) const
+            {
+                for (auto const& [resource, state] : m_graph.m_passes[m_pass].beginTransitions) beginTransition(m_graph.m_nodes[resource].resource, state);
+            }
+
+            // Calls transition(Resource, ResourceStates) for each resource that the pass uses, with
+            // the state that it needs it in. Call before recording the pass's work.
+            template <typename Transition>
+            void ForEachTransition(Transition&& transition) const
+            {
+                for (Access const& access : m_graph.m_passes[m_pass].accesses) transition(m_graph.m_nodes[access.resource].resource, access.compiledState);
+            }
+
+            Resource Get(FrameGraphResource resource) const { return m_graph.m_nodes.at(resource.index).resource; }
+            std::string const& Name() const { return m_graph.m_passes[m_pass].name; }
+        };
+
+        // member functions
+
+        // Adds a pass: setup(Builder&) declares what it uses (at once), and execute(PassContext
+        // const&) records its work, when the graph is executed (if it isn't culled). Passes are
+        // added in the order in which a serial frame would run them; a read sees the last write
+        // added before it. If setup throws, the pass is kept with what it declared so far; Reset
+        // the graph.
+        template <typename Setup>
+        void AddPass(std::string name, Setup&& setup, std::function<void(PassContext const&)> execute)
+        {
+            if (m_compiled) throw std::logic_error{ "A frame graph can't change once it's compiled; Reset it." };
+            Pass pass;
+            pass.name = std::move(name);
+            pass.execute = std::move(execute);
+            m_passes.push_back(std::move(pass));
+            Builder builder{ *this, static_cast<uint32_t>(m_passes.size() - 1) };
+            setup(builder);
+        }
+
+        void Compile()
+        {
+            if (m_compiled) throw std::logic_error{ "The frame graph is compiled already." };
+            m_statistics = FrameGraphStatistics{};
+            m_statistics.passes = static_cast<uint32_t>(m_passes.size());
+            Cull();
+            for (Pass const& pass : m_passes) m_statistics.culledPasses += pass.isCulled ? 1 : 0;
+            Schedule();
+            ScheduleTransitions();
+            Place();
+            for (Node const& node : m_nodes) m_statistics.transientResources += !node.isImported && node.firstPosition != s_none ? 1 : 0;
+            m_compiled = true;
+        }
+
+        // Runs the kept passes, in the order scheduled.
+        void Execute() const
+        {
+            if (!m_realized) throw std::logic_error{ "The frame graph's transients aren't realized." };
+            for (uint32_t const pass : m_schedule) m_passes[pass].execute(PassContext{ *this, pass });
+        }
+
+        // A resource that outlives the frame (the back buffer, say), in the state it's in now.
+        FrameGraphResource Import(std::string name, Resource resource, ResourceStates state)
+        {
+            if (m_compiled) throw std::logic_error{ "A frame graph can't change once it's compiled; Reset it." };
+            Node node;
+            node.name = std::move(name);
+            node.resource = resource;
+            node.importedState = state;
+            node.isImported = true;
+            m_nodes.push_back(std::move(node));
+            return FrameGraphResource{ static_cast<uint32_t>(m_nodes.size() - 1) };
+        }
+
+        // Gives the transients that a kept pass uses their backend resources: place(Description
+        // const&, uint64_t heapOffset) returns one, at that offset in a heap of HeapSize() bytes.
+        template <typename PlaceResource>
+        void Realize(PlaceResource&& place)
+        {
+            if (!m_compiled) throw std::logic_error{ "Compile the frame graph before realizing it." };
+            for (Node& node : m_nodes)
+            {
+                if (!node.isImported && node.firstPosition != s_none) node.resource = place(node.description, node.heapOffset);
+            }
+            m_realized = true;
+        }
+
+        // Clears the passes and resources, for the next frame's.
+        void Reset()
+        {
+            m_compiled = m_realized = false;
+            m_nodes.clear();
+            m_passes.clear();
+            m_schedule.clear();
+        }
+
+        // accessors
+
+        uint64_t HeapOffset(FrameGraphResource resource) const { return m_nodes.at(resource.index).heapOffset; }
+        uint64_t HeapSize() const { return m_statistics.heapBytes; }
+        bool IsAliased(FrameGraphResource resource) const { return m_nodes.at(resource.index).isAliased; }
+        bool IsCulled(uint32_t pass) const { return m_passes.at(pass).isCulled; }
+        uint32_t PassCount() const { return static_cast<uint32_t>(m_passes.size()); }
+        std::string const& PassName(uint32_t pass) const { return m_passes.at(pass).name; }
+        std::string const& ResourceName(FrameGraphResource resource) const { return m_nodes.at(resource.index).name; }
+
+        // Kept passes (by the order in which they were added), in the order in which they run.
+        std::vector<uint32_t> const& ScheduledPasses() const { return m_schedule; }
+
+        FrameGraphStatistics const& Statistics() const { return m_statistics; }
+    };
+}
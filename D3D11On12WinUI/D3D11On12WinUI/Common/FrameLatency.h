@@ -0,0 +1,151 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cwchar>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "CommandLine.h"
+
+namespace DX
+{
+    // How many swap chain buffers to use, and how many frames the CPU may queue ahead of the
+    // display. Fewer buffers and a lower latency mean less input-to-display latency; more give
+    // the GPU more slack, and so a steadier frame rate under load.
+    struct FrameLatencySettings final
+    {
+        static constexpr uint32_t s_minNumFramebuffers{ 2 };
+        static constexpr uint32_t s_maxNumFramebuffers{ 4 };
+
+        uint32_t numFramebuffers{ 3 };
+        uint32_t maximumFrameLatency{ 2 }; // The most presents that can be queued before the render thread waits.
+        bool framePacing{ true }; // Delay the start of each frame to just before its deadline (see FramePacer.h).
+
+        // Returns these settings, brought into range. The latency can't usefully exceed the buffer count.
+        FrameLatencySettings Clamped() const
+        {
+            FrameLatencySettings clamped{ *this };
+            clamped.numFramebuffers = std::clamp(numFramebuffers, s_minNumFramebuffers, s_maxNumFramebuffers);
+            clamped.maximumFrameLatency = std::clamp(maximumFrameLatency, 1u, clamped.numFramebuffers);
+            return clamped;
+        }
+
+        // Reads `--buffers N`, `--latency N` and `--no-pacing` from a command line; anything else
+        // is ignored, and so are values that are missing.
+        static FrameLatencySettings Parse(std::wstring_view commandLine)
+        {
+            FrameLatencySettings settings;
+            std::vector<std::wstring_view> const tokens{ SplitCommandLine(commandLine) };
+            for (size_t tokenIndex{ 0 }; tokenIndex < tokens.size(); ++tokenIndex)
+            {
+                if (tokens[tokenIndex] == L"--no-pacing") settings.framePacing = false;
+                if (tokenIndex + 1 == tokens.size()) break;
+
+                uint32_t* pValue{ nullptr };
+                if (tokens[tokenIndex] == L"--buffers") pValue = &settings.numFramebuffers;
+                else if (tokens[tokenIndex] == L"--latency") pValue = &settings.maximumFrameLatency;
+                if (!pValue) continue;
+
+                std::wstring const valueText{ tokens[tokenIndex + 1] };
+                wchar_t* pEnd{ nullptr };
+                unsigned long const value{ std::wcstoul(valueText.c_str(), &pEnd, 10) };
+                if (pEnd != valueText.c_str()) *pValue = static_cast<uint32_t>(value);
+            }
+            return settings.Clamped();
+        }
+    };
+
+    // Percentiles of the latencies that a LatencyMeter has measured, in milliseconds.
+    struct LatencySummary final
+    {
+        size_t sampleCount{ 0 };
+        double p50Milliseconds{ 0. };
+        double p99Milliseconds{ 0. };
+    };
+
+    // Measures the time from when a frame samples its input (the start of the frame) to when
+    // that frame reaches the screen. Frames are identified by present count; the display time
+    // for a frame is known only later (DXGI reports it through the swap chain's frame
+    // statistics), so each frame's start time waits here until it is.
+    class LatencyMeter final
+    {
+        static constexpr size_t s_maxSamples{ 240 }; // Four seconds at 60Hz.
+
+        // data members
+
+        std::deque<std::pair<uint64_t, uint64_t>> m_pendingFrames; // (present count, frame start in nanoseconds)
+        std::vector<double> m_samplesMilliseconds;
+        size_t m_nextSampleIndex{ 0 };
+
+    public:
+        // member functions
+
+        void FramePresented(uint64_t presentCount, uint64_t frameStartNanoseconds)
+        {
+            m_pendingFrames.push_back({ presentCount, frameStartNanoseconds });
+            // Don't let frames whose display times are never reported accumulate.
+            while (m_pendingFrames.size() > s_maxSamples) m_pendingFrames.pop_front();
+        }
+
+        // Records the latency of the frame with the given present count. Earlier frames that are
+        // still pending are discarded; their display times weren't reported, so they can't be measured.
+        void FrameDisplayed(uint64_t presentCount, uint64_t displayNanoseconds)
+        {
+            while (!m_pendingFrames.empty() && m_pendingFrames.front().first <= presentCount)
+            {
+                auto const [pendingPresentCount, frameStartNanoseconds] { m_pendingFrames.front() };
+                m_pendingFrames.pop_front();
+                if (pendingPresentCount != presentCount || displayNanoseconds < frameStartNanoseconds) continue;
+
+                double const milliseconds{ (displayNanoseconds - frameStartNanoseconds) / 1e6 };
+                if (m_samplesMilliseconds.size() < s_maxSamples)
+                {
+                    m_samplesMilliseconds.push_back(milliseconds);
+                }
+                else
+                {
+                    m_samplesMilliseconds[m_nextSampleIndex] = milliseconds;
+                }
+                m_nextSampleIndex = (m_nextSampleIndex + 1) % s_maxSamples;
+            }
+        }
+
+        void Reset()
+        {
+            m_pendingFrames.clear();
+            m_samplesMilliseconds.clear();
+            m_nextSampleIndex = 0;
+        }
+
+        // Summarizes the most recent (up to s_maxSamples) measurements.
+        LatencySummary Summary() const
+        {
+            LatencySummary summary;
+            summary.sampleCount = m_samplesMilliseconds.size();
+            if (summary.sampleCount == 0) return summary;
+
+            std::vector<double> sorted{ m_samplesMilliseconds };
+            std::sort(sorted.begin(), sorted.end());
+            auto percentile = [&](double fraction) { return sorted[std::min(sorted.size() - 1, static_cast<size_t>(fraction * (sorted.size() - 1) + .5))]; };
+            summary.p50Milliseconds = percentile(.5);
+            summary.p99Milliseconds = percentile(.99);
+            return summary;
+        }
+    };
+}
@@ -0,0 +1,184 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// The timing model behind frame pacing. It's free of Windows types, and it's given every
+// time explicitly (in nanoseconds, on whatever clock the swap chain reports display times
+// on), so that it can be driven by a synthetic timeline as well as by DeviceResources.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace DX
+{
+    // Delays the start of each frame so that the frame finishes (CPU recording, then GPU
+    // execution) just before the vblank at which it's meant to be displayed. Starting earlier
+    // than that only makes the frame wait in the queue, with older input; starting at an
+    // arbitrary point in the refresh interval makes the frame times uneven.
+    //
+    // Per frame: call PlanFrame, wait until the time it returns, record, submit and present; then
+    // call FramePresented and, once they're known, GpuFrameMeasured and FrameDisplayed.
+    class FramePacer final
+    {
+        // Keeps the most recent durations, and predicts the next one as the longest of them.
+        class DurationPredictor final
+        {
+            static constexpr size_t s_windowSize{ 32 };
+
+            // data members
+
+            size_t m_count{ 0 };
+            size_t m_nextIndex{ 0 };
+            std::array<uint64_t, s_windowSize> m_samples{};
+
+        public:
+            // member functions
+
+            void Add(uint64_t nanoseconds)
+            {
+                m_samples[m_nextIndex] = nanoseconds;
+                m_nextIndex = (m_nextIndex + 1) % s_windowSize;
+                m_count = std::min(m_count + 1, s_windowSize);
+            }
+
+            // A lower percentile gives lower latency, but each frame that runs over its prediction
+            // misses its vblank; over a window this short, the longest is the better trade.
+            uint64_t Predict() const
+            {
+                return m_count == 0 ? 0 : *std::max_element(m_samples.begin(), m_samples.begin() + m_count);
+            }
+
+            void Reset() { m_count = 0; m_nextIndex = 0; }
+        };
+
+        // data members
+
+        DurationPredictor m_cpuPredictor;
+        DurationPredictor m_gpuPredictor;
+        bool m_haveVblank{ false };
+        uint64_t m_lastDisplayedPresentCount{ 0 };
+        uint64_t m_lastPresentCount{ 0 };
+        uint64_t m_lastVblankNanoseconds{ 0 };
+        uint64_t m_marginNanoseconds{ 1'000'000 }; // Slack for what the predictions don't cover (for example, composition).
+        uint64_t m_missedVsyncs{ 0 };
+        double m_refreshPeriodNanoseconds{ 16'666'667. };
+
+    public:
+        FramePacer(uint64_t refreshPeriodNanoseconds = 16'666'667) :
+            m_refreshPeriodNanoseconds{ static_cast<double>(refreshPeriodNanoseconds) }
+        {
+        }
+
+        // member functions
+
+        // Returns the time at which to start the next frame (never earlier than `nowNanoseconds`).
+        // Until a vblank time is known, that's now.
+        uint64_t PlanFrame(uint64_t nowNanoseconds)
+        {
+            if (!m_haveVblank) return nowNanoseconds;
+
+            uint64_t const predictedCpu{ m_cpuPredictor.Predict() };
+            uint64_t const predictedGpu{ m_gpuPredictor.Predict() };
+            uint64_t const predictedWork{ predictedCpu + predictedGpu + m_marginNanoseconds };
+
+            // One frame's GPU work overlaps the next frame's recording, so the work of a frame may
+            // span more than a refresh. But if either the CPU or the GPU alone can't keep up with
+            // the display, then the queue is needed to absorb the variation, and delaying the
+            // frame would only add missed vsyncs.
+            if (std::max(predictedCpu, predictedGpu) > m_refreshPeriodNanoseconds) return nowNanoseconds;
+
+            // The first vblank that the frame can make; but the frames that are already queued
+            // (presented, but not yet displayed) take a vblank each before it.
+            uint64_t deadline{ VblankAtOrAfter(nowNanoseconds + predictedWork) };
+            if (m_lastPresentCount > m_lastDisplayedPresentCount)
+            {
+                uint64_t const queuedFrames{ m_lastPresentCount - m_lastDisplayedPresentCount };
+                uint64_t const afterQueuedFrames{ m_lastVblankNanoseconds + static_cast<uint64_t>((queuedFrames + .5) * m_refreshPeriodNanoseconds) };
+                deadline = std::max(deadline, VblankAtOrAfter(afterQueuedFrames));
+            }
+
+            return std::max(nowNanoseconds, deadline - predictedWork);
+        }
+
+        // The frame was presented, with the given present count, having taken `cpuNanoseconds`
+        // from its start.
+        void FramePresented(uint64_t presentCount, uint64_t cpuNanoseconds)
+        {
+            m_lastPresentCount = presentCount;
+            m_cpuPredictor.Add(cpuNanoseconds);
+        }
+
+        // The GPU time of a frame (it may be several frames old by the time it's known).
+        void GpuFrameMeasured(uint64_t gpuNanoseconds) { m_gpuPredictor.Add(gpuNanoseconds); }
+
+        // A frame reached the screen, at a vblank. Refines the vblank phase and period, and counts
+        // the vblanks since the previous displayed frame that showed no new frame.
+        void FrameDisplayed(uint64_t presentCount, uint64_t displayNanoseconds)
+        {
+            if (presentCount <= m_lastDisplayedPresentCount) return;
+
+            if (m_haveVblank && displayNanoseconds > m_lastVblankNanoseconds)
+            {
+                double const interval{ static_cast<double>(displayNanoseconds - m_lastVblankNanoseconds) };
+                double const refreshes{ std::round(interval / m_refreshPeriodNanoseconds) };
+                uint64_t const newFrames{ presentCount - m_lastDisplayedPresentCount };
+
+                if (refreshes >= 1. && refreshes <= 8.)
+                {
+                    // The display's period drifts slowly, if at all; follow it gently.
+                    m_refreshPeriodNanoseconds += (interval / refreshes - m_refreshPeriodNanoseconds) / 8.;
+                }
+                if (refreshes > static_cast<double>(newFrames))
+                {
+                    m_missedVsyncs += static_cast<uint64_t>(refreshes) - newFrames;
+                }
+            }
+
+            m_haveVblank = true;
+            m_lastDisplayedPresentCount = presentCount;
+            m_lastVblankNanoseconds = displayNanoseconds;
+        }
+
+        // Forgets the vblank phase and the predictions (for example, when the swap chain is replaced).
+        void Reset()
+        {
+            m_cpuPredictor.Reset();
+            m_gpuPredictor.Reset();
+            m_haveVblank = false;
+            m_lastDisplayedPresentCount = 0;
+            m_lastPresentCount = 0;
+        }
+
+        // Returns the first vblank at or after `nanoseconds`, extrapolated from the last one seen.
+        uint64_t VblankAtOrAfter(uint64_t nanoseconds) const
+        {
+            if (nanoseconds <= m_lastVblankNanoseconds) return m_lastVblankNanoseconds;
+            double const refreshes{ std::ceil((nanoseconds - m_lastVblankNanoseconds) / m_refreshPeriodNanoseconds) };
+            return m_lastVblankNanoseconds + static_cast<uint64_t>(refreshes * m_refreshPeriodNanoseconds);
+        }
+
+        // accessors
+
+        uint64_t MarginNanoseconds() const { return m_marginNanoseconds; }
+        uint64_t MissedVsyncs() const { return m_missedVsyncs; }
+        uint64_t PredictedCpuNanoseconds() const { return m_cpuPredictor.Predict(); }
+        uint64_t PredictedGpuNanoseconds() const { return m_gpuPredictor.Predict(); }
+        uint64_t RefreshPeriodNanoseconds() const { return static_cast<uint64_t>(m_refreshPeriodNanoseconds); }
+
+        // mutators
+
+        void MarginNanoseconds(uint64_t marginNanoseconds) { m_marginNanoseconds = marginNanoseconds; }
+    };
+}
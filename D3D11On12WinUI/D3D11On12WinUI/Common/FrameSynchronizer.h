@@ -0,0 +1,108 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "RenderDevice.h"
+
+namespace DX
+{
+    // Tracks one fence value per frame buffer, so that the CPU can run ahead of the GPU by
+    // up to (number of frame buffers - 1) frames. This is the CPU-GPU synchronization logic
+    // of DeviceResources, written against the backend-neutral interfaces so that the same
+    // code runs against the headless backend.
+    class FrameSynchronizer final
+    {
+        // data members
+
+        uint32_t m_currentBufferIndex{ 0 };
+        std::vector<uint64_t> m_fenceValues;
+
+    public:
+        FrameSynchronizer(uint32_t numFramebuffers = 3) :
+            m_fenceValues(numFramebuffers, 0)
+        {
+        }
+
+        // member functions
+
+        // Prepare to render the next frame.
+        void MoveToNextFrame(IRenderCommandQueue& commandQueue, IRenderFence& fence, uint32_t newCurrentBufferIndex)
+        {
+            // Put a signal on the queue for the old current frame's fence value.
+            uint64_t const fenceValueForOldCurrentBuffer{ m_fenceValues[m_currentBufferIndex] };
+            commandQueue.Signal(fence, fenceValueForOldCurrentBuffer);
+
+            // From here on, "current" means "new current".
+            m_currentBufferIndex = newCurrentBufferIndex;
+            uint64_t& fenceValueForNewCurrentBuffer{ m_fenceValues[m_currentBufferIndex] };
+
+            // If the fence values of all the frames are still queued, then wait for the
+            // oldest frame to become free (the value of fenceValueForNewCurrentBuffer
+            // represents that oldest value, since we haven't updated that value yet).
+            if (fence.CompletedValue() < fenceValueForNewCurrentBuffer)
+            {
+                fence.WaitForValue(fenceValueForNewCurrentBuffer);
+            }
+
+            // Set the fence value for the "new current" frame (which we'll signal the next time through this function).
+            fenceValueForNewCurrentBuffer = fenceValueForOldCurrentBuffer + 1;
+        }
+
+        // Wait for the GPU to drain its work queue, using the current buffer's fence value as the signal value.
+        void WaitForGpu(IRenderCommandQueue& commandQueue, IRenderFence& fence) const
+        {
+            uint64_t const fenceValueForCurrentBuffer{ m_fenceValues[m_currentBufferIndex] };
+            commandQueue.Signal(fence, fenceValueForCurrentBuffer);
+            fence.WaitForValue(fenceValueForCurrentBuffer);
+        }
+
+        // Makes a different buffer current without presenting (for example, because the swap
+        // chain has been replaced, and its current buffer index starts again). Waits only until
+        // the GPU has finished with the new current buffer's last frame, not until it's idle.
+        void SwitchToBuffer(IRenderFence& fence, uint32_t newCurrentBufferIndex)
+        {
+            if (newCurrentBufferIndex == m_currentBufferIndex) return;
+
+            uint64_t const fenceValueForCurrentFrame{ m_fenceValues[m_currentBufferIndex] };
+            uint64_t& fenceValueForNewCurrentBuffer{ m_fenceValues[newCurrentBufferIndex] };
+            if (fence.CompletedValue() < fenceValueForNewCurrentBuffer)
+            {
+                fence.WaitForValue(fenceValueForNewCurrentBuffer);
+            }
+
+            // The current frame's (not yet signaled) fence value moves with it. The old buffer keeps
+            // that value too, which is conservative, since that buffer isn't used by this frame.
+            fenceValueForNewCurrentBuffer = fenceValueForCurrentFrame;
+            m_currentBufferIndex = newCurrentBufferIndex;
+        }
+
+        // Returns the value to create the fence with, and advances the current buffer's fence
+        // value past it. Call once per fence (that is, once per device).
+        uint64_t BeginFenceTimeline()
+        {
+            return m_fenceValues[m_currentBufferIndex]++;
+        }
+
+        // accessors
+
+        uint32_t CurrentBufferIndex() const { return m_currentBufferIndex; }
+        uint64_t CurrentFenceValue() const { return m_fenceValues[m_currentBufferIndex]; }
+        uint32_t NumFramebuffers() const { return static_cast<uint32_t>(m_fenceValues.size()); }
+
+        // mutators
+
+        void CurrentBufferIndex(uint32_t currentBufferIndex) { m_currentBufferIndex = currentBufferIndex; }
+    };
+}
@@ -0,0 +1,240 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// The backend-neutral glyph atlas that D3D12GlyphRenderer draws text from: one texture into
+// which every glyph that's drawn is rasterized once, and packed by SkylinePacker. Glyphs stay
+// until the atlas is full; then it's emptied (see GlyphBatcher), and the glyphs still being
+// drawn are packed again.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace DX
+{
+    struct AtlasRect final
+    {
+        uint32_t x{ 0 };
+        uint32_t y{ 0 };
+        uint32_t width{ 0 };
+        uint32_t height{ 0 };
+    };
+
+    // Packs rectangles into a fixed area, keeping only the skyline (the top edge of what's been
+    // packed, as a list of horizontal segments); each is placed where its top would be lowest
+    // (bottom-left). Rectangles aren't freed one by one; Reset frees them all. Good for glyphs,
+    // whose heights vary little.
+    class SkylinePacker final
+    {
+        // The packed area's top edge is at y over [x, x + width).
+        struct Segment final
+        {
+            uint32_t x{ 0 };
+            uint32_t y{ 0 };
+            uint32_t width{ 0 };
+        };
+
+        // data members
+
+        uint32_t m_height{ 0 };
+        std::vector<Segment> m_skyline; // Left to right, covering the width.
+        uint64_t m_usedArea{ 0 };
+        uint32_t m_width{ 0 };
+
+        // member functions
+
+        // The y at which a rectangle whose left edge is that of segment `index` would rest, or nothing if it doesn't fit there.
+        std::optional<uint32_t> Fit(size_t index, uint32_t width, uint32_t height) const
+        {
+            if (m_skyline[index].x + width > m_width) return std::nullopt;
+            uint32_t y{ 0 };
+            for (uint32_t covered{ 0 }; covered < width; ++index)
+            {
+                y = std::max(y, m_skyline[index].y);
+                if (y + height > m_height) return std::nullopt;
+                covered += m_skyline[index].width;
+            }
+            return y;
+        }
+
+    public:
+        SkylinePacker(uint32_t width, uint32_t height) :
+            m_height{ height },
+            m_width{ width }
+        {
+            Reset();
+        }
+
+        // member functions
+
+        // Returns where a `width` x `height` rectangle was placed, or nothing if there's no room.
+        std::optional<AtlasRect> Pack(uint32_t width, uint32_t height)
+        {
+            if (width == 0 || height == 0) return AtlasRect{ 0, 0, width, height };
+
+            size_t bestIndex{ m_skyline.size() };
+            uint32_t bestTop{ UINT32_MAX };
+            uint32_t bestY{ 0 };
+            for (size_t index{ 0 }; index < m_skyline.size(); ++index)
+            {
+                std::optional<uint32_t> const y{ Fit(index, width, height) };
+                if (!y || *y + height >= bestTop) continue;
+                bestIndex = index;
+                bestTop = *y + height;
+                bestY = *y;
+            }
+            if (bestIndex == m_skyline.size()) return std::nullopt;
+
+            // The new segment covers [x, x + width); trim or drop those that it overlaps, and merge it with any neighbor at its height.
+            AtlasRect const rect{ m_skyline[bestIndex].x, bestY, width, height };
+            uint32_t const right{ rect.x + width };
+            m_skyline.insert(m_skyline.begin() + bestIndex, Segment{ rect.x, bestTop, width });
+            size_t next{ bestIndex + 1 };
+            while (next < m_skyline.size() && m_skyline[next].x < right)
+            {
+                Segment& segment{ m_skyline[next] };
+                uint32_t const segmentRight{ segment.x + segment.width };
+                if (segmentRight <= right)
+                {
+                    m_skyline.erase(m_skyline.begin() + next);
+                    continue;
+                }
+                segment.width = segmentRight - right;
+                segment.x = right;
+                break;
+            }
+            if (next < m_skyline.size() && m_skyline[next].y == bestTop)
+            {
+                m_skyline[bestIndex].width += m_skyline[next].width;
+                m_skyline.erase(m_skyline.begin() + next);
+            }
+            if (bestIndex > 0 && m_skyline[bestIndex - 1].y == bestTop)
+            {
+                m_skyline[bestIndex - 1].width += m_skyline[bestIndex].width;
+                m_skyline.erase(m_skyline.begin() + bestIndex);
+            }
+
+            m_usedArea += uint64_t{ width } * height;
+            return rect;
+        }
+
+        void Reset()
+        {
+            m_skyline.assign(1, Segment{ 0, 0, m_width });
+            m_usedArea = 0;
+        }
+
+        // accessors
+
+        uint32_t Height() const { return m_height; }
+        double Occupancy() const { return m_width && m_height ? static_cast<double>(m_usedArea) / (uint64_t{ m_width } * m_height) : 0.; }
+        size_t SegmentCount() const { return m_skyline.size(); }
+        uint32_t Width() const { return m_width; }
+    };
+
+    // A glyph of a font face (an index that the text engine gives it, say) at a size in pixels.
+    struct GlyphKey final
+    {
+        uint32_t fontFace{ 0 };
+        uint32_t glyphIndex{ 0 };
+        uint32_t pixelSize{ 0 }; // In 1/64ths of a pixel, so that sizes that differ by less than that share glyphs.
+
+        bool operator==(GlyphKey const& other) const { return fontFace == other.fontFace && glyphIndex == other.glyphIndex && pixelSize == other.pixelSize; }
+    };
+
+    struct GlyphKeyHash final
+    {
+        size_t operator()(GlyphKey const& key) const
+        {
+            uint64_t const bits{ (uint64_t{ key.fontFace } << 48) ^ (uint64_t{ key.glyphIndex } << 24) ^ key.pixelSize };
+            return static_cast<size_t>(bits * 0x9e3779b97f4a7c15ull >> 16);
+        }
+    };
+
+    // Where a glyph's bitmap is in the atlas, and where it's drawn relative to the pen (on the baseline).
+    struct AtlasGlyph final
+    {
+        AtlasRect rect; // Empty for glyphs with no pixels (spaces).
+        int32_t left{ 0 };
+        int32_t top{ 0 }; // Negative above the baseline.
+    };
+
+    struct GlyphAtlasStatistics final
+    {
+        uint64_t hits{ 0 };
+        uint64_t misses{ 0 };
+        uint64_t resets{ 0 }; // Times that the atlas was emptied, because it was full.
+
+        double HitRate() const { return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0.; }
+    };
+
+    class GlyphAtlas final
+    {
+        static constexpr uint32_t s_padding{ 1 }; // Between glyphs, so that a quad's edge never samples a neighbor.
+
+        // data members
+
+        std::unordered_map<GlyphKey, AtlasGlyph, GlyphKeyHash> m_glyphs;
+        SkylinePacker m_packer;
+        GlyphAtlasStatistics m_statistics;
+
+    public:
+        GlyphAtlas(uint32_t width, uint32_t height) :
+            m_packer{ width, height }
+        {
+        }
+
+        // member functions
+
+        // Places a glyph's bitmap; returns nullptr if the atlas is full.
+        AtlasGlyph const* Add(GlyphKey const& key, uint32_t width, uint32_t height, int32_t left, int32_t top)
+        {
+            std::optional<AtlasRect> rect{ AtlasRect{} };
+            if (width > 0 && height > 0)
+            {
+                rect = m_packer.Pack(width + s_padding, height + s_padding);
+                if (!rect) return nullptr;
+                rect->width = width;
+                rect->height = height;
+            }
+            return &(m_glyphs[key] = AtlasGlyph{ *rect, left, top });
+        }
+
+        // Returns the glyph, or nullptr if it isn't in the atlas; and counts the lookup.
+        AtlasGlyph const* Find(GlyphKey const& key)
+        {
+            auto const it{ m_glyphs.find(key) };
+            ++(it == m_glyphs.end() ? m_statistics.misses : m_statistics.hits);
+            return it == m_glyphs.end() ? nullptr : &it->second;
+        }
+
+        // Empties the atlas (what was drawn from it must be placed again).
+        void Reset()
+        {
+            m_glyphs.clear();
+            m_packer.Reset();
+            ++m_statistics.resets;
+        }
+
+        // accessors
+
+        size_t GlyphCount() const { return m_glyphs.size(); }
+        uint32_t Height() const { return m_packer.Height(); }
+        double Occupancy() const { return m_packer.Occupancy(); }
+        GlyphAtlasStatistics const& Statistics() const { return m_statistics; }
+        uint32_t Width() const { return m_packer.Width(); }
+    };
+}
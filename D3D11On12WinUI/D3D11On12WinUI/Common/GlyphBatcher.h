@@ -0,0 +1,267 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// The backend-neutral part of D3D12GlyphRenderer: turns a frame's glyph runs (from DirectWrite,
+// or any text engine) into one quad per glyph, each an instance of one instanced draw, textured
+// from a GlyphAtlas. A glyph that isn't in the atlas is rasterized (by the caller's rasterizer)
+// and packed into it, and its bitmap is queued to be uploaded before the draw. If the atlas
+// fills up, it's emptied, and the glyphs that the frame has drawn so far are placed again;
+// if it fills up again in the same frame, the frame's glyphs that don't fit are dropped.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "GlyphAtlas.h"
+
+namespace DX
+{
+    // An instance of the glyph pipeline's quad (see shader_vx_glyph.hlsl), in pixels from the
+    // top left of the render target; and its texture coordinates in the atlas.
+    struct GlyphQuad final
+    {
+        float x{ 0.f };
+        float y{ 0.f };
+        float width{ 0.f };
+        float height{ 0.f };
+        float u0{ 0.f };
+        float v0{ 0.f };
+        float u1{ 0.f };
+        float v1{ 0.f };
+        uint32_t color{ 0 }; // RGBA, red in the low byte; not premultiplied.
+    };
+
+    // A glyph of a run, with its pen position (on the baseline), in pixels.
+    struct GlyphPosition final
+    {
+        uint32_t glyphIndex{ 0 };
+        float x{ 0.f };
+        float y{ 0.f };
+    };
+
+    // What a rasterizer made of a glyph: its coverage, `width` bytes a row, and where it's drawn
+    // relative to the pen. Glyphs with no pixels (spaces) have no width or height.
+    struct GlyphBitmap final
+    {
+        uint32_t width{ 0 };
+        uint32_t height{ 0 };
+        int32_t left{ 0 };
+        int32_t top{ 0 }; // Negative above the baseline.
+    };
+
+    // A glyph's bitmap, to be copied into the atlas at `rect`; its rows are `rect.width` bytes,
+    // from `offset` in GlyphBatcher::UploadBytes.
+    struct GlyphUpload final
+    {
+        AtlasRect rect;
+        size_t offset{ 0 };
+    };
+
+    struct GlyphBatcherStatistics final
+    {
+        uint64_t runs{ 0 };
+        uint64_t glyphs{ 0 };
+        uint64_t quads{ 0 }; // Glyphs with pixels.
+        uint64_t rasterized{ 0 };
+        uint64_t dropped{ 0 }; // Glyphs that didn't fit in the atlas even when it was emptied for them.
+    };
+
+    class GlyphBatcher final
+    {
+        // A quad's glyph, to place it again if the atlas is emptied.
+        struct QuadGlyph final
+        {
+            GlyphKey key;
+            AtlasGlyph glyph;
+        };
+
+        // data members
+
+        GlyphAtlas m_atlas;
+        std::vector<uint8_t> m_atlasPixels; // A copy of the atlas texture, from which Repack places glyphs again.
+        std::vector<QuadGlyph> m_quadGlyphs; // Of m_quads.
+        std::vector<GlyphQuad> m_quads;
+        std::vector<uint8_t> m_pixels; // The rasterizer's.
+        bool m_repacked{ false }; // This frame; the atlas holds only its glyphs, so emptying it again wouldn't help.
+        std::vector<uint8_t> m_uploadBytes;
+        std::vector<GlyphUpload> m_uploads;
+        GlyphBatcherStatistics m_statistics;
+
+        // member functions
+
+        // Adds a glyph's bitmap (`width` bytes a row) to the atlas and its copy, and queues its upload; returns nullptr if the atlas is full.
+        AtlasGlyph const* Add(GlyphKey const& key, GlyphBitmap const& bitmap, uint8_t const* pPixels)
+        {
+            AtlasGlyph const* pGlyph{ m_atlas.Add(key, bitmap.width, bitmap.height, bitmap.left, bitmap.top) };
+            if (!pGlyph || pGlyph->rect.width == 0) return pGlyph;
+
+            AtlasRect const& rect{ pGlyph->rect };
+            m_uploads.push_back(GlyphUpload{ rect, m_uploadBytes.size() });
+            m_uploadBytes.insert(m_uploadBytes.end(), pPixels, pPixels + size_t{ rect.width } * rect.height);
+            for (uint32_t row{ 0 }; row < rect.height; ++row)
+            {
+                std::copy_n(pPixels + size_t{ row } * rect.width, rect.width, &m_atlasPixels[size_t{ rect.y + row } * m_atlas.Width() + rect.x]);
+            }
+            return pGlyph;
+        }
+
+        // Rasterizes a glyph into the atlas; returns nullptr if the atlas is full.
+        template <typename Rasterize>
+        AtlasGlyph const* Place(GlyphKey const& key, Rasterize& rasterize)
+        {
+            m_pixels.clear();
+            GlyphBitmap const bitmap{ rasterize(key.glyphIndex, m_pixels) };
+            ++m_statistics.rasterized;
+            m_pixels.resize(size_t{ bitmap.width } * bitmap.height);
+            return Add(key, bitmap, m_pixels.data());
+        }
+
+        // Empties the atlas, and places the glyphs of the quads so far again (from the atlas's
+        // copy, as they may be of other runs than the one being added, so other font faces and
+        // sizes than its rasterizer's); those that don't fit are dropped.
+        void Repack()
+        {
+            struct Saved final
+            {
+                size_t offset{ 0 }; // In `pixels`.
+                AtlasGlyph const* pPlaced{ nullptr };
+            };
+            std::unordered_map<GlyphKey, Saved, GlyphKeyHash> saved;
+            std::vector<uint8_t> pixels;
+            for (QuadGlyph const& quadGlyph : m_quadGlyphs)
+            {
+                if (!saved.emplace(quadGlyph.key, Saved{ pixels.size() }).second) continue;
+                AtlasRect const& rect{ quadGlyph.glyph.rect };
+                for (uint32_t row{ 0 }; row < rect.height; ++row)
+                {
+                    uint8_t const* pRow{ &m_atlasPixels[size_t{ rect.y + row } * m_atlas.Width() + rect.x] };
+                    pixels.insert(pixels.end(), pRow, pRow + rect.width);
+                }
+            }
+
+            m_atlas.Reset();
+            m_uploads.clear();
+            m_uploadBytes.clear();
+            size_t kept{ 0 };
+            for (size_t quad{ 0 }; quad < m_quads.size(); ++quad)
+            {
+                QuadGlyph const& quadGlyph{ m_quadGlyphs[quad] };
+                Saved& glyph{ saved[quadGlyph.key] };
+                if (!glyph.pPlaced)
+                {
+                    GlyphBitmap const bitmap{ quadGlyph.glyph.rect.width, quadGlyph.glyph.rect.height, quadGlyph.glyph.left, quadGlyph.glyph.top };
+                    glyph.pPlaced = Add(quadGlyph.key, bitmap, pixels.data() + glyph.offset);
+                }
+                if (!glyph.pPlaced)
+                {
+                    ++m_statistics.dropped;
+                    continue;
+                }
+                m_quads[kept] = m_quads[quad];
+                m_quadGlyphs[kept] = QuadGlyph{ quadGlyph.key, *glyph.pPlaced };
+                TexCoords(glyph.pPlaced->rect, m_quads[kept]);
+                ++kept;
+            }
+            m_quads.resize(kept);
+            m_quadGlyphs.resize(kept);
+        }
+
+        void TexCoords(AtlasRect const& rect, GlyphQuad& quad) const
+        {
+            float const inverseWidth{ 1.f / m_atlas.Width() };
+            float const inverseHeight{ 1.f / m_atlas.Height() };
+            quad.u0 = rect.x * inverseWidth;
+            quad.v0 = rect.y * inverseHeight;
+            quad.u1 = (rect.x + rect.width) * inverseWidth;
+            quad.v1 = (rect.y + rect.height) * inverseHeight;
+        }
+
+    public:
+        GlyphBatcher(uint32_t atlasWidth, uint32_t atlasHeight) :
+            m_atlas{ atlasWidth, atlasHeight },
+            m_atlasPixels(size_t{ atlasWidth } * atlasHeight)
+        {
+        }
+
+        // member functions
+
+        // Adds a run of glyphs of a font face at a size, in a color. Each glyph is drawn with its
+        // bitmap's top left on a whole pixel. rasterize(glyphIndex, std::vector<uint8_t>& pixels)
+        // appends a glyph's coverage to `pixels` and returns its GlyphBitmap; it's called only for
+        // glyphs that aren't in the atlas.
+        template <typename Rasterize>
+        void AddGlyphRun(uint32_t fontFace, float pixelSize, GlyphPosition const* pGlyphs, size_t glyphCount, uint32_t color, Rasterize&& rasterize)
+        {
+            ++m_statistics.runs;
+            uint32_t const size{ static_cast<uint32_t>(std::lround(pixelSize * 64.f)) };
+            for (size_t glyph{ 0 }; glyph < glyphCount; ++glyph)
+            {
+                ++m_statistics.glyphs;
+                GlyphKey const key{ fontFace, pGlyphs[glyph].glyphIndex, size };
+                AtlasGlyph const* pGlyph{ m_atlas.Find(key) };
+                if (!pGlyph) pGlyph = Place(key, rasterize);
+                if (!pGlyph && !m_repacked)
+                {
+                    Repack();
+                    m_repacked = true;
+                    pGlyph = Place(key, rasterize);
+                }
+                if (!pGlyph)
+                {
+                    ++m_statistics.dropped;
+                    continue;
+                }
+                if (pGlyph->rect.width == 0) continue;
+
+                GlyphQuad quad;
+                quad.x = std::round(pGlyphs[glyph].x) + pGlyph->left;
+                quad.y = std::round(pGlyphs[glyph].y) + pGlyph->top;
+                quad.width = static_cast<float>(pGlyph->rect.width);
+                quad.height = static_cast<float>(pGlyph->rect.height);
+                quad.color = color;
+                TexCoords(pGlyph->rect, quad);
+                m_quads.push_back(quad);
+                m_quadGlyphs.push_back(QuadGlyph{ key, *pGlyph });
+                ++m_statistics.quads;
+            }
+        }
+
+        // Starts a frame: no quads, and nothing to upload.
+        void Begin()
+        {
+            m_quadGlyphs.clear();
+            m_quads.clear();
+            m_repacked = false;
+            m_uploadBytes.clear();
+            m_uploads.clear();
+        }
+
+        // Empties the atlas; for when its texture is lost (with the device, say).
+        void ResetAtlas()
+        {
+            Begin();
+            m_atlas.Reset();
+        }
+
+        // accessors
+
+        GlyphAtlas const& Atlas() const { return m_atlas; }
+        std::vector<GlyphQuad> const& Quads() const { return m_quads; }
+        GlyphBatcherStatistics const& Statistics() const { return m_statistics; }
+        std::vector<uint8_t> const& UploadBytes() const { return m_uploadBytes; }
+        std::vector<GlyphUpload> const& Uploads() const { return m_uploads; }
+    };
+}
@@ -0,0 +1,64 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "pch.h"
+
+namespace DX
+{
+    GpuFrameTimer::GpuFrameTimer(::ID3D12Device* pD3D12Device, ::ID3D12CommandQueue* pD3D12CommandQueue, UINT numFramebuffers)
+    {
+        winrt::check_hresult(pD3D12CommandQueue->GetTimestampFrequency(&m_timestampFrequency));
+
+        D3D12_QUERY_HEAP_DESC queryHeapDesc{};
+        queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+        queryHeapDesc.Count = 2 * numFramebuffers;
+        winrt::check_hresult(pD3D12Device->CreateQueryHeap(&queryHeapDesc, __uuidof(m_pD3D12QueryHeap), m_pD3D12QueryHeap.put_void()));
+
+        D3D12_HEAP_PROPERTIES heapPropertiesReadback{ CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK) };
+        D3D12_RESOURCE_DESC readbackBufferDesc{ CD3DX12_RESOURCE_DESC::Buffer(sizeof(uint64_t) * queryHeapDesc.Count) };
+        winrt::check_hresult(pD3D12Device->CreateCommittedResource(
+            &heapPropertiesReadback,
+            D3D12_HEAP_FLAG_NONE,
+            &readbackBufferDesc,
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            nullptr,
+            __uuidof(m_pD3D12ReadbackBuffer),
+            m_pD3D12ReadbackBuffer.put_void()));
+    }
+
+    void GpuFrameTimer::Begin(::ID3D12GraphicsCommandList* pD3D12GraphicsCommandList, UINT frameIndex) const
+    {
+        pD3D12GraphicsCommandList->EndQuery(m_pD3D12QueryHeap.get(), D3D12_QUERY_TYPE_TIMESTAMP, 2 * frameIndex);
+    }
+
+    void GpuFrameTimer::End(::ID3D12GraphicsCommandList* pD3D12GraphicsCommandList, UINT frameIndex) const
+    {
+        pD3D12GraphicsCommandList->EndQuery(m_pD3D12QueryHeap.get(), D3D12_QUERY_TYPE_TIMESTAMP, 2 * frameIndex + 1);
+        pD3D12GraphicsCommandList->ResolveQueryData(m_pD3D12QueryHeap.get(), D3D12_QUERY_TYPE_TIMESTAMP, 2 * frameIndex, 2, m_pD3D12ReadbackBuffer.get(), sizeof(uint64_t) * 2 * frameIndex);
+    }
+
+    bool GpuFrameTimer::TryGetNanoseconds(UINT frameIndex, uint64_t& nanoseconds) const
+    {
+        D3D12_RANGE readRange{ sizeof(uint64_t) * 2 * frameIndex, sizeof(uint64_t) * (2 * frameIndex + 2) };
+        uint64_t* pTimestamps{ nullptr };
+        winrt::check_hresult(m_pD3D12ReadbackBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pTimestamps)));
+        uint64_t const begin{ pTimestamps[2 * frameIndex] };
+        uint64_t const end{ pTimestamps[2 * frameIndex + 1] };
+        D3D12_RANGE writtenRange{ 0, 0 }; // We didn't write anything.
+        m_pD3D12ReadbackBuffer->Unmap(0, &writtenRange);
+
+        // Until a frame has been resolved into this slot, the buffer holds zeros.
+        if (end <= begin || m_timestampFrequency == 0) return false;
+        uint64_t const ticks{ end - begin };
+        nanoseconds = ticks / m_timestampFrequency * 1'000'000'000ull + ticks % m_timestampFrequency * 1'000'000'000ull / m_timestampFrequency;
+        return true;
+    }
+}
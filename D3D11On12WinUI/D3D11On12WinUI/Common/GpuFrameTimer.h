@@ -0,0 +1,39 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+namespace DX
+{
+    // Measures the GPU time of each frame's Direct3D 12 command list with a pair of timestamp
+    // queries per frame buffer. The results for a frame buffer can be read once the GPU has
+    // finished that buffer's frame (that is, after FrameSynchronizer has waited for it).
+    class GpuFrameTimer final
+    {
+        // data members
+
+        uint64_t m_timestampFrequency{ 0 };
+        winrt::com_ptr<::ID3D12QueryHeap> m_pD3D12QueryHeap{ nullptr };
+        winrt::com_ptr<::ID3D12Resource> m_pD3D12ReadbackBuffer{ nullptr };
+
+    public:
+        GpuFrameTimer(::ID3D12Device* pD3D12Device, ::ID3D12CommandQueue* pD3D12CommandQueue, UINT numFramebuffers);
+
+        // member functions
+
+        // Record these at the start and end of the frame's command list.
+        void Begin(::ID3D12GraphicsCommandList* pD3D12GraphicsCommandList, UINT frameIndex) const;
+        void End(::ID3D12GraphicsCommandList* pD3D12GraphicsCommandList, UINT frameIndex) const;
+
+        // Returns `false` if the frame buffer has no complete measurement yet.
+        bool TryGetNanoseconds(UINT frameIndex, uint64_t& nanoseconds) const;
+    };
+}
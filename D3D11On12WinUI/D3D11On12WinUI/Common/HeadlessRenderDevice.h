@@ -0,0 +1,601 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// A headless implementation of the RenderDevice.h interfaces. Command lists record their
+// calls; the queue estimates a GPU cost for each submitted list and advances a simulated GPU
+// timeline; fences complete, and swap chains flip, according to that timeline. Nothing is
+// drawn, unless the queue is given an executor (see SoftwareRasterizer.h). Like the render loop in Sample3DSceneRenderer, drive these objects from one thread.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "RenderDevice.h"
+
+namespace DX
+{
+    // Either wall-clock time, or virtual time that moves only when it's advanced explicitly
+    // (or when something waits on it). Virtual time makes runs deterministic, and lets a run
+    // simulate seconds of GPU work in microseconds.
+    class HeadlessClock final
+    {
+        // data members
+
+        std::chrono::steady_clock::time_point m_origin{ std::chrono::steady_clock::now() };
+        bool m_isVirtual{ false };
+        uint64_t m_virtualNanoseconds{ 0 };
+
+    public:
+        HeadlessClock(bool isVirtual = false) :
+            m_isVirtual{ isVirtual }
+        {
+        }
+
+        // member functions
+
+        // Advances virtual time (for example, by the measured CPU cost of a frame). Has no effect on a wall clock.
+        void Advance(uint64_t nanoseconds)
+        {
+            if (m_isVirtual) m_virtualNanoseconds += nanoseconds;
+        }
+
+        uint64_t NowNanoseconds() const
+        {
+            if (m_isVirtual) return m_virtualNanoseconds;
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_origin).count());
+        }
+
+        void SleepUntil(uint64_t nanoseconds)
+        {
+            if (m_isVirtual)
+            {
+                m_virtualNanoseconds = std::max(m_virtualNanoseconds, nanoseconds);
+            }
+            else
+            {
+                std::this_thread::sleep_until(m_origin + std::chrono::nanoseconds(nanoseconds));
+            }
+        }
+
+        // accessors
+
+        bool IsVirtual() const { return m_isVirtual; }
+    };
+
+    // How many simulated GPU nanoseconds each kind of command costs.
+    struct HeadlessGpuCostModel final
+    {
+        uint64_t commandListOverhead{ 5'000 };
+        uint64_t perBarrier{ 500 };
+        uint64_t perClearedPixel{ 0 }; // Nonzero values make clears scale with the render target size.
+        uint64_t perDraw{ 2'000 };
+        uint64_t perDrawnIndex{ 2 };
+        uint64_t perDrawnInstance{ 20 };
+        uint64_t perPresent{ 50'000 }; // Composition and flip.
+    };
+
+    class HeadlessRenderResource final : public IRenderResource
+    {
+        // data members
+
+        RenderHeapType m_heapType{ RenderHeapType::Default };
+        std::vector<uint8_t> m_storage;
+        uint32_t m_width{ 0 };
+        uint32_t m_height{ 0 };
+
+    public:
+        HeadlessRenderResource(RenderHeapType heapType, uint64_t sizeInBytes, uint32_t width = 0, uint32_t height = 0) :
+            m_heapType{ heapType },
+            m_storage(static_cast<size_t>(sizeInBytes)),
+            m_width{ width },
+            m_height{ height }
+        {
+        }
+
+        // member functions
+
+        uint64_t SizeInBytes() const override { return m_storage.size(); }
+
+        // Unlike a GPU resource, every headless resource is CPU-addressable, so that a
+        // CPU executor can read vertex, index, and constant data.
+        void* Map() override { return m_storage.data(); }
+        void Unmap() override {}
+
+        // accessors
+
+        uint8_t const* Data() const { return m_storage.data(); }
+        uint8_t* Data() { return m_storage.data(); }
+        RenderHeapType HeapType() const { return m_heapType; }
+        uint32_t Height() const { return m_height; }
+        uint32_t Width() const { return m_width; }
+    };
+
+    enum class HeadlessCommandType : uint32_t
+    {
+        ResourceBarrier,
+        SetViewport,
+        SetScissorRect,
+        ClearRenderTarget,
+        ClearDepth,
+        SetRenderTargets,
+        SetConstantBuffer,
+        SetVertexBuffer,
+        SetIndexBuffer,
+        DrawIndexedInstanced,
+        Count
+    };
+
+    // One recorded command. The meaning of the fields depends on the type.
+    struct HeadlessCommand final
+    {
+        HeadlessCommandType type{};
+        HeadlessRenderResource* resources[2]{};
+        uint32_t values[5]{};
+        float floats[6]{};
+    };
+
+    class HeadlessRenderCommandList final : public IRenderCommandList
+    {
+        // data members
+
+        std::vector<HeadlessCommand> m_commands;
+        bool m_isClosed{ false };
+
+        HeadlessCommand& Record(HeadlessCommandType type)
+        {
+            if (m_isClosed) throw std::logic_error("Recording into a closed command list.");
+            m_commands.push_back(HeadlessCommand{});
+            m_commands.back().type = type;
+            return m_commands.back();
+        }
+
+    public:
+        // member functions
+
+        void Close() override { m_isClosed = true; }
+
+        // The command list can be reset any time after it has been submitted.
+        void Reset()
+        {
+            m_commands.clear();
+            m_isClosed = false;
+        }
+
+        void ResourceBarrier(HeadlessRenderResource* pResource)
+        {
+            Record(HeadlessCommandType::ResourceBarrier).resources[0] = pResource;
+        }
+
+        void SetViewport(float x, float y, float width, float height, float minDepth, float maxDepth)
+        {
+            HeadlessCommand& command{ Record(HeadlessCommandType::SetViewport) };
+            float const values[]{ x, y, width, height, minDepth, maxDepth };
+            std::copy(std::begin(values), std::end(values), command.floats);
+        }
+
+        void SetScissorRect(uint32_t left, uint32_t top, uint32_t right, uint32_t bottom)
+        {
+            HeadlessCommand& command{ Record(HeadlessCommandType::SetScissorRect) };
+            uint32_t const values[]{ left, top, right, bottom };
+            std::copy(std::begin(values), std::end(values), command.values);
+        }
+
+        void ClearRenderTarget(HeadlessRenderResource* pRenderTarget, float const clearColor4[4])
+        {
+            HeadlessCommand& command{ Record(HeadlessCommandType::ClearRenderTarget) };
+            command.resources[0] = pRenderTarget;
+            std::copy(clearColor4, clearColor4 + 4, command.floats);
+        }
+
+        void ClearDepth(HeadlessRenderResource* pDepthStencil, float depth)
+        {
+            HeadlessCommand& command{ Record(HeadlessCommandType::ClearDepth) };
+            command.resources[0] = pDepthStencil;
+            command.floats[0] = depth;
+        }
+
+        void SetRenderTargets(HeadlessRenderResource* pRenderTarget, HeadlessRenderResource* pDepthStencil)
+        {
+            HeadlessCommand& command{ Record(HeadlessCommandType::SetRenderTargets) };
+            command.resources[0] = pRenderTarget;
+            command.resources[1] = pDepthStencil;
+        }
+
+        void SetConstantBuffer(uint32_t rootParameterIndex, HeadlessRenderResource* pBuffer, uint32_t offsetInBytes)
+        {
+            HeadlessCommand& command{ Record(HeadlessCommandType::SetConstantBuffer) };
+            command.resources[0] = pBuffer;
+            command.values[0] = rootParameterIndex;
+            command.values[1] = offsetInBytes;
+        }
+
+        void SetVertexBuffer(HeadlessRenderResource* pBuffer, uint32_t strideInBytes)
+        {
+            HeadlessCommand& command{ Record(HeadlessCommandType::SetVertexBuffer) };
+            command.resources[0] = pBuffer;
+            command.values[0] = strideInBytes;
+        }
+
+        void SetIndexBuffer(HeadlessRenderResource* pBuffer, RenderIndexFormat format)
+        {
+            HeadlessCommand& command{ Record(HeadlessCommandType::SetIndexBuffer) };
+            command.resources[0] = pBuffer;
+            command.values[0] = static_cast<uint32_t>(format);
+        }
+
+        void DrawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation)
+        {
+            HeadlessCommand& command{ Record(HeadlessCommandType::DrawIndexedInstanced) };
+            uint32_t const values[]{ indexCountPerInstance, instanceCount, startIndexLocation, static_cast<uint32_t>(baseVertexLocation), startInstanceLocation };
+            std::copy(std::begin(values), std::end(values), command.values);
+        }
+
+        // Returns the simulated GPU cost of executing this list.
+        uint64_t EstimateGpuNanoseconds(HeadlessGpuCostModel const& costModel) const
+        {
+            uint64_t nanoseconds{ costModel.commandListOverhead };
+            for (HeadlessCommand const& command : m_commands)
+            {
+                switch (command.type)
+                {
+                case HeadlessCommandType::ResourceBarrier:
+                    nanoseconds += costModel.perBarrier;
+                    break;
+                case HeadlessCommandType::ClearRenderTarget:
+                case HeadlessCommandType::ClearDepth:
+                    if (command.resources[0])
+                    {
+                        nanoseconds += costModel.perClearedPixel * command.resources[0]->Width() * command.resources[0]->Height();
+                    }
+                    break;
+                case HeadlessCommandType::DrawIndexedInstanced:
+                    nanoseconds += costModel.perDraw
+                        + costModel.perDrawnIndex * command.values[0] * command.values[1]
+                        + costModel.perDrawnInstance * command.values[1];
+                    break;
+                default:
+                    break;
+                }
+            }
+            return nanoseconds;
+        }
+
+        // accessors
+
+        std::vector<HeadlessCommand> const& Commands() const { return m_commands; }
+        bool IsClosed() const { return m_isClosed; }
+    };
+
+    // Carries out the commands in a submitted list (for example, by rasterizing its draws on the CPU).
+    class IHeadlessCommandExecutor
+    {
+    public:
+        virtual ~IHeadlessCommandExecutor() = default;
+
+        virtual void Execute(HeadlessRenderCommandList const& commandList) = 0;
+    };
+
+    class HeadlessRenderFence final : public IRenderFence
+    {
+        // data members
+
+        HeadlessClock& m_clock;
+        mutable uint64_t m_completedValue{ 0 };
+        // Signals that have been scheduled on the GPU timeline, but that may not have happened yet.
+        mutable std::deque<std::pair<uint64_t, uint64_t>> m_scheduledSignals; // (value, GPU time in nanoseconds)
+
+        void Retire(uint64_t nowNanoseconds) const
+        {
+            while (!m_scheduledSignals.empty() && m_scheduledSignals.front().second <= nowNanoseconds)
+            {
+                m_completedValue = std::max(m_completedValue, m_scheduledSignals.front().first);
+                m_scheduledSignals.pop_front();
+            }
+        }
+
+    public:
+        HeadlessRenderFence(HeadlessClock& clock, uint64_t initialValue) :
+            m_clock{ clock },
+            m_completedValue{ initialValue }
+        {
+        }
+
+        // member functions
+
+        uint64_t CompletedValue() const override
+        {
+            Retire(m_clock.NowNanoseconds());
+            return m_completedValue;
+        }
+
+        void WaitForValue(uint64_t value) override
+        {
+            Retire(m_clock.NowNanoseconds());
+            if (m_completedValue >= value) return;
+
+            uint64_t signalTime{ 0 };
+            if (!TryGetSignalTime(value, signalTime))
+            {
+                // On a real device this would hang forever.
+                throw std::logic_error("Waiting on a fence value that has not been signaled.");
+            }
+            m_clock.SleepUntil(signalTime);
+            Retire(signalTime);
+        }
+
+        void ScheduleSignal(uint64_t value, uint64_t gpuNanoseconds)
+        {
+            // Signals on one queue are scheduled in GPU-time order. Signals from different queues
+            // can arrive out of order, so keep the deque sorted by time.
+            auto it{ std::upper_bound(m_scheduledSignals.begin(), m_scheduledSignals.end(), gpuNanoseconds,
+                [](uint64_t time, std::pair<uint64_t, uint64_t> const& signal) { return time < signal.second; }) };
+            m_scheduledSignals.insert(it, { value, gpuNanoseconds });
+        }
+
+        // Returns `true` and the GPU time at which the fence reaches `value`, if that's known.
+        bool TryGetSignalTime(uint64_t value, uint64_t& gpuNanoseconds) const
+        {
+            if (m_completedValue >= value)
+            {
+                gpuNanoseconds = 0;
+                return true;
+            }
+            for (auto const& signal : m_scheduledSignals)
+            {
+                if (signal.first >= value)
+                {
+                    gpuNanoseconds = signal.second;
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    // Running totals for a headless device.
+    struct HeadlessRenderStatistics final
+    {
+        uint64_t commandCounts[static_cast<size_t>(HeadlessCommandType::Count)]{};
+        uint64_t executedCommandLists{ 0 };
+        uint64_t gpuBusyNanoseconds{ 0 };
+        uint64_t presents{ 0 };
+        uint64_t drawnIndices{ 0 };
+    };
+
+    class HeadlessRenderCommandQueue final : public IRenderCommandQueue
+    {
+        // data members
+
+        HeadlessClock& m_clock;
+        HeadlessGpuCostModel const& m_costModel;
+        IHeadlessCommandExecutor* m_pExecutor{ nullptr };
+        uint64_t m_gpuBusyUntil{ 0 }; // The GPU time at which everything submitted so far completes.
+        HeadlessRenderStatistics& m_statistics;
+
+    public:
+        HeadlessRenderCommandQueue(HeadlessClock& clock, HeadlessGpuCostModel const& costModel, HeadlessRenderStatistics& statistics) :
+            m_clock{ clock },
+            m_costModel{ costModel },
+            m_statistics{ statistics }
+        {
+        }
+
+        // member functions
+
+        void ExecuteCommandList(IRenderCommandList& commandList) override
+        {
+            auto& headlessCommandList{ static_cast<HeadlessRenderCommandList&>(commandList) };
+            if (!headlessCommandList.IsClosed()) throw std::logic_error("Executing a command list that hasn't been closed.");
+
+            uint64_t const cost{ headlessCommandList.EstimateGpuNanoseconds(m_costModel) };
+            AppendGpuWork(cost);
+            if (m_pExecutor) m_pExecutor->Execute(headlessCommandList);
+
+            ++m_statistics.executedCommandLists;
+            for (HeadlessCommand const& command : headlessCommandList.Commands())
+            {
+                ++m_statistics.commandCounts[static_cast<size_t>(command.type)];
+                if (command.type == HeadlessCommandType::DrawIndexedInstanced)
+                {
+                    m_statistics.drawnIndices += uint64_t{ command.values[0] } * command.values[1];
+                }
+            }
+        }
+
+        void Signal(IRenderFence& fence, uint64_t value) override
+        {
+            static_cast<HeadlessRenderFence&>(fence).ScheduleSignal(value, std::max(m_gpuBusyUntil, m_clock.NowNanoseconds()));
+        }
+
+        void Wait(IRenderFence& fence, uint64_t value) override
+        {
+            uint64_t signalTime{ 0 };
+            if (!static_cast<HeadlessRenderFence&>(fence).TryGetSignalTime(value, signalTime))
+            {
+                throw std::logic_error("GPU wait on a fence value that has not been signaled.");
+            }
+            m_gpuBusyUntil = std::max(m_gpuBusyUntil, signalTime);
+        }
+
+        // Appends `nanoseconds` of work to the GPU timeline. The GPU idles (and doesn't accumulate
+        // credit) while the CPU isn't giving it work.
+        void AppendGpuWork(uint64_t nanoseconds)
+        {
+            m_gpuBusyUntil = std::max(m_gpuBusyUntil, m_clock.NowNanoseconds()) + nanoseconds;
+            m_statistics.gpuBusyNanoseconds += nanoseconds;
+        }
+
+        // accessors
+
+        uint64_t GpuBusyUntil() const { return m_gpuBusyUntil; }
+        HeadlessGpuCostModel const& CostModel() const { return m_costModel; }
+
+        // mutators
+
+        // With an executor, submitted lists are executed synchronously, before ExecuteCommandList returns.
+        void Executor(IHeadlessCommandExecutor* pExecutor) { m_pExecutor = pExecutor; }
+    };
+
+    class HeadlessRenderSwapChain final : public IRenderSwapChain
+    {
+        // data members
+
+        std::vector<std::unique_ptr<HeadlessRenderResource>> m_buffers;
+        HeadlessClock& m_clock;
+        HeadlessRenderCommandQueue& m_commandQueue;
+        uint32_t m_currentBackBufferIndex{ 0 };
+        RenderDisplayedFrame m_lastDisplayedFrame;
+        uint32_t m_maximumFrameLatency{ 3 };
+        uint64_t m_presentCount{ 0 };
+        std::deque<uint64_t> m_queuedPresentTimes; // When each queued (not yet displayed) frame hits the screen.
+        HeadlessRenderStatistics& m_statistics;
+        uint64_t m_vsyncPeriodNanoseconds{ 16'666'667 };
+
+        void RetireDisplayedFrames(uint64_t nowNanoseconds)
+        {
+            while (!m_queuedPresentTimes.empty() && m_queuedPresentTimes.front() <= nowNanoseconds)
+            {
+                m_lastDisplayedFrame.presentCount = m_presentCount - m_queuedPresentTimes.size() + 1;
+                m_lastDisplayedFrame.displayNanoseconds = m_queuedPresentTimes.front();
+                m_queuedPresentTimes.pop_front();
+            }
+        }
+
+    public:
+        HeadlessRenderSwapChain(HeadlessClock& clock, HeadlessRenderCommandQueue& commandQueue, HeadlessRenderStatistics& statistics, uint32_t width, uint32_t height, uint32_t bufferCount) :
+            m_clock{ clock },
+            m_commandQueue{ commandQueue },
+            m_statistics{ statistics }
+        {
+            for (uint32_t bufferIndex{ 0 }; bufferIndex < bufferCount; ++bufferIndex)
+            {
+                m_buffers.push_back(std::make_unique<HeadlessRenderResource>(RenderHeapType::Default, uint64_t{ width } * height * 4, width, height));
+            }
+        }
+
+        // member functions
+
+        uint32_t BufferCount() const override { return static_cast<uint32_t>(m_buffers.size()); }
+        uint32_t CurrentBackBufferIndex() const override { return m_currentBackBufferIndex; }
+
+        // Queues the current back buffer for display. As with DXGI, this blocks while the
+        // maximum number of frames are already queued.
+        RenderPresentResult Present(uint32_t syncInterval) override
+        {
+            m_commandQueue.AppendGpuWork(m_commandQueue.CostModel().perPresent);
+
+            // The frame is ready when the GPU finishes it, and is displayed at the next vblank (or immediately, without vsync).
+            uint64_t const readyTime{ m_commandQueue.GpuBusyUntil() };
+            uint64_t displayTime{ readyTime };
+            if (syncInterval > 0)
+            {
+                uint64_t const earliest{ m_queuedPresentTimes.empty() ? readyTime : std::max(readyTime, m_queuedPresentTimes.back() + 1) };
+                uint64_t const vblanks{ (earliest + m_vsyncPeriodNanoseconds - 1) / m_vsyncPeriodNanoseconds };
+                displayTime = std::max(vblanks, uint64_t{ 1 }) * m_vsyncPeriodNanoseconds + (syncInterval - 1) * m_vsyncPeriodNanoseconds;
+            }
+
+            WaitForFrameLatency();
+            m_queuedPresentTimes.push_back(displayTime);
+            ++m_presentCount;
+
+            m_currentBackBufferIndex = (m_currentBackBufferIndex + 1) % BufferCount();
+            ++m_statistics.presents;
+            return RenderPresentResult::Ok;
+        }
+
+        uint64_t PresentCount() const override { return m_presentCount; }
+
+        bool TryGetLastDisplayedFrame(RenderDisplayedFrame& frame) override
+        {
+            RetireDisplayedFrames(m_clock.NowNanoseconds());
+            frame = m_lastDisplayedFrame;
+            return frame.presentCount != 0;
+        }
+
+        void WaitForFrameLatency() override
+        {
+            RetireDisplayedFrames(m_clock.NowNanoseconds());
+            if (m_queuedPresentTimes.size() >= m_maximumFrameLatency)
+            {
+                uint64_t const displayTime{ m_queuedPresentTimes[m_queuedPresentTimes.size() - m_maximumFrameLatency] };
+                m_clock.SleepUntil(displayTime);
+                RetireDisplayedFrames(displayTime);
+            }
+        }
+
+        // accessors
+
+        HeadlessRenderResource* BackBuffer(uint32_t bufferIndex) const { return m_buffers[bufferIndex].get(); }
+        uint64_t VsyncPeriodNanoseconds() const { return m_vsyncPeriodNanoseconds; }
+
+        // mutators
+
+        void MaximumFrameLatency(uint32_t maximumFrameLatency) { m_maximumFrameLatency = std::max(maximumFrameLatency, 1u); }
+        void VsyncPeriodNanoseconds(uint64_t vsyncPeriodNanoseconds) { m_vsyncPeriodNanoseconds = std::max(vsyncPeriodNanoseconds, uint64_t{ 1 }); }
+    };
+
+    class HeadlessRenderDevice final : public IRenderDevice
+    {
+        // data members
+
+        HeadlessClock m_clock;
+        HeadlessGpuCostModel m_costModel;
+        HeadlessRenderStatistics m_statistics;
+
+    public:
+        HeadlessRenderDevice(bool useVirtualClock = false) :
+            m_clock{ useVirtualClock }
+        {
+        }
+
+        // member functions
+
+        std::unique_ptr<IRenderResource> CreateBuffer(RenderHeapType heapType, uint64_t sizeInBytes) override
+        {
+            return std::make_unique<HeadlessRenderResource>(heapType, sizeInBytes);
+        }
+
+        std::unique_ptr<IRenderResource> CreateTexture2D(uint32_t width, uint32_t height, uint32_t bytesPerPixel) override
+        {
+            return std::make_unique<HeadlessRenderResource>(RenderHeapType::Default, uint64_t{ width } * height * bytesPerPixel, width, height);
+        }
+
+        std::unique_ptr<IRenderCommandQueue> CreateCommandQueue() override
+        {
+            return std::make_unique<HeadlessRenderCommandQueue>(m_clock, m_costModel, m_statistics);
+        }
+
+        std::unique_ptr<IRenderFence> CreateFence(uint64_t initialValue) override
+        {
+            return std::make_unique<HeadlessRenderFence>(m_clock, initialValue);
+        }
+
+        std::unique_ptr<IRenderSwapChain> CreateSwapChain(IRenderCommandQueue& commandQueue, uint32_t width, uint32_t height, uint32_t bufferCount) override
+        {
+            return std::make_unique<HeadlessRenderSwapChain>(m_clock, static_cast<HeadlessRenderCommandQueue&>(commandQueue), m_statistics, width, height, bufferCount);
+        }
+
+        // accessors
+
+        HeadlessClock& Clock() { return m_clock; }
+        HeadlessGpuCostModel& CostModel() { return m_costModel; }
+        HeadlessRenderStatistics const& Statistics() const { return m_statistics; }
+    };
+}
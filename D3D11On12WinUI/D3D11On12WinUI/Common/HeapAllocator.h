@@ -0,0 +1,465 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// The bookkeeping for sub-allocating large blocks of GPU memory (the ID3D12Heaps of
+// PlacedResourceAllocator) into placed resources. Each block is managed by a two-level
+// segregated fit (TLSF) allocator: free ranges are kept in lists binned by size (a power-of-two
+// first level, split into 16 linear second-level bins), with a bitmap per level, so that
+// allocating and freeing take constant time, and a freed range is merged with free neighbours
+// at once. A pool of blocks frees ranges a fence value late, as DescriptorAllocator does. It
+// deals only in offsets, so the same code runs against D3D12 heaps and in the headless bench.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace DX
+{
+    // A range of one TlsfAllocator.
+    struct TlsfAllocation final
+    {
+        uint64_t offset{ 0 }; // In bytes.
+        uint64_t size{ 0 }; // In bytes; the requested size, rounded up to the granularity.
+        uint32_t range{ 0 }; // Identifies the range to Free.
+    };
+
+    // Manages `capacity` bytes, in units of `granularity` bytes (a power of two).
+    class TlsfAllocator final
+    {
+        static constexpr uint32_t s_firstLevelCount{ 40 }; // Enough for 2^40 units.
+        static constexpr uint32_t s_none{ ~0u };
+        static constexpr uint32_t s_secondLevelBits{ 4 };
+        static constexpr uint32_t s_secondLevelCount{ 1u << s_secondLevelBits };
+
+        // A free or allocated range. Ranges are linked in address order (to merge neighbours),
+        // and free ranges are also linked into the list of their size's bin.
+        struct Range final
+        {
+            uint64_t offset{ 0 }; // In units.
+            uint64_t size{ 0 }; // In units.
+            uint32_t previousPhysical{ s_none };
+            uint32_t nextPhysical{ s_none };
+            uint32_t previousFree{ s_none };
+            uint32_t nextFree{ s_none };
+            bool isFree{ false };
+        };
+
+        // data members
+
+        uint32_t m_allocationCount{ 0 };
+        uint64_t m_capacity{ 0 }; // In units.
+        uint64_t m_firstLevelBitmap{ 0 };
+        std::vector<uint32_t> m_freeHeads; // The first free range of each (first level, second level) bin.
+        uint64_t m_freeUnits{ 0 };
+        uint32_t m_granularityShift{ 0 };
+        std::vector<Range> m_ranges;
+        std::array<uint32_t, s_firstLevelCount> m_secondLevelBitmaps{};
+        std::vector<uint32_t> m_unusedRanges; // Slots in m_ranges that can be reused.
+
+        static uint32_t HighestBit(uint64_t value)
+        {
+#if defined(_MSC_VER)
+            unsigned long index{ 0 };
+            _BitScanReverse64(&index, value);
+            return index;
+#else
+            return 63 - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+        }
+
+        static uint32_t LowestBit(uint64_t value)
+        {
+#if defined(_MSC_VER)
+            unsigned long index{ 0 };
+            _BitScanForward64(&index, value);
+            return index;
+#else
+            return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+        }
+
+        // The bin that a range of `size` units is filed in.
+        static void Bin(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel)
+        {
+            if (size < s_secondLevelCount)
+            {
+                firstLevel = 0;
+                secondLevel = static_cast<uint32_t>(size);
+            }
+            else
+            {
+                uint32_t const highestBit{ HighestBit(size) };
+                firstLevel = highestBit - s_secondLevelBits + 1;
+                secondLevel = static_cast<uint32_t>(size >> (highestBit - s_secondLevelBits)) - s_secondLevelCount;
+            }
+        }
+
+        // Returns a free range that `size` units, aligned to `alignment` units, fit in; or s_none.
+        // Every range in the bins above that of `size + alignment - 1` fits, wherever it starts,
+        // so the bitmaps find one at once. Only if those are all empty are the smaller ranges
+        // searched, for one that fits as it's aligned.
+        uint32_t FindFree(uint64_t size, uint64_t alignment) const
+        {
+            uint64_t const searchSize{ size + alignment - 1 };
+            uint64_t roundedSize{ searchSize };
+            if (searchSize >= s_secondLevelCount) roundedSize += (uint64_t{ 1 } << (HighestBit(searchSize) - s_secondLevelBits)) - 1;
+            uint32_t firstLevel{ 0 }, secondLevel{ 0 };
+            Bin(roundedSize, firstLevel, secondLevel);
+            if (uint32_t const index{ NextNonEmptyBin(firstLevel * s_secondLevelCount + secondLevel) }; index != s_none) return m_freeHeads[index];
+
+            Bin(size, firstLevel, secondLevel);
+            for (uint32_t bin{ NextNonEmptyBin(firstLevel * s_secondLevelCount + secondLevel) }; bin != s_none; bin = NextNonEmptyBin(bin + 1))
+            {
+                for (uint32_t index{ m_freeHeads[bin] }; index != s_none; index = m_ranges[index].nextFree)
+                {
+                    Range const& range{ m_ranges[index] };
+                    if (((range.offset + alignment - 1) & ~(alignment - 1)) + size <= range.offset + range.size) return index;
+                }
+            }
+            return s_none;
+        }
+
+        void InsertFree(uint32_t index)
+        {
+            uint32_t firstLevel{ 0 }, secondLevel{ 0 };
+            Bin(m_ranges[index].size, firstLevel, secondLevel);
+            uint32_t& head{ m_freeHeads[firstLevel * s_secondLevelCount + secondLevel] };
+
+            m_ranges[index].isFree = true;
+            m_ranges[index].previousFree = s_none;
+            m_ranges[index].nextFree = head;
+            if (head != s_none) m_ranges[head].previousFree = index;
+            head = index;
+            m_firstLevelBitmap |= uint64_t{ 1 } << firstLevel;
+            m_secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+        }
+
+        // Returns the first bin, from `bin` on, that has a free range; or s_none.
+        uint32_t NextNonEmptyBin(uint32_t bin) const
+        {
+            uint32_t firstLevel{ bin / s_secondLevelCount };
+            if (firstLevel >= s_firstLevelCount) return s_none;
+            uint32_t secondLevelMap{ m_secondLevelBitmaps[firstLevel] & (~0u << (bin % s_secondLevelCount)) };
+            if (secondLevelMap == 0)
+            {
+                uint64_t const firstLevelMap{ m_firstLevelBitmap & (~uint64_t{ 0 } << (firstLevel + 1)) };
+                if (firstLevelMap == 0) return s_none;
+                firstLevel = LowestBit(firstLevelMap);
+                secondLevelMap = m_secondLevelBitmaps[firstLevel];
+            }
+            return firstLevel * s_secondLevelCount + LowestBit(secondLevelMap);
+        }
+
+        uint32_t NewRange(uint64_t offset, uint64_t size, uint32_t previousPhysical, uint32_t nextPhysical)
+        {
+            uint32_t index{ 0 };
+            if (!m_unusedRanges.empty())
+            {
+                index = m_unusedRanges.back();
+                m_unusedRanges.pop_back();
+            }
+            else
+            {
+                index = static_cast<uint32_t>(m_ranges.size());
+                m_ranges.emplace_back();
+            }
+            m_ranges[index] = Range{ offset, size, previousPhysical, nextPhysical };
+            if (previousPhysical != s_none) m_ranges[previousPhysical].nextPhysical = index;
+            if (nextPhysical != s_none) m_ranges[nextPhysical].previousPhysical = index;
+            return index;
+        }
+
+        void RemoveFree(uint32_t index)
+        {
+            Range& range{ m_ranges[index] };
+            if (range.previousFree != s_none)
+            {
+                m_ranges[range.previousFree].nextFree = range.nextFree;
+            }
+            else
+            {
+                uint32_t firstLevel{ 0 }, secondLevel{ 0 };
+                Bin(range.size, firstLevel, secondLevel);
+                m_freeHeads[firstLevel * s_secondLevelCount + secondLevel] = range.nextFree;
+                if (range.nextFree == s_none)
+                {
+                    m_secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+                    if (m_secondLevelBitmaps[firstLevel] == 0) m_firstLevelBitmap &= ~(uint64_t{ 1 } << firstLevel);
+                }
+            }
+            if (range.nextFree != s_none) m_ranges[range.nextFree].previousFree = range.previousFree;
+            range.isFree = false;
+        }
+
+        // Unlinks a range (whose neighbour has absorbed it) from the address order.
+        void RetireRange(uint32_t index)
+        {
+            Range const& range{ m_ranges[index] };
+            if (range.previousPhysical != s_none) m_ranges[range.previousPhysical].nextPhysical = range.nextPhysical;
+            if (range.nextPhysical != s_none) m_ranges[range.nextPhysical].previousPhysical = range.previousPhysical;
+            m_unusedRanges.push_back(index);
+        }
+
+    public:
+        TlsfAllocator(uint64_t capacity = 0, uint64_t granularity = 1)
+        {
+            Reset(capacity, granularity);
+        }
+
+        // member functions
+
+        // Returns `sizeInBytes` bytes aligned to `alignment` (a power of two), or nothing if no free range is big enough.
+        std::optional<TlsfAllocation> Allocate(uint64_t sizeInBytes, uint64_t alignment)
+        {
+            uint64_t const size{ std::max<uint64_t>((sizeInBytes + (uint64_t{ 1 } << m_granularityShift) - 1) >> m_granularityShift, 1) };
+            uint64_t const alignmentUnits{ std::max<uint64_t>(alignment >> m_granularityShift, 1) };
+            if (size > m_freeUnits) return std::nullopt;
+
+            uint32_t const index{ FindFree(size, alignmentUnits) };
+            if (index == s_none) return std::nullopt;
+            RemoveFree(index);
+
+            // Give back the start of the range, up to the alignment, and what's left after the
+            // allocation. A free range's neighbours are never free, so these needn't be merged.
+            uint64_t const alignedOffset{ (m_ranges[index].offset + alignmentUnits - 1) & ~(alignmentUnits - 1) };
+            if (uint64_t const padding{ alignedOffset - m_ranges[index].offset }; padding != 0)
+            {
+                uint32_t const paddingIndex{ NewRange(m_ranges[index].offset, padding, m_ranges[index].previousPhysical, index) };
+                InsertFree(paddingIndex);
+                m_ranges[index].offset = alignedOffset;
+                m_ranges[index].size -= padding;
+            }
+            if (m_ranges[index].size > size)
+            {
+                uint32_t const remainderIndex{ NewRange(alignedOffset + size, m_ranges[index].size - size, index, m_ranges[index].nextPhysical) };
+                InsertFree(remainderIndex);
+                m_ranges[index].size = size;
+            }
+
+            m_freeUnits -= size;
+            ++m_allocationCount;
+            return TlsfAllocation{ alignedOffset << m_granularityShift, size << m_granularityShift, index };
+        }
+
+        void Free(TlsfAllocation const& allocation)
+        {
+            uint32_t index{ allocation.range };
+            m_freeUnits += m_ranges[index].size;
+            --m_allocationCount;
+
+            uint32_t const next{ m_ranges[index].nextPhysical };
+            if (next != s_none && m_ranges[next].isFree)
+            {
+                RemoveFree(next);
+                m_ranges[index].size += m_ranges[next].size;
+                RetireRange(next);
+            }
+            uint32_t const previous{ m_ranges[index].previousPhysical };
+            if (previous != s_none && m_ranges[previous].isFree)
+            {
+                RemoveFree(previous);
+                m_ranges[previous].size += m_ranges[index].size;
+                RetireRange(index);
+                index = previous;
+            }
+            InsertFree(index);
+        }
+
+        // Frees everything.
+        void Reset(uint64_t capacity, uint64_t granularity)
+        {
+            m_granularityShift = granularity > 1 ? HighestBit(granularity) : 0;
+            m_capacity = capacity >> m_granularityShift;
+            m_allocationCount = 0;
+            m_firstLevelBitmap = 0;
+            m_freeHeads.assign(s_firstLevelCount * s_secondLevelCount, s_none);
+            m_freeUnits = m_capacity;
+            m_ranges.clear();
+            m_secondLevelBitmaps.fill(0);
+            m_unusedRanges.clear();
+            if (m_capacity != 0) InsertFree(NewRange(0, m_capacity, s_none, s_none));
+        }
+
+        // accessors
+
+        uint32_t AllocationCount() const { return m_allocationCount; }
+        uint64_t Capacity() const { return m_capacity << m_granularityShift; }
+        uint64_t FreeBytes() const { return m_freeUnits << m_granularityShift; }
+
+        // The largest allocation that could succeed (with no more than the granularity's alignment).
+        uint64_t LargestFreeBytes() const
+        {
+            if (m_firstLevelBitmap == 0) return 0;
+            uint32_t const firstLevel{ HighestBit(m_firstLevelBitmap) };
+            uint32_t const secondLevel{ HighestBit(m_secondLevelBitmaps[firstLevel]) };
+            uint64_t largest{ 0 };
+            for (uint32_t index{ m_freeHeads[firstLevel * s_secondLevelCount + secondLevel] }; index != s_none; index = m_ranges[index].nextFree)
+            {
+                largest = std::max(largest, m_ranges[index].size);
+            }
+            return largest << m_granularityShift;
+        }
+    };
+
+    // A range of one block of a HeapAllocator.
+    struct HeapAllocation final
+    {
+        uint32_t block{ 0 };
+        TlsfAllocation range;
+    };
+
+    struct HeapAllocatorStatistics final
+    {
+        uint64_t allocations{ 0 };
+        uint64_t blocksCreated{ 0 };
+        uint64_t blocksReleased{ 0 };
+        uint64_t frees{ 0 };
+
+        // These describe the blocks as they are now (see HeapAllocator::Statistics).
+        uint64_t allocatedBytes{ 0 };
+        uint32_t blocks{ 0 };
+        uint64_t freeBytes{ 0 };
+        uint64_t largestFreeBytes{ 0 }; // In any one block.
+        uint64_t largestFreeBytesPerBlock{ 0 }; // Summed over the blocks.
+        uint32_t liveAllocations{ 0 };
+        uint64_t reservedBytes{ 0 };
+
+        // The share of free memory that's outside the largest free range of its block; 0 if each block's free memory is all one range.
+        double Fragmentation() const { return freeBytes ? 1. - static_cast<double>(largestFreeBytesPerBlock) / freeBytes : 0.; }
+    };
+
+    // Allocates from blocks of `blockSize` bytes, and makes another block when none of them has
+    // room. An allocation bigger than a block gets a block of its own. The owner creates the memory
+    // for each block (the first time that an allocation lands in it), and releases that memory
+    // when Reclaim reports that the block is no longer needed.
+    class HeapAllocator final
+    {
+        // data members
+
+        std::vector<std::unique_ptr<TlsfAllocator>> m_blocks; // Null where a block has been released.
+        uint64_t m_blockSize{ 0 };
+        uint64_t m_granularity{ 1 };
+        std::deque<std::pair<uint64_t, HeapAllocation>> m_retired; // (fence value, allocation), in fence-value order.
+        HeapAllocatorStatistics m_statistics;
+
+        uint32_t NewBlock(uint64_t capacity)
+        {
+            auto it{ std::find(m_blocks.begin(), m_blocks.end(), nullptr) };
+            if (it == m_blocks.end()) it = m_blocks.insert(it, nullptr);
+            *it = std::make_unique<TlsfAllocator>(capacity, m_granularity);
+            ++m_statistics.blocksCreated;
+            return static_cast<uint32_t>(it - m_blocks.begin());
+        }
+
+    public:
+        HeapAllocator(uint64_t blockSize = 0, uint64_t granularity = 1) :
+            m_blockSize{ blockSize },
+            m_granularity{ granularity }
+        {
+        }
+
+        // member functions
+
+        // Returns `sizeInBytes` bytes aligned to `alignment` (a power of two, no bigger than the
+        // alignment of the block's memory). Lower-numbered blocks are preferred, so that the
+        // others can empty out.
+        HeapAllocation Allocate(uint64_t sizeInBytes, uint64_t alignment)
+        {
+            ++m_statistics.allocations;
+            for (uint32_t block{ 0 }; block < m_blocks.size(); ++block)
+            {
+                if (!m_blocks[block] || m_blocks[block]->Capacity() != m_blockSize) continue;
+                if (std::optional<TlsfAllocation> range{ m_blocks[block]->Allocate(sizeInBytes, alignment) }) return HeapAllocation{ block, *range };
+            }
+
+            uint64_t const roundedSize{ (sizeInBytes + m_granularity - 1) & ~(m_granularity - 1) };
+            uint32_t const block{ NewBlock(std::max(roundedSize, m_blockSize)) };
+            return HeapAllocation{ block, *m_blocks[block]->Allocate(sizeInBytes, alignment) };
+        }
+
+        // Frees an allocation, to be reused once the fence reaches `fenceValue`.
+        void Free(HeapAllocation const& allocation, uint64_t fenceValue)
+        {
+            ++m_statistics.frees;
+            m_retired.emplace_back(fenceValue, allocation);
+        }
+
+        // Frees the allocations whose fence values have been reached, and calls
+        // `releaseBlock(block)` for each block that's no longer needed: that is, an empty block
+        // of its own for one big allocation, or an empty block when another is empty too.
+        template <typename ReleaseBlock>
+        void Reclaim(uint64_t completedFenceValue, ReleaseBlock&& releaseBlock)
+        {
+            if (m_retired.empty() || m_retired.front().first > completedFenceValue) return;
+
+            while (!m_retired.empty() && m_retired.front().first <= completedFenceValue)
+            {
+                HeapAllocation const& allocation{ m_retired.front().second };
+                m_blocks[allocation.block]->Free(allocation.range);
+                m_retired.pop_front();
+            }
+
+            bool isSpareKept{ false };
+            for (uint32_t block{ 0 }; block < m_blocks.size(); ++block)
+            {
+                if (!m_blocks[block] || m_blocks[block]->AllocationCount() != 0) continue;
+                if (m_blocks[block]->Capacity() == m_blockSize && !isSpareKept)
+                {
+                    isSpareKept = true;
+                    continue;
+                }
+                m_blocks[block] = nullptr;
+                ++m_statistics.blocksReleased;
+                releaseBlock(block);
+            }
+        }
+
+        // Frees everything, and forgets every block. Only for when the GPU is idle, or the device is gone.
+        void Reset()
+        {
+            m_blocks.clear();
+            m_retired.clear();
+        }
+
+        // accessors
+
+        uint64_t BlockSize(uint32_t block) const { return m_blocks[block]->Capacity(); }
+
+        HeapAllocatorStatistics Statistics() const
+        {
+            HeapAllocatorStatistics statistics{ m_statistics };
+            for (auto const& pBlock : m_blocks)
+            {
+                if (!pBlock) continue;
+                ++statistics.blocks;
+                statistics.allocatedBytes += pBlock->Capacity() - pBlock->FreeBytes();
+                statistics.freeBytes += pBlock->FreeBytes();
+                uint64_t const largestFreeBytes{ pBlock->LargestFreeBytes() };
+                statistics.largestFreeBytes = std::max(statistics.largestFreeBytes, largestFreeBytes);
+                statistics.largestFreeBytesPerBlock += largestFreeBytes;
+                statistics.liveAllocations += pBlock->AllocationCount();
+                statistics.reservedBytes += pBlock->Capacity();
+            }
+            return statistics;
+        }
+    };
+}
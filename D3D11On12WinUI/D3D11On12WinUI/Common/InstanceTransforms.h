@@ -0,0 +1,330 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// The per-instance data for drawing many cubes with one instanced draw, and the batch
+// transform that computes it each frame. The transforms are computed four instances at a
+// time (with SSE2 or NEON), from structure-of-arrays scene data, and written out as the
+// array-of-structures vertex stream that the input assembler reads. The output is written
+// with streaming stores where they're available, since it's usually going straight into
+// write-combined upload memory that the CPU never reads back.
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DX_INSTANCE_TRANSFORMS_SSE2
+#endif
+#if defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define DX_INSTANCE_TRANSFORMS_NEON
+#endif
+
+namespace DX
+{
+    // One instance's entry in the per-instance vertex stream (input slot 1). worldRows are the
+    // first three rows of the instance's world matrix in column-vector form, so that
+    // worldPosition.x = dot(float4(position, 1), worldRows[0]), and so on; the fourth row is
+    // always (0, 0, 0, 1). color multiplies the vertex color. 64 bytes, a cache line.
+    struct InstanceData final
+    {
+        float worldRows[3][4];
+        float color[4];
+    };
+    static_assert(sizeof(InstanceData) == 64, "InstanceData must match the instance input layout.");
+
+    // A field of cubes on a cubic grid, each spinning about its own vertical axis at its own
+    // rate. One instance is the app's single cube: unscaled, at the origin, white, and still.
+    class InstanceField final
+    {
+        static constexpr float s_extent{ 1.2f }; // The grid's side, in model units (the cube's side is 1).
+        static constexpr float s_pi{ 3.14159265f };
+
+        // data members
+
+        // Structure-of-arrays scene data, padded to a multiple of four instances.
+        std::vector<float> m_blue;
+        uint32_t m_count{ 0 };
+        std::vector<float> m_green;
+        std::vector<float> m_phase; // In radians.
+        std::vector<float> m_red;
+        float m_scale{ 1.f };
+        std::vector<float> m_spinRate; // In radians per second.
+        bool m_useSimd{ true };
+        std::vector<float> m_x;
+        std::vector<float> m_y;
+        std::vector<float> m_z;
+
+        // sin and cos of an angle, reduced to [-pi/2, pi/2] and then approximated by the same
+        // polynomials as DirectX::XMScalarSinCos. The SIMD paths evaluate exactly the same
+        // operations, so every path writes the same values.
+        static void SinCos(float angle, float& sine, float& cosine)
+        {
+            float const quotient{ std::nearbyint(angle * (1.f / (2.f * s_pi))) };
+            float y{ angle - 2.f * s_pi * quotient };
+            float sign{ 1.f };
+            if (y > s_pi / 2) { y = s_pi - y; sign = -1.f; }
+            else if (y < -s_pi / 2) { y = -s_pi - y; sign = -1.f; }
+
+            float const y2{ y * y };
+            sine = (((((-2.3889859e-08f * y2 + 2.7525562e-06f) * y2 - 0.00019840874f) * y2 + 0.0083333310f) * y2 - 0.16666667f) * y2 + 1.f) * y;
+            cosine = sign * (((((-2.6051615e-07f * y2 + 2.4760495e-05f) * y2 - 0.0013888378f) * y2 + 0.041666638f) * y2 - 0.5f) * y2 + 1.f);
+        }
+
+        void WriteScalar(float seconds, InstanceData* pDestination, uint32_t first, uint32_t end) const
+        {
+            for (uint32_t index{ first }; index < end; ++index)
+            {
+                float sine, cosine;
+                SinCos(m_phase[index] + m_spinRate[index] * seconds, sine, cosine);
+                float const scaledCosine{ m_scale * cosine };
+                float const scaledSine{ m_scale * sine };
+
+                InstanceData& instance{ pDestination[index] };
+                instance = InstanceData{ {
+                    { scaledCosine, 0.f, scaledSine, m_x[index] },
+                    { 0.f, m_scale, 0.f, m_y[index] },
+                    { -scaledSine, 0.f, scaledCosine, m_z[index] } },
+                    { m_red[index], m_green[index], m_blue[index], 1.f } };
+            }
+        }
+
+#if defined(DX_INSTANCE_TRANSFORMS_SSE2)
+        static __m128 Select(__m128 a, __m128 b, __m128 mask) { return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a)); }
+
+        static void SinCos(__m128 angle, __m128& sine, __m128& cosine)
+        {
+            __m128 const halfPi{ _mm_set1_ps(s_pi / 2) };
+            __m128 const quotient{ _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(angle, _mm_set1_ps(1.f / (2.f * s_pi))))) };
+            __m128 y{ _mm_sub_ps(angle, _mm_mul_ps(_mm_set1_ps(2.f * s_pi), quotient)) };
+            __m128 const above{ _mm_cmpgt_ps(y, halfPi) };
+            __m128 const below{ _mm_cmplt_ps(y, _mm_set1_ps(-s_pi / 2)) };
+            y = Select(y, _mm_sub_ps(_mm_set1_ps(s_pi), y), above);
+            y = Select(y, _mm_sub_ps(_mm_set1_ps(-s_pi), y), below);
+            __m128 const sign{ Select(_mm_set1_ps(1.f), _mm_set1_ps(-1.f), _mm_or_ps(above, below)) };
+
+            __m128 const y2{ _mm_mul_ps(y, y) };
+            __m128 s{ _mm_set1_ps(-2.3889859e-08f) };
+            s = _mm_add_ps(_mm_mul_ps(s, y2), _mm_set1_ps(2.7525562e-06f));
+            s = _mm_sub_ps(_mm_mul_ps(s, y2), _mm_set1_ps(0.00019840874f));
+            s = _mm_add_ps(_mm_mul_ps(s, y2), _mm_set1_ps(0.0083333310f));
+            s = _mm_sub_ps(_mm_mul_ps(s, y2), _mm_set1_ps(0.16666667f));
+            sine = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(s, y2), _mm_set1_ps(1.f)), y);
+
+            __m128 c{ _mm_set1_ps(-2.6051615e-07f) };
+            c = _mm_add_ps(_mm_mul_ps(c, y2), _mm_set1_ps(2.4760495e-05f));
+            c = _mm_sub_ps(_mm_mul_ps(c, y2), _mm_set1_ps(0.0013888378f));
+            c = _mm_add_ps(_mm_mul_ps(c, y2), _mm_set1_ps(0.041666638f));
+            c = _mm_sub_ps(_mm_mul_ps(c, y2), _mm_set1_ps(0.5f));
+            cosine = _mm_mul_ps(sign, _mm_add_ps(_mm_mul_ps(c, y2), _mm_set1_ps(1.f)));
+        }
+
+        // Transposes four vectors (one component of a row, for four instances) into the
+        // row for each of the four instances, and stores the rows 64 bytes apart.
+        static void StoreRows(float* pDestination, __m128 a, __m128 b, __m128 c, __m128 d)
+        {
+            _MM_TRANSPOSE4_PS(a, b, c, d);
+            _mm_stream_ps(pDestination, a);
+            _mm_stream_ps(pDestination + 16, b);
+            _mm_stream_ps(pDestination + 32, c);
+            _mm_stream_ps(pDestination + 48, d);
+        }
+
+        // first is a multiple of four, and pDestination is 16-byte aligned.
+        void WriteSimd(float seconds, InstanceData* pDestination, uint32_t first, uint32_t end) const
+        {
+            __m128 const zero{ _mm_setzero_ps() };
+            __m128 const one{ _mm_set1_ps(1.f) };
+            __m128 const scale{ _mm_set1_ps(m_scale) };
+            __m128 const time{ _mm_set1_ps(seconds) };
+
+            for (uint32_t index{ first }; index < end; index += 4)
+            {
+                __m128 sine, cosine;
+                SinCos(_mm_add_ps(_mm_loadu_ps(&m_phase[index]), _mm_mul_ps(_mm_loadu_ps(&m_spinRate[index]), time)), sine, cosine);
+                __m128 const scaledCosine{ _mm_mul_ps(scale, cosine) };
+                __m128 const scaledSine{ _mm_mul_ps(scale, sine) };
+
+                float* pInstances{ &pDestination[index].worldRows[0][0] };
+                StoreRows(pInstances, scaledCosine, zero, scaledSine, _mm_loadu_ps(&m_x[index]));
+                StoreRows(pInstances + 4, zero, scale, zero, _mm_loadu_ps(&m_y[index]));
+                StoreRows(pInstances + 8, _mm_sub_ps(zero, scaledSine), zero, scaledCosine, _mm_loadu_ps(&m_z[index]));
+                StoreRows(pInstances + 12, _mm_loadu_ps(&m_red[index]), _mm_loadu_ps(&m_green[index]), _mm_loadu_ps(&m_blue[index]), one);
+            }
+
+            // Streaming stores are weakly ordered; make them visible before the GPU is told to read.
+            _mm_sfence();
+        }
+#elif defined(DX_INSTANCE_TRANSFORMS_NEON)
+        static void SinCos(float32x4_t angle, float32x4_t& sine, float32x4_t& cosine)
+        {
+            float32x4_t const quotient{ vrndnq_f32(vmulq_f32(angle, vdupq_n_f32(1.f / (2.f * s_pi)))) };
+            float32x4_t y{ vsubq_f32(angle, vmulq_f32(vdupq_n_f32(2.f * s_pi), quotient)) };
+            uint32x4_t const above{ vcgtq_f32(y, vdupq_n_f32(s_pi / 2)) };
+            uint32x4_t const below{ vcltq_f32(y, vdupq_n_f32(-s_pi / 2)) };
+            y = vbslq_f32(above, vsubq_f32(vdupq_n_f32(s_pi), y), y);
+            y = vbslq_f32(below, vsubq_f32(vdupq_n_f32(-s_pi), y), y);
+            float32x4_t const sign{ vbslq_f32(vorrq_u32(above, below), vdupq_n_f32(-1.f), vdupq_n_f32(1.f)) };
+
+            // vmulq then vaddq (not vmlaq, which may fuse), to match the other paths.
+            float32x4_t const y2{ vmulq_f32(y, y) };
+            float32x4_t s{ vdupq_n_f32(-2.3889859e-08f) };
+            s = vaddq_f32(vmulq_f32(s, y2), vdupq_n_f32(2.7525562e-06f));
+            s = vsubq_f32(vmulq_f32(s, y2), vdupq_n_f32(0.00019840874f));
+            s = vaddq_f32(vmulq_f32(s, y2), vdupq_n_f32(0.0083333310f));
+            s = vsubq_f32(vmulq_f32(s, y2), vdupq_n_f32(0.16666667f));
+            sine = vmulq_f32(vaddq_f32(vmulq_f32(s, y2), vdupq_n_f32(1.f)), y);
+
+            float32x4_t c{ vdupq_n_f32(-2.6051615e-07f) };
+            c = vaddq_f32(vmulq_f32(c, y2), vdupq_n_f32(2.4760495e-05f));
+            c = vsubq_f32(vmulq_f32(c, y2), vdupq_n_f32(0.0013888378f));
+            c = vaddq_f32(vmulq_f32(c, y2), vdupq_n_f32(0.041666638f));
+            c = vsubq_f32(vmulq_f32(c, y2), vdupq_n_f32(0.5f));
+            cosine = vmulq_f32(sign, vaddq_f32(vmulq_f32(c, y2), vdupq_n_f32(1.f)));
+        }
+
+        // Transposes four vectors (one component of a row, for four instances) into the
+        // row for each of the four instances, and stores the rows 64 bytes apart.
+        static void StoreRows(float* pDestination, float32x4_t a, float32x4_t b, float32x4_t c, float32x4_t d)
+        {
+            float32x4x2_t const ac{ vzipq_f32(a, c) }; // a0 c0 a1 c1, a2 c2 a3 c3
+            float32x4x2_t const bd{ vzipq_f32(b, d) }; // b0 d0 b1 d1, b2 d2 b3 d3
+            float32x4x2_t const rows01{ vzipq_f32(ac.val[0], bd.val[0]) }; // a0 b0 c0 d0, a1 b1 c1 d1
+            float32x4x2_t const rows23{ vzipq_f32(ac.val[1], bd.val[1]) };
+            vst1q_f32(pDestination, rows01.val[0]);
+            vst1q_f32(pDestination + 16, rows01.val[1]);
+            vst1q_f32(pDestination + 32, rows23.val[0]);
+            vst1q_f32(pDestination + 48, rows23.val[1]);
+        }
+
+        // first is a multiple of four.
+        void WriteSimd(float seconds, InstanceData* pDestination, uint32_t first, uint32_t end) const
+        {
+            float32x4_t const zero{ vdupq_n_f32(0.f) };
+            float32x4_t const one{ vdupq_n_f32(1.f) };
+            float32x4_t const scale{ vdupq_n_f32(m_scale) };
+            float32x4_t const time{ vdupq_n_f32(seconds) };
+
+            for (uint32_t index{ first }; index < end; index += 4)
+            {
+                float32x4_t sine, cosine;
+                SinCos(vaddq_f32(vld1q_f32(&m_phase[index]), vmulq_f32(vld1q_f32(&m_spinRate[index]), time)), sine, cosine);
+                float32x4_t const scaledCosine{ vmulq_f32(scale, cosine) };
+                float32x4_t const scaledSine{ vmulq_f32(scale, sine) };
+
+                float* pInstances{ &pDestination[index].worldRows[0][0] };
+                StoreRows(pInstances, scaledCosine, zero, scaledSine, vld1q_f32(&m_x[index]));
+                StoreRows(pInstances + 4, zero, scale, zero, vld1q_f32(&m_y[index]));
+                StoreRows(pInstances + 8, vnegq_f32(scaledSine), zero, scaledCosine, vld1q_f32(&m_z[index]));
+                StoreRows(pInstances + 12, vld1q_f32(&m_red[index]), vld1q_f32(&m_green[index]), vld1q_f32(&m_blue[index]), one);
+            }
+        }
+#endif
+
+    public:
+        InstanceField(uint32_t count = 1) :
+            m_count{ count }
+        {
+            uint32_t const paddedCount{ (count + 3) & ~3u };
+            for (auto* pArray : { &m_blue, &m_green, &m_phase, &m_red, &m_spinRate, &m_x, &m_y, &m_z })
+            {
+                pArray->assign(paddedCount, 0.f);
+            }
+            if (count <= 1)
+            {
+                m_blue.assign(paddedCount, 1.f);
+                m_green.assign(paddedCount, 1.f);
+                m_red.assign(paddedCount, 1.f);
+                return;
+            }
+
+            uint32_t gridSide{ static_cast<uint32_t>(std::cbrt(static_cast<double>(count))) };
+            while (uint64_t{ gridSide } * gridSide * gridSide < count) ++gridSide;
+            float const cellSize{ s_extent / gridSide };
+            m_scale = cellSize * .6f;
+
+            for (uint32_t index{ 0 }; index < count; ++index)
+            {
+                uint32_t const column{ index % gridSide };
+                uint32_t const row{ (index / gridSide) % gridSide };
+                uint32_t const layer{ index / (gridSide * gridSide) };
+                m_x[index] = -s_extent / 2 + cellSize * (column + .5f);
+                m_y[index] = s_extent / 2 - cellSize * (row + .5f);
+                m_z[index] = -s_extent / 2 + cellSize * (layer + .5f);
+
+                // A cheap hash of the index spreads the phases and rates without visible patterns.
+                uint32_t hash{ index * 2654435761u };
+                hash ^= hash >> 15;
+                m_phase[index] = (hash & 0xffff) * (2.f * s_pi / 65536.f);
+                m_spinRate[index] = .5f + (hash >> 16) * (1.f / 65536.f);
+
+                m_red[index] = .4f + .6f * (column + .5f) / gridSide;
+                m_green[index] = .4f + .6f * (row + .5f) / gridSide;
+                m_blue[index] = .4f + .6f * (layer + .5f) / gridSide;
+            }
+        }
+
+        // member functions
+
+        // Writes instances [first, first + count) of the field, as they are at `seconds`, into
+        // pDestination[first] onward. Disjoint ranges can be written from different threads;
+        // ranges that start on a multiple of four are written four instances at a time.
+        void Write(float seconds, InstanceData* pDestination, uint32_t first, uint32_t count) const
+        {
+            uint32_t end{ first + count };
+            if (end > m_count) end = m_count;
+            if (first >= end) return;
+
+#if defined(DX_INSTANCE_TRANSFORMS_SSE2) || defined(DX_INSTANCE_TRANSFORMS_NEON)
+            bool const aligned{ (reinterpret_cast<uintptr_t>(pDestination) & 15) == 0 };
+            if (m_useSimd && aligned && (first & 3) == 0)
+            {
+                uint32_t const simdEnd{ first + ((end - first) & ~3u) };
+                WriteSimd(seconds, pDestination, first, simdEnd);
+                first = simdEnd;
+            }
+#endif
+            WriteScalar(seconds, pDestination, first, end);
+        }
+
+        // accessors
+
+        // Where instance `index` is (it spins about its center, so that doesn't move).
+        void Center(uint32_t index, float& x, float& y, float& z) const
+        {
+            x = m_x[index];
+            y = m_y[index];
+            z = m_z[index];
+        }
+
+        uint32_t Count() const { return m_count; }
+
+        // Of the cube, whose side is 1 before it's scaled.
+        float Scale() const { return m_scale; }
+
+        // The number of instances that Write computes at a time: 4 with SSE2 or NEON, otherwise 1.
+        uint32_t SimdWidth() const
+        {
+#if defined(DX_INSTANCE_TRANSFORMS_SSE2) || defined(DX_INSTANCE_TRANSFORMS_NEON)
+            return m_useSimd ? 4 : 1;
+#else
+            return 1;
+#endif
+        }
+
+        // mutators
+
+        void UseSimd(bool useSimd) { m_useSimd = useSimd; }
+    };
+}
@@ -0,0 +1,473 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Places screen-space labels on 3D anchor points, so that no two overlap. Each frame, the
+// anchors are projected through the world-view-projection matrix, four at a time (with SSE2
+// or NEON), and those outside the view volume are dropped; then the rest are placed in order
+// of priority, each only if its rectangle overlaps none placed before it. The placed labels'
+// rectangles are kept in a uniform grid of cells the size of the largest label: each is
+// entered in every cell (at most nine) that the top left of a label overlapping it could be
+// in, so that a candidate (of which most are dropped, in a crowded view) is tested only
+// against those of the cell that its top left is in, four at a time. The candidates are
+// sorted by priority once, when they're set, not every frame.
+// Backend-neutral: the caller draws what's placed (see SampleTextRenderer, which adds the
+// labels' glyphs to its glyph batch, so that they're drawn with the text in one draw).
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DX_LABEL_DECLUTTER_SSE2
+#endif
+#if defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define DX_LABEL_DECLUTTER_NEON
+#endif
+
+namespace DX
+{
+    // A label that may be placed: its anchor, in the space that Update's matrix transforms from;
+    // the size of its rectangle, in the viewport's units, with the anchor at the middle of its
+    // bottom edge; and its priority (higher is placed first; of equal priority, the first given).
+    struct LabelCandidate final
+    {
+        float x{ 0.f };
+        float y{ 0.f };
+        float z{ 0.f };
+        float width{ 0.f };
+        float height{ 0.f };
+        uint32_t priority{ 0 };
+    };
+
+    // A placed label: its index in the candidates, and its rectangle's top left in the viewport.
+    struct LabelPlacement final
+    {
+        uint32_t label{ 0 };
+        float left{ 0.f };
+        float top{ 0.f };
+    };
+
+    struct LabelDeclutterStatistics final
+    {
+        uint64_t frames{ 0 };
+        uint64_t candidates{ 0 };
+        uint64_t visible{ 0 }; // Candidates whose anchors were in the view volume.
+        uint64_t placed{ 0 };
+
+        double PlacedFraction() const { return visible ? static_cast<double>(placed) / visible : 0.; }
+    };
+
+    class LabelDeclutter final
+    {
+        static constexpr float s_empty{ std::numeric_limits<float>::max() };
+
+        // Up to four of the rectangles entered in a cell; unused lanes hold an empty rectangle,
+        // which overlaps nothing, so that a block is always tested whole. A cell's first block
+        // is the cell's own (so that it's found without another load), and the rest are chained.
+        struct CellBlock final
+        {
+            float left[4]{ s_empty, s_empty, s_empty, s_empty };
+            float top[4]{ s_empty, s_empty, s_empty, s_empty };
+            float right[4]{ -s_empty, -s_empty, -s_empty, -s_empty };
+            float bottom[4]{ -s_empty, -s_empty, -s_empty, -s_empty };
+            int32_t next{ -1 }; // The cell's next block, or -1.
+            uint32_t count{ 0 };
+        };
+
+        // data members
+
+        std::vector<CellBlock> m_cellBlocks; // The first m_columns * m_rows are the cells'.
+        std::vector<uint32_t> m_cells; // This frame's, of the visible candidates' top lefts.
+        float m_cellHeight{ 1.f };
+        float m_cellWidth{ 1.f };
+        float m_inverseCellHeight{ 1.f };
+        float m_inverseCellWidth{ 1.f };
+        uint32_t m_columns{ 0 };
+        std::vector<float> m_height; // Of each candidate, in order of priority, as are the other arrays.
+        std::vector<uint32_t> m_labels; // The candidates' indices, as they were given.
+        std::vector<float> m_left; // This frame's, of the visible candidates.
+        std::vector<LabelPlacement> m_placements;
+        uint32_t m_rows{ 0 };
+        LabelDeclutterStatistics m_statistics;
+        std::vector<float> m_top;
+        bool m_useSimd{ true };
+        std::vector<uint32_t> m_visible; // This frame's, in order of priority; the first m_visibleCount.
+        uint32_t m_visibleCount{ 0 };
+        std::vector<float> m_width;
+        std::vector<float> m_x; // The anchors.
+        std::vector<float> m_y;
+        std::vector<float> m_z;
+
+        // member functions
+
+        // The cells that points are in; those off the viewport are clamped to its edge.
+        uint32_t Column(float x) const { return static_cast<uint32_t>(std::clamp(x * m_inverseCellWidth, 0.f, static_cast<float>(m_columns - 1))); }
+        uint32_t Row(float y) const { return static_cast<uint32_t>(std::clamp(y * m_inverseCellHeight, 0.f, static_cast<float>(m_rows - 1))); }
+
+        // Places the visible candidates, in order of priority, where they overlap none placed before.
+        void Declutter()
+        {
+            m_cellBlocks.assign(size_t{ m_columns } * m_rows, CellBlock{});
+            m_placements.clear();
+
+            float const* const pLeft{ m_left.data() };
+            float const* const pTop{ m_top.data() };
+            float const* const pWidth{ m_width.data() };
+            float const* const pHeight{ m_height.data() };
+            uint32_t const* const pCells{ m_cells.data() };
+            for (uint32_t visible{ 0 }; visible < m_visibleCount; ++visible)
+            {
+                uint32_t const slot{ m_visible[visible] };
+                float const left{ pLeft[slot] };
+                float const top{ pTop[slot] };
+                float const right{ left + pWidth[slot] };
+                float const bottom{ top + pHeight[slot] };
+                if (Overlaps(pCells[slot], left, top, right, bottom)) continue;
+
+                // A label overlapping this one would have its top left in (left - width, right) by
+                // (top - height, bottom), and its width and height are at most a cell's.
+                uint32_t const lastColumn{ Column(right) };
+                uint32_t const lastRow{ Row(bottom) };
+                for (uint32_t row{ Row(top - m_cellHeight) }; row <= lastRow; ++row)
+                {
+                    for (uint32_t column{ Column(left - m_cellWidth) }; column <= lastColumn; ++column)
+                    {
+                        Insert(row * m_columns + column, left, top, right, bottom);
+                    }
+                }
+                m_placements.push_back(LabelPlacement{ m_labels[slot], left, top });
+            }
+        }
+
+        // Into the cell's first block, or the one after it, which is the only other that may not be full.
+        void Insert(uint32_t cell, float left, float top, float right, float bottom)
+        {
+            int32_t block{ static_cast<int32_t>(cell) };
+            if (m_cellBlocks[block].count == 4)
+            {
+                int32_t const second{ m_cellBlocks[block].next };
+                if (second >= 0 && m_cellBlocks[second].count < 4)
+                {
+                    block = second;
+                }
+                else
+                {
+                    int32_t const added{ static_cast<int32_t>(m_cellBlocks.size()) };
+                    m_cellBlocks.push_back(CellBlock{});
+                    m_cellBlocks[added].next = second;
+                    m_cellBlocks[block].next = added;
+                    block = added;
+                }
+            }
+            CellBlock& cellBlock{ m_cellBlocks[block] };
+            uint32_t const lane{ cellBlock.count++ };
+            cellBlock.left[lane] = left;
+            cellBlock.top[lane] = top;
+            cellBlock.right[lane] = right;
+            cellBlock.bottom[lane] = bottom;
+        }
+
+        // Whether a rectangle overlaps one entered in a cell; rectangles that only touch don't.
+        bool Overlaps(uint32_t cell, float left, float top, float right, float bottom) const
+        {
+#if defined(DX_LABEL_DECLUTTER_SSE2)
+            if (m_useSimd)
+            {
+                __m128 const lefts{ _mm_set1_ps(left) };
+                __m128 const tops{ _mm_set1_ps(top) };
+                __m128 const rights{ _mm_set1_ps(right) };
+                __m128 const bottoms{ _mm_set1_ps(bottom) };
+                for (int32_t block{ static_cast<int32_t>(cell) }; block >= 0; block = m_cellBlocks[block].next)
+                {
+                    CellBlock const& cellBlock{ m_cellBlocks[block] };
+                    __m128 const horizontal{ _mm_and_ps(_mm_cmplt_ps(lefts, _mm_loadu_ps(cellBlock.right)), _mm_cmplt_ps(_mm_loadu_ps(cellBlock.left), rights)) };
+                    __m128 const vertical{ _mm_and_ps(_mm_cmplt_ps(tops, _mm_loadu_ps(cellBlock.bottom)), _mm_cmplt_ps(_mm_loadu_ps(cellBlock.top), bottoms)) };
+                    if (_mm_movemask_ps(_mm_and_ps(horizontal, vertical)) != 0) return true;
+                }
+                return false;
+            }
+#elif defined(DX_LABEL_DECLUTTER_NEON)
+            if (m_useSimd)
+            {
+                float32x4_t const lefts{ vdupq_n_f32(left) };
+                float32x4_t const tops{ vdupq_n_f32(top) };
+                float32x4_t const rights{ vdupq_n_f32(right) };
+                float32x4_t const bottoms{ vdupq_n_f32(bottom) };
+                for (int32_t block{ static_cast<int32_t>(cell) }; block >= 0; block = m_cellBlocks[block].next)
+                {
+                    CellBlock const& cellBlock{ m_cellBlocks[block] };
+                    uint32x4_t const horizontal{ vandq_u32(vcltq_f32(lefts, vld1q_f32(cellBlock.right)), vcltq_f32(vld1q_f32(cellBlock.left), rights)) };
+                    uint32x4_t const vertical{ vandq_u32(vcltq_f32(tops, vld1q_f32(cellBlock.bottom)), vcltq_f32(vld1q_f32(cellBlock.top), bottoms)) };
+                    if (vmaxvq_u32(vandq_u32(horizontal, vertical)) != 0) return true;
+                }
+                return false;
+            }
+#endif
+            for (int32_t block{ static_cast<int32_t>(cell) }; block >= 0; block = m_cellBlocks[block].next)
+            {
+                CellBlock const& cellBlock{ m_cellBlocks[block] };
+                for (uint32_t lane{ 0 }; lane < cellBlock.count; ++lane)
+                {
+                    if (left < cellBlock.right[lane] && cellBlock.left[lane] < right && top < cellBlock.bottom[lane] && cellBlock.top[lane] < bottom) return true;
+                }
+            }
+            return false;
+        }
+
+        // Projects the anchors, and keeps the visible candidates' rectangles and the cells their
+        // top lefts are in. The SIMD paths evaluate exactly the same operations as the scalar
+        // one, so every path places the same labels. The visible candidates are listed without
+        // branching on each: every slot is written, and the count advances only past visible ones.
+        void Project(float const (&clipRows)[4][4], float viewportWidth, float viewportHeight)
+        {
+            uint32_t const count{ static_cast<uint32_t>(m_labels.size()) };
+            float const halfWidth{ viewportWidth * .5f };
+            float const halfHeight{ viewportHeight * .5f };
+            // Through local pointers, as the stores of the cells (through a vector type) could
+            // otherwise alias anything, and make the compiler load every operand again.
+            float const* const pX{ m_x.data() };
+            float const* const pY{ m_y.data() };
+            float const* const pZ{ m_z.data() };
+            float const* const pWidth{ m_width.data() };
+            float const* const pHeight{ m_height.data() };
+            float* const pLeft{ m_left.data() };
+            float* const pTop{ m_top.data() };
+            uint32_t* const pCells{ m_cells.data() };
+            uint32_t* const pVisible{ m_visible.data() };
+            uint32_t visibleCount{ 0 };
+            uint32_t slot{ 0 };
+
+#if defined(DX_LABEL_DECLUTTER_SSE2)
+            if (m_useSimd)
+            {
+                __m128 const zero{ _mm_setzero_ps() };
+                __m128 const half{ _mm_set1_ps(.5f) };
+                __m128 const halfWidths{ _mm_set1_ps(halfWidth) };
+                __m128 const halfHeights{ _mm_set1_ps(halfHeight) };
+                __m128 const columns{ _mm_set1_ps(static_cast<float>(m_columns)) };
+                __m128 const lastColumn{ _mm_set1_ps(static_cast<float>(m_columns - 1)) };
+                __m128 const lastRow{ _mm_set1_ps(static_cast<float>(m_rows - 1)) };
+                __m128 const inverseCellWidth{ _mm_set1_ps(m_inverseCellWidth) };
+                __m128 const inverseCellHeight{ _mm_set1_ps(m_inverseCellHeight) };
+                __m128 matrix[4][4];
+                for (uint32_t row{ 0 }; row < 4; ++row)
+                {
+                    for (uint32_t column{ 0 }; column < 4; ++column) matrix[row][column] = _mm_set1_ps(clipRows[row][column]);
+                }
+                auto row = [&](uint32_t row, __m128 x, __m128 y, __m128 z)
+                    {
+                        return _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(matrix[row][0], x), _mm_mul_ps(matrix[row][1], y)), _mm_mul_ps(matrix[row][2], z)), matrix[row][3]);
+                    };
+                for (; slot + 4 <= count; slot += 4)
+                {
+                    __m128 const x{ _mm_loadu_ps(pX + slot) };
+                    __m128 const y{ _mm_loadu_ps(pY + slot) };
+                    __m128 const z{ _mm_loadu_ps(pZ + slot) };
+                    __m128 const clipX{ row(0, x, y, z) };
+                    __m128 const clipY{ row(1, x, y, z) };
+                    __m128 const clipZ{ row(2, x, y, z) };
+                    __m128 const clipW{ row(3, x, y, z) };
+                    __m128 const negativeW{ _mm_sub_ps(zero, clipW) };
+                    __m128 const inside{ _mm_and_ps(
+                        _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(clipZ, zero), _mm_cmple_ps(clipZ, clipW)), _mm_and_ps(_mm_cmpge_ps(clipX, negativeW), _mm_cmple_ps(clipX, clipW))),
+                        _mm_and_ps(_mm_cmpge_ps(clipY, negativeW), _mm_cmple_ps(clipY, clipW))) };
+                    int const visible{ _mm_movemask_ps(inside) };
+                    if (visible == 0) continue;
+
+                    __m128 const inverseW{ _mm_div_ps(_mm_set1_ps(1.f), clipW) };
+                    __m128 const anchorX{ _mm_add_ps(_mm_mul_ps(_mm_mul_ps(clipX, inverseW), halfWidths), halfWidths) };
+                    __m128 const anchorY{ _mm_sub_ps(halfHeights, _mm_mul_ps(_mm_mul_ps(clipY, inverseW), halfHeights)) };
+                    __m128 const left{ _mm_sub_ps(anchorX, _mm_mul_ps(_mm_loadu_ps(pWidth + slot), half)) };
+                    __m128 const top{ _mm_sub_ps(anchorY, _mm_loadu_ps(pHeight + slot)) };
+                    _mm_storeu_ps(pLeft + slot, left);
+                    _mm_storeu_ps(pTop + slot, top);
+
+                    // Clamped to the grid, and truncated (they aren't negative), as Column and Row do.
+                    __m128 const column{ _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(left, inverseCellWidth), zero), lastColumn))) };
+                    __m128 const cellRow{ _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(top, inverseCellHeight), zero), lastRow))) };
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(pCells + slot), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(cellRow, columns), column)));
+                    for (uint32_t lane{ 0 }; lane < 4; ++lane)
+                    {
+                        pVisible[visibleCount] = slot + lane;
+                        visibleCount += (visible >> lane) & 1;
+                    }
+                }
+            }
+#elif defined(DX_LABEL_DECLUTTER_NEON)
+            if (m_useSimd)
+            {
+                float32x4_t const zero{ vdupq_n_f32(0.f) };
+                float32x4_t const half{ vdupq_n_f32(.5f) };
+                float32x4_t const halfWidths{ vdupq_n_f32(halfWidth) };
+                float32x4_t const halfHeights{ vdupq_n_f32(halfHeight) };
+                float32x4_t const columns{ vdupq_n_f32(static_cast<float>(m_columns)) };
+                float32x4_t const lastColumn{ vdupq_n_f32(static_cast<float>(m_columns - 1)) };
+                float32x4_t const lastRow{ vdupq_n_f32(static_cast<float>(m_rows - 1)) };
+                float32x4_t const inverseCellWidth{ vdupq_n_f32(m_inverseCellWidth) };
+                float32x4_t const inverseCellHeight{ vdupq_n_f32(m_inverseCellHeight) };
+                float32x4_t matrix[4][4];
+                for (uint32_t row{ 0 }; row < 4; ++row)
+                {
+                    for (uint32_t column{ 0 }; column < 4; ++column) matrix[row][column] = vdupq_n_f32(clipRows[row][column]);
+                }
+
+                // vmulq then vaddq (not vmlaq, which may fuse), to match the scalar path.
+                auto row = [&](uint32_t row, float32x4_t x, float32x4_t y, float32x4_t z)
+                    {
+                        return vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(matrix[row][0], x), vmulq_f32(matrix[row][1], y)), vmulq_f32(matrix[row][2], z)), matrix[row][3]);
+                    };
+                for (; slot + 4 <= count; slot += 4)
+                {
+                    float32x4_t const x{ vld1q_f32(pX + slot) };
+                    float32x4_t const y{ vld1q_f32(pY + slot) };
+                    float32x4_t const z{ vld1q_f32(pZ + slot) };
+                    float32x4_t const clipX{ row(0, x, y, z) };
+                    float32x4_t const clipY{ row(1, x, y, z) };
+                    float32x4_t const clipZ{ row(2, x, y, z) };
+                    float32x4_t const clipW{ row(3, x, y, z) };
+                    float32x4_t const negativeW{ vsubq_f32(zero, clipW) };
+                    uint32x4_t const inside{ vandq_u32(
+                        vandq_u32(vandq_u32(vcgeq_f32(clipZ, zero), vcleq_f32(clipZ, clipW)), vandq_u32(vcgeq_f32(clipX, negativeW), vcleq_f32(clipX, clipW))),
+                        vandq_u32(vcgeq_f32(clipY, negativeW), vcleq_f32(clipY, clipW))) };
+                    if (vmaxvq_u32(inside) == 0) continue;
+
+                    float32x4_t const inverseW{ vdivq_f32(vdupq_n_f32(1.f), clipW) };
+                    float32x4_t const anchorX{ vaddq_f32(vmulq_f32(vmulq_f32(clipX, inverseW), halfWidths), halfWidths) };
+                    float32x4_t const anchorY{ vsubq_f32(halfHeights, vmulq_f32(vmulq_f32(clipY, inverseW), halfHeights)) };
+                    float32x4_t const left{ vsubq_f32(anchorX, vmulq_f32(vld1q_f32(pWidth + slot), half)) };
+                    float32x4_t const top{ vsubq_f32(anchorY, vld1q_f32(pHeight + slot)) };
+                    vst1q_f32(pLeft + slot, left);
+                    vst1q_f32(pTop + slot, top);
+
+                    // Clamped to the grid, and truncated (they aren't negative), as Column and Row do.
+                    float32x4_t const column{ vcvtq_f32_u32(vcvtq_u32_f32(vminq_f32(vmaxq_f32(vmulq_f32(left, inverseCellWidth), zero), lastColumn))) };
+                    float32x4_t const cellRow{ vcvtq_f32_u32(vcvtq_u32_f32(vminq_f32(vmaxq_f32(vmulq_f32(top, inverseCellHeight), zero), lastRow))) };
+                    vst1q_u32(pCells + slot, vcvtq_u32_f32(vaddq_f32(vmulq_f32(cellRow, columns), column)));
+                    uint32_t lanes[4];
+                    vst1q_u32(lanes, inside);
+                    for (uint32_t lane{ 0 }; lane < 4; ++lane)
+                    {
+                        pVisible[visibleCount] = slot + lane;
+                        visibleCount += lanes[lane] & 1;
+                    }
+                }
+            }
+#endif
+            for (; slot < count; ++slot)
+            {
+                float const x{ pX[slot] };
+                float const y{ pY[slot] };
+                float const z{ pZ[slot] };
+                auto row = [&](uint32_t row) { return clipRows[row][0] * x + clipRows[row][1] * y + clipRows[row][2] * z + clipRows[row][3]; };
+                float const clipX{ row(0) };
+                float const clipY{ row(1) };
+                float const clipZ{ row(2) };
+                float const clipW{ row(3) };
+                float const negativeW{ 0.f - clipW };
+                if (!(clipZ >= 0.f && clipZ <= clipW && clipX >= negativeW && clipX <= clipW && clipY >= negativeW && clipY <= clipW)) continue;
+
+                float const inverseW{ 1.f / clipW };
+                float const anchorX{ clipX * inverseW * halfWidth + halfWidth };
+                float const anchorY{ halfHeight - clipY * inverseW * halfHeight };
+                pLeft[slot] = anchorX - pWidth[slot] * .5f;
+                pTop[slot] = anchorY - pHeight[slot];
+                pCells[slot] = Row(pTop[slot]) * m_columns + Column(pLeft[slot]);
+                pVisible[visibleCount++] = slot;
+            }
+            m_visibleCount = visibleCount;
+        }
+
+    public:
+        // member functions
+
+        // Sets the candidates (and sorts them by priority, which is why it's not done per frame).
+        void Labels(std::vector<LabelCandidate> const& candidates)
+        {
+            uint32_t const count{ static_cast<uint32_t>(candidates.size()) };
+            m_labels.resize(count);
+            std::iota(m_labels.begin(), m_labels.end(), 0u);
+            std::stable_sort(m_labels.begin(), m_labels.end(), [&](uint32_t a, uint32_t b) { return candidates[a].priority > candidates[b].priority; });
+
+            for (auto* pArray : { &m_height, &m_left, &m_top, &m_width, &m_x, &m_y, &m_z })
+            {
+                pArray->resize(count);
+            }
+            m_cells.resize(count);
+            m_visible.resize(count);
+            m_visibleCount = 0;
+            m_cellWidth = 1.f;
+            m_cellHeight = 1.f;
+            for (uint32_t slot{ 0 }; slot < count; ++slot)
+            {
+                LabelCandidate const& candidate{ candidates[m_labels[slot]] };
+                m_x[slot] = candidate.x;
+                m_y[slot] = candidate.y;
+                m_z[slot] = candidate.z;
+                m_width[slot] = candidate.width;
+                m_height[slot] = candidate.height;
+                m_cellWidth = std::max(m_cellWidth, candidate.width);
+                m_cellHeight = std::max(m_cellHeight, candidate.height);
+            }
+            m_inverseCellWidth = 1.f / m_cellWidth;
+            m_inverseCellHeight = 1.f / m_cellHeight;
+            m_placements.clear();
+        }
+
+        // Places this frame's labels, on a viewport of the given size, from the top left.
+        // clipRows are the rows of the world-view-projection matrix in column-vector form, so
+        // that clip.x = dot(float4(anchor, 1), clipRows[0]), and so on; that's the product
+        // projection * view * world of WorldViewProjectionConstantBuffer's (transposed) matrices.
+        void Update(float const (&clipRows)[4][4], float viewportWidth, float viewportHeight)
+        {
+            m_columns = std::max(static_cast<uint32_t>(std::ceil(viewportWidth * m_inverseCellWidth)), 1u);
+            m_rows = std::max(static_cast<uint32_t>(std::ceil(viewportHeight * m_inverseCellHeight)), 1u);
+            Project(clipRows, viewportWidth, viewportHeight);
+            Declutter();
+
+            ++m_statistics.frames;
+            m_statistics.candidates += m_labels.size();
+            m_statistics.visible += m_visibleCount;
+            m_statistics.placed += m_placements.size();
+        }
+
+        // accessors
+
+        uint32_t Count() const { return static_cast<uint32_t>(m_labels.size()); }
+
+        // This frame's, in order of priority.
+        std::vector<LabelPlacement> const& Placements() const { return m_placements; }
+
+        // The number of candidates that are projected, and of placed labels tested against, at a
+        // time: 4 with SSE2 or NEON, otherwise 1.
+        uint32_t SimdWidth() const
+        {
+#if defined(DX_LABEL_DECLUTTER_SSE2) || defined(DX_LABEL_DECLUTTER_NEON)
+            return m_useSimd ? 4 : 1;
+#else
+            return 1;
+#endif
+        }
+
+        LabelDeclutterStatistics const& Statistics() const { return m_statistics; }
+        uint32_t VisibleCount() const { return m_visibleCount; }
+
+        // mutators
+
+        void UseSimd(bool useSimd) { m_useSimd = useSimd; }
+    };
+}
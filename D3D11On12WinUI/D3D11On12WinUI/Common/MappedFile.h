@@ -0,0 +1,121 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// A read-only file, mapped into memory (MapViewOfFile on Windows, mmap elsewhere). Its pages
+// are read in as they're touched, and belong to the file rather than to the process's
+// commit charge, so the system can drop them under memory pressure and read them again.
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace DX
+{
+    class MappedFile final
+    {
+        // data members
+
+        void const* m_pData{ nullptr };
+        size_t m_sizeInBytes{ 0 };
+
+    public:
+        MappedFile() = default;
+
+        ~MappedFile()
+        {
+            Close();
+        }
+
+        MappedFile(MappedFile&& other) noexcept :
+            m_pData{ std::exchange(other.m_pData, nullptr) },
+            m_sizeInBytes{ std::exchange(other.m_sizeInBytes, 0) }
+        {
+        }
+
+        MappedFile& operator=(MappedFile&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Close();
+                m_pData = std::exchange(other.m_pData, nullptr);
+                m_sizeInBytes = std::exchange(other.m_sizeInBytes, 0);
+            }
+            return *this;
+        }
+
+        MappedFile(MappedFile const&) = delete;
+        MappedFile& operator=(MappedFile const&) = delete;
+
+        // member functions
+
+        void Close()
+        {
+            if (!m_pData) return;
+#if defined(_WIN32)
+            ::UnmapViewOfFile(m_pData);
+#else
+            ::munmap(const_cast<void*>(m_pData), m_sizeInBytes);
+#endif
+            m_pData = nullptr;
+            m_sizeInBytes = 0;
+        }
+
+        // Maps the whole file. Returns false (and maps nothing) if it can't be opened, or is empty.
+        bool Open(std::filesystem::path const& path)
+        {
+            Close();
+#if defined(_WIN32)
+            HANDLE const file{ ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+            if (file == INVALID_HANDLE_VALUE) return false;
+            LARGE_INTEGER fileSize{};
+            HANDLE const mapping{ ::GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0 ? ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr };
+            ::CloseHandle(file); // The mapping keeps the file open.
+            if (!mapping) return false;
+            m_pData = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            ::CloseHandle(mapping); // And the view keeps the mapping.
+            m_sizeInBytes = m_pData ? static_cast<size_t>(fileSize.QuadPart) : 0;
+#else
+            int const file{ ::open(path.c_str(), O_RDONLY) };
+            if (file < 0) return false;
+            struct stat status{};
+            void* pData{ ::fstat(file, &status) == 0 && status.st_size > 0 ? ::mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED };
+            ::close(file);
+            if (pData == MAP_FAILED) return false;
+            m_pData = pData;
+            m_sizeInBytes = static_cast<size_t>(status.st_size);
+#endif
+            return m_pData != nullptr;
+        }
+
+        // accessors
+
+        void const* Data() const { return m_pData; }
+        size_t Size() const { return m_sizeInBytes; }
+    };
+}
@@ -0,0 +1,81 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// The backend-neutral part of D3D12OverlayLayer: decides, each frame, whether the 2D overlay
+// must be rasterized again into its persistent texture, or whether last frame's texture can
+// be composited as it is. It must be rasterized again when what it draws has changed (the
+// caller hashes that), when its size or DPI has changed (the texture is recreated), or when
+// the texture has been lost (Invalidate). Otherwise the frame pays nothing for the overlay
+// but the composite.
+
+#include <cstdint>
+
+namespace DX
+{
+    struct OverlayLayerStatistics final
+    {
+        uint64_t frames{ 0 };
+        uint64_t rasterizations{ 0 }; // Frames in which the overlay was rasterized.
+        uint64_t contentChanges{ 0 };
+        uint64_t resizes{ 0 }; // Of the size or the DPI.
+        uint64_t invalidations{ 0 }; // Of the texture; the first frame's is one.
+
+        double RasterizedFraction() const { return frames ? static_cast<double>(rasterizations) / frames : 0.; }
+    };
+
+    class OverlayLayer final
+    {
+        // data members
+
+        uint64_t m_contentHash{ 0 };
+        float m_dpi{ 0.f };
+        uint32_t m_height{ 0 };
+        OverlayLayerStatistics m_statistics;
+        bool m_valid{ false }; // The texture holds m_contentHash's overlay, at this size and DPI.
+        uint32_t m_width{ 0 };
+
+    public:
+        // member functions
+
+        // Call once a frame, with a hash of what the overlay draws, and the size (in pixels) and
+        // DPI of the target. Returns `true` if the overlay must be rasterized; the caller must
+        // then rasterize it, before the composite.
+        bool BeginFrame(uint64_t contentHash, uint32_t width, uint32_t height, float dpi)
+        {
+            ++m_statistics.frames;
+            bool const resized{ width != m_width || height != m_height || dpi != m_dpi };
+            bool const contentChanged{ contentHash != m_contentHash };
+            if (m_valid && !resized && !contentChanged) return false;
+
+            // Count only the first reason, so that the reasons add up to the rasterizations.
+            if (!m_valid) ++m_statistics.invalidations;
+            else if (resized) ++m_statistics.resizes;
+            else ++m_statistics.contentChanges;
+            ++m_statistics.rasterizations;
+
+            m_contentHash = contentHash;
+            m_width = width;
+            m_height = height;
+            m_dpi = dpi;
+            m_valid = true;
+            return true;
+        }
+
+        // For when the texture is lost (with the device, say): the next frame rasterizes.
+        void Invalidate() { m_valid = false; }
+
+        // accessors
+
+        OverlayLayerStatistics const& Statistics() const { return m_statistics; }
+    };
+}
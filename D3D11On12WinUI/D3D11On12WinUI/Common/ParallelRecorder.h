@@ -0,0 +1,180 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Records parts of a frame on threads of its own, while the render thread records the rest of
+// it; the render thread then collects the parts' recordings, in order, and plays them back. So
+// the recording is off the frame's critical path, but for whatever of it the render thread has
+// to wait for. Backend-neutral: a recording is whatever a part returns (for Direct2D, a closed
+// com_ptr<ID2D1CommandList>). Each part is told which of the threads it's on, so that it can
+// record with that thread's own context; no two parts are on a thread at once.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace DX
+{
+    // How much of the work moved off the render thread can't be told from these alone: with
+    // fewer cores than threads, the parts take the render thread's time without its waiting for
+    // them. Compare the render thread's frame time with and without the threads instead.
+    struct ParallelRecorderStatistics final
+    {
+        uint64_t frames{ 0 }; // That recorded parts (Begin and Collect).
+        uint64_t parts{ 0 };
+        uint64_t recordNanoseconds{ 0 }; // On the threads, summed over the parts.
+        uint64_t waitNanoseconds{ 0 }; // The render thread's, in Collect.
+        uint64_t playbackNanoseconds{ 0 }; // The render thread's, as told by PlayedBack.
+    };
+
+    template <typename TRecording>
+    class ParallelRecorder final
+    {
+        using Clock = std::chrono::steady_clock;
+
+    public:
+        using Part = std::function<TRecording(uint32_t threadIndex)>;
+
+    private:
+        // data members
+
+        // Shared with the threads (under m_mutex).
+        std::exception_ptr m_exception; // The first that a part of this frame threw.
+        size_t m_nextPart{ 0 };
+        std::condition_variable m_partAvailable;
+        std::condition_variable m_partFinished;
+        std::vector<Part> m_parts;
+        size_t m_partsFinished{ 0 };
+        std::vector<TRecording> m_recordings;
+        uint64_t m_recordNanoseconds{ 0 };
+        std::mutex m_mutex;
+        bool m_shuttingDown{ false };
+        std::vector<std::thread> m_threads;
+
+        // The render thread's own.
+        bool m_recording{ false };
+        ParallelRecorderStatistics m_statistics;
+
+        void ThreadMain(uint32_t threadIndex)
+        {
+            std::unique_lock<std::mutex> lock{ m_mutex };
+            for (;;)
+            {
+                m_partAvailable.wait(lock, [&] { return m_shuttingDown || m_nextPart < m_parts.size(); });
+                if (m_shuttingDown) return;
+                size_t const part{ m_nextPart++ };
+                Part const& record{ m_parts[part] };
+                lock.unlock();
+
+                TRecording recording{};
+                std::exception_ptr exception;
+                Clock::time_point const startTime{ Clock::now() };
+                try
+                {
+                    recording = record(threadIndex);
+                }
+                catch (...)
+                {
+                    exception = std::current_exception();
+                }
+                uint64_t const nanoseconds{ static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - startTime).count()) };
+
+                lock.lock();
+                m_recordings[part] = std::move(recording);
+                if (exception && !m_exception) m_exception = exception;
+                m_recordNanoseconds += nanoseconds;
+                if (++m_partsFinished == m_parts.size()) m_partFinished.notify_all();
+            }
+        }
+
+    public:
+        // A thread count of 0 means one thread (at least one is needed, for the work to be off the render thread).
+        explicit ParallelRecorder(uint32_t threadCount)
+        {
+            threadCount = std::max(threadCount, 1u);
+            for (uint32_t threadIndex{ 0 }; threadIndex < threadCount; ++threadIndex)
+            {
+                m_threads.emplace_back(&ParallelRecorder::ThreadMain, this, threadIndex);
+            }
+        }
+
+        // Waits for the parts being recorded; those that haven't started are abandoned.
+        ~ParallelRecorder()
+        {
+            {
+                std::lock_guard<std::mutex> lock{ m_mutex };
+                m_shuttingDown = true;
+            }
+            m_partAvailable.notify_all();
+            for (auto& thread : m_threads)
+            {
+                thread.join();
+            }
+        }
+
+        ParallelRecorder(ParallelRecorder const&) = delete;
+        ParallelRecorder& operator=(ParallelRecorder const&) = delete;
+
+        // member functions
+
+        // Starts recording the parts on the threads, and returns at once. What they refer to must
+        // stay as it is until Collect; call Collect before the next Begin.
+        void Begin(std::vector<Part> parts)
+        {
+            {
+                std::lock_guard<std::mutex> lock{ m_mutex };
+                m_parts = std::move(parts);
+                m_recordings.assign(m_parts.size(), TRecording{});
+                m_nextPart = 0;
+                m_partsFinished = 0;
+                m_exception = nullptr;
+                m_recordNanoseconds = 0;
+            }
+            m_recording = true;
+            m_partAvailable.notify_all();
+        }
+
+        // Waits for the parts to be recorded, and returns their recordings, in the order of the
+        // parts; they're the caller's to move from. Rethrows what a part threw.
+        std::vector<TRecording>& Collect()
+        {
+            Clock::time_point const startTime{ Clock::now() };
+            std::unique_lock<std::mutex> lock{ m_mutex };
+            m_partFinished.wait(lock, [&] { return m_partsFinished == m_parts.size(); });
+            m_statistics.waitNanoseconds += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - startTime).count());
+            ++m_statistics.frames;
+            m_statistics.parts += m_parts.size();
+            m_statistics.recordNanoseconds += m_recordNanoseconds;
+            m_parts.clear();
+            m_recording = false;
+            if (m_exception) std::rethrow_exception(std::exchange(m_exception, nullptr));
+            return m_recordings;
+        }
+
+        // The render thread's time playing back what Collect returned, for the statistics.
+        void PlayedBack(uint64_t nanoseconds) { m_statistics.playbackNanoseconds += nanoseconds; }
+
+        // accessors
+
+        // Between Begin and Collect.
+        bool Recording() const { return m_recording; }
+        ParallelRecorderStatistics const& Statistics() const { return m_statistics; }
+        uint32_t ThreadCount() const { return static_cast<uint32_t>(m_threads.size()); }
+    };
+}
@@ -0,0 +1,202 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// The backend-neutral part of the pipeline cache (D3D12PipelineCache): a hash of pipeline
+// descriptions that's the same from run to run (so, of the bytes that they describe, never of
+// pointers), and the archive of cached blobs (serialized root signatures, and the pipeline
+// library) that's saved to disk between runs. The archive is tagged with the device (adapter
+// and driver) that it was made on, and checksummed; a file that's from another device, or an
+// older format, or is damaged, is ignored, and the cache starts empty.
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "StableHasher.h"
+
+namespace DX
+{
+    enum class PipelineCacheEntryKind : uint32_t
+    {
+        RootSignature, // A serialized root signature, keyed by the hash of its description.
+        PipelineLibrary, // The serialized pipeline library (key 0).
+        PipelineBlob // A pipeline's cached blob, keyed by the hash of its description; for drivers without pipeline libraries.
+    };
+
+    enum class PipelineCacheLoadResult : uint32_t
+    {
+        None, // Nothing has been loaded.
+        Loaded,
+        Missing,
+        NotAnArchive,
+        OlderFormat,
+        OtherDevice, // From another adapter or driver version.
+        Corrupt
+    };
+
+    struct PipelineCacheStatistics final
+    {
+        uint64_t pipelineHits{ 0 };
+        uint64_t pipelineMisses{ 0 };
+        uint64_t rootSignatureHits{ 0 };
+        uint64_t rootSignatureMisses{ 0 };
+        PipelineCacheLoadResult loadResult{ PipelineCacheLoadResult::None };
+
+        double HitRate() const
+        {
+            uint64_t const hits{ pipelineHits + rootSignatureHits };
+            uint64_t const lookups{ hits + pipelineMisses + rootSignatureMisses };
+            return lookups ? static_cast<double>(hits) / lookups : 0.;
+        }
+    };
+
+    class PipelineCacheArchive final
+    {
+        static constexpr uint32_t s_magic{ 0x43504c50 }; // "PLPC"
+        static constexpr uint32_t s_formatVersion{ 1 };
+
+        // The file is this header, then each entry (an EntryHeader, then its data, padded to 8 bytes).
+        struct Header final
+        {
+            uint32_t magic{ s_magic };
+            uint32_t formatVersion{ s_formatVersion };
+            uint64_t deviceHash{ 0 };
+            uint64_t payloadSize{ 0 };
+            uint64_t payloadHash{ 0 };
+        };
+
+        struct EntryHeader final
+        {
+            uint64_t key{ 0 };
+            PipelineCacheEntryKind kind{ PipelineCacheEntryKind::RootSignature };
+            uint32_t sizeInBytes{ 0 };
+        };
+
+        // data members
+
+        uint64_t m_deviceHash{ 0 };
+        bool m_dirty{ false }; // Changed since it was loaded or serialized.
+        std::map<std::pair<PipelineCacheEntryKind, uint64_t>, std::vector<uint8_t>> m_entries;
+        PipelineCacheStatistics m_statistics;
+
+        static uint64_t PaddedSize(uint64_t sizeInBytes) { return (sizeInBytes + 7) & ~uint64_t{ 7 }; }
+
+        PipelineCacheLoadResult Parse(uint8_t const* pBytes, size_t sizeInBytes)
+        {
+            if (!pBytes) return PipelineCacheLoadResult::Missing;
+
+            Header header;
+            if (sizeInBytes < sizeof(Header)) return PipelineCacheLoadResult::NotAnArchive;
+            std::memcpy(&header, pBytes, sizeof(header));
+            if (header.magic != s_magic) return PipelineCacheLoadResult::NotAnArchive;
+            if (header.formatVersion != s_formatVersion) return PipelineCacheLoadResult::OlderFormat;
+            if (header.deviceHash != m_deviceHash) return PipelineCacheLoadResult::OtherDevice;
+            if (header.payloadSize != sizeInBytes - sizeof(Header)) return PipelineCacheLoadResult::Corrupt;
+
+            uint8_t const* pPayload{ pBytes + sizeof(Header) };
+            StableHasher payloadHasher;
+            payloadHasher.Add(pPayload, static_cast<size_t>(header.payloadSize));
+            if (payloadHasher.Hash() != header.payloadHash) return PipelineCacheLoadResult::Corrupt;
+
+            for (uint64_t offset{ 0 }; offset < header.payloadSize;)
+            {
+                EntryHeader entryHeader;
+                if (header.payloadSize - offset < sizeof(EntryHeader)) return PipelineCacheLoadResult::Corrupt;
+                std::memcpy(&entryHeader, pPayload + offset, sizeof(entryHeader));
+                offset += sizeof(EntryHeader);
+                if (entryHeader.kind > PipelineCacheEntryKind::PipelineBlob || header.payloadSize - offset < PaddedSize(entryHeader.sizeInBytes)) return PipelineCacheLoadResult::Corrupt;
+                m_entries[{ entryHeader.kind, entryHeader.key }].assign(pPayload + offset, pPayload + offset + entryHeader.sizeInBytes);
+                offset += PaddedSize(entryHeader.sizeInBytes);
+            }
+            return PipelineCacheLoadResult::Loaded;
+        }
+
+    public:
+        // `deviceHash` identifies the adapter and driver (see D3D12PipelineCache); an archive made on another is ignored.
+        PipelineCacheArchive(uint64_t deviceHash = 0) :
+            m_deviceHash{ deviceHash }
+        {
+        }
+
+        // member functions
+
+        // Counts a lookup that was answered elsewhere (by the pipeline library).
+        void CountLookup(PipelineCacheEntryKind kind, bool hit)
+        {
+            if (kind == PipelineCacheEntryKind::RootSignature) ++(hit ? m_statistics.rootSignatureHits : m_statistics.rootSignatureMisses);
+            else ++(hit ? m_statistics.pipelineHits : m_statistics.pipelineMisses);
+        }
+
+        // Returns the entry's data, or nullptr; and counts the lookup.
+        std::vector<uint8_t> const* Find(PipelineCacheEntryKind kind, uint64_t key)
+        {
+            auto it{ m_entries.find({ kind, key }) };
+            if (kind != PipelineCacheEntryKind::PipelineLibrary) CountLookup(kind, it != m_entries.end());
+            return it == m_entries.end() ? nullptr : &it->second;
+        }
+
+        // Adds (or replaces) an entry.
+        void Insert(PipelineCacheEntryKind kind, uint64_t key, void const* pData, size_t sizeInBytes)
+        {
+            auto const* pBytes{ static_cast<uint8_t const*>(pData) };
+            m_entries[{ kind, key }].assign(pBytes, pBytes + sizeInBytes);
+            m_dirty = true;
+        }
+
+        // Replaces the entries with those of a serialized archive, if it's valid for this device;
+        // otherwise, empties the archive. Pass nullptr if there's no file.
+        PipelineCacheLoadResult Load(void const* pData, size_t sizeInBytes)
+        {
+            m_entries.clear();
+            m_dirty = false;
+            m_statistics.loadResult = Parse(static_cast<uint8_t const*>(pData), sizeInBytes);
+            if (m_statistics.loadResult != PipelineCacheLoadResult::Loaded) m_entries.clear();
+            return m_statistics.loadResult;
+        }
+
+        std::vector<uint8_t> Serialize()
+        {
+            uint64_t payloadSize{ 0 };
+            for (auto const& entry : m_entries) payloadSize += sizeof(EntryHeader) + PaddedSize(entry.second.size());
+
+            std::vector<uint8_t> bytes(sizeof(Header) + payloadSize, 0);
+            uint8_t* pPayload{ bytes.data() + sizeof(Header) };
+            uint8_t* pWrite{ pPayload };
+            for (auto const& entry : m_entries)
+            {
+                EntryHeader const entryHeader{ entry.first.second, entry.first.first, static_cast<uint32_t>(entry.second.size()) };
+                std::memcpy(pWrite, &entryHeader, sizeof(entryHeader));
+                if (!entry.second.empty()) std::memcpy(pWrite + sizeof(entryHeader), entry.second.data(), entry.second.size());
+                pWrite += sizeof(entryHeader) + PaddedSize(entry.second.size());
+            }
+
+            StableHasher payloadHasher;
+            payloadHasher.Add(pPayload, static_cast<size_t>(payloadSize));
+            Header header;
+            header.deviceHash = m_deviceHash;
+            header.payloadSize = payloadSize;
+            header.payloadHash = payloadHasher.Hash();
+            std::memcpy(bytes.data(), &header, sizeof(header));
+            m_dirty = false;
+            return bytes;
+        }
+
+        // accessors
+
+        bool Dirty() const { return m_dirty; }
+        size_t EntryCount() const { return m_entries.size(); }
+        PipelineCacheStatistics const& Statistics() const { return m_statistics; }
+    };
+}
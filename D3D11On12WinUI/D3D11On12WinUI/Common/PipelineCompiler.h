@@ -0,0 +1,300 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Compiles pipelines on threads of its own, so that the render thread never waits in the
+// driver's compiler (which, for a new pipeline, can take 100 ms or more). The render thread
+// requests a pipeline by key, and each frame asks whether it's ready; until it is, the object
+// that wants it is drawn with a fallback pipeline (or skipped). Backend-neutral: a pipeline is
+// whatever the compile function returns (for D3D12, a com_ptr<ID3D12PipelineState>), and one
+// that converts to `false` means the compile failed.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace DX
+{
+    enum class PipelineCompileStatus : uint32_t
+    {
+        Unknown, // Never requested.
+        Pending,
+        Ready,
+        Failed // The compile function threw (or returned nothing); the fallback is used for good.
+    };
+
+    struct PipelineCompilerStatistics final
+    {
+        uint64_t requested{ 0 };
+        uint64_t compiled{ 0 };
+        uint64_t failed{ 0 };
+        uint32_t pending{ 0 };
+
+        // Of the most recent compiles: the time spent compiling, and the time from request to ready (which includes waiting for a thread).
+        double compileP50Milliseconds{ 0. };
+        double compileP99Milliseconds{ 0. };
+        double readyP50Milliseconds{ 0. };
+        double readyP99Milliseconds{ 0. };
+
+        // Each Acquire of a pipeline that wasn't ready is a frame that an object spent on the fallback.
+        uint64_t fallbackFrames{ 0 };
+        uint32_t maxFallbackFrames{ 0 }; // The most that any one pipeline's objects spent.
+        uint64_t pipelinesFallenBack{ 0 }; // Pipelines that were acquired at least once before they were ready.
+
+        double AverageFallbackFrames() const { return pipelinesFallenBack ? static_cast<double>(fallbackFrames) / pipelinesFallenBack : 0.; }
+    };
+
+    template <typename TPipeline>
+    class PipelineCompiler final
+    {
+        static constexpr size_t s_maxSamples{ 256 };
+        using Clock = std::chrono::steady_clock;
+
+        struct Job final
+        {
+            uint64_t key{ 0 };
+            std::function<TPipeline()> compile;
+        };
+
+        struct Finished final
+        {
+            uint64_t key{ 0 };
+            std::optional<TPipeline> pipeline; // Empty if the compile failed.
+            double compileMilliseconds{ 0. };
+        };
+
+        struct Entry final
+        {
+            PipelineCompileStatus status{ PipelineCompileStatus::Pending };
+            TPipeline pipeline{};
+            Clock::time_point requestTime;
+            uint32_t fallbackFrames{ 0 };
+        };
+
+        // data members
+
+        // Shared with the threads (under m_mutex).
+        std::deque<Job> m_jobs;
+        std::condition_variable m_jobAvailable;
+        std::condition_variable m_jobFinished;
+        std::vector<Finished> m_finished;
+        std::mutex m_mutex;
+        bool m_shuttingDown{ false };
+        std::vector<std::thread> m_threads;
+        uint32_t m_threadsBusy{ 0 };
+
+        // The render thread's own.
+        std::vector<double> m_compileSamplesMilliseconds;
+        std::unordered_map<uint64_t, Entry> m_entries;
+        size_t m_nextSampleIndex{ 0 };
+        std::vector<double> m_readySamplesMilliseconds;
+        PipelineCompilerStatistics m_statistics;
+
+        static void Record(std::vector<double>& samples, size_t sampleIndex, double milliseconds)
+        {
+            if (samples.size() < s_maxSamples) samples.push_back(milliseconds);
+            else samples[sampleIndex] = milliseconds;
+        }
+
+        static std::pair<double, double> Percentiles(std::vector<double> sorted)
+        {
+            if (sorted.empty()) return { 0., 0. };
+            std::sort(sorted.begin(), sorted.end());
+            auto percentile = [&](double fraction) { return sorted[std::min(sorted.size() - 1, static_cast<size_t>(fraction * (sorted.size() - 1) + .5))]; };
+            return { percentile(.5), percentile(.99) };
+        }
+
+        void ThreadMain()
+        {
+            for (;;)
+            {
+                Job job;
+                {
+                    std::unique_lock<std::mutex> lock{ m_mutex };
+                    m_jobAvailable.wait(lock, [&] { return m_shuttingDown || !m_jobs.empty(); });
+                    if (m_shuttingDown) return;
+                    job = std::move(m_jobs.front());
+                    m_jobs.pop_front();
+                    ++m_threadsBusy;
+                }
+
+                Finished finished{};
+                finished.key = job.key;
+                Clock::time_point const startTime{ Clock::now() };
+                try
+                {
+                    finished.pipeline = job.compile();
+                    if (!finished.pipeline.value()) finished.pipeline.reset();
+                }
+                catch (...)
+                {
+                    finished.pipeline.reset();
+                }
+                finished.compileMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - startTime).count();
+
+                {
+                    std::lock_guard<std::mutex> lock{ m_mutex };
+                    m_finished.push_back(std::move(finished));
+                    --m_threadsBusy;
+                }
+                m_jobFinished.notify_all();
+            }
+        }
+
+    public:
+        // A thread count of 0 means half the hardware threads (at least one), leaving the rest
+        // to the render thread and the app.
+        PipelineCompiler(uint32_t threadCount = 0)
+        {
+            if (threadCount == 0) threadCount = std::max(std::thread::hardware_concurrency() / 2, 1u);
+            for (uint32_t threadIndex{ 0 }; threadIndex < threadCount; ++threadIndex)
+            {
+                m_threads.emplace_back(&PipelineCompiler::ThreadMain, this);
+            }
+        }
+
+        // Waits for the compiles in progress; those that haven't started are abandoned.
+        ~PipelineCompiler()
+        {
+            {
+                std::lock_guard<std::mutex> lock{ m_mutex };
+                m_shuttingDown = true;
+                m_jobs.clear();
+            }
+            m_jobAvailable.notify_all();
+            for (auto& thread : m_threads)
+            {
+                thread.join();
+            }
+        }
+
+        PipelineCompiler(PipelineCompiler const&) = delete;
+        PipelineCompiler& operator=(PipelineCompiler const&) = delete;
+
+        // member functions
+
+        // Returns the pipeline if it's ready; otherwise nullptr, and counts a frame on the fallback
+        // for the object that wanted it. Call once per object per frame.
+        TPipeline const* Acquire(uint64_t key)
+        {
+            auto it{ m_entries.find(key) };
+            if (it == m_entries.end()) return nullptr;
+            Entry& entry{ it->second };
+            if (entry.status == PipelineCompileStatus::Ready) return &entry.pipeline;
+
+            if (entry.fallbackFrames++ == 0) ++m_statistics.pipelinesFallenBack;
+            ++m_statistics.fallbackFrames;
+            m_statistics.maxFallbackFrames = std::max(m_statistics.maxFallbackFrames, entry.fallbackFrames);
+            return nullptr;
+        }
+
+        // Takes the compiles that have finished since the last call, and returns how many of them
+        // succeeded. The render thread calls this once per frame, before it acquires pipelines.
+        uint32_t Poll()
+        {
+            std::vector<Finished> finished;
+            {
+                std::lock_guard<std::mutex> lock{ m_mutex };
+                finished.swap(m_finished);
+            }
+
+            uint32_t readyCount{ 0 };
+            Clock::time_point const now{ Clock::now() };
+            for (Finished& result : finished)
+            {
+                auto it{ m_entries.find(result.key) };
+                if (it == m_entries.end()) continue; // Forgotten (by Reset) while it compiled.
+                Entry& entry{ it->second };
+                --m_statistics.pending;
+                if (!result.pipeline)
+                {
+                    entry.status = PipelineCompileStatus::Failed;
+                    ++m_statistics.failed;
+                    continue;
+                }
+                entry.status = PipelineCompileStatus::Ready;
+                entry.pipeline = std::move(*result.pipeline);
+                ++m_statistics.compiled;
+                ++readyCount;
+                Record(m_compileSamplesMilliseconds, m_nextSampleIndex, result.compileMilliseconds);
+                Record(m_readySamplesMilliseconds, m_nextSampleIndex, std::chrono::duration<double, std::milli>(now - entry.requestTime).count());
+                m_nextSampleIndex = (m_nextSampleIndex + 1) % s_maxSamples;
+            }
+            return readyCount;
+        }
+
+        // Queues `compile` to run on one of the threads, unless `key` has been requested already.
+        // What `compile` refers to must outlive the compiler (or the next Reset).
+        void Request(uint64_t key, std::function<TPipeline()> compile)
+        {
+            if (!m_entries.emplace(key, Entry{ PipelineCompileStatus::Pending, TPipeline{}, Clock::now() }).second) return;
+            ++m_statistics.requested;
+            ++m_statistics.pending;
+            {
+                std::lock_guard<std::mutex> lock{ m_mutex };
+                m_jobs.push_back({ key, std::move(compile) });
+            }
+            m_jobAvailable.notify_one();
+        }
+
+        // Abandons the compiles that haven't started, waits for those in progress, and forgets
+        // every pipeline (as when the device is lost). The statistics are kept.
+        void Reset()
+        {
+            std::unique_lock<std::mutex> lock{ m_mutex };
+            m_jobs.clear();
+            m_jobFinished.wait(lock, [&] { return m_threadsBusy == 0; });
+            m_finished.clear();
+            m_entries.clear();
+            m_statistics.pending = 0;
+        }
+
+        // Blocks until every requested compile has finished (for tests, and for a loading screen
+        // that would rather wait), and then polls.
+        uint32_t WaitForAll()
+        {
+            {
+                std::unique_lock<std::mutex> lock{ m_mutex };
+                m_jobFinished.wait(lock, [&] { return m_jobs.empty() && m_threadsBusy == 0; });
+            }
+            return Poll();
+        }
+
+        // accessors
+
+        PipelineCompileStatus Status(uint64_t key) const
+        {
+            auto it{ m_entries.find(key) };
+            return it == m_entries.end() ? PipelineCompileStatus::Unknown : it->second.status;
+        }
+
+        PipelineCompilerStatistics Statistics() const
+        {
+            PipelineCompilerStatistics statistics{ m_statistics };
+            std::tie(statistics.compileP50Milliseconds, statistics.compileP99Milliseconds) = Percentiles(m_compileSamplesMilliseconds);
+            std::tie(statistics.readyP50Milliseconds, statistics.readyP99Milliseconds) = Percentiles(m_readySamplesMilliseconds);
+            return statistics;
+        }
+
+        uint32_t ThreadCount() const { return static_cast<uint32_t>(m_threads.size()); }
+    };
+}
@@ -0,0 +1,147 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "pch.h"
+
+namespace DX
+{
+    PlacedResourceAllocator::PlacedResourceAllocator(winrt::com_ptr<::ID3D12Device> const& pD3D12Device, UINT64 blockSize) :
+        m_pD3D12Device{ pD3D12Device }
+    {
+        // Textures that qualify for small (4KB) placement alignment are placed at that
+        // granularity; everything else is aligned to (at least) 64KB anyway.
+        for (uint32_t pool{ 0 }; pool < s_poolCount; ++pool)
+        {
+            bool const isTexturePool{ pool % static_cast<uint32_t>(PlacedResourceClass::Count) == static_cast<uint32_t>(PlacedResourceClass::Texture) };
+            m_pools[pool].allocator = HeapAllocator{ blockSize, isTexturePool ? D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT };
+        }
+    }
+
+    PlacedHeapRange PlacedResourceAllocator::AllocateRange(D3D12_HEAP_TYPE heapType, PlacedResourceClass resourceClass, UINT64 sizeInBytes)
+    {
+        uint32_t const pool{ PoolIndex(heapType, resourceClass) };
+        UINT64 const alignment{ resourceClass == PlacedResourceClass::RenderTargetOrDepthStencil ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT };
+        HeapAllocation const allocation{ m_pools[pool].allocator.Allocate(sizeInBytes, alignment) };
+        return PlacedHeapRange{ Heap(pool, allocation.block), allocation, pool };
+    }
+
+    PlacedResourceClass PlacedResourceAllocator::ClassOf(D3D12_RESOURCE_DESC const& resourceDesc)
+    {
+        if (resourceDesc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER) return PlacedResourceClass::Buffer;
+        if (resourceDesc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) return PlacedResourceClass::RenderTargetOrDepthStencil;
+        return PlacedResourceClass::Texture;
+    }
+
+    PlacedResource PlacedResourceAllocator::CreateResource(D3D12_HEAP_TYPE heapType, D3D12_RESOURCE_DESC const& resourceDesc, D3D12_RESOURCE_STATES initialState, D3D12_CLEAR_VALUE const* pOptimizedClearValue)
+    {
+        PlacedResourceClass const resourceClass{ ClassOf(resourceDesc) };
+        uint32_t const pool{ PoolIndex(heapType, resourceClass) };
+
+        // Ask for small placement alignment for a texture that might qualify; the device says whether it does.
+        D3D12_RESOURCE_DESC placedDesc{ resourceDesc };
+        D3D12_RESOURCE_ALLOCATION_INFO allocationInfo{};
+        if (resourceClass == PlacedResourceClass::Texture && placedDesc.SampleDesc.Count == 1 && placedDesc.Alignment == 0)
+        {
+            placedDesc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+            allocationInfo = m_pD3D12Device->GetResourceAllocationInfo(0, 1, &placedDesc);
+            if (allocationInfo.Alignment != D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT) placedDesc.Alignment = 0;
+        }
+        if (placedDesc.Alignment == 0) allocationInfo = m_pD3D12Device->GetResourceAllocationInfo(0, 1, &placedDesc);
+        if (allocationInfo.SizeInBytes == UINT64_MAX) winrt::throw_hresult(E_INVALIDARG);
+
+        HeapAllocation const allocation{ m_pools[pool].allocator.Allocate(allocationInfo.SizeInBytes, allocationInfo.Alignment) };
+
+        PlacedResource placedResource{ nullptr, allocation, pool };
+        HRESULT const hr{ m_pD3D12Device->CreatePlacedResource(
+            Heap(pool, allocation.block),
+            allocation.range.offset,
+            &placedDesc,
+            initialState,
+            pOptimizedClearValue,
+            __uuidof(placedResource.pResource),
+            placedResource.pResource.put_void()) };
+        if (FAILED(hr))
+        {
+            m_pools[pool].allocator.Free(allocation, 0); // Nothing used it, so it's free at once.
+            winrt::throw_hresult(hr);
+        }
+        return placedResource;
+    }
+
+    void PlacedResourceAllocator::Free(PlacedResource const& resource, uint64_t fenceValue)
+    {
+        m_pools[resource.pool].allocator.Free(resource.allocation, fenceValue);
+    }
+
+    void PlacedResourceAllocator::Free(PlacedHeapRange const& range, uint64_t fenceValue)
+    {
+        m_pools[range.pool].allocator.Free(range.allocation, fenceValue);
+    }
+
+    // Returns the heap of a block, creating it if this is the block's first allocation.
+    ::ID3D12Heap* PlacedResourceAllocator::Heap(uint32_t pool, uint32_t block)
+    {
+        std::vector<winrt::com_ptr<::ID3D12Heap>>& pD3D12Heaps{ m_pools[pool].pD3D12Heaps };
+        if (block >= pD3D12Heaps.size()) pD3D12Heaps.resize(block + 1);
+        if (pD3D12Heaps[block]) return pD3D12Heaps[block].get();
+
+        static constexpr D3D12_HEAP_FLAGS s_classHeapFlags[]{
+            D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+            D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES,
+            D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES };
+        uint32_t const resourceClass{ pool % static_cast<uint32_t>(PlacedResourceClass::Count) };
+        auto const heapType{ static_cast<D3D12_HEAP_TYPE>(D3D12_HEAP_TYPE_DEFAULT + pool / static_cast<uint32_t>(PlacedResourceClass::Count)) };
+
+        // A heap's size is a multiple of 64KB (a block of its own, for a small-aligned texture,
+        // mightn't be). Render targets and depth stencils may be multisampled, so their heaps are aligned for that.
+        UINT64 const heapSize{ (m_pools[pool].allocator.BlockSize(block) + D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1) & ~UINT64{ D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1 } };
+        UINT64 const heapAlignment{ resourceClass == static_cast<uint32_t>(PlacedResourceClass::RenderTargetOrDepthStencil) ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT };
+        CD3DX12_HEAP_DESC const heapDesc{ heapSize, heapType, heapAlignment, s_classHeapFlags[resourceClass] };
+        winrt::check_hresult(m_pD3D12Device->CreateHeap(&heapDesc, __uuidof(pD3D12Heaps[block]), pD3D12Heaps[block].put_void()));
+        pD3D12Heaps[block]->SetName(L"PlacedResourceAllocator");
+        return pD3D12Heaps[block].get();
+    }
+
+    uint32_t PlacedResourceAllocator::PoolIndex(D3D12_HEAP_TYPE heapType, PlacedResourceClass resourceClass)
+    {
+        if (heapType < D3D12_HEAP_TYPE_DEFAULT || heapType > D3D12_HEAP_TYPE_READBACK) winrt::throw_hresult(E_INVALIDARG);
+        return (heapType - D3D12_HEAP_TYPE_DEFAULT) * static_cast<uint32_t>(PlacedResourceClass::Count) + static_cast<uint32_t>(resourceClass);
+    }
+
+    void PlacedResourceAllocator::Reclaim(uint64_t completedFenceValue)
+    {
+        for (Pool& pool : m_pools)
+        {
+            pool.allocator.Reclaim(completedFenceValue, [&pool](uint32_t block) { if (block < pool.pD3D12Heaps.size()) pool.pD3D12Heaps[block] = nullptr; });
+        }
+    }
+
+    HeapAllocatorStatistics PlacedResourceAllocator::Statistics() const
+    {
+        HeapAllocatorStatistics statistics;
+        for (Pool const& pool : m_pools)
+        {
+            HeapAllocatorStatistics const poolStatistics{ pool.allocator.Statistics() };
+            statistics.allocations += poolStatistics.allocations;
+            statistics.blocksCreated += poolStatistics.blocksCreated;
+            statistics.blocksReleased += poolStatistics.blocksReleased;
+            statistics.frees += poolStatistics.frees;
+            statistics.allocatedBytes += poolStatistics.allocatedBytes;
+            statistics.blocks += poolStatistics.blocks;
+            statistics.freeBytes += poolStatistics.freeBytes;
+            statistics.largestFreeBytes = std::max(statistics.largestFreeBytes, poolStatistics.largestFreeBytes);
+            statistics.largestFreeBytesPerBlock += poolStatistics.largestFreeBytesPerBlock;
+            statistics.liveAllocations += poolStatistics.liveAllocations;
+            statistics.reservedBytes += poolStatistics.reservedBytes;
+        }
+        return statistics;
+    }
+}
@@ -0,0 +1,94 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+namespace DX
+{
+    // What a heap may hold. Not every device can mix these in one heap (resource heap tier 1),
+    // so each has heaps of its own.
+    enum class PlacedResourceClass : uint32_t
+    {
+        Buffer,
+        Texture,
+        RenderTargetOrDepthStencil,
+        Count
+    };
+
+    // A resource placed in one of PlacedResourceAllocator's heaps.
+    struct PlacedResource final
+    {
+        winrt::com_ptr<::ID3D12Resource> pResource{ nullptr };
+        HeapAllocation allocation;
+        uint32_t pool{ 0 };
+    };
+
+    // A range of one of PlacedResourceAllocator's heaps, that the caller places resources in
+    // itself (several at the same offset, say, as FrameGraph aliases transients).
+    struct PlacedHeapRange final
+    {
+        ::ID3D12Heap* pD3D12Heap{ nullptr }; // Kept alive by the allocator until the range is freed.
+        HeapAllocation allocation;
+        uint32_t pool{ 0 };
+    };
+
+    // Creates resources placed in large ID3D12Heaps, rather than one committed resource (and
+    // so one heap, with its own allocation in the kernel) each. There's a pool of heaps (see
+    // HeapAllocator) for each heap type and resource class, and a resource's range is reused
+    // once the fence passes the value that it was freed at.
+    class PlacedResourceAllocator final
+    {
+        static constexpr uint32_t s_heapTypeCount{ 3 }; // D3D12_HEAP_TYPE_DEFAULT, _UPLOAD, and _READBACK.
+        static constexpr uint32_t s_poolCount{ s_heapTypeCount * static_cast<uint32_t>(PlacedResourceClass::Count) };
+
+        struct Pool final
+        {
+            HeapAllocator allocator;
+            std::vector<winrt::com_ptr<::ID3D12Heap>> pD3D12Heaps; // Indexed by block.
+        };
+
+        // data members
+
+        winrt::com_ptr<::ID3D12Device> m_pD3D12Device{ nullptr };
+        std::array<Pool, s_poolCount> m_pools;
+
+        // member functions
+
+        static PlacedResourceClass ClassOf(D3D12_RESOURCE_DESC const& resourceDesc);
+        ::ID3D12Heap* Heap(uint32_t pool, uint32_t block);
+        static uint32_t PoolIndex(D3D12_HEAP_TYPE heapType, PlacedResourceClass resourceClass);
+
+    public:
+        PlacedResourceAllocator(winrt::com_ptr<::ID3D12Device> const& pD3D12Device, UINT64 blockSize);
+
+        // member functions
+
+        // The range starts at a multiple of 64KB (or, for render targets and depth stencils, 4MB, as multisampled ones need).
+        PlacedHeapRange AllocateRange(D3D12_HEAP_TYPE heapType, PlacedResourceClass resourceClass, UINT64 sizeInBytes);
+
+        PlacedResource CreateResource(D3D12_HEAP_TYPE heapType, D3D12_RESOURCE_DESC const& resourceDesc, D3D12_RESOURCE_STATES initialState, D3D12_CLEAR_VALUE const* pOptimizedClearValue = nullptr);
+
+        // Frees the resource's range, to be reused once the fence reaches `fenceValue`. The
+        // resource itself must be released by then (see DeviceResources::FreePlacedResource).
+        void Free(PlacedResource const& resource, uint64_t fenceValue);
+        void Free(PlacedHeapRange const& range, uint64_t fenceValue); // The resources placed in it must be released by then.
+
+        // Reuses the ranges freed at fence values up to `completedFenceValue`, and releases the heaps that are no longer needed.
+        void Reclaim(uint64_t completedFenceValue);
+
+        // accessors
+
+        HeapAllocatorStatistics Statistics(D3D12_HEAP_TYPE heapType, PlacedResourceClass resourceClass) const { return m_pools[PoolIndex(heapType, resourceClass)].allocator.Statistics(); }
+
+        // Summed over every pool (except largestFreeBytes, which is the largest in any one heap).
+        HeapAllocatorStatistics Statistics() const;
+    };
+}
@@ -0,0 +1,125 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "SpscRing.h"
+
+namespace DX
+{
+    // The window's bounds, in DIPs (the same values as the window's Bounds() Rect).
+    struct RenderBounds final
+    {
+        float x{ 0.f };
+        float y{ 0.f };
+        float width{ 0.f };
+        float height{ 0.f };
+    };
+
+    enum class RenderCommandType : uint32_t
+    {
+        Animate, // Start animating.
+        CameraOrbit, // Orbit the camera by (yawRadians, pitchRadians).
+        Invalidate, // The content has changed; render a frame.
+        VisibilityChanged, // The window has been shown or hidden (visible).
+    };
+
+    struct RenderCommand final
+    {
+        RenderCommandType type{ RenderCommandType::Animate };
+        float yawRadians{ 0.f };
+        float pitchRadians{ 0.f };
+        bool visible{ true };
+    };
+
+    // Window changes that have happened since the consumer last took them, merged.
+    struct RenderWindowChange final
+    {
+        RenderBounds bounds; // The latest bounds.
+        bool dpiChanged{ false };
+        bool sizeChanged{ false };
+    };
+
+    // Carries commands from the UI thread (the producer) to the render thread (the consumer)
+    // without locks. Commands go through an SpscRing, in order. Size and DPI changes don't take
+    // ring slots: each overwrites one latest-bounds slot (guarded by a sequence count) and sets
+    // a pending bit, so however many arrive between two frames, the render thread sees them as
+    // one change with the final bounds; and they can't be lost to a full ring.
+    class RenderCommandChannel final
+    {
+        static constexpr uint32_t s_dpiChangedBit{ 1 };
+        static constexpr uint32_t s_sizeChangedBit{ 2 };
+
+        // data members
+
+        std::array<std::atomic<float>, 4> m_bounds{}; // x, y, width, height.
+        std::atomic<uint32_t> m_boundsSequence{ 0 }; // Odd while the producer is writing m_bounds.
+        SpscRing<RenderCommand, 64> m_commands;
+        std::atomic<uint32_t> m_pendingWindowChanges{ 0 };
+
+        void PostWindowChange(RenderBounds const& bounds, uint32_t changeBit)
+        {
+            uint32_t const sequence{ m_boundsSequence.load(std::memory_order_relaxed) };
+            m_boundsSequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_bounds[0].store(bounds.x, std::memory_order_relaxed);
+            m_bounds[1].store(bounds.y, std::memory_order_relaxed);
+            m_bounds[2].store(bounds.width, std::memory_order_relaxed);
+            m_bounds[3].store(bounds.height, std::memory_order_relaxed);
+            m_boundsSequence.store(sequence + 2, std::memory_order_release);
+            m_pendingWindowChanges.fetch_or(changeBit, std::memory_order_release);
+        }
+
+        RenderBounds ReadBounds() const
+        {
+            for (;;)
+            {
+                uint32_t const sequence{ m_boundsSequence.load(std::memory_order_acquire) };
+                RenderBounds bounds{
+                    m_bounds[0].load(std::memory_order_relaxed),
+                    m_bounds[1].load(std::memory_order_relaxed),
+                    m_bounds[2].load(std::memory_order_relaxed),
+                    m_bounds[3].load(std::memory_order_relaxed) };
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if ((sequence & 1) == 0 && sequence == m_boundsSequence.load(std::memory_order_relaxed)) return bounds;
+            }
+        }
+
+    public:
+        // Producer member functions
+
+        void PostDpiChanged(RenderBounds const& bounds) { PostWindowChange(bounds, s_dpiChangedBit); }
+        void PostSizeChanged(RenderBounds const& bounds) { PostWindowChange(bounds, s_sizeChangedBit); }
+
+        // Returns `false` if the render thread is so far behind that the ring is full; the
+        // command is then dropped.
+        bool Post(RenderCommand const& command) { return m_commands.TryPush(command); }
+
+        // Consumer member functions
+
+        // Call once per frame, before taking the commands.
+        bool TakeWindowChange(RenderWindowChange& windowChange)
+        {
+            uint32_t const changes{ m_pendingWindowChanges.exchange(0, std::memory_order_acquire) };
+            if (changes == 0) return false;
+            windowChange.bounds = ReadBounds();
+            windowChange.dpiChanged = (changes & s_dpiChangedBit) != 0;
+            windowChange.sizeChanged = (changes & s_sizeChangedBit) != 0;
+            return true;
+        }
+
+        bool TryTake(RenderCommand& command) { return m_commands.TryPop(command); }
+    };
+}
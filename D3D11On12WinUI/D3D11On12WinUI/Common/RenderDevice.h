@@ -0,0 +1,131 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// This header is deliberately free of Windows types, so that it (and the headless backend
+// that implements it) can be compiled on any platform with a C++17 compiler.
+
+#include <cstdint>
+#include <memory>
+
+namespace DX
+{
+    // The outcome of presenting a frame.
+    enum class RenderPresentResult
+    {
+        Ok,
+        Occluded,
+        DeviceLost
+    };
+
+    enum class RenderHeapType
+    {
+        Default, // GPU-local memory.
+        Upload // CPU-writable memory that the GPU reads.
+    };
+
+    enum class RenderIndexFormat
+    {
+        UInt16,
+        UInt32
+    };
+
+    // A presented frame that has reached the screen.
+    struct RenderDisplayedFrame
+    {
+        uint64_t presentCount{ 0 }; // Which present (counting from 1) this was.
+        uint64_t displayNanoseconds{ 0 }; // When it was displayed, on the backend's clock.
+    };
+
+    // A buffer or texture.
+    class IRenderResource
+    {
+    public:
+        virtual ~IRenderResource() = default;
+
+        virtual uint64_t SizeInBytes() const = 0;
+
+        // Returns `nullptr` for resources that can't be mapped.
+        virtual void* Map() = 0;
+        virtual void Unmap() = 0;
+    };
+
+    // A monotonically increasing value that the GPU timeline signals, and that the CPU can wait on.
+    class IRenderFence
+    {
+    public:
+        virtual ~IRenderFence() = default;
+
+        virtual uint64_t CompletedValue() const = 0;
+
+        // Blocks the calling thread until the fence reaches (at least) `value`.
+        virtual void WaitForValue(uint64_t value) = 0;
+    };
+
+    // A recorded list of GPU commands. Recording is backend-specific; the queue only needs to
+    // know how to submit the list.
+    class IRenderCommandList
+    {
+    public:
+        virtual ~IRenderCommandList() = default;
+
+        virtual void Close() = 0;
+    };
+
+    class IRenderCommandQueue
+    {
+    public:
+        virtual ~IRenderCommandQueue() = default;
+
+        virtual void ExecuteCommandList(IRenderCommandList& commandList) = 0;
+
+        // Enqueues a GPU-side signal of `fence` to `value`, once all previously submitted work has completed.
+        virtual void Signal(IRenderFence& fence, uint64_t value) = 0;
+
+        // Enqueues a GPU-side wait; subsequently submitted work doesn't start until `fence` reaches `value`.
+        virtual void Wait(IRenderFence& fence, uint64_t value) = 0;
+    };
+
+    class IRenderSwapChain
+    {
+    public:
+        virtual ~IRenderSwapChain() = default;
+
+        virtual uint32_t BufferCount() const = 0;
+        virtual uint32_t CurrentBackBufferIndex() const = 0;
+        virtual RenderPresentResult Present(uint32_t syncInterval) = 0;
+
+        // The number of presents so far; so, the present count of the most recent frame.
+        virtual uint64_t PresentCount() const = 0;
+
+        // Returns `false` if no frame is known to have been displayed yet.
+        virtual bool TryGetLastDisplayedFrame(RenderDisplayedFrame& frame) = 0;
+
+        // Blocks until the maximum frame latency allows another frame to be queued, so that the
+        // next Present won't block. Call this before sampling input and recording the frame.
+        virtual void WaitForFrameLatency() = 0;
+    };
+
+    // Creates the objects above. Only the headless backend creates everything through this
+    // interface; the Direct3D 12 backend wraps objects that DeviceResources creates itself.
+    class IRenderDevice
+    {
+    public:
+        virtual ~IRenderDevice() = default;
+
+        virtual std::unique_ptr<IRenderResource> CreateBuffer(RenderHeapType heapType, uint64_t sizeInBytes) = 0;
+        virtual std::unique_ptr<IRenderResource> CreateTexture2D(uint32_t width, uint32_t height, uint32_t bytesPerPixel) = 0;
+        virtual std::unique_ptr<IRenderCommandQueue> CreateCommandQueue() = 0;
+        virtual std::unique_ptr<IRenderFence> CreateFence(uint64_t initialValue) = 0;
+        virtual std::unique_ptr<IRenderSwapChain> CreateSwapChain(IRenderCommandQueue& commandQueue, uint32_t width, uint32_t height, uint32_t bufferCount) = 0;
+    };
+}
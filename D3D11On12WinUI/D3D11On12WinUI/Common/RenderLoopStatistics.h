@@ -0,0 +1,83 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace DX
+{
+    // Counts the frames that the render loop renders and the ones it skips (while nothing has
+    // changed, or while the window can't be seen), and estimates the CPU and GPU time that the
+    // skipped frames would have cost. Only the render thread records; the counters can be read
+    // from any thread.
+    class RenderLoopStatistics final
+    {
+        // data members
+
+        double m_averageCpuFrameNanoseconds{ 0. };
+        double m_averageGpuFrameNanoseconds{ 0. };
+        std::atomic<uint64_t> m_cpuNanosecondsSaved{ 0 };
+        std::atomic<uint64_t> m_framesRendered{ 0 };
+        std::atomic<uint64_t> m_framesSkipped{ 0 };
+        std::atomic<uint64_t> m_gpuNanosecondsSaved{ 0 };
+        uint64_t m_idleRemainderNanoseconds{ 0 }; // Idle time that's less than a refresh period, carried over.
+
+        // Follows recent frames, but isn't thrown by one slow one.
+        static void Average(double& average, uint64_t nanoseconds, bool first)
+        {
+            average = first ? static_cast<double>(nanoseconds) : average + (nanoseconds - average) / 16.;
+        }
+
+    public:
+        // member functions
+
+        // A frame was rendered, taking `cpuNanoseconds` of the render thread's time.
+        void FrameRendered(uint64_t cpuNanoseconds)
+        {
+            Average(m_averageCpuFrameNanoseconds, cpuNanoseconds, m_framesRendered.load(std::memory_order_relaxed) == 0);
+            m_framesRendered.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // The GPU time of a rendered frame.
+        void GpuFrameMeasured(uint64_t gpuNanoseconds)
+        {
+            Average(m_averageGpuFrameNanoseconds, gpuNanoseconds, m_averageGpuFrameNanoseconds == 0.);
+        }
+
+        // The render loop slept for `nanoseconds` instead of rendering. Each refresh period of
+        // that counts as a skipped frame, which would have cost an average frame's CPU and GPU time.
+        void Idled(uint64_t nanoseconds, uint64_t refreshPeriodNanoseconds)
+        {
+            if (refreshPeriodNanoseconds == 0) return;
+            m_idleRemainderNanoseconds += nanoseconds;
+            uint64_t const framesSkipped{ m_idleRemainderNanoseconds / refreshPeriodNanoseconds };
+            m_idleRemainderNanoseconds %= refreshPeriodNanoseconds;
+            if (framesSkipped == 0) return;
+
+            m_framesSkipped.fetch_add(framesSkipped, std::memory_order_relaxed);
+            m_cpuNanosecondsSaved.fetch_add(static_cast<uint64_t>(framesSkipped * m_averageCpuFrameNanoseconds), std::memory_order_relaxed);
+            m_gpuNanosecondsSaved.fetch_add(static_cast<uint64_t>(framesSkipped * m_averageGpuFrameNanoseconds), std::memory_order_relaxed);
+        }
+
+        // accessors
+
+        // Render thread only.
+        double AverageCpuFrameNanoseconds() const { return m_averageCpuFrameNanoseconds; }
+        double AverageGpuFrameNanoseconds() const { return m_averageGpuFrameNanoseconds; }
+
+        uint64_t CpuNanosecondsSaved() const { return m_cpuNanosecondsSaved.load(std::memory_order_relaxed); }
+        uint64_t FramesRendered() const { return m_framesRendered.load(std::memory_order_relaxed); }
+        uint64_t FramesSkipped() const { return m_framesSkipped.load(std::memory_order_relaxed); }
+        uint64_t GpuNanosecondsSaved() const { return m_gpuNanosecondsSaved.load(std::memory_order_relaxed); }
+    };
+}
@@ -0,0 +1,426 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Resource state transitions, declared rather than hand-written. While a command list is
+// recorded, its CommandListResourceStates is told the state that each resource must be in
+// before the next piece of work (Transition), and issues only the barriers that those states
+// actually require: it skips a transition to the state a resource is already in, merges
+// transitions that nothing used the state in between (A to B to C becomes A to C), and hands
+// the rest to the backend as one batch, so as one ResourceBarrier call. Where a caller knows
+// early which state a resource will need, BeginTransition starts a split barrier, which the
+// GPU can overlap with the work in between.
+//
+// The state that a resource is in when a list starts depends on the lists submitted before it,
+// which needn't have been recorded before it; so a list's first use of each resource is left
+// open, and ResourceStateTracker resolves it at submission, against the state that the lists
+// submitted so far left it in, into fix-up barriers to execute just before the list. The
+// tracker follows Direct3D 12's implicit promotion and decay rules, so buffers (and textures
+// read from the COMMON state) need no barriers at all.
+//
+// A resource is tracked as a whole (not per subresource). The Resource type is the backend's
+// handle (ID3D12Resource*, say); nothing here dereferences it.
+
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace DX
+{
+    // The same bits as D3D12_RESOURCE_STATES (which the Direct3D 12 wrapper static_asserts).
+    enum class ResourceStates : uint32_t
+    {
+        Common = 0,
+        Present = 0,
+        VertexAndConstantBuffer = 0x1,
+        IndexBuffer = 0x2,
+        RenderTarget = 0x4,
+        UnorderedAccess = 0x8,
+        DepthWrite = 0x10,
+        DepthRead = 0x20,
+        NonPixelShaderResource = 0x40,
+        PixelShaderResource = 0x80,
+        IndirectArgument = 0x200,
+        CopyDest = 0x400,
+        CopySource = 0x800,
+        ResolveDest = 0x1000,
+        ResolveSource = 0x2000
+    };
+
+    constexpr ResourceStates operator|(ResourceStates a, ResourceStates b) { return static_cast<ResourceStates>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b)); }
+    constexpr ResourceStates operator&(ResourceStates a, ResourceStates b) { return static_cast<ResourceStates>(static_cast<uint32_t>(a) & static_cast<uint32_t>(b)); }
+
+    // Read-only states can be combined, and a resource in a combination of them can be used in any one.
+    constexpr bool IsReadOnlyState(ResourceStates states)
+    {
+        constexpr ResourceStates readOnly{ ResourceStates::VertexAndConstantBuffer | ResourceStates::IndexBuffer | ResourceStates::DepthRead |
+            ResourceStates::NonPixelShaderResource | ResourceStates::PixelShaderResource | ResourceStates::IndirectArgument |
+            ResourceStates::CopySource | ResourceStates::ResolveSource };
+        return states != ResourceStates::Common && (states & readOnly) == states;
+    }
+
+    enum class ResourceKind
+    {
+        Buffer, // Promoted from COMMON to any state on first use in a command list; decays back to COMMON after each submission.
+        Texture // Promoted from COMMON only to shader-resource and copy states; decays only from a read-only state that it was promoted to.
+    };
+
+    constexpr bool IsImplicitlyPromotable(ResourceKind kind, ResourceStates state)
+    {
+        if (kind == ResourceKind::Buffer) return true;
+        constexpr ResourceStates promotable{ ResourceStates::NonPixelShaderResource | ResourceStates::PixelShaderResource | ResourceStates::CopyDest | ResourceStates::CopySource };
+        return state != ResourceStates::Common && (state & promotable) == state;
+    }
+
+    enum class ResourceBarrierSplit : uint32_t
+    {
+        None,
+        BeginOnly, // The resource is unusable until the matching EndOnly barrier.
+        EndOnly
+    };
+
+    template <typename Resource>
+    struct ResourceBarrier final
+    {
+        Resource resource{};
+        ResourceStates before{ ResourceStates::Common };
+        ResourceStates after{ ResourceStates::Common };
+        ResourceBarrierSplit split{ ResourceBarrierSplit::None };
+    };
+
+    struct ResourceBarrierStatistics final
+    {
+        uint64_t transitions{ 0 }; // Transition and BeginTransition calls.
+        uint64_t deferred{ 0 }; // Of those, first uses in a list, left for ResourceStateTracker::Resolve.
+        uint64_t redundant{ 0 }; // Of those, the ones that needed no barrier, the resource being in the state already.
+        uint64_t merged{ 0 }; // Barriers folded into (or cancelled by) an earlier one in the same batch.
+        uint64_t barriers{ 0 }; // Barriers issued in recorded lists (split halves count one each).
+        uint64_t splitBarriers{ 0 }; // Of those, the BeginOnly halves.
+        uint64_t batches{ 0 }; // ResourceBarrier calls.
+    };
+
+    // The states that one command list requires, and the barriers that it issues, as it's recorded.
+    // Not thread-safe; each list that's recorded at once needs its own.
+    template <typename Resource>
+    class CommandListResourceStates final
+    {
+        static constexpr uint32_t s_noBarrier{ UINT32_MAX };
+
+        struct Entry final
+        {
+            Resource resource{};
+            bool hasFirst{ false }; // Whether the list has required a state of the resource yet.
+            bool isFirstProvisional{ false }; // No work has used the first state yet, so a later Transition replaces it.
+            ResourceStates first{ ResourceStates::Common }; // Required at the list's start; resolved at submission.
+            ResourceStates current{ ResourceStates::Common }; // After the barriers so far (for an open split, its before state).
+            ResourceStates splitTarget{ ResourceStates::Common };
+            bool splitOpen{ false };
+            bool transitioned{ false }; // By a barrier that the list issued (so not left in the state it was promoted to).
+            uint32_t batchIndex{ s_noBarrier }; // Of this resource's last barrier, while it's in the unflushed batch.
+        };
+
+        // data members
+
+        std::vector<ResourceBarrier<Resource>> m_batch;
+        bool m_closed{ false };
+        std::vector<Entry> m_entries; // In order of first use.
+        std::unordered_map<Resource, uint32_t> m_indices; // Into m_entries.
+        ResourceBarrierStatistics m_statistics;
+
+        Entry& Use(Resource resource)
+        {
+            if (m_closed) throw std::logic_error{ "A closed command list's resource states can't change until it's Reset." };
+            ++m_statistics.transitions;
+            auto [it, isNew] { m_indices.try_emplace(resource, static_cast<uint32_t>(m_entries.size())) };
+            if (isNew) m_entries.push_back(Entry{ resource });
+            return m_entries[it->second];
+        }
+
+        void Append(Entry& entry, ResourceStates before, ResourceStates after, ResourceBarrierSplit split)
+        {
+            entry.batchIndex = static_cast<uint32_t>(m_batch.size());
+            m_batch.push_back({ entry.resource, before, after, split });
+        }
+
+        // Moves `entry` to `after`, ending its open split (if any) on the way.
+        void TransitionTo(Entry& entry, ResourceStates after)
+        {
+            if (entry.splitOpen)
+            {
+                entry.splitOpen = false;
+                ResourceBarrier<Resource>* pBegin{ entry.batchIndex != s_noBarrier ? &m_batch[entry.batchIndex] : nullptr };
+                if (pBegin && pBegin->split == ResourceBarrierSplit::BeginOnly)
+                {
+                    // Nothing was recorded since the split began, so there's nothing for it to
+                    // overlap; make it a whole barrier, to wherever the resource is going now.
+                    ++m_statistics.merged;
+                    pBegin->split = ResourceBarrierSplit::None;
+                    pBegin->after = after;
+                    entry.current = after;
+                    if (pBegin->before == pBegin->after)
+                    {
+                        pBegin->resource = Resource{};
+                        entry.batchIndex = s_noBarrier;
+                    }
+                    return;
+                }
+                Append(entry, entry.current, entry.splitTarget, ResourceBarrierSplit::EndOnly);
+                entry.current = entry.splitTarget;
+                if (Satisfies(entry.current, after)) return;
+            }
+
+            ResourceBarrier<Resource>* pLast{ entry.batchIndex != s_noBarrier ? &m_batch[entry.batchIndex] : nullptr };
+            if (pLast && pLast->split == ResourceBarrierSplit::None)
+            {
+                // The state that the last barrier moved to was never used; go straight on.
+                ++m_statistics.merged;
+                pLast->after = after;
+                entry.current = after;
+                if (pLast->before == pLast->after)
+                {
+                    pLast->resource = Resource{};
+                    entry.batchIndex = s_noBarrier;
+                }
+                return;
+            }
+            Append(entry, entry.current, after, ResourceBarrierSplit::None);
+            entry.current = after;
+        }
+
+        static bool Satisfies(ResourceStates current, ResourceStates required)
+        {
+            return current == required || (IsReadOnlyState(required) && IsReadOnlyState(current) && (current & required) == required);
+        }
+
+    public:
+        // member functions
+
+        // Ends the splits still open, and issues what's batched. Call this once the list's
+        // commands are recorded, before it's closed and submitted.
+        template <typename IssueBarriers>
+        void Close(IssueBarriers&& issueBarriers)
+        {
+            for (Entry& entry : m_entries)
+            {
+                if (entry.splitOpen) TransitionTo(entry, entry.splitTarget);
+            }
+            Flush(issueBarriers);
+            m_closed = true;
+        }
+
+        // Issues the batched barriers, as one call of issueBarriers(ResourceBarrier<Resource> const*, uint32_t count).
+        // Call this before recording the work that needs the states that were asked for.
+        template <typename IssueBarriers>
+        void Flush(IssueBarriers&& issueBarriers)
+        {
+            uint32_t count{ 0 };
+            for (ResourceBarrier<Resource> const& barrier : m_batch)
+            {
+                if (barrier.resource == Resource{}) continue; // Cancelled by a later transition.
+                m_entries[m_indices.find(barrier.resource)->second].transitioned = true;
+                ++m_statistics.barriers;
+                if (barrier.split == ResourceBarrierSplit::BeginOnly) ++m_statistics.splitBarriers;
+                m_batch[count++] = barrier;
+            }
+            if (count > 0)
+            {
+                issueBarriers(static_cast<ResourceBarrier<Resource> const*>(m_batch.data()), count);
+                ++m_statistics.batches;
+            }
+            m_batch.clear();
+            for (Entry& entry : m_entries)
+            {
+                entry.batchIndex = s_noBarrier;
+                entry.isFirstProvisional = false;
+            }
+        }
+
+        // Call when the list is reset, to record it anew.
+        void Reset()
+        {
+            m_batch.clear();
+            m_closed = false;
+            m_entries.clear();
+            m_indices.clear();
+        }
+
+        // Starts moving `resource` to `state`, which the work recorded after the next Flush
+        // mustn't use it in; Transition to `state` (or Close) ends the move. Before any work in
+        // the list has used the resource, what state it's in isn't known (until submission), so
+        // there's no split to begin; the Transition that follows is resolved at submission instead.
+        void BeginTransition(Resource resource, ResourceStates state)
+        {
+            Entry& entry{ Use(resource) };
+            if (!entry.hasFirst || entry.isFirstProvisional)
+            {
+                entry.hasFirst = entry.isFirstProvisional = false;
+                ++m_statistics.deferred;
+                return;
+            }
+            if (entry.splitOpen)
+            {
+                if (entry.splitTarget == state) return void(++m_statistics.redundant);
+                TransitionTo(entry, entry.splitTarget);
+            }
+            if (Satisfies(entry.current, state)) return void(++m_statistics.redundant);
+
+            // A barrier still in the batch, that nothing has used the result of, is folded into the split.
+            ResourceBarrier<Resource>* pLast{ entry.batchIndex != s_noBarrier ? &m_batch[entry.batchIndex] : nullptr };
+            if (pLast && pLast->split == ResourceBarrierSplit::None)
+            {
+                ++m_statistics.merged;
+                pLast->resource = Resource{};
+                entry.current = pLast->before;
+                entry.batchIndex = s_noBarrier;
+                if (entry.current == state) return;
+            }
+            Append(entry, entry.current, state, ResourceBarrierSplit::BeginOnly);
+            entry.splitOpen = true;
+            entry.splitTarget = state;
+        }
+
+        // Requires `resource` to be in `state` for the work recorded after the next Flush.
+        void Transition(Resource resource, ResourceStates state)
+        {
+            Entry& entry{ Use(resource) };
+            if (!entry.hasFirst || entry.isFirstProvisional)
+            {
+                // The first use (or a replacement for one that no work has used): resolved at submission.
+                entry.hasFirst = entry.isFirstProvisional = true;
+                entry.first = entry.current = state;
+                ++m_statistics.deferred;
+                return;
+            }
+            if (!entry.splitOpen && Satisfies(entry.current, state))
+            {
+                ++m_statistics.redundant;
+                return;
+            }
+            TransitionTo(entry, state);
+        }
+
+        // accessors
+
+        bool IsClosed() const { return m_closed; }
+
+        // Cumulative, across Resets.
+        ResourceBarrierStatistics const& Statistics() const { return m_statistics; }
+
+        // For ResourceStateTracker::Resolve: calls visit(resource, firstState, finalState, transitioned) for each resource used.
+        template <typename Visit>
+        void VisitResources(Visit&& visit) const
+        {
+            for (Entry const& entry : m_entries)
+            {
+                if (entry.hasFirst) visit(entry.resource, entry.first, entry.current, entry.transitioned);
+            }
+        }
+    };
+
+    // The state that each resource is in on the queue, as of the lists submitted so far.
+    // Thread-safe; resources can be registered from any thread.
+    template <typename Resource>
+    class ResourceStateTracker final
+    {
+        struct Entry final
+        {
+            ResourceStates state{ ResourceStates::Common };
+            ResourceKind kind{ ResourceKind::Buffer };
+        };
+
+        // data members
+
+        uint64_t m_fixUpBarriers{ 0 };
+        mutable std::mutex m_mutex;
+        std::unordered_map<Resource, Entry> m_resources;
+
+    public:
+        // member functions
+
+        // Records a state change made other than through a tracked list (by the 11On12 device's
+        // ReleaseWrappedResources, say).
+        void Assume(Resource resource, ResourceStates state)
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            auto it{ m_resources.find(resource) };
+            if (it != m_resources.end()) it->second.state = state;
+        }
+
+        // Starts tracking `resource`, in the state it was created in (or, for a resource created
+        // elsewhere, such as a swap chain's buffer, the state that it's in now).
+        void Register(Resource resource, ResourceStates state, ResourceKind kind)
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            m_resources[resource] = Entry{ state, kind };
+        }
+
+        // Call as `list` is submitted (and in the order in which lists are submitted). Appends to
+        // `fixUps` the barriers that must execute just before the list, to bring its resources
+        // from the states that earlier lists left them in to those that it first uses them in;
+        // and moves them on to the states that it leaves them in.
+        void Resolve(CommandListResourceStates<Resource> const& list, std::vector<ResourceBarrier<Resource>>& fixUps)
+        {
+            if (!list.IsClosed()) throw std::logic_error{ "Close a command list's resource states before resolving them." };
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            list.VisitResources([&](Resource resource, ResourceStates first, ResourceStates last, bool transitioned)
+                {
+                    auto it{ m_resources.find(resource) };
+                    if (it == m_resources.end()) throw std::invalid_argument{ "A command list used a resource that isn't registered with the state tracker." };
+                    Entry& entry{ it->second };
+
+                    bool const promoted{ entry.state == ResourceStates::Common && IsImplicitlyPromotable(entry.kind, first) };
+                    if (entry.state != first && !promoted)
+                    {
+                        fixUps.push_back({ resource, entry.state, first, ResourceBarrierSplit::None });
+                        ++m_fixUpBarriers;
+                    }
+
+                    // Once the list has executed, buffers decay to COMMON, as do textures left in the read-only state they were promoted to.
+                    bool const decays{ entry.kind == ResourceKind::Buffer || (promoted && !transitioned && IsReadOnlyState(last)) };
+                    entry.state = decays ? ResourceStates::Common : last;
+                });
+        }
+
+        void Unregister(Resource resource)
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            m_resources.erase(resource);
+        }
+
+        // accessors
+
+        uint64_t FixUpBarrierCount() const
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            return m_fixUpBarriers;
+        }
+
+        uint32_t ResourceCount() const
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            return static_cast<uint32_t>(m_resources.size());
+        }
+
+        // Returns `false` if the resource isn't registered.
+        bool TryGetState(Resource resource, ResourceStates& state) const
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            auto it{ m_resources.find(resource) };
+            if (it == m_resources.end()) return false;
+            state = it->second.state;
+            return true;
+        }
+    };
+}
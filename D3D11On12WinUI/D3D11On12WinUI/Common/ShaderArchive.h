@@ -0,0 +1,265 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Compiled shaders, packed into one file at build time (by ShaderPacker) rather than shipped as
+// a .cso file each. The file is an index of named blobs, sorted by the hash of their names,
+// followed by the blobs; so it's memory-mapped (see MappedFile) and a shader's bytecode is
+// handed to pipeline creation where it lies, without being read or copied. Each blob has a
+// hash of its contents, which Find checks; and the index has one, which Open checks. Blobs
+// with the same contents (permutations that compile to the same bytecode) are stored once.
+// Portable, so that the packer runs on any build machine.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "StableHasher.h"
+
+namespace DX
+{
+    // A shader's bytecode, where it lies in the archive's memory.
+    struct ShaderBlob final
+    {
+        void const* pData{ nullptr };
+        size_t sizeInBytes{ 0 };
+
+        explicit operator bool() const { return pData != nullptr; }
+    };
+
+    enum class ShaderArchiveOpenResult : uint32_t
+    {
+        Opened,
+        NotAnArchive,
+        OlderFormat,
+        Corrupt // Truncated, or the index doesn't match its hash, or an entry lies outside the file.
+    };
+
+    struct ShaderArchiveFormat final
+    {
+        static constexpr uint32_t s_magic{ 0x52414853 }; // "SHAR"
+        static constexpr uint32_t s_formatVersion{ 1 };
+        static constexpr uint64_t s_blobAlignment{ 16 };
+
+        // The file is this header, the entries, the names (not null-terminated), and then the blobs.
+        struct Header final
+        {
+            uint32_t magic{ s_magic };
+            uint32_t formatVersion{ s_formatVersion };
+            uint32_t entryCount{ 0 };
+            uint32_t namesSize{ 0 };
+            uint64_t fileSize{ 0 };
+            uint64_t indexHash{ 0 }; // Of the entries and the names.
+        };
+
+        struct Entry final
+        {
+            uint64_t nameHash{ 0 };
+            uint64_t contentHash{ 0 };
+            uint64_t dataOffset{ 0 }; // From the start of the file.
+            uint64_t dataSize{ 0 };
+            uint32_t nameOffset{ 0 }; // From the start of the names.
+            uint32_t nameSize{ 0 };
+        };
+
+        static uint64_t HashOf(void const* pData, size_t sizeInBytes)
+        {
+            StableHasher hasher;
+            hasher.Add(pData, sizeInBytes);
+            return hasher.Hash();
+        }
+    };
+
+    // Reads an archive in memory (typically, a mapped file). The memory must outlive the reader,
+    // and the blobs that it finds.
+    class ShaderArchiveReader final
+    {
+        using Format = ShaderArchiveFormat;
+
+        // data members
+
+        uint8_t const* m_pBytes{ nullptr };
+        Format::Entry const* m_pEntries{ nullptr };
+        uint32_t m_entryCount{ 0 };
+        char const* m_pNames{ nullptr };
+
+    public:
+        // member functions
+
+        // Returns the blob named `name`, or an empty blob if there's none, or if its contents
+        // don't match their hash (and `verify` is true).
+        ShaderBlob Find(std::string_view name, bool verify = true) const
+        {
+            uint64_t const nameHash{ Format::HashOf(name.data(), name.size()) };
+            Format::Entry const* pEnd{ m_pEntries + m_entryCount };
+            Format::Entry const* pEntry{ std::lower_bound(m_pEntries, pEnd, nameHash, [](Format::Entry const& entry, uint64_t hash) { return entry.nameHash < hash; }) };
+            for (; pEntry != pEnd && pEntry->nameHash == nameHash; ++pEntry)
+            {
+                if (std::string_view{ m_pNames + pEntry->nameOffset, pEntry->nameSize } != name) continue;
+                ShaderBlob const blob{ m_pBytes + pEntry->dataOffset, static_cast<size_t>(pEntry->dataSize) };
+                if (verify && Format::HashOf(blob.pData, blob.sizeInBytes) != pEntry->contentHash) return {};
+                return blob;
+            }
+            return {};
+        }
+
+        // Validates the header and the index (but not the blobs; Find checks each as it's found).
+        ShaderArchiveOpenResult Open(void const* pData, size_t sizeInBytes)
+        {
+            *this = ShaderArchiveReader{};
+            auto const* pBytes{ static_cast<uint8_t const*>(pData) };
+
+            Format::Header header;
+            if (!pBytes || sizeInBytes < sizeof(header)) return ShaderArchiveOpenResult::NotAnArchive;
+            std::memcpy(&header, pBytes, sizeof(header));
+            if (header.magic != Format::s_magic) return ShaderArchiveOpenResult::NotAnArchive;
+            if (header.formatVersion != Format::s_formatVersion) return ShaderArchiveOpenResult::OlderFormat;
+            if (header.fileSize != sizeInBytes) return ShaderArchiveOpenResult::Corrupt;
+
+            uint64_t const indexSize{ uint64_t{ header.entryCount } * sizeof(Format::Entry) + header.namesSize };
+            if (indexSize > sizeInBytes - sizeof(header)) return ShaderArchiveOpenResult::Corrupt;
+            if (Format::HashOf(pBytes + sizeof(header), static_cast<size_t>(indexSize)) != header.indexHash) return ShaderArchiveOpenResult::Corrupt;
+
+            // The entries are read in place, so they must be aligned (as a mapping, or any allocation, is).
+            auto const* pEntries{ reinterpret_cast<Format::Entry const*>(pBytes + sizeof(header)) };
+            if (reinterpret_cast<uintptr_t>(pEntries) % alignof(Format::Entry) != 0) return ShaderArchiveOpenResult::Corrupt;
+            for (uint32_t entry{ 0 }; entry < header.entryCount; ++entry)
+            {
+                Format::Entry const& e{ pEntries[entry] };
+                if (uint64_t{ e.nameOffset } + e.nameSize > header.namesSize) return ShaderArchiveOpenResult::Corrupt;
+                if (e.dataOffset > sizeInBytes || e.dataSize > sizeInBytes - e.dataOffset) return ShaderArchiveOpenResult::Corrupt;
+                if (entry > 0 && pEntries[entry - 1].nameHash > e.nameHash) return ShaderArchiveOpenResult::Corrupt;
+            }
+
+            m_pBytes = pBytes;
+            m_pEntries = pEntries;
+            m_entryCount = header.entryCount;
+            m_pNames = reinterpret_cast<char const*>(pEntries + header.entryCount);
+            return ShaderArchiveOpenResult::Opened;
+        }
+
+        // accessors
+
+        uint32_t EntryCount() const { return m_entryCount; }
+        std::string_view Name(uint32_t entry) const { return { m_pNames + m_pEntries[entry].nameOffset, m_pEntries[entry].nameSize }; }
+    };
+
+    // Packs named blobs into an archive (see ShaderPacker).
+    class ShaderArchiveWriter final
+    {
+        using Format = ShaderArchiveFormat;
+
+        struct Shader final
+        {
+            std::string name;
+            std::vector<uint8_t> data{};
+        };
+
+        // data members
+
+        std::vector<Shader> m_shaders;
+
+        static uint64_t Aligned(uint64_t offset) { return (offset + Format::s_blobAlignment - 1) & ~(Format::s_blobAlignment - 1); }
+
+    public:
+        // member functions
+
+        // Adds (or replaces) a blob. Returns false if the name was already added.
+        bool Add(std::string_view name, void const* pData, size_t sizeInBytes)
+        {
+            auto const* pBytes{ static_cast<uint8_t const*>(pData) };
+            auto it{ std::find_if(m_shaders.begin(), m_shaders.end(), [&](Shader const& shader) { return shader.name == name; }) };
+            bool const isNew{ it == m_shaders.end() };
+            if (isNew) it = m_shaders.insert(m_shaders.end(), Shader{ std::string{ name } });
+            it->data.assign(pBytes, pBytes + sizeInBytes);
+            return isNew;
+        }
+
+        // Returns the archive, and the number of bytes saved by storing identical blobs once.
+        std::pair<std::vector<uint8_t>, uint64_t> Serialize() const
+        {
+            // The index is sorted by name hash (and then name, for the sake of a stable file).
+            std::vector<Format::Entry> entries(m_shaders.size());
+            std::vector<size_t> order(m_shaders.size());
+            std::string names;
+            for (size_t shader{ 0 }; shader < m_shaders.size(); ++shader)
+            {
+                order[shader] = shader;
+                entries[shader].nameHash = Format::HashOf(m_shaders[shader].name.data(), m_shaders[shader].name.size());
+            }
+            std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return std::tie(entries[a].nameHash, m_shaders[a].name) < std::tie(entries[b].nameHash, m_shaders[b].name); });
+
+            Format::Header header;
+            header.entryCount = static_cast<uint32_t>(m_shaders.size());
+            for (size_t const shader : order) names += m_shaders[shader].name;
+            header.namesSize = static_cast<uint32_t>(names.size());
+            uint64_t dataOffset{ Aligned(sizeof(header) + sizeof(Format::Entry) * entries.size() + names.size()) };
+
+            // Lay out the blobs, storing each distinct one once.
+            std::vector<Format::Entry> sortedEntries;
+            std::vector<std::tuple<uint64_t, uint64_t, size_t>> blobs; // (content hash, offset, shader) of each distinct blob.
+            uint64_t bytesShared{ 0 };
+            uint32_t nameOffset{ 0 };
+            for (size_t const shader : order)
+            {
+                Shader const& s{ m_shaders[shader] };
+                Format::Entry entry{ entries[shader] };
+                entry.contentHash = Format::HashOf(s.data.data(), s.data.size());
+                entry.dataSize = s.data.size();
+                entry.nameOffset = nameOffset;
+                entry.nameSize = static_cast<uint32_t>(s.name.size());
+                nameOffset += entry.nameSize;
+
+                auto same{ std::find_if(blobs.begin(), blobs.end(), [&](auto const& blob)
+                    {
+                        Shader const& other{ m_shaders[std::get<2>(blob)] };
+                        return std::get<0>(blob) == entry.contentHash && other.data == s.data;
+                    }) };
+                if (same != blobs.end())
+                {
+                    entry.dataOffset = std::get<1>(*same);
+                    bytesShared += s.data.size();
+                }
+                else
+                {
+                    entry.dataOffset = dataOffset;
+                    blobs.emplace_back(entry.contentHash, dataOffset, shader);
+                    dataOffset = Aligned(dataOffset + s.data.size());
+                }
+                sortedEntries.push_back(entry);
+            }
+
+            std::vector<uint8_t> bytes(dataOffset, 0);
+            header.fileSize = bytes.size();
+            uint8_t* pIndex{ bytes.data() + sizeof(header) };
+            if (!sortedEntries.empty()) std::memcpy(pIndex, sortedEntries.data(), sizeof(Format::Entry) * sortedEntries.size());
+            if (!names.empty()) std::memcpy(pIndex + sizeof(Format::Entry) * sortedEntries.size(), names.data(), names.size());
+            header.indexHash = Format::HashOf(pIndex, sizeof(Format::Entry) * sortedEntries.size() + names.size());
+            std::memcpy(bytes.data(), &header, sizeof(header));
+            for (auto const& [contentHash, offset, shader] : blobs)
+            {
+                if (!m_shaders[shader].data.empty()) std::memcpy(bytes.data() + offset, m_shaders[shader].data.data(), m_shaders[shader].data.size());
+            }
+            return { std::move(bytes), bytesShared };
+        }
+
+        // accessors
+
+        size_t ShaderCount() const { return m_shaders.size(); }
+    };
+}
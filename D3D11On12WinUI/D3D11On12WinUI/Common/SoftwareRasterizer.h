@@ -0,0 +1,1086 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// A CPU rasterizer that runs the cube's pipeline: the vertex transform in
+// shader_vx_pos3norm3color3_phong.hlsl (as for the app's single instance, whose instance
+// transform is the identity and whose color is white), CalcPhong in shader_px_pos3norm3color3_phong.hlsl,
+// back-face culling with clockwise front faces, and a D32_FLOAT depth test with
+// D3D12_COMPARISON_FUNC_LESS, into a B8G8R8A8_UNORM target.
+//
+// Draws are queued, and rasterized at Flush. Triangles are set up in parallel (one job per
+// draw), binned into 64x64 tiles, and then each tile is rasterized by one thread, in
+// submission order, a few pixels at a time (8 with AVX2, 4 with SSE2 or NEON, or 1).
+// Coverage uses 4-bit subpixel fixed point and the top-left fill rule, so the output is the
+// same for every SIMD path and every thread count, provided that the compiler doesn't
+// contract multiplies and adds into FMAs (MSVC doesn't with /fp:precise; for GCC and
+// Clang, use -ffp-contract=off, which is the default with -std=c++17).
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "HeadlessRenderDevice.h"
+#include "WorkerPool.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define DX_SOFTWARE_RASTERIZER_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DX_SOFTWARE_RASTERIZER_SSE2
+#endif
+#if defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define DX_SOFTWARE_RASTERIZER_NEON
+#endif
+
+namespace DX
+{
+    // The same layout as VertexPositionNormalColor.
+    struct SoftwareVertex final
+    {
+        float position[3];
+        float normal[3];
+        float color[3];
+    };
+
+    // The same layout as WorldViewProjectionConstantBuffer.
+    struct SoftwareConstants final
+    {
+        float world[16];
+        float view[16];
+        float projection[16];
+    };
+
+    // Where a draw writes. Color is B8G8R8A8_UNORM, one uint32_t per pixel; depth is D32_FLOAT
+    // with the same dimensions and pitch, or null for no depth test.
+    struct SoftwareRenderTarget final
+    {
+        uint32_t* pColor{ nullptr };
+        float* pDepth{ nullptr };
+        uint32_t width{ 0 };
+        uint32_t height{ 0 };
+        uint32_t pitchInPixels{ 0 };
+    };
+
+    struct SoftwareViewport final
+    {
+        float x{ 0.f };
+        float y{ 0.f };
+        float width{ 0.f };
+        float height{ 0.f };
+        float minDepth{ 0.f };
+        float maxDepth{ 1.f };
+    };
+
+    struct SoftwareScissorRect final
+    {
+        uint32_t left{ 0 };
+        uint32_t top{ 0 };
+        uint32_t right{ UINT32_MAX };
+        uint32_t bottom{ UINT32_MAX };
+    };
+
+    enum class SoftwareSimdPath : uint32_t
+    {
+        Scalar,
+        Sse2,
+        Avx2,
+        Neon
+    };
+
+    // Running totals for a software rasterizer.
+    struct SoftwareRasterizerStatistics final
+    {
+        uint64_t draws{ 0 };
+        uint64_t trianglesSubmitted{ 0 };
+        uint64_t trianglesRasterized{ 0 }; // After clipping and culling.
+        uint64_t pixelsShaded{ 0 }; // Pixels that passed the depth test and were written.
+        uint64_t flushes{ 0 };
+    };
+
+    // Lane types for the per-pixel loop. Each one provides the same operations, so that the
+    // loop is written once. Masks are all-ones or all-zeros per lane. Max and Min follow the
+    // SSE rules (a > b ? a : b, and a < b ? a : b) on every path, so that NaNs behave the same.
+    namespace SoftwareRasterizerLanes
+    {
+        struct Scalar final
+        {
+            static constexpr uint32_t Width{ 1 };
+            using Float = float;
+            using Int = int32_t;
+            using Mask = int32_t;
+
+            static Float Splat(float value) { return value; }
+            static Float Ramp(float start) { return start; }
+            static Int SplatInt(int32_t value) { return value; }
+            static Int RampInt(int32_t start, int32_t) { return start; }
+            static Float Add(Float a, Float b) { return a + b; }
+            static Float Sub(Float a, Float b) { return a - b; }
+            static Float Mul(Float a, Float b) { return a * b; }
+            static Float Div(Float a, Float b) { return a / b; }
+            static Float Sqrt(Float a) { return std::sqrt(a); }
+            static Float Max(Float a, Float b) { return a > b ? a : b; }
+            static Float Min(Float a, Float b) { return a < b ? a : b; }
+            static Mask Less(Float a, Float b) { return a < b ? -1 : 0; }
+            static Mask NonNegative(Int a) { return a >= 0 ? -1 : 0; }
+            static Mask And(Mask a, Mask b) { return a & b; }
+            static uint32_t Bits(Mask mask) { return mask ? 1u : 0u; }
+            static Float Select(Float a, Float b, Mask mask) { return mask ? b : a; }
+            static Int SelectInt(Int a, Int b, Mask mask) { return mask ? b : a; }
+            static Int ToInt(Float a) { return static_cast<int32_t>(a); }
+            static Int Or(Int a, Int b) { return a | b; }
+            template <int shift> static Int ShiftLeft(Int a) { return static_cast<int32_t>(static_cast<uint32_t>(a) << shift); }
+            static Float Load(float const* p) { return *p; }
+            static void Store(float* p, Float value) { *p = value; }
+            static Int LoadInt(uint32_t const* p) { return static_cast<int32_t>(*p); }
+            static void StoreInt(uint32_t* p, Int value) { *p = static_cast<uint32_t>(value); }
+        };
+
+#if defined(DX_SOFTWARE_RASTERIZER_SSE2)
+        struct Sse2 final
+        {
+            static constexpr uint32_t Width{ 4 };
+            using Float = __m128;
+            using Int = __m128i;
+            using Mask = __m128;
+
+            static Float Splat(float value) { return _mm_set1_ps(value); }
+            static Float Ramp(float start) { return _mm_add_ps(_mm_set1_ps(start), _mm_setr_ps(0.f, 1.f, 2.f, 3.f)); }
+            static Int SplatInt(int32_t value) { return _mm_set1_epi32(value); }
+            static Int RampInt(int32_t start, int32_t step) { return _mm_add_epi32(_mm_set1_epi32(start), _mm_setr_epi32(0, step, 2 * step, 3 * step)); }
+            static Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+            static Float Sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+            static Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+            static Float Div(Float a, Float b) { return _mm_div_ps(a, b); }
+            static Float Sqrt(Float a) { return _mm_sqrt_ps(a); }
+            static Float Max(Float a, Float b) { return _mm_max_ps(a, b); }
+            static Float Min(Float a, Float b) { return _mm_min_ps(a, b); }
+            static Mask Less(Float a, Float b) { return _mm_cmplt_ps(a, b); }
+            static Mask NonNegative(Int a) { return _mm_castsi128_ps(_mm_cmpgt_epi32(a, _mm_set1_epi32(-1))); }
+            static Mask And(Mask a, Mask b) { return _mm_and_ps(a, b); }
+            static uint32_t Bits(Mask mask) { return static_cast<uint32_t>(_mm_movemask_ps(mask)); }
+            static Float Select(Float a, Float b, Mask mask) { return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a)); }
+            static Int SelectInt(Int a, Int b, Mask mask) { return _mm_castps_si128(Select(_mm_castsi128_ps(a), _mm_castsi128_ps(b), mask)); }
+            static Int ToInt(Float a) { return _mm_cvttps_epi32(a); }
+            static Int Or(Int a, Int b) { return _mm_or_si128(a, b); }
+            template <int shift> static Int ShiftLeft(Int a) { return _mm_slli_epi32(a, shift); }
+            static Float Load(float const* p) { return _mm_loadu_ps(p); }
+            static void Store(float* p, Float value) { _mm_storeu_ps(p, value); }
+            static Int LoadInt(uint32_t const* p) { return _mm_loadu_si128(reinterpret_cast<__m128i const*>(p)); }
+            static void StoreInt(uint32_t* p, Int value) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), value); }
+        };
+#endif
+
+#if defined(DX_SOFTWARE_RASTERIZER_AVX2)
+        struct Avx2 final
+        {
+            static constexpr uint32_t Width{ 8 };
+            using Float = __m256;
+            using Int = __m256i;
+            using Mask = __m256;
+
+            static Float Splat(float value) { return _mm256_set1_ps(value); }
+            static Float Ramp(float start) { return _mm256_add_ps(_mm256_set1_ps(start), _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f)); }
+            static Int SplatInt(int32_t value) { return _mm256_set1_epi32(value); }
+            static Int RampInt(int32_t start, int32_t step)
+            {
+                return _mm256_add_epi32(_mm256_set1_epi32(start), _mm256_setr_epi32(0, step, 2 * step, 3 * step, 4 * step, 5 * step, 6 * step, 7 * step));
+            }
+            static Float Add(Float a, Float b) { return _mm256_add_ps(a, b); }
+            static Float Sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+            static Float Mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+            static Float Div(Float a, Float b) { return _mm256_div_ps(a, b); }
+            static Float Sqrt(Float a) { return _mm256_sqrt_ps(a); }
+            static Float Max(Float a, Float b) { return _mm256_max_ps(a, b); }
+            static Float Min(Float a, Float b) { return _mm256_min_ps(a, b); }
+            static Mask Less(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+            static Mask NonNegative(Int a) { return _mm256_castsi256_ps(_mm256_cmpgt_epi32(a, _mm256_set1_epi32(-1))); }
+            static Mask And(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+            static uint32_t Bits(Mask mask) { return static_cast<uint32_t>(_mm256_movemask_ps(mask)); }
+            static Float Select(Float a, Float b, Mask mask) { return _mm256_blendv_ps(a, b, mask); }
+            static Int SelectInt(Int a, Int b, Mask mask) { return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b), mask)); }
+            static Int ToInt(Float a) { return _mm256_cvttps_epi32(a); }
+            static Int Or(Int a, Int b) { return _mm256_or_si256(a, b); }
+            template <int shift> static Int ShiftLeft(Int a) { return _mm256_slli_epi32(a, shift); }
+            static Float Load(float const* p) { return _mm256_loadu_ps(p); }
+            static void Store(float* p, Float value) { _mm256_storeu_ps(p, value); }
+            static Int LoadInt(uint32_t const* p) { return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p)); }
+            static void StoreInt(uint32_t* p, Int value) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), value); }
+        };
+#endif
+
+#if defined(DX_SOFTWARE_RASTERIZER_NEON)
+        struct Neon final
+        {
+            static constexpr uint32_t Width{ 4 };
+            using Float = float32x4_t;
+            using Int = int32x4_t;
+            using Mask = uint32x4_t;
+
+            static Float Splat(float value) { return vdupq_n_f32(value); }
+            static Float Ramp(float start)
+            {
+                float const lanes[]{ 0.f, 1.f, 2.f, 3.f };
+                return vaddq_f32(vdupq_n_f32(start), vld1q_f32(lanes));
+            }
+            static Int SplatInt(int32_t value) { return vdupq_n_s32(value); }
+            static Int RampInt(int32_t start, int32_t step)
+            {
+                int32_t const lanes[]{ 0, step, 2 * step, 3 * step };
+                return vaddq_s32(vdupq_n_s32(start), vld1q_s32(lanes));
+            }
+            static Float Add(Float a, Float b) { return vaddq_f32(a, b); }
+            static Float Sub(Float a, Float b) { return vsubq_f32(a, b); }
+            static Float Mul(Float a, Float b) { return vmulq_f32(a, b); }
+            static Float Div(Float a, Float b) { return vdivq_f32(a, b); }
+            static Float Sqrt(Float a) { return vsqrtq_f32(a); }
+            static Float Max(Float a, Float b) { return vbslq_f32(vcgtq_f32(a, b), a, b); }
+            static Float Min(Float a, Float b) { return vbslq_f32(vcltq_f32(a, b), a, b); }
+            static Mask Less(Float a, Float b) { return vcltq_f32(a, b); }
+            static Mask NonNegative(Int a) { return vcgeq_s32(a, vdupq_n_s32(0)); }
+            static Mask And(Mask a, Mask b) { return vandq_u32(a, b); }
+            static uint32_t Bits(Mask mask)
+            {
+                uint32_t const lanes[]{ 1, 2, 4, 8 };
+                return vaddvq_u32(vandq_u32(mask, vld1q_u32(lanes)));
+            }
+            static Float Select(Float a, Float b, Mask mask) { return vbslq_f32(mask, b, a); }
+            static Int SelectInt(Int a, Int b, Mask mask) { return vbslq_s32(mask, b, a); }
+            static Int ToInt(Float a) { return vcvtq_s32_f32(a); }
+            static Int Or(Int a, Int b) { return vorrq_s32(a, b); }
+            template <int shift> static Int ShiftLeft(Int a) { return vshlq_n_s32(a, shift); }
+            static Float Load(float const* p) { return vld1q_f32(p); }
+            static void Store(float* p, Float value) { vst1q_f32(p, value); }
+            static Int LoadInt(uint32_t const* p) { return vreinterpretq_s32_u32(vld1q_u32(p)); }
+            static void StoreInt(uint32_t* p, Int value) { vst1q_u32(p, vreinterpretq_u32_s32(value)); }
+        };
+#endif
+    }
+
+    class SoftwareRasterizer final
+    {
+    public:
+        static constexpr uint32_t s_tileSize{ 64 };
+        static constexpr uint32_t s_subpixelBits{ 4 };
+        static constexpr uint32_t s_maxTargetSize{ 8192 }; // Keeps the per-tile edge functions within 32 bits.
+
+    private:
+        static constexpr int32_t s_subpixelScale{ 1 << s_subpixelBits };
+        static constexpr uint32_t s_numPlanes{ 11 }; // Depth, 1/w, and nine attributes (divided by w).
+        static constexpr uint32_t s_numAttributes{ 9 }; // World normal, view normal, color.
+
+        // A vertex after the vertex shader: clip-space position and attributes.
+        struct ShadedVertex final
+        {
+            float position[4];
+            float attributes[s_numAttributes];
+        };
+
+        // Everything the tile loop needs to know about one triangle. The edge functions are
+        // E(x, y) = A * x + B * y + C, in subpixel units; a pixel center is covered when all three
+        // are non-negative (the top-left rule is folded into C). Each plane gives a value at
+        // pixel coordinates (x, y) as c + a * x + b * y.
+        struct TriangleSetup final
+        {
+            int32_t edgeA[3];
+            int32_t edgeB[3];
+            int64_t edgeC[3];
+            int32_t minX, minY, maxX, maxY; // The pixels to consider: [minX, maxX) x [minY, maxY).
+            float planeA[s_numPlanes];
+            float planeB[s_numPlanes];
+            double planeC[s_numPlanes];
+        };
+
+        struct PendingDraw final
+        {
+            SoftwareConstants constants;
+            SoftwareViewport viewport;
+            SoftwareScissorRect scissorRect;
+            uint8_t const* pVertices;
+            uint32_t vertexStrideInBytes;
+            void const* pIndices;
+            RenderIndexFormat indexFormat;
+            uint32_t indexCount;
+            uint32_t instanceCount;
+            int32_t baseVertexLocation;
+        };
+
+        struct alignas(64) ThreadCounters final
+        {
+            uint64_t pixelsShaded{ 0 };
+        };
+
+        // Phong constants, as CalcPhong computes them.
+        struct PhongConstants final
+        {
+            float lightDirection[3];
+            float halfway[3];
+            float ambient[3]{ .5f, .3f, .3f };
+            float directional[3]{ .4f, .4f, .4f };
+
+            PhongConstants()
+            {
+                float const light[]{ 1.f, -1.f, -1.f };
+                float const lightLength{ std::sqrt(light[0] * light[0] + light[1] * light[1] + light[2] * light[2]) };
+                float const half[]{ 0.f + light[0], 0.f + light[1], -1.f + light[2] };
+                float const halfLength{ std::sqrt(half[0] * half[0] + half[1] * half[1] + half[2] * half[2]) };
+                for (uint32_t component{ 0 }; component < 3; ++component)
+                {
+                    lightDirection[component] = light[component] / lightLength;
+                    halfway[component] = -(half[component] / halfLength);
+                }
+            }
+        };
+
+        // data members
+
+        std::vector<std::vector<uint32_t>> m_bins; // Per tile, indices into m_triangles in submission order.
+        std::vector<PendingDraw> m_pendingDraws;
+        std::vector<std::vector<TriangleSetup>> m_perDrawTriangles;
+        PhongConstants m_phong;
+        SoftwareSimdPath m_simdPath{ BestSimdPath() };
+        SoftwareRasterizerStatistics m_statistics;
+        SoftwareRenderTarget m_target;
+        std::vector<ThreadCounters> m_threadCounters;
+        uint32_t m_tilesX{ 0 };
+        uint32_t m_tilesY{ 0 };
+        std::vector<TriangleSetup> m_triangles;
+        WorkerPool m_workerPool;
+
+        // Transforms by a matrix as the shaders do: the constant buffer holds each matrix so that
+        // component j of the result is the dot product of stored row j with the input.
+        static void Transform4(float const matrix[16], float const input[4], float output[4])
+        {
+            for (uint32_t row{ 0 }; row < 4; ++row)
+            {
+                float const* m{ matrix + row * 4 };
+                output[row] = m[0] * input[0] + m[1] * input[1] + m[2] * input[2] + m[3] * input[3];
+            }
+        }
+
+        static void Transform3(float const matrix[16], float const input[3], float output[3])
+        {
+            for (uint32_t row{ 0 }; row < 3; ++row)
+            {
+                float const* m{ matrix + row * 4 };
+                output[row] = m[0] * input[0] + m[1] * input[1] + m[2] * input[2];
+            }
+        }
+
+        static ShadedVertex ShadeVertex(SoftwareConstants const& constants, SoftwareVertex const& vertex)
+        {
+            ShadedVertex shaded{};
+            float const position[]{ vertex.position[0], vertex.position[1], vertex.position[2], 1.f };
+            float world[4], view[4];
+            Transform4(constants.world, position, world);
+            Transform4(constants.view, world, view);
+            Transform4(constants.projection, view, shaded.position);
+
+            Transform3(constants.world, vertex.normal, shaded.attributes);
+            Transform3(constants.view, shaded.attributes, shaded.attributes + 3);
+            std::copy(vertex.color, vertex.color + 3, shaded.attributes + 6);
+            return shaded;
+        }
+
+        // The signed distance of a clip-space position from each of the six clip planes.
+        static float ClipDistance(float const position[4], uint32_t plane)
+        {
+            switch (plane)
+            {
+            case 0: return position[2]; // Near: z >= 0.
+            case 1: return position[3] - position[2]; // Far: z <= w.
+            case 2: return position[3] + position[0];
+            case 3: return position[3] - position[0];
+            case 4: return position[3] + position[1];
+            default: return position[3] - position[1];
+            }
+        }
+
+        static bool IsInside(ShadedVertex const& vertex)
+        {
+            for (uint32_t plane{ 0 }; plane < 6; ++plane)
+            {
+                if (ClipDistance(vertex.position, plane) < 0.f) return false;
+            }
+            return true;
+        }
+
+        // Clips a triangle to the view volume (Sutherland-Hodgman). Returns the number of vertices in the resulting convex polygon.
+        static uint32_t ClipTriangle(ShadedVertex const (&triangle)[3], ShadedVertex (&polygon)[9])
+        {
+            ShadedVertex scratch[9];
+            ShadedVertex* pInput{ polygon };
+            ShadedVertex* pOutput{ scratch };
+            std::copy(std::begin(triangle), std::end(triangle), polygon);
+            uint32_t count{ 3 };
+
+            for (uint32_t plane{ 0 }; plane < 6 && count > 0; ++plane)
+            {
+                uint32_t outputCount{ 0 };
+                for (uint32_t index{ 0 }; index < count; ++index)
+                {
+                    ShadedVertex const& current{ pInput[index] };
+                    ShadedVertex const& next{ pInput[(index + 1) % count] };
+                    float const currentDistance{ ClipDistance(current.position, plane) };
+                    float const nextDistance{ ClipDistance(next.position, plane) };
+
+                    if (currentDistance >= 0.f) pOutput[outputCount++] = current;
+                    if ((currentDistance >= 0.f) != (nextDistance >= 0.f))
+                    {
+                        float const t{ currentDistance / (currentDistance - nextDistance) };
+                        ShadedVertex& clipped{ pOutput[outputCount++] };
+                        for (uint32_t component{ 0 }; component < 4; ++component)
+                        {
+                            clipped.position[component] = current.position[component] + t * (next.position[component] - current.position[component]);
+                        }
+                        for (uint32_t attribute{ 0 }; attribute < s_numAttributes; ++attribute)
+                        {
+                            clipped.attributes[attribute] = current.attributes[attribute] + t * (next.attributes[attribute] - current.attributes[attribute]);
+                        }
+                    }
+                }
+                std::swap(pInput, pOutput);
+                count = outputCount;
+            }
+
+            if (pInput != polygon) std::copy(pInput, pInput + count, polygon);
+            return count;
+        }
+
+        // Projects, snaps, culls, and sets up one (clipped) triangle. Returns `false` if it covers no pixels.
+        static bool SetupTriangle(ShadedVertex const& v0, ShadedVertex const& v1, ShadedVertex const& v2, PendingDraw const& draw, SoftwareRenderTarget const& target, TriangleSetup& setup)
+        {
+            ShadedVertex const* vertices[]{ &v0, &v1, &v2 };
+            int32_t fixedX[3], fixedY[3];
+            double screenX[3], screenY[3], values[3][s_numPlanes];
+
+            SoftwareViewport const& viewport{ draw.viewport };
+            for (uint32_t vertex{ 0 }; vertex < 3; ++vertex)
+            {
+                float const* position{ vertices[vertex]->position };
+                if (!(position[3] > 0.f)) return false;
+                float const oneOverW{ 1.f / position[3] };
+                float const x{ viewport.x + (position[0] * oneOverW + 1.f) * .5f * viewport.width };
+                float const y{ viewport.y + (1.f - position[1] * oneOverW) * .5f * viewport.height };
+                float const z{ viewport.minDepth + position[2] * oneOverW * (viewport.maxDepth - viewport.minDepth) };
+
+                fixedX[vertex] = static_cast<int32_t>(std::lround(std::clamp(x, 0.f, static_cast<float>(s_maxTargetSize)) * s_subpixelScale));
+                fixedY[vertex] = static_cast<int32_t>(std::lround(std::clamp(y, 0.f, static_cast<float>(s_maxTargetSize)) * s_subpixelScale));
+                screenX[vertex] = static_cast<double>(fixedX[vertex]) / s_subpixelScale;
+                screenY[vertex] = static_cast<double>(fixedY[vertex]) / s_subpixelScale;
+
+                values[vertex][0] = z;
+                values[vertex][1] = oneOverW;
+                for (uint32_t attribute{ 0 }; attribute < s_numAttributes; ++attribute)
+                {
+                    values[vertex][2 + attribute] = static_cast<double>(vertices[vertex]->attributes[attribute]) * oneOverW;
+                }
+            }
+
+            // Cull back faces and degenerate triangles. With y pointing down, a positive area means clockwise.
+            int64_t const area{ int64_t{ fixedX[1] - fixedX[0] } * (fixedY[2] - fixedY[0]) - int64_t{ fixedX[2] - fixedX[0] } * (fixedY[1] - fixedY[0]) };
+            if (area <= 0) return false;
+
+            // Pixels whose centers are inside the bounding box, clamped to the viewport, scissor rect, and target.
+            int32_t const half{ s_subpixelScale / 2 };
+            int32_t const minFixedX{ std::min({ fixedX[0], fixedX[1], fixedX[2] }) };
+            int32_t const maxFixedX{ std::max({ fixedX[0], fixedX[1], fixedX[2] }) };
+            int32_t const minFixedY{ std::min({ fixedY[0], fixedY[1], fixedY[2] }) };
+            int32_t const maxFixedY{ std::max({ fixedY[0], fixedY[1], fixedY[2] }) };
+            int64_t const clipLeft{ std::max<int64_t>({ int64_t{ 0 }, int64_t{ draw.scissorRect.left }, static_cast<int64_t>(std::ceil(viewport.x)) }) };
+            int64_t const clipTop{ std::max<int64_t>({ int64_t{ 0 }, int64_t{ draw.scissorRect.top }, static_cast<int64_t>(std::ceil(viewport.y)) }) };
+            int64_t const clipRight{ std::min<int64_t>({ int64_t{ target.width }, int64_t{ draw.scissorRect.right }, static_cast<int64_t>(std::floor(viewport.x + viewport.width)) }) };
+            int64_t const clipBottom{ std::min<int64_t>({ int64_t{ target.height }, int64_t{ draw.scissorRect.bottom }, static_cast<int64_t>(std::floor(viewport.y + viewport.height)) }) };
+
+            setup.minX = static_cast<int32_t>(std::max<int64_t>(clipLeft, (minFixedX - half + s_subpixelScale - 1) / s_subpixelScale));
+            setup.minY = static_cast<int32_t>(std::max<int64_t>(clipTop, (minFixedY - half + s_subpixelScale - 1) / s_subpixelScale));
+            setup.maxX = static_cast<int32_t>(std::min<int64_t>(clipRight, static_cast<int64_t>(std::floor((maxFixedX - half) / static_cast<double>(s_subpixelScale))) + 1));
+            setup.maxY = static_cast<int32_t>(std::min<int64_t>(clipBottom, static_cast<int64_t>(std::floor((maxFixedY - half) / static_cast<double>(s_subpixelScale))) + 1));
+            if (setup.minX >= setup.maxX || setup.minY >= setup.maxY) return false;
+
+            for (uint32_t edge{ 0 }; edge < 3; ++edge)
+            {
+                uint32_t const from{ edge };
+                uint32_t const to{ (edge + 1) % 3 };
+                int32_t const dx{ fixedX[to] - fixedX[from] };
+                int32_t const dy{ fixedY[to] - fixedY[from] };
+                setup.edgeA[edge] = -dy;
+                setup.edgeB[edge] = dx;
+                setup.edgeC[edge] = int64_t{ dy } * fixedX[from] - int64_t{ dx } * fixedY[from];
+
+                // Top-left rule: pixel centers exactly on an edge belong to the triangle only for a top edge
+                // (horizontal, with the triangle below it) or a left edge (which, clockwise, goes up).
+                bool const isTopLeft{ (dy == 0 && dx > 0) || dy < 0 };
+                if (!isTopLeft) setup.edgeC[edge] -= 1;
+            }
+
+            // Plane equations, in pixel units, through the snapped vertex positions.
+            double const determinant{ (screenX[1] - screenX[0]) * (screenY[2] - screenY[0]) - (screenX[2] - screenX[0]) * (screenY[1] - screenY[0]) };
+            for (uint32_t plane{ 0 }; plane < s_numPlanes; ++plane)
+            {
+                double const delta1{ values[1][plane] - values[0][plane] };
+                double const delta2{ values[2][plane] - values[0][plane] };
+                double const a{ (delta1 * (screenY[2] - screenY[0]) - delta2 * (screenY[1] - screenY[0])) / determinant };
+                double const b{ ((screenX[1] - screenX[0]) * delta2 - (screenX[2] - screenX[0]) * delta1) / determinant };
+                setup.planeA[plane] = static_cast<float>(a);
+                setup.planeB[plane] = static_cast<float>(b);
+                setup.planeC[plane] = values[0][plane] - a * screenX[0] - b * screenY[0];
+            }
+            return true;
+        }
+
+        void SetupDraw(PendingDraw const& draw, std::vector<TriangleSetup>& triangles) const
+        {
+            triangles.clear();
+
+            // Shade each referenced vertex once.
+            uint32_t maxIndex{ 0 };
+            auto indexAt = [&](uint32_t position) -> uint32_t
+            {
+                return (draw.indexFormat == RenderIndexFormat::UInt16)
+                    ? static_cast<uint16_t const*>(draw.pIndices)[position]
+                    : static_cast<uint32_t const*>(draw.pIndices)[position];
+            };
+            for (uint32_t position{ 0 }; position < draw.indexCount; ++position)
+            {
+                maxIndex = std::max(maxIndex, indexAt(position));
+            }
+
+            std::vector<ShadedVertex> shadedVertices(static_cast<size_t>(static_cast<int64_t>(maxIndex) + draw.baseVertexLocation + 1));
+            for (size_t vertex{ 0 }; vertex < shadedVertices.size(); ++vertex)
+            {
+                SoftwareVertex input;
+                std::memcpy(&input, draw.pVertices + vertex * draw.vertexStrideInBytes, sizeof(input));
+                shadedVertices[vertex] = ShadeVertex(draw.constants, input);
+            }
+
+            // Every instance uses the same constants, so every instance draws the same triangles.
+            for (uint32_t instance{ 0 }; instance < draw.instanceCount; ++instance)
+            {
+                for (uint32_t position{ 0 }; position + 2 < draw.indexCount; position += 3)
+                {
+                    ShadedVertex const triangle[3]{
+                        shadedVertices[indexAt(position) + draw.baseVertexLocation],
+                        shadedVertices[indexAt(position + 1) + draw.baseVertexLocation],
+                        shadedVertices[indexAt(position + 2) + draw.baseVertexLocation] };
+
+                    TriangleSetup setup;
+                    if (IsInside(triangle[0]) && IsInside(triangle[1]) && IsInside(triangle[2]))
+                    {
+                        if (SetupTriangle(triangle[0], triangle[1], triangle[2], draw, m_target, setup)) triangles.push_back(setup);
+                        continue;
+                    }
+
+                    ShadedVertex polygon[9];
+                    uint32_t const count{ ClipTriangle(triangle, polygon) };
+                    for (uint32_t fan{ 1 }; fan + 1 < count; ++fan)
+                    {
+                        if (SetupTriangle(polygon[0], polygon[fan], polygon[fan + 1], draw, m_target, setup)) triangles.push_back(setup);
+                    }
+                }
+            }
+        }
+
+        template <typename Lanes>
+        uint64_t RasterizeTile(uint32_t tileIndex)
+        {
+            using Float = typename Lanes::Float;
+            using Int = typename Lanes::Int;
+            using Mask = typename Lanes::Mask;
+            constexpr uint32_t width{ Lanes::Width };
+
+            int32_t const tileX{ static_cast<int32_t>((tileIndex % m_tilesX) * s_tileSize) };
+            int32_t const tileY{ static_cast<int32_t>((tileIndex / m_tilesX) * s_tileSize) };
+            int32_t const tileRight{ std::min(tileX + static_cast<int32_t>(s_tileSize), static_cast<int32_t>(m_target.width)) };
+            int32_t const tileBottom{ std::min(tileY + static_cast<int32_t>(s_tileSize), static_cast<int32_t>(m_target.height)) };
+
+            uint64_t pixelsShaded{ 0 };
+            for (uint32_t triangleIndex : m_bins[tileIndex])
+            {
+                TriangleSetup const& setup{ m_triangles[triangleIndex] };
+                int32_t const x0{ std::max(tileX, setup.minX) };
+                int32_t const y0{ std::max(tileY, setup.minY) };
+                int32_t const x1{ std::min(tileRight, setup.maxX) };
+                int32_t const y1{ std::min(tileBottom, setup.maxY) };
+                if (x0 >= x1 || y0 >= y1) continue;
+
+                // Classify each edge against the corner pixel centers. An edge that's entirely outside rejects
+                // the triangle; an edge that's entirely inside needs no per-pixel test. The remaining edges
+                // cross this tile, so their values here fit in 32 bits.
+                int32_t rowEdge[3]{}, stepX[3]{}, stepY[3]{};
+                bool isRejected{ false };
+                for (uint32_t edge{ 0 }; edge < 3 && !isRejected; ++edge)
+                {
+                    auto evaluate = [&](int32_t x, int32_t y)
+                    {
+                        return int64_t{ setup.edgeA[edge] } * (x * s_subpixelScale + s_subpixelScale / 2)
+                            + int64_t{ setup.edgeB[edge] } * (y * s_subpixelScale + s_subpixelScale / 2)
+                            + setup.edgeC[edge];
+                    };
+                    int64_t const corners[]{ evaluate(x0, y0), evaluate(x1 - 1, y0), evaluate(x0, y1 - 1), evaluate(x1 - 1, y1 - 1) };
+                    int64_t const minCorner{ std::min({ corners[0], corners[1], corners[2], corners[3] }) };
+                    int64_t const maxCorner{ std::max({ corners[0], corners[1], corners[2], corners[3] }) };
+                    if (maxCorner < 0)
+                    {
+                        isRejected = true;
+                    }
+                    else if (minCorner < 0)
+                    {
+                        rowEdge[edge] = static_cast<int32_t>(corners[0]);
+                        stepX[edge] = setup.edgeA[edge] * s_subpixelScale;
+                        stepY[edge] = setup.edgeB[edge] * s_subpixelScale;
+                    }
+                }
+                if (isRejected) continue;
+
+                // Plane values at the tile's origin; per pixel, value = origin + a * (x - tileX) + b * (y - tileY), at pixel centers.
+                Float planeOrigin[s_numPlanes], planeA[s_numPlanes], planeB[s_numPlanes];
+                for (uint32_t plane{ 0 }; plane < s_numPlanes; ++plane)
+                {
+                    planeOrigin[plane] = Lanes::Splat(static_cast<float>(setup.planeC[plane] + setup.planeA[plane] * static_cast<double>(tileX) + setup.planeB[plane] * static_cast<double>(tileY)));
+                    planeA[plane] = Lanes::Splat(setup.planeA[plane]);
+                    planeB[plane] = Lanes::Splat(setup.planeB[plane]);
+                }
+
+                // Process aligned groups of lanes within the tile, masking off the pixels outside [x0, x1).
+                int32_t const groupStart{ tileX + ((x0 - tileX) / static_cast<int32_t>(width)) * static_cast<int32_t>(width) };
+                for (int32_t y{ y0 }; y < y1; ++y)
+                {
+                    uint32_t* pColorRow{ m_target.pColor + static_cast<size_t>(y) * m_target.pitchInPixels };
+                    float* pDepthRow{ m_target.pDepth ? m_target.pDepth + static_cast<size_t>(y) * m_target.pitchInPixels : nullptr };
+                    Float const localY{ Lanes::Splat(static_cast<float>(y - tileY) + .5f) };
+
+                    for (int32_t x{ groupStart }; x < x1; x += width)
+                    {
+                        Mask coverage{ Lanes::And(Lanes::NonNegative(Lanes::RampInt(x - x0, 1)), Lanes::NonNegative(Lanes::RampInt(x1 - 1 - x, -1))) };
+                        for (uint32_t edge{ 0 }; edge < 3; ++edge)
+                        {
+                            int32_t const value{ rowEdge[edge] + stepX[edge] * (x - x0) };
+                            coverage = Lanes::And(coverage, Lanes::NonNegative(Lanes::RampInt(value, stepX[edge])));
+                        }
+                        if (Lanes::Bits(coverage) == 0) continue;
+
+                        // A group that runs past the end of the row goes through a scratch copy, so that
+                        // nothing outside this tile is read or written.
+                        bool const isPartial{ x + static_cast<int32_t>(width) > static_cast<int32_t>(m_target.width) };
+                        uint32_t colorScratch[width]{};
+                        float depthScratch[width]{};
+                        uint32_t* pColor{ pColorRow + x };
+                        float* pDepth{ pDepthRow ? pDepthRow + x : nullptr };
+                        if (isPartial)
+                        {
+                            uint32_t const valid{ m_target.width - static_cast<uint32_t>(x) };
+                            std::copy(pColor, pColor + valid, colorScratch);
+                            if (pDepth) std::copy(pDepth, pDepth + valid, depthScratch);
+                            pColor = colorScratch;
+                            pDepth = pDepth ? depthScratch : nullptr;
+                        }
+
+                        Float const localX{ Lanes::Ramp(static_cast<float>(x - tileX) + .5f) };
+                        auto planeValue = [&](uint32_t plane)
+                        {
+                            return Lanes::Add(Lanes::Add(planeOrigin[plane], Lanes::Mul(planeA[plane], localX)), Lanes::Mul(planeB[plane], localY));
+                        };
+
+                        Float const depth{ planeValue(0) };
+                        if (pDepth)
+                        {
+                            Float const oldDepth{ Lanes::Load(pDepth) };
+                            coverage = Lanes::And(coverage, Lanes::Less(depth, oldDepth));
+                            if (Lanes::Bits(coverage) == 0) continue;
+                            Lanes::Store(pDepth, Lanes::Select(oldDepth, depth, coverage));
+                        }
+
+                        // Perspective-correct attributes.
+                        Float const one{ Lanes::Splat(1.f) };
+                        Float const w{ Lanes::Div(one, planeValue(1)) };
+                        Float attributes[s_numAttributes];
+                        for (uint32_t attribute{ 0 }; attribute < s_numAttributes; ++attribute)
+                        {
+                            attributes[attribute] = Lanes::Mul(planeValue(2 + attribute), w);
+                        }
+
+                        // The pixel shader: normalize the normals, square the color, and call CalcPhong.
+                        auto normalize = [&](Float* vector)
+                        {
+                            Float const lengthSquared{ Lanes::Add(Lanes::Add(Lanes::Mul(vector[0], vector[0]), Lanes::Mul(vector[1], vector[1])), Lanes::Mul(vector[2], vector[2])) };
+                            Float const reciprocalLength{ Lanes::Div(one, Lanes::Sqrt(lengthSquared)) };
+                            for (uint32_t component{ 0 }; component < 3; ++component)
+                            {
+                                vector[component] = Lanes::Mul(vector[component], reciprocalLength);
+                            }
+                        };
+                        auto dot = [&](Float const* vector, float const* constant)
+                        {
+                            return Lanes::Add(Lanes::Add(Lanes::Mul(vector[0], Lanes::Splat(constant[0])), Lanes::Mul(vector[1], Lanes::Splat(constant[1]))), Lanes::Mul(vector[2], Lanes::Splat(constant[2])));
+                        };
+                        normalize(attributes);
+                        normalize(attributes + 3);
+
+                        Float const diffuse{ dot(attributes, m_phong.lightDirection) };
+                        Float const specularBase{ Lanes::Max(Lanes::Splat(0.f), dot(attributes + 3, m_phong.halfway)) };
+                        Float const power2{ Lanes::Mul(specularBase, specularBase) };
+                        Float const power4{ Lanes::Mul(power2, power2) };
+                        Float const power8{ Lanes::Mul(power4, power4) };
+                        Float const power16{ Lanes::Mul(power8, power8) };
+                        Float const specular{ Lanes::Mul(Lanes::Mul(Lanes::Mul(power16, power8), power4), power2) }; // pow(x, 30)
+
+                        Int channels[3];
+                        for (uint32_t component{ 0 }; component < 3; ++component)
+                        {
+                            Float const color{ Lanes::Mul(attributes[6 + component], attributes[6 + component]) };
+                            Float const directional{ Lanes::Splat(m_phong.directional[component]) };
+                            Float finalColor{ Lanes::Mul(Lanes::Add(Lanes::Splat(m_phong.ambient[component]), Lanes::Mul(diffuse, directional)), color) };
+                            finalColor = Lanes::Add(finalColor, Lanes::Mul(specular, directional));
+
+                            // Convert to UNORM8: saturate, scale, and round to nearest.
+                            Float const saturated{ Lanes::Min(Lanes::Max(finalColor, Lanes::Splat(0.f)), one) };
+                            channels[component] = Lanes::ToInt(Lanes::Add(Lanes::Mul(saturated, Lanes::Splat(255.f)), Lanes::Splat(.5f)));
+                        }
+
+                        // B8G8R8A8, with alpha 1.
+                        Int const packed{ Lanes::Or(Lanes::Or(Lanes::Or(Lanes::SplatInt(static_cast<int32_t>(0xFF000000u)), Lanes::template ShiftLeft<16>(channels[0])), Lanes::template ShiftLeft<8>(channels[1])), channels[2]) };
+                        Lanes::StoreInt(pColor, Lanes::SelectInt(Lanes::LoadInt(pColor), packed, coverage));
+
+                        uint32_t const bits{ Lanes::Bits(coverage) };
+                        for (uint32_t lane{ 0 }; lane < width; ++lane)
+                        {
+                            pixelsShaded += (bits >> lane) & 1u;
+                        }
+
+                        if (isPartial)
+                        {
+                            uint32_t const valid{ m_target.width - static_cast<uint32_t>(x) };
+                            std::copy(colorScratch, colorScratch + valid, pColorRow + x);
+                            if (pDepthRow) std::copy(depthScratch, depthScratch + valid, pDepthRow + x);
+                        }
+                    }
+
+                    for (uint32_t edge{ 0 }; edge < 3; ++edge)
+                    {
+                        rowEdge[edge] += stepY[edge];
+                    }
+                }
+            }
+            return pixelsShaded;
+        }
+
+        uint64_t RasterizeTile(uint32_t tileIndex, SoftwareSimdPath simdPath)
+        {
+            switch (simdPath)
+            {
+#if defined(DX_SOFTWARE_RASTERIZER_AVX2)
+            case SoftwareSimdPath::Avx2: return RasterizeTile<SoftwareRasterizerLanes::Avx2>(tileIndex);
+#endif
+#if defined(DX_SOFTWARE_RASTERIZER_SSE2)
+            case SoftwareSimdPath::Sse2: return RasterizeTile<SoftwareRasterizerLanes::Sse2>(tileIndex);
+#endif
+#if defined(DX_SOFTWARE_RASTERIZER_NEON)
+            case SoftwareSimdPath::Neon: return RasterizeTile<SoftwareRasterizerLanes::Neon>(tileIndex);
+#endif
+            default: return RasterizeTile<SoftwareRasterizerLanes::Scalar>(tileIndex);
+            }
+        }
+
+        static uint32_t ToBgra8(float const color4[4])
+        {
+            auto toUnorm8 = [](float value) { return static_cast<uint32_t>((value > 0.f ? (value < 1.f ? value : 1.f) : 0.f) * 255.f + .5f); };
+            return (toUnorm8(color4[3]) << 24) | (toUnorm8(color4[0]) << 16) | (toUnorm8(color4[1]) << 8) | toUnorm8(color4[2]);
+        }
+
+    public:
+        // A thread count of 0 means one thread per hardware thread.
+        SoftwareRasterizer(uint32_t threadCount = 0) :
+            m_workerPool{ threadCount }
+        {
+            m_threadCounters.resize(m_workerPool.ThreadCount());
+        }
+
+        // member functions
+
+        // The widest SIMD path that this build supports.
+        static SoftwareSimdPath BestSimdPath()
+        {
+#if defined(DX_SOFTWARE_RASTERIZER_AVX2)
+            return SoftwareSimdPath::Avx2;
+#elif defined(DX_SOFTWARE_RASTERIZER_SSE2)
+            return SoftwareSimdPath::Sse2;
+#elif defined(DX_SOFTWARE_RASTERIZER_NEON)
+            return SoftwareSimdPath::Neon;
+#else
+            return SoftwareSimdPath::Scalar;
+#endif
+        }
+
+        static bool IsSimdPathSupported(SoftwareSimdPath simdPath)
+        {
+            switch (simdPath)
+            {
+            case SoftwareSimdPath::Scalar: return true;
+#if defined(DX_SOFTWARE_RASTERIZER_AVX2)
+            case SoftwareSimdPath::Avx2: return true;
+#endif
+#if defined(DX_SOFTWARE_RASTERIZER_SSE2)
+            case SoftwareSimdPath::Sse2: return true;
+#endif
+#if defined(DX_SOFTWARE_RASTERIZER_NEON)
+            case SoftwareSimdPath::Neon: return true;
+#endif
+            default: return false;
+            }
+        }
+
+        static char const* SimdPathName(SoftwareSimdPath simdPath)
+        {
+            switch (simdPath)
+            {
+            case SoftwareSimdPath::Sse2: return "SSE2";
+            case SoftwareSimdPath::Avx2: return "AVX2";
+            case SoftwareSimdPath::Neon: return "NEON";
+            default: return "scalar";
+            }
+        }
+
+        void ClearRenderTarget(SoftwareRenderTarget const& target, float const clearColor4[4])
+        {
+            Flush();
+            uint32_t const color{ ToBgra8(clearColor4) };
+            for (uint32_t y{ 0 }; y < target.height; ++y)
+            {
+                std::fill_n(target.pColor + static_cast<size_t>(y) * target.pitchInPixels, target.width, color);
+            }
+        }
+
+        void ClearDepth(SoftwareRenderTarget const& target, float depth)
+        {
+            Flush();
+            if (!target.pDepth) return;
+            for (uint32_t y{ 0 }; y < target.height; ++y)
+            {
+                std::fill_n(target.pDepth + static_cast<size_t>(y) * target.pitchInPixels, target.width, depth);
+            }
+        }
+
+        // Queues a draw of VertexPositionNormalColor vertices. The constants are copied; the vertex
+        // and index data must stay valid until the next Flush.
+        void DrawIndexedInstanced(SoftwareRenderTarget const& target, SoftwareViewport const& viewport, SoftwareScissorRect const& scissorRect, SoftwareConstants const& constants,
+            void const* pVertices, uint32_t vertexStrideInBytes, void const* pIndices, RenderIndexFormat indexFormat,
+            uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation)
+        {
+            if (target.width > s_maxTargetSize || target.height > s_maxTargetSize) throw std::invalid_argument("Render target is too large for the software rasterizer.");
+            if (!target.pColor) throw std::invalid_argument("No render target bound.");
+
+            if (target.pColor != m_target.pColor || target.pDepth != m_target.pDepth || target.width != m_target.width || target.height != m_target.height)
+            {
+                Flush();
+                m_target = target;
+            }
+
+            PendingDraw draw{};
+            draw.constants = constants;
+            draw.viewport = viewport;
+            draw.scissorRect = scissorRect;
+            draw.pVertices = static_cast<uint8_t const*>(pVertices);
+            draw.vertexStrideInBytes = vertexStrideInBytes;
+            draw.indexFormat = indexFormat;
+            draw.pIndices = static_cast<uint8_t const*>(pIndices) + uint64_t{ startIndexLocation } * (indexFormat == RenderIndexFormat::UInt16 ? 2 : 4);
+            draw.indexCount = indexCountPerInstance;
+            draw.instanceCount = instanceCount;
+            draw.baseVertexLocation = baseVertexLocation;
+            m_pendingDraws.push_back(draw);
+
+            ++m_statistics.draws;
+            m_statistics.trianglesSubmitted += uint64_t{ indexCountPerInstance / 3 } * instanceCount;
+        }
+
+        // Rasterizes all the queued draws.
+        void Flush()
+        {
+            if (m_pendingDraws.empty()) return;
+
+            // Set up triangles, one job per draw.
+            if (m_perDrawTriangles.size() < m_pendingDraws.size()) m_perDrawTriangles.resize(m_pendingDraws.size());
+            m_workerPool.ParallelFor(static_cast<uint32_t>(m_pendingDraws.size()), [&](uint32_t drawIndex, uint32_t)
+            {
+                SetupDraw(m_pendingDraws[drawIndex], m_perDrawTriangles[drawIndex]);
+            });
+
+            // Bin them, in submission order.
+            m_tilesX = (m_target.width + s_tileSize - 1) / s_tileSize;
+            m_tilesY = (m_target.height + s_tileSize - 1) / s_tileSize;
+            m_bins.resize(static_cast<size_t>(m_tilesX) * m_tilesY);
+            for (auto& bin : m_bins)
+            {
+                bin.clear();
+            }
+            m_triangles.clear();
+            for (size_t drawIndex{ 0 }; drawIndex < m_pendingDraws.size(); ++drawIndex)
+            {
+                for (TriangleSetup const& setup : m_perDrawTriangles[drawIndex])
+                {
+                    uint32_t const triangleIndex{ static_cast<uint32_t>(m_triangles.size()) };
+                    m_triangles.push_back(setup);
+                    for (uint32_t tileY{ static_cast<uint32_t>(setup.minY) / s_tileSize }; tileY <= static_cast<uint32_t>(setup.maxY - 1) / s_tileSize; ++tileY)
+                    {
+                        for (uint32_t tileX{ static_cast<uint32_t>(setup.minX) / s_tileSize }; tileX <= static_cast<uint32_t>(setup.maxX - 1) / s_tileSize; ++tileX)
+                        {
+                            m_bins[static_cast<size_t>(tileY) * m_tilesX + tileX].push_back(triangleIndex);
+                        }
+                    }
+                }
+            }
+
+            // Rasterize, one job per tile.
+            SoftwareSimdPath const simdPath{ m_simdPath };
+            m_workerPool.ParallelFor(static_cast<uint32_t>(m_bins.size()), [&](uint32_t tileIndex, uint32_t threadIndex)
+            {
+                if (!m_bins[tileIndex].empty()) m_threadCounters[threadIndex].pixelsShaded += RasterizeTile(tileIndex, simdPath);
+            });
+
+            for (ThreadCounters& counters : m_threadCounters)
+            {
+                m_statistics.pixelsShaded += counters.pixelsShaded;
+                counters.pixelsShaded = 0;
+            }
+            m_statistics.trianglesRasterized += m_triangles.size();
+            ++m_statistics.flushes;
+            m_pendingDraws.clear();
+        }
+
+        // accessors
+
+        SoftwareSimdPath SimdPath() const { return m_simdPath; }
+        SoftwareRasterizerStatistics const& Statistics() const { return m_statistics; }
+        uint32_t ThreadCount() const { return m_workerPool.ThreadCount(); }
+
+        // mutators
+
+        // For example, to check that a narrower path produces the same image.
+        void SimdPath(SoftwareSimdPath simdPath)
+        {
+            if (!IsSimdPathSupported(simdPath)) throw std::invalid_argument("SIMD path not supported by this build.");
+            m_simdPath = simdPath;
+        }
+    };
+
+    // Executes headless command lists with a SoftwareRasterizer, so that the headless backend
+    // draws what a D3D12 queue would. Render targets are BGRA8 textures, and depth buffers
+    // are 4-byte-per-pixel (D32_FLOAT) textures, both created with CreateTexture2D (or
+    // owned by a HeadlessRenderSwapChain). Vertex buffers hold VertexPositionNormalColor, and
+    // constant buffers hold WorldViewProjectionConstantBuffer.
+    class SoftwareRasterizerExecutor final : public IHeadlessCommandExecutor
+    {
+        // data members
+
+        HeadlessRenderResource* m_pConstantBuffer{ nullptr };
+        uint32_t m_constantBufferOffset{ 0 };
+        HeadlessRenderResource* m_pDepthStencil{ nullptr };
+        HeadlessRenderResource* m_pIndexBuffer{ nullptr };
+        RenderIndexFormat m_indexFormat{ RenderIndexFormat::UInt16 };
+        SoftwareRasterizer& m_rasterizer;
+        HeadlessRenderResource* m_pRenderTarget{ nullptr };
+        SoftwareScissorRect m_scissorRect;
+        HeadlessRenderResource* m_pVertexBuffer{ nullptr };
+        uint32_t m_vertexStrideInBytes{ 0 };
+        SoftwareViewport m_viewport;
+
+        static SoftwareRenderTarget TargetFor(HeadlessRenderResource* pRenderTarget, HeadlessRenderResource* pDepthStencil)
+        {
+            SoftwareRenderTarget target;
+            if (pRenderTarget)
+            {
+                target.pColor = reinterpret_cast<uint32_t*>(pRenderTarget->Data());
+                target.width = pRenderTarget->Width();
+                target.height = pRenderTarget->Height();
+            }
+            else if (pDepthStencil)
+            {
+                target.width = pDepthStencil->Width();
+                target.height = pDepthStencil->Height();
+            }
+            target.pitchInPixels = target.width;
+            if (pDepthStencil && pDepthStencil->Width() == target.width && pDepthStencil->Height() == target.height)
+            {
+                target.pDepth = reinterpret_cast<float*>(pDepthStencil->Data());
+            }
+            return target;
+        }
+
+    public:
+        SoftwareRasterizerExecutor(SoftwareRasterizer& rasterizer) :
+            m_rasterizer{ rasterizer }
+        {
+        }
+
+        // member functions
+
+        void Execute(HeadlessRenderCommandList const& commandList) override
+        {
+            for (HeadlessCommand const& command : commandList.Commands())
+            {
+                switch (command.type)
+                {
+                case HeadlessCommandType::SetViewport:
+                    m_viewport = SoftwareViewport{ command.floats[0], command.floats[1], command.floats[2], command.floats[3], command.floats[4], command.floats[5] };
+                    break;
+                case HeadlessCommandType::SetScissorRect:
+                    m_scissorRect = SoftwareScissorRect{ command.values[0], command.values[1], command.values[2], command.values[3] };
+                    break;
+                case HeadlessCommandType::ClearRenderTarget:
+                    if (command.resources[0]) m_rasterizer.ClearRenderTarget(TargetFor(command.resources[0], nullptr), command.floats);
+                    break;
+                case HeadlessCommandType::ClearDepth:
+                    if (command.resources[0]) m_rasterizer.ClearDepth(TargetFor(nullptr, command.resources[0]), command.floats[0]);
+                    break;
+                case HeadlessCommandType::SetRenderTargets:
+                    m_pRenderTarget = command.resources[0];
+                    m_pDepthStencil = command.resources[1];
+                    break;
+                case HeadlessCommandType::SetConstantBuffer:
+                    m_pConstantBuffer = command.resources[0];
+                    m_constantBufferOffset = command.values[1];
+                    break;
+                case HeadlessCommandType::SetVertexBuffer:
+                    m_pVertexBuffer = command.resources[0];
+                    m_vertexStrideInBytes = command.values[0];
+                    break;
+                case HeadlessCommandType::SetIndexBuffer:
+                    m_pIndexBuffer = command.resources[0];
+                    m_indexFormat = static_cast<RenderIndexFormat>(command.values[0]);
+                    break;
+                case HeadlessCommandType::DrawIndexedInstanced:
+                {
+                    if (!m_pRenderTarget || !m_pConstantBuffer || !m_pVertexBuffer || !m_pIndexBuffer) throw std::logic_error("Draw with incomplete pipeline state.");
+                    SoftwareConstants constants;
+                    std::memcpy(&constants, m_pConstantBuffer->Data() + m_constantBufferOffset, sizeof(constants));
+                    m_rasterizer.DrawIndexedInstanced(TargetFor(m_pRenderTarget, m_pDepthStencil), m_viewport, m_scissorRect, constants,
+                        m_pVertexBuffer->Data(), m_vertexStrideInBytes, m_pIndexBuffer->Data(), m_indexFormat,
+                        command.values[0], command.values[1], command.values[2], static_cast<int32_t>(command.values[3]));
+                    break;
+                }
+                default:
+                    break;
+                }
+            }
+
+            // The list's work is complete when ExecuteCommandList returns.
+            m_rasterizer.Flush();
+        }
+    };
+}
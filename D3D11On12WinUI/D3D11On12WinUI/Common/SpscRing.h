@@ -0,0 +1,72 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace DX
+{
+    // A bounded queue between exactly one producer thread and exactly one consumer thread,
+    // with no locks: each side owns one index, and publishes it with a release store that the
+    // other side reads with an acquire load. Capacity must be a power of two.
+    template <typename T, size_t Capacity>
+    class SpscRing final
+    {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscRing's capacity must be a power of two.");
+
+        static constexpr size_t s_cacheLineSize{ 64 };
+
+        // data members
+
+        // The indices only ever increase (they're masked on use), and they're kept on separate
+        // cache lines so that the two threads don't contend for one.
+        alignas(s_cacheLineSize) std::atomic<uint64_t> m_head{ 0 }; // Written by the consumer.
+        alignas(s_cacheLineSize) std::atomic<uint64_t> m_tail{ 0 }; // Written by the producer.
+        alignas(s_cacheLineSize) std::array<T, Capacity> m_slots{};
+
+    public:
+        SpscRing() = default;
+        SpscRing(SpscRing const&) = delete;
+        SpscRing& operator=(SpscRing const&) = delete;
+
+        // member functions
+
+        // Producer only. Returns `false` (and drops nothing) if the ring is full.
+        bool TryPush(T value)
+        {
+            uint64_t const tail{ m_tail.load(std::memory_order_relaxed) };
+            if (tail - m_head.load(std::memory_order_acquire) == Capacity) return false;
+            m_slots[tail & (Capacity - 1)] = std::move(value);
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer only. Returns `false` if the ring is empty.
+        bool TryPop(T& value)
+        {
+            uint64_t const head{ m_head.load(std::memory_order_relaxed) };
+            if (head == m_tail.load(std::memory_order_acquire)) return false;
+            value = std::move(m_slots[head & (Capacity - 1)]);
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // accessors
+
+        // Exact only on the consumer's thread, when the producer is idle; otherwise a snapshot.
+        bool Empty() const { return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire); }
+    };
+}
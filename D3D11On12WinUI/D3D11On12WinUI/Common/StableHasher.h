@@ -0,0 +1,66 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// A hash that's the same from run to run, and from machine to machine, for keys that are saved
+// to disk (pipeline descriptions in PipelineCache, shaders in ShaderArchive).
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace DX
+{
+    // The 64-bit FNV-1a hash of whatever's added, in order.
+    class StableHasher final
+    {
+        // data members
+
+        uint64_t m_hash{ 14695981039346656037ull };
+
+    public:
+        // member functions
+
+        void Add(void const* pData, size_t sizeInBytes)
+        {
+            auto const* pBytes{ static_cast<uint8_t const*>(pData) };
+            for (size_t byte{ 0 }; byte < sizeInBytes; ++byte)
+            {
+                m_hash = (m_hash ^ pBytes[byte]) * 1099511628211ull;
+            }
+        }
+
+        // For numbers and enumerations (and structs of them with no padding, via Add(pData, sizeInBytes)).
+        template <typename T>
+        void Add(T value)
+        {
+            static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "Hash the bytes that a pointer points to, not the pointer.");
+            Add(&value, sizeof(value));
+        }
+
+        // A null-terminated string (or nullptr, which hashes differently from "").
+        void AddString(char const* pString)
+        {
+            if (!pString)
+            {
+                Add(uint8_t{ 0xff });
+                return;
+            }
+            Add(pString, std::strlen(pString) + 1);
+        }
+
+        // accessors
+
+        uint64_t Hash() const { return m_hash; }
+    };
+}
@@ -0,0 +1,251 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Startup (and recovery from device loss) as a graph of tasks, each of which names the tasks
+// that it depends on, rather than as one function that does everything in turn. Tasks whose
+// dependencies have finished run at once, on a WorkerPool's threads; so creating the device
+// overlaps mapping the shaders and creating the DirectWrite and WIC factories, and so on. Each
+// task is timed, and the report names the chain of tasks that bounded the whole (the critical
+// path): shortening any other task doesn't bring the first frame any sooner.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "WorkerPool.h"
+
+namespace DX
+{
+    // When a task ran, in milliseconds from the start of the run.
+    struct StartupStep final
+    {
+        std::string name;
+        double startMilliseconds{ 0. };
+        double endMilliseconds{ 0. };
+        uint32_t threadIndex{ 0 };
+        bool waitedForThread{ false }; // On the critical path: it was held up by the task before it on its thread, rather than by a dependency.
+
+        double Milliseconds() const { return endMilliseconds - startMilliseconds; }
+    };
+
+    struct StartupReport final
+    {
+        double totalMilliseconds{ 0. }; // From the start of the run to the end of the last task.
+        double taskMilliseconds{ 0. }; // The sum of the tasks; what a serial startup would take.
+        double firstPresentMilliseconds{ 0. }; // From the start of the run, if the caller records it.
+        uint32_t threadCount{ 0 };
+        std::vector<StartupStep> criticalPath; // In order: each step is the one that its successor waited for last (a dependency, or a thread).
+        std::vector<StartupStep> steps; // Every task, in the order in which they were added.
+
+        std::string ToString() const
+        {
+            char line[160]{};
+            std::snprintf(line, sizeof(line), "Startup: %.1f ms on %u threads (%.1f ms of tasks)", totalMilliseconds, threadCount, taskMilliseconds);
+            std::string text{ line };
+            if (firstPresentMilliseconds > 0.)
+            {
+                std::snprintf(line, sizeof(line), "; first present at %.1f ms", firstPresentMilliseconds);
+                text += line;
+            }
+            text += "\n  critical path:";
+            for (StartupStep const& step : criticalPath)
+            {
+                std::snprintf(line, sizeof(line), " %s%s %.1f ms", &step == &criticalPath.front() ? "" : step.waitedForThread ? "> (thread) " : "> ", step.name.c_str(), step.Milliseconds());
+                text += line;
+            }
+            for (StartupStep const& step : steps)
+            {
+                std::snprintf(line, sizeof(line), "\n  %-16s %7.1f to %7.1f ms (thread %u)", step.name.c_str(), step.startMilliseconds, step.endMilliseconds, step.threadIndex);
+                text += line;
+            }
+            return text;
+        }
+    };
+
+    class StartupGraph final
+    {
+    public:
+        using TaskId = uint32_t;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Task final
+        {
+            std::string name;
+            std::function<void()> run;
+            std::vector<TaskId> dependencies;
+            std::vector<TaskId> dependents;
+            uint32_t unfinishedDependencies{ 0 };
+            StartupStep step;
+        };
+
+        // data members
+
+        std::condition_variable m_changed;
+        std::exception_ptr m_exception;
+        uint32_t m_finishedCount{ 0 };
+        std::mutex m_mutex;
+        std::vector<TaskId> m_ready;
+        Clock::time_point m_startTime;
+        std::vector<Task> m_tasks;
+        uint32_t m_threadCount{ 0 };
+
+        double MillisecondsSinceStart() const { return std::chrono::duration<double, std::milli>(Clock::now() - m_startTime).count(); }
+
+        // Runs ready tasks until every task has finished, or one has thrown.
+        void Work(uint32_t threadIndex)
+        {
+            std::unique_lock<std::mutex> lock{ m_mutex };
+            for (;;)
+            {
+                m_changed.wait(lock, [&] { return m_exception || !m_ready.empty() || m_finishedCount == m_tasks.size(); });
+                if (m_exception || m_ready.empty()) return;
+                TaskId const id{ m_ready.back() };
+                m_ready.pop_back();
+                Task& task{ m_tasks[id] };
+                lock.unlock();
+
+                task.step.threadIndex = threadIndex;
+                task.step.startMilliseconds = MillisecondsSinceStart();
+                std::exception_ptr exception;
+                try
+                {
+                    task.run();
+                }
+                catch (...)
+                {
+                    exception = std::current_exception();
+                }
+                task.step.endMilliseconds = MillisecondsSinceStart();
+
+                lock.lock();
+                if (exception && !m_exception) m_exception = exception;
+                ++m_finishedCount;
+                for (TaskId const dependent : task.dependents)
+                {
+                    if (--m_tasks[dependent].unfinishedDependencies == 0) m_ready.push_back(dependent);
+                }
+                m_changed.notify_all();
+            }
+        }
+
+    public:
+        // member functions
+
+        // Adds a task that runs once every one of `dependencies` (tasks added before it) has
+        // finished. A task may run on any of the pool's threads, so what it touches must either
+        // be free-threaded (as a D3D12 device is) or be touched only by tasks that it depends
+        // on, or that depend on it.
+        TaskId Add(std::string name, std::function<void()> run, std::initializer_list<TaskId> dependencies = {})
+        {
+            TaskId const id{ static_cast<TaskId>(m_tasks.size()) };
+            Task task;
+            task.name = std::move(name);
+            task.run = std::move(run);
+            task.step.name = task.name;
+            for (TaskId const dependency : dependencies)
+            {
+                if (dependency >= id) throw std::invalid_argument{ "A startup task can depend only on tasks added before it." };
+                task.dependencies.push_back(dependency);
+                m_tasks[dependency].dependents.push_back(id);
+            }
+            m_tasks.push_back(std::move(task));
+            return id;
+        }
+
+        // Runs every task, on the pool's threads (and the calling thread), and returns once they
+        // have all finished. If a task throws, no more tasks are started, and the exception is
+        // rethrown here once those already running have finished.
+        void Run(WorkerPool& workerPool)
+        {
+            m_ready.clear();
+            for (TaskId id{ static_cast<TaskId>(m_tasks.size()) }; id-- > 0;)
+            {
+                m_tasks[id].unfinishedDependencies = static_cast<uint32_t>(m_tasks[id].dependencies.size());
+                if (m_tasks[id].dependencies.empty()) m_ready.push_back(id);
+            }
+            m_finishedCount = 0;
+            m_exception = nullptr;
+            m_threadCount = workerPool.ThreadCount();
+            m_startTime = Clock::now();
+
+            workerPool.ParallelFor(workerPool.ThreadCount(), [&](uint32_t, uint32_t threadIndex) { Work(threadIndex); });
+            if (m_exception) std::rethrow_exception(m_exception);
+        }
+
+        // accessors
+
+        // What the last Run took, and which tasks bounded it.
+        StartupReport Report() const
+        {
+            StartupReport report;
+            report.threadCount = m_threadCount;
+            for (Task const& task : m_tasks)
+            {
+                report.steps.push_back(task.step);
+                report.taskMilliseconds += task.step.Milliseconds();
+                report.totalMilliseconds = std::max(report.totalMilliseconds, task.step.endMilliseconds);
+            }
+            if (m_tasks.empty()) return report;
+
+            // Walk back from the task that finished last, through what each task waited for last:
+            // the dependency that finished last or, if it then waited for a thread, the task
+            // that finished before it on that thread.
+            auto finishedLater = [&](TaskId a, TaskId b) { return m_tasks[a].step.endMilliseconds < m_tasks[b].step.endMilliseconds; };
+            std::vector<TaskId> ids(m_tasks.size());
+            for (TaskId id{ 0 }; id < ids.size(); ++id) ids[id] = id;
+            TaskId id{ *std::max_element(ids.begin(), ids.end(), finishedLater) };
+            for (;;)
+            {
+                StartupStep const& step{ m_tasks[id].step };
+                std::vector<TaskId> const& dependencies{ m_tasks[id].dependencies };
+                std::optional<TaskId> waitedFor;
+                if (!dependencies.empty()) waitedFor = *std::max_element(dependencies.begin(), dependencies.end(), finishedLater);
+                std::optional<TaskId> previousOnThread;
+                for (TaskId const other : ids)
+                {
+                    StartupStep const& otherStep{ m_tasks[other].step };
+                    if (other == id || otherStep.threadIndex != step.threadIndex || otherStep.endMilliseconds > step.startMilliseconds) continue;
+                    if (!previousOnThread || finishedLater(*previousOnThread, other)) previousOnThread = other;
+                }
+
+                report.criticalPath.push_back(step);
+                bool const waitedForThread{ previousOnThread && (!waitedFor || finishedLater(*waitedFor, *previousOnThread)) &&
+                    step.startMilliseconds - m_tasks[*previousOnThread].step.endMilliseconds < step.startMilliseconds - (waitedFor ? m_tasks[*waitedFor].step.endMilliseconds : 0.) };
+                if (waitedForThread)
+                {
+                    report.criticalPath.back().waitedForThread = true;
+                    waitedFor = previousOnThread;
+                }
+                if (!waitedFor) break;
+                id = *waitedFor;
+            }
+            std::reverse(report.criticalPath.begin(), report.criticalPath.end());
+            return report;
+        }
+
+        uint32_t TaskCount() const { return static_cast<uint32_t>(m_tasks.size()); }
+    };
+}
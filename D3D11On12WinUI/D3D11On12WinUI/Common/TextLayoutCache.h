@@ -0,0 +1,156 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// The backend-neutral part of SampleTextRenderer's cache of text layouts (what DirectWrite
+// shapes and lays out, the costliest CPU work in a frame), so that text that hasn't changed
+// isn't laid out again. A layout is keyed by its text, its text format, and the layout box
+// (the maximum width and height, and the DPI). The least recently used layout is evicted when
+// the cache is full; and all of them when the layout box changes (the window is resized, or
+// moved to a display with another DPI), as none would be asked for again.
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include "StableHasher.h"
+
+namespace DX
+{
+    struct TextLayoutBox final
+    {
+        float maxWidth{ 0.f };
+        float maxHeight{ 0.f };
+        float dpi{ 96.f };
+
+        bool operator==(TextLayoutBox const& other) const { return maxWidth == other.maxWidth && maxHeight == other.maxHeight && dpi == other.dpi; }
+        bool operator!=(TextLayoutBox const& other) const { return !(*this == other); }
+    };
+
+    struct TextLayoutCacheStatistics final
+    {
+        uint64_t hits{ 0 };
+        uint64_t misses{ 0 };
+        uint64_t evictions{ 0 }; // Of the least recently used, when the cache was full.
+        uint64_t invalidations{ 0 }; // Of every layout, when the layout box changed.
+
+        double HitRate() const { return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0.; }
+    };
+
+    // `Layout` is whatever the text engine lays text out into (a com_ptr<IDWriteTextLayout>, say).
+    // The text format is identified by a number that's unique while its layouts are cached (its
+    // address, say); Clear the cache when a text format is released.
+    template <typename Layout>
+    class TextLayoutCache final
+    {
+        struct Entry final
+        {
+            uint64_t hash{ 0 };
+            std::wstring text;
+            uint64_t format{ 0 };
+            Layout layout{};
+        };
+
+        using Entries = std::list<Entry>;
+
+        // data members
+
+        TextLayoutBox m_box;
+        size_t m_capacity{ 0 };
+        Entries m_entries; // The most recently used first.
+        std::unordered_map<uint64_t, typename Entries::iterator> m_index; // By hash.
+        TextLayoutCacheStatistics m_statistics;
+
+    public:
+        // The hash of a layout's key. Layouts whose keys hash alike are told apart by their text
+        // and format (the one asked for replaces the other), so a collision costs only a layout.
+        static uint64_t Hash(std::wstring_view text, uint64_t format, TextLayoutBox const& box)
+        {
+            StableHasher hasher;
+            hasher.Add(static_cast<uint64_t>(text.size()));
+            hasher.Add(text.data(), text.size() * sizeof(wchar_t));
+            hasher.Add(format);
+            hasher.Add(box.maxWidth);
+            hasher.Add(box.maxHeight);
+            hasher.Add(box.dpi);
+            return hasher.Hash();
+        }
+
+        explicit TextLayoutCache(size_t capacity = 64) :
+            m_capacity{ capacity > 0 ? capacity : 1 }
+        {
+        }
+
+        // member functions
+
+        void Clear()
+        {
+            m_entries.clear();
+            m_index.clear();
+        }
+
+        // Returns the layout of `text` in `format` in the layout box, calling create(text) for
+        // one if it isn't cached. The reference is good until the next call that changes the cache.
+        template <typename Create>
+        Layout const& Find(std::wstring_view text, uint64_t format, Create&& create)
+        {
+            uint64_t const hash{ Hash(text, format, m_box) };
+            auto const it{ m_index.find(hash) };
+            if (it != m_index.end() && it->second->format == format && it->second->text == text)
+            {
+                ++m_statistics.hits;
+                m_entries.splice(m_entries.begin(), m_entries, it->second);
+                return it->second->layout;
+            }
+
+            ++m_statistics.misses;
+            Layout layout{ create(text) }; // Before the cache changes, in case it throws.
+            if (it != m_index.end())
+            {
+                m_entries.erase(it->second);
+                m_index.erase(it);
+            }
+            else if (m_entries.size() == m_capacity)
+            {
+                m_index.erase(m_entries.back().hash);
+                m_entries.pop_back();
+                ++m_statistics.evictions;
+            }
+            m_entries.push_front(Entry{ hash, std::wstring{ text }, format, std::move(layout) });
+            m_index.emplace(hash, m_entries.begin());
+            return m_entries.front().layout;
+        }
+
+        // accessors
+
+        size_t Capacity() const { return m_capacity; }
+        TextLayoutBox const& LayoutBox() const { return m_box; }
+        size_t Size() const { return m_entries.size(); }
+        TextLayoutCacheStatistics const& Statistics() const { return m_statistics; }
+
+        // mutators
+
+        // Call each frame before Find; a box other than the last drops every layout.
+        void LayoutBox(TextLayoutBox const& box)
+        {
+            if (box == m_box) return;
+            m_box = box;
+            if (m_entries.empty()) return;
+            Clear();
+            ++m_statistics.invalidations;
+        }
+    };
+}
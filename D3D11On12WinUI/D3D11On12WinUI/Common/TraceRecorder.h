@@ -0,0 +1,178 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Records what setup, reset and the other lifecycle phases cost, as spans (a TraceSpan times
+// the scope that it's declared in) and instants, from any thread; and writes them as Chrome
+// trace JSON, which chrome://tracing, Perfetto and Edge's performance tools open. The events
+// are kept in memory (up to s_maxEvents; those beyond are counted, and dropped), so recording
+// one costs a clock read and a lock, not I/O.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace DX
+{
+    struct TraceEvent final
+    {
+        char const* name{ nullptr }; // Must outlive the recorder (a string literal, typically).
+        char const* category{ nullptr };
+        uint64_t startMicroseconds{ 0 }; // From the recorder's creation.
+        uint64_t durationMicroseconds{ 0 };
+        uint32_t threadIndex{ 0 }; // 1 for the first thread that recorded anything, and so on.
+        bool isInstant{ false };
+    };
+
+    class TraceRecorder final
+    {
+        using Clock = std::chrono::steady_clock;
+
+        // data members
+
+        uint64_t m_droppedCount{ 0 };
+        std::vector<TraceEvent> m_events;
+        mutable std::mutex m_mutex;
+        Clock::time_point const m_startTime{ Clock::now() };
+        std::vector<std::thread::id> m_threads; // A thread's index is its position, plus one.
+
+        // Call under the lock.
+        uint32_t ThreadIndex(std::thread::id thread)
+        {
+            auto it{ std::find(m_threads.begin(), m_threads.end(), thread) };
+            if (it == m_threads.end()) it = m_threads.insert(m_threads.end(), thread);
+            return static_cast<uint32_t>(it - m_threads.begin()) + 1;
+        }
+
+        static void AppendEscaped(std::string& json, char const* pText)
+        {
+            for (; *pText; ++pText)
+            {
+                if (*pText == '"' || *pText == '\\') json += '\\';
+                if (static_cast<unsigned char>(*pText) >= 0x20) json += *pText;
+            }
+        }
+
+    public:
+        static constexpr size_t s_maxEvents{ 16384 };
+
+        // member functions
+
+        void Clear()
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            m_events.clear();
+            m_droppedCount = 0;
+        }
+
+        // Records a moment (such as the first present), on the calling thread.
+        void Instant(char const* name, char const* category = "lifecycle")
+        {
+            Record({ name, category, Now(), 0, 0, true });
+        }
+
+        uint64_t Now() const { return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - m_startTime).count()); }
+
+        // Records an event; its threadIndex is filled in for the calling thread.
+        void Record(TraceEvent event)
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            if (m_events.size() >= s_maxEvents)
+            {
+                ++m_droppedCount;
+                return;
+            }
+            event.threadIndex = ThreadIndex(std::this_thread::get_id());
+            m_events.push_back(event);
+        }
+
+        // The events as a Chrome trace ("JSON object format"), in the order in which they ended.
+        std::string ToChromeJson() const
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            std::string json{ "{\"traceEvents\":[" };
+            char number[96]{};
+            for (TraceEvent const& event : m_events)
+            {
+                if (&event != &m_events.front()) json += ',';
+                json += "\n{\"name\":\"";
+                AppendEscaped(json, event.name);
+                json += "\",\"cat\":\"";
+                AppendEscaped(json, event.category);
+                if (event.isInstant)
+                {
+                    std::snprintf(number, sizeof(number), "\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%llu,\"pid\":1,\"tid\":%u}",
+                        static_cast<unsigned long long>(event.startMicroseconds), event.threadIndex);
+                }
+                else
+                {
+                    std::snprintf(number, sizeof(number), "\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":1,\"tid\":%u}",
+                        static_cast<unsigned long long>(event.startMicroseconds), static_cast<unsigned long long>(event.durationMicroseconds), event.threadIndex);
+                }
+                json += number;
+            }
+            std::snprintf(number, sizeof(number), "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":%llu}}\n", static_cast<unsigned long long>(m_droppedCount));
+            json += number;
+            return json;
+        }
+
+        // accessors
+
+        uint64_t DroppedCount() const
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            return m_droppedCount;
+        }
+
+        std::vector<TraceEvent> Events() const
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            return m_events;
+        }
+    };
+
+    // Times the scope that it's declared in, as a span in `recorder`:
+    //     DX::TraceSpan const span{ m_trace, "DeviceResources::CreateDevice" };
+    class TraceSpan final
+    {
+        // data members
+
+        char const* m_category{ nullptr };
+        char const* m_name{ nullptr };
+        TraceRecorder& m_recorder;
+        uint64_t m_startMicroseconds{ 0 };
+
+    public:
+        TraceSpan(TraceRecorder& recorder, char const* name, char const* category = "lifecycle") :
+            m_category{ category },
+            m_name{ name },
+            m_recorder{ recorder },
+            m_startMicroseconds{ recorder.Now() }
+        {
+        }
+
+        // Records the span even if the scope is left by an exception, as a failed setup is one worth seeing.
+        ~TraceSpan()
+        {
+            m_recorder.Record({ m_name, m_category, m_startMicroseconds, m_recorder.Now() - m_startMicroseconds });
+        }
+
+        TraceSpan(TraceSpan const&) = delete;
+        TraceSpan& operator=(TraceSpan const&) = delete;
+    };
+}
@@ -0,0 +1,147 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// The bookkeeping for uploads that go through a dedicated copy queue. Each upload stages its
+// data in a ring of upload memory, and joins the open batch; a batch is submitted as one
+// command list, which signals the copy queue's fence with the batch's ticket. Whatever uses an
+// uploaded resource waits, GPU-side, for that ticket, rather than the CPU waiting for every
+// upload. A batch's staging memory is reused once its ticket is reached. It deals only in
+// offsets and fence values, so the same code runs against a D3D12 copy queue (in
+// CopyUploadQueue) and against the headless backend.
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <optional>
+
+#include "UploadRing.h"
+
+namespace DX
+{
+    struct UploadBatcherStatistics final
+    {
+        uint64_t batches{ 0 };
+        uint64_t bytes{ 0 }; // Staged so far, whether or not the batch has been submitted.
+        uint64_t busyNanoseconds{ 0 }; // The time during which at least one submitted batch was incomplete.
+        uint64_t completedBytes{ 0 };
+        uint64_t stagingWaits{ 0 }; // Times that a full staging ring made the CPU wait for a batch.
+        uint64_t uploads{ 0 };
+
+        // Completion is only seen when it's polled for, so this errs low.
+        double MegabytesPerSecond() const { return busyNanoseconds ? completedBytes * 1e3 / busyNanoseconds : 0.; }
+    };
+
+    class UploadBatcher final
+    {
+        struct SubmittedBatch final
+        {
+            uint64_t ticket{ 0 };
+            uint64_t bytes{ 0 };
+            uint64_t submitNanoseconds{ 0 };
+        };
+
+        // data members
+
+        uint64_t m_lastCompletionNanoseconds{ 0 };
+        uint64_t m_openBytes{ 0 };
+        uint64_t m_openTicket{ 1 }; // The ticket of the batch that uploads join now.
+        uint32_t m_openUploads{ 0 };
+        UploadRing m_staging;
+        UploadBatcherStatistics m_statistics;
+        std::deque<SubmittedBatch> m_submitted; // In ticket order.
+
+    public:
+        UploadBatcher(uint64_t stagingCapacity = 0, uint64_t firstTicket = 1)
+        {
+            Reset(stagingCapacity, firstTicket);
+        }
+
+        // member functions
+
+        // Returns the staging offset of `sizeInBytes` bytes, aligned to `alignment`, for an
+        // upload that joins the open batch; or nothing if the staging ring is full. In that
+        // case, submit the open batch, wait for OldestPendingTicket, Reclaim, and try again.
+        std::optional<uint64_t> AllocateStaging(uint64_t sizeInBytes, uint64_t alignment)
+        {
+            std::optional<uint64_t> offset{ m_staging.Allocate(sizeInBytes, alignment) };
+            if (!offset) return std::nullopt;
+
+            ++m_openUploads;
+            m_openBytes += sizeInBytes;
+            ++m_statistics.uploads;
+            m_statistics.bytes += sizeInBytes;
+            return offset;
+        }
+
+        // Makes the staging memory of the batches whose tickets have been reached available again.
+        void Reclaim(uint64_t completedTicket, uint64_t nowNanoseconds)
+        {
+            while (!m_submitted.empty() && m_submitted.front().ticket <= completedTicket)
+            {
+                uint64_t const start{ std::max(m_submitted.front().submitNanoseconds, m_lastCompletionNanoseconds) };
+                if (nowNanoseconds > start) m_statistics.busyNanoseconds += nowNanoseconds - start;
+                m_statistics.completedBytes += m_submitted.front().bytes;
+                m_lastCompletionNanoseconds = nowNanoseconds;
+                m_submitted.pop_front();
+            }
+            m_staging.Reclaim(completedTicket);
+        }
+
+        // Forgets every batch. Only for when the copy queue is idle, or is being replaced.
+        void Reset(uint64_t stagingCapacity, uint64_t firstTicket)
+        {
+            m_lastCompletionNanoseconds = 0;
+            m_openBytes = 0;
+            m_openTicket = firstTicket;
+            m_openUploads = 0;
+            m_staging.Reset(stagingCapacity);
+            m_submitted.clear();
+        }
+
+        // Counts a wait for a full staging ring (see AllocateStaging).
+        void StagingWaited() { ++m_statistics.stagingWaits; }
+
+        // Ends the open batch, and returns its ticket: the value to signal the copy queue's
+        // fence with once its command list has been submitted. If the batch is empty, nothing is
+        // submitted, and this returns the ticket of the last batch that was.
+        uint64_t Submit(uint64_t nowNanoseconds)
+        {
+            if (m_openUploads == 0) return m_openTicket - 1;
+
+            uint64_t const ticket{ m_openTicket++ };
+            m_staging.FinishFrame(ticket);
+            m_submitted.push_back(SubmittedBatch{ ticket, m_openBytes, nowNanoseconds });
+            m_openBytes = 0;
+            m_openUploads = 0;
+            ++m_statistics.batches;
+            return ticket;
+        }
+
+        // accessors
+
+        bool HasOpenBatch() const { return m_openUploads != 0; }
+        uint64_t LastSubmittedTicket() const { return m_openTicket - 1; }
+
+        // The ticket that covers every upload staged so far.
+        uint64_t LatestTicket() const { return HasOpenBatch() ? m_openTicket : m_openTicket - 1; }
+
+        // The largest upload (or piece of one) that's sure to fit in an otherwise empty staging
+        // ring, wherever the ring's head is, for any alignment up to the same size.
+        uint64_t MaxStagingSize() const { return m_staging.Capacity() / 4; }
+
+        std::optional<uint64_t> OldestPendingTicket() const { return m_submitted.empty() ? std::nullopt : std::optional<uint64_t>{ m_submitted.front().ticket }; }
+        uint64_t OpenTicket() const { return m_openTicket; }
+        UploadRing const& Staging() const { return m_staging; }
+        UploadBatcherStatistics const& Statistics() const { return m_statistics; }
+    };
+}
@@ -0,0 +1,128 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// The bookkeeping for a ring of upload memory that's sub-allocated linearly, frame after
+// frame, and reclaimed a frame at a time once the fence value that ends each frame is
+// reached. It deals only in offsets, so the same code runs against a D3D12 upload buffer (in
+// DeviceResources) and against the headless backend.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <optional>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DX_UPLOAD_RING_SSE2
+#endif
+
+namespace DX
+{
+    // Copies into write-combined upload memory. Streaming stores go straight to the write-combining
+    // buffers, rather than reading each destination line into the cache first. The data is visible
+    // to the GPU once the copy returns.
+    inline void StreamingCopy(void* pDestination, void const* pSource, size_t sizeInBytes)
+    {
+        auto* pDestinationBytes{ static_cast<uint8_t*>(pDestination) };
+        auto const* pSourceBytes{ static_cast<uint8_t const*>(pSource) };
+#if defined(DX_UPLOAD_RING_SSE2)
+        if ((reinterpret_cast<uintptr_t>(pDestinationBytes) & 15) == 0)
+        {
+            size_t const streamedSize{ sizeInBytes & ~size_t{ 15 } };
+            for (size_t offset{ 0 }; offset < streamedSize; offset += 16)
+            {
+                _mm_stream_si128(reinterpret_cast<__m128i*>(pDestinationBytes + offset), _mm_loadu_si128(reinterpret_cast<__m128i const*>(pSourceBytes + offset)));
+            }
+            _mm_sfence();
+            pDestinationBytes += streamedSize;
+            pSourceBytes += streamedSize;
+            sizeInBytes -= streamedSize;
+        }
+#endif
+        std::memcpy(pDestinationBytes, pSourceBytes, sizeInBytes);
+    }
+
+    class UploadRing final
+    {
+        // data members
+
+        uint64_t m_capacity{ 0 };
+        std::deque<std::pair<uint64_t, uint64_t>> m_frames; // (fence value, head at the end of the frame), in order.
+        uint64_t m_head{ 0 }; // Where the next allocation starts. Like m_tail, it counts up without wrapping; the offset is it modulo the capacity.
+        uint64_t m_peakUsedBytes{ 0 };
+        uint64_t m_tail{ 0 }; // The start of the oldest allocation that the GPU may still be reading.
+
+    public:
+        UploadRing(uint64_t capacity = 0) :
+            m_capacity{ capacity }
+        {
+        }
+
+        // member functions
+
+        // Returns the offset of `sizeInBytes` bytes, aligned to `alignment` (a power of two that
+        // divides the capacity), or nothing if they don't fit without overwriting data that the
+        // GPU may still be reading. An allocation never straddles the end of the ring; if it
+        // would, the rest of the lap is skipped.
+        std::optional<uint64_t> Allocate(uint64_t sizeInBytes, uint64_t alignment)
+        {
+            if (m_capacity == 0 || sizeInBytes > m_capacity) return std::nullopt;
+
+            uint64_t start{ (m_head + alignment - 1) & ~(alignment - 1) };
+            if (start % m_capacity + sizeInBytes > m_capacity)
+            {
+                start += m_capacity - start % m_capacity;
+            }
+            uint64_t const end{ start + sizeInBytes };
+            if (end - m_tail > m_capacity) return std::nullopt;
+
+            m_head = end;
+            if (m_head - m_tail > m_peakUsedBytes) m_peakUsedBytes = m_head - m_tail;
+            return start % m_capacity;
+        }
+
+        // Ends the current frame: everything allocated since the last call is reclaimed once the fence reaches `fenceValue`.
+        void FinishFrame(uint64_t fenceValue)
+        {
+            if (!m_frames.empty() && m_frames.back().second == m_head) return;
+            m_frames.emplace_back(fenceValue, m_head);
+        }
+
+        // Reclaims the frames whose fence values have been reached.
+        void Reclaim(uint64_t completedFenceValue)
+        {
+            while (!m_frames.empty() && m_frames.front().first <= completedFenceValue)
+            {
+                m_tail = m_frames.front().second;
+                m_frames.pop_front();
+            }
+        }
+
+        // Reclaims everything. Only for when the GPU is idle, or the memory is being replaced.
+        void Reset(uint64_t capacity)
+        {
+            m_capacity = capacity;
+            m_frames.clear();
+            m_head = 0;
+            m_tail = 0;
+        }
+
+        // accessors
+
+        uint64_t Capacity() const { return m_capacity; }
+        uint64_t PeakUsedBytes() const { return m_peakUsedBytes; }
+        uint64_t UsedBytes() const { return m_head - m_tail; }
+    };
+}
@@ -0,0 +1,139 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DX
+{
+    // A fixed set of worker threads that run parallel-for loops. The calling thread takes
+    // part in each loop, so a pool with a thread count of 1 runs everything inline.
+    class WorkerPool final
+    {
+        // data members
+
+        std::condition_variable m_jobAvailable;
+        std::condition_variable m_jobFinished;
+        std::function<void(uint32_t, uint32_t)> const* m_pJob{ nullptr };
+        uint32_t m_jobCount{ 0 };
+        uint64_t m_jobGeneration{ 0 };
+        std::mutex m_mutex;
+        std::atomic<uint32_t> m_nextIndex{ 0 };
+        bool m_shuttingDown{ false };
+        std::vector<std::thread> m_threads;
+        uint32_t m_workersBusy{ 0 };
+
+        // Claims and runs indices until there are none left.
+        void Drain(std::function<void(uint32_t, uint32_t)> const& job, uint32_t count, uint32_t threadIndex)
+        {
+            for (uint32_t index{ m_nextIndex.fetch_add(1) }; index < count; index = m_nextIndex.fetch_add(1))
+            {
+                job(index, threadIndex);
+            }
+        }
+
+        void WorkerMain(uint32_t threadIndex)
+        {
+            uint64_t seenGeneration{ 0 };
+            for (;;)
+            {
+                std::function<void(uint32_t, uint32_t)> const* pJob{ nullptr };
+                uint32_t count{ 0 };
+                {
+                    std::unique_lock<std::mutex> lock{ m_mutex };
+                    m_jobAvailable.wait(lock, [&] { return m_shuttingDown || m_jobGeneration != seenGeneration; });
+                    if (m_shuttingDown) return;
+                    seenGeneration = m_jobGeneration;
+                    pJob = m_pJob;
+                    count = m_jobCount;
+                    ++m_workersBusy;
+                }
+
+                Drain(*pJob, count, threadIndex);
+
+                {
+                    std::lock_guard<std::mutex> lock{ m_mutex };
+                    if (--m_workersBusy == 0) m_jobFinished.notify_all();
+                }
+            }
+        }
+
+    public:
+        // A thread count of 0 means one thread per hardware thread.
+        WorkerPool(uint32_t threadCount = 0)
+        {
+            if (threadCount == 0) threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+            for (uint32_t threadIndex{ 1 }; threadIndex < threadCount; ++threadIndex)
+            {
+                m_threads.emplace_back(&WorkerPool::WorkerMain, this, threadIndex);
+            }
+        }
+
+        ~WorkerPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock{ m_mutex };
+                m_shuttingDown = true;
+            }
+            m_jobAvailable.notify_all();
+            for (auto& thread : m_threads)
+            {
+                thread.join();
+            }
+        }
+
+        WorkerPool(WorkerPool const&) = delete;
+        WorkerPool& operator=(WorkerPool const&) = delete;
+
+        // member functions
+
+        // Calls job(index, threadIndex) for each index in [0, count), and returns when all the calls
+        // have returned. threadIndex is in [0, ThreadCount()), and is 0 for the calling thread.
+        // Don't call ParallelFor from inside a job.
+        void ParallelFor(uint32_t count, std::function<void(uint32_t, uint32_t)> const& job)
+        {
+            if (count == 0) return;
+
+            m_nextIndex.store(0);
+            if (m_threads.empty() || count == 1)
+            {
+                Drain(job, count, 0);
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock{ m_mutex };
+                m_pJob = &job;
+                m_jobCount = count;
+                ++m_jobGeneration;
+            }
+            m_jobAvailable.notify_all();
+
+            Drain(job, count, 0);
+
+            std::unique_lock<std::mutex> lock{ m_mutex };
+            m_jobFinished.wait(lock, [&] { return m_workersBusy == 0 && m_nextIndex.load() >= count; });
+            m_pJob = nullptr;
+        }
+
+        // accessors
+
+        uint32_t ThreadCount() const { return static_cast<uint32_t>(m_threads.size()) + 1; }
+    };
+}
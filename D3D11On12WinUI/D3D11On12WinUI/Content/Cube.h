@@ -18,30 +18,28 @@ namespace winrt::D3D11On12WinUI
     class Cube final
     {
         static constexpr UINT s_alignedWvpConstantBufferSize{ (sizeof(WorldViewProjectionConstantBuffer) + 255) & ~255 }; // A constant buffer must be 256-byte aligned.
-        static inline D3D12_HEAP_PROPERTIES s_heapPropertiesUpload{ CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD) };
+        static constexpr uint32_t s_instancesPerJob{ 16384 }; // A multiple of 4, so that each job writes whole SIMD batches.
+        static constexpr uint32_t s_maxInstanceCount{ 1u << 22 }; // 256 MB of instance data per frame buffer.
 
         // data members
 
-        UINT m_cbvDescriptorSize{ 0 };
+        float m_animationSeconds{ 0.f };
+        uint64_t m_geometryUploadTicket{ 0 }; // The vertex and index buffers are usable once the copy queue reaches this.
         std::array<uint16_t, 36> m_indices;
-        unsigned char* m_pMappedWvpConstantBuffer{ nullptr };
+        DX::InstanceField m_instanceField;
+        uint64_t m_instanceUpdateNanoseconds{ 0 }; // CPU time spent writing the last frame's instance data.
+        std::unique_ptr<DX::WorkerPool> m_pWorkerPool; // Splits the instance data of large fields across threads.
         std::vector<VertexPositionNormalColor> m_vertices;
         Sample3DSceneRenderer & m_sample3DSceneRenderer;
         DirectX::XMFLOAT4X4 m_worldTransform;
-        std::array<WorldViewProjectionConstantBuffer, DX::DeviceResources::NumFramebuffers()> m_wvpConstantBufferDatas;
 
         // Direct3D data members
 
-        std::array<D3D12_GPU_DESCRIPTOR_HANDLE, DX::DeviceResources::NumFramebuffers()> m_gpuDescriptorHandleWvpCbv{};
         D3D12_INDEX_BUFFER_VIEW m_d3d12IndexView{};
+        D3D12_VERTEX_BUFFER_VIEW m_d3d12InstanceView{}; // The current frame's, in the upload ring.
         D3D12_VERTEX_BUFFER_VIEW m_d3d12VertexView{};
-        D3D12_GPU_DESCRIPTOR_HANDLE m_d3d12WvpConstantBufferGPUHandle{};
-        winrt::com_ptr<::ID3D12Resource> m_pD3D12IndexBufferUpload{};
-        winrt::com_ptr<::ID3D12Resource> m_pD3D12IndexResource;
-        winrt::com_ptr<::ID3D12Resource> m_pD3D12VertexBufferUpload{};
-        winrt::com_ptr<::ID3D12Resource> m_pD3D12VertexResource;
-        winrt::com_ptr<::ID3D12DescriptorHeap> m_pD3D12WvpCbvDescriptorHeap;
-        winrt::com_ptr<::ID3D12Resource> m_pD3D12WvpConstantBuffer;
+        DX::PlacedResource m_d3d12IndexResource;
+        DX::PlacedResource m_d3d12VertexResource;
 
     public:
         Cube(Sample3DSceneRenderer& sample3DSceneRenderer);
@@ -49,14 +47,24 @@ namespace winrt::D3D11On12WinUI
 
         // member functions
 
-        void CreateBuffers(winrt::com_ptr<::ID3D12GraphicsCommandList> const& pD3D12GraphicsCommandList);
+        void CreateBuffers();
         void ReleaseBuffers();
-        void ReleaseUploadBuffers();
-        void Render(winrt::com_ptr<::ID3D12GraphicsCommandList> const& pD3D12GraphicsCommandList);
+
+        // The frame graph's scene pass, recorded into the frame's command list (see
+        // Sample3DSceneRenderer::OpenCommandList): clears the back buffer and `depthStencil` (a transient), and draws.
+        void Render(winrt::com_ptr<::ID3D12GraphicsCommandList> const& pD3D12GraphicsCommandList, DX::D3D12FrameGraph::PassContext const& context, DX::FrameGraphResource depthStencil);
         void SetIAState(ID3D12GraphicsCommandList* pD3D12GraphicsCommandList) const;
 
+        // accessors
+
+        uint32_t InstanceCount() const { return m_instanceField.Count(); }
+        DX::InstanceField const& Instances() const { return m_instanceField; }
+        uint64_t InstanceUpdateNanoseconds() const { return m_instanceUpdateNanoseconds; }
+
         // mutators
 
+        void AnimationTime(float seconds) { m_animationSeconds = seconds; }
+        void InstanceCount(uint32_t instanceCount);
         void Rotation(DX::Vector3 const& rotation);
     };
 }
@@ -0,0 +1,28 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// The unit cube's geometry, with no Windows dependencies, so that the Cube class and the
+// headless tools draw exactly the same mesh.
+
+#include <array>
+#include <cstdint>
+
+namespace winrt::D3D11On12WinUI::CubeGeometry
+{
+    constexpr float r{ 0.5f };
+
+    // 24 vertices (4 per face), as x, y, z triples.
+    constexpr std::array<float, 72> Positions{ r, r, r, r, -r, r, -r, -r, r, -r, r, r, r, r, -r, r, -r, -r, r, -r, r, r, r, r, -r, r, -r, -r, -r, -r, r, -r, -r, r, r, -r, -r, r, r, -r, -r, r, -r, -r, -r, -r, r, -r, r, r, -r, r, r, r, -r, r, r, -r, r, -r, r, -r, r, r, -r, -r, -r, -r, -r, -r, -r, r };
+    constexpr std::array<float, 72> Normals{ 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 1, 0, -0, 1, 0, 0, 1, 0, -0, 1, 0, -0, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, -1, 0, -0, -1, -0, 0, -1, 0, -0, -1, 0, -0, 0, 1, 0, 0, 1, -0, 0, 1, 0, 0, 1, 0, -0, -1, 0, 0, -1, -0, -0, -1, 0, -0, -1, 0, };
+    constexpr std::array<uint16_t, 36> Indices{ 0, 1, 2, 0, 2, 3, 4, 5, 6, 4, 6, 7, 8, 9, 10, 8, 10, 11, 12, 13, 14, 12, 14, 15, 16, 17, 18, 16, 18, 19, 20, 21, 22, 20, 22, 23 };
+}
@@ -20,15 +20,97 @@ namespace winrt::D3D11On12WinUI
         m_pSampleTextRenderer = std::make_unique<SampleTextRenderer>(m_deviceResources);
     }
 
-    // Begin animating the cube.
-    void Sample3DSceneRenderer::Animate() {
-        m_animating = true;
-        m_stepTimer = DX::StepTimer();
-    };
+    // Sets the policy for choosing the adapter (GPU). Call before StartRenderLoop.
+    void Sample3DSceneRenderer::AdapterSelection(DX::AdapterPolicy const& adapterPolicy)
+    {
+        m_deviceResources.AdapterSelection(adapterPolicy);
+    }
+
+    // Begin animating the cube. Like the other public member functions that the UI thread
+    // calls, this posts a command, which the render thread applies at the start of its next frame.
+    void Sample3DSceneRenderer::Animate()
+    {
+        m_commandChannel.Post({ DX::RenderCommandType::Animate });
+        Wake();
+    }
+
+    // Applies, on the render thread, what the UI thread has posted since the last frame. Any
+    // number of size and DPI changes arrive as one, so the window-dependent setup is done once.
+    // Returns `true` if anything was applied.
+    bool Sample3DSceneRenderer::ApplyCommands()
+    {
+        bool applied{ false };
+        DX::RenderWindowChange windowChange;
+        if (m_commandChannel.TakeWindowChange(windowChange))
+        {
+            applied = true;
+            DirectX::XMFLOAT2 const outputSize{ windowChange.bounds.width, windowChange.bounds.height };
+            if (windowChange.dpiChanged)
+            {
+                m_deviceResources.DpiAndOutputSize(outputSize);
+            }
+            else
+            {
+                m_deviceResources.OutputSize(outputSize, true);
+            }
+            WindowDependentSetup();
+        }
+
+        bool cameraMoved{ false };
+        DX::RenderCommand command;
+        while (m_commandChannel.TryTake(command))
+        {
+            applied = true;
+            switch (command.type)
+            {
+            case DX::RenderCommandType::Animate:
+                m_animating = true;
+                m_stepTimer = DX::StepTimer();
+                break;
+            case DX::RenderCommandType::CameraOrbit:
+                m_cameraYawRadians += command.yawRadians;
+                m_cameraPitchRadians = std::clamp(m_cameraPitchRadians + command.pitchRadians, -1.4f, 1.4f);
+                cameraMoved = true;
+                break;
+            case DX::RenderCommandType::Invalidate:
+                break;
+            case DX::RenderCommandType::VisibilityChanged:
+                m_windowVisible = command.visible;
+                break;
+            }
+        }
+        if (cameraMoved) UpdateViewMatrix();
+        return applied;
+    }
+
+    // Creates the command list that each frame records into.
+    void Sample3DSceneRenderer::CommandListSetup()
+    {
+        DX::TraceSpan const span{ m_deviceResources.Trace(), "Sample3DSceneRenderer::CommandListSetup" };
+
+        auto pD3D12Device{ m_deviceResources.ID3D12Device() };
+
+        // Create the command list that each frame records into. OpenCommandList resets it (and
+        // the frame's allocator) before recording, so close it for now.
+        m_pD3D12GraphicsCommandList = nullptr;
+        winrt::check_hresult(
+            pD3D12Device->CreateCommandList(
+                0,
+                D3D12_COMMAND_LIST_TYPE_DIRECT,
+                m_deviceResources.ID3D12CommandAllocator(),
+                nullptr, // OpenCommandList sets the pipeline state when it resets the list.
+                __uuidof(m_pD3D12GraphicsCommandList),
+                m_pD3D12GraphicsCommandList.put_void()
+            )
+        );
+        winrt::check_hresult(m_pD3D12GraphicsCommandList->Close());
+    }
 
     void Sample3DSceneRenderer::CreateBuffers()
     {
-        m_pCube->CreateBuffers(m_pD3D12GraphicsCommandList);
+        DX::TraceSpan const span{ m_deviceResources.Trace(), "Sample3DSceneRenderer::CreateBuffers" };
+
+        m_pCube->CreateBuffers();
     }
 
     void Sample3DSceneRenderer::ReleaseBuffers()
@@ -36,38 +118,311 @@ namespace winrt::D3D11On12WinUI
         m_pCube->ReleaseBuffers();
     }
 
+    // Sets the swap chain's buffer count and maximum frame latency. Call before StartRenderLoop.
+    void Sample3DSceneRenderer::FrameLatency(DX::FrameLatencySettings const& frameLatencySettings)
+    {
+        m_deviceResources.FrameLatency(frameLatencySettings);
+    }
+
+    // Sets the number of cubes to draw (with one instanced draw). Call before StartRenderLoop.
+    void Sample3DSceneRenderer::InstanceCount(uint32_t instanceCount)
+    {
+        m_pCube->InstanceCount(instanceCount);
+        m_pSampleTextRenderer->InstanceCount(m_pCube->InstanceCount());
+    }
+
+    // Sleeps until a command is posted, rather than render a frame that would show nothing new
+    // (or that couldn't be seen). While occluded, it wakes now and then to look again. The
+    // timeouts also let the render loop notice that it's been canceled.
+    void Sample3DSceneRenderer::Idle(bool occluded)
+    {
+        uint64_t const startNanoseconds{ DX::QpcNowNanoseconds() };
+        ::WaitForSingleObjectEx(m_wakeEvent.get(), occluded ? 100 : 1000, FALSE);
+        m_deviceResources.Idled(DX::QpcNowNanoseconds() - startNanoseconds);
+    }
+
+    // Asks for a frame to be rendered, for when something that the render loop doesn't know
+    // about has changed what a frame would show. Can be called from any thread.
+    void Sample3DSceneRenderer::InvalidateContent()
+    {
+        m_commandChannel.Post({ DX::RenderCommandType::Invalidate });
+        Wake();
+    }
+
     // We queue dpi changes so that they happen on the right thread.
     void Sample3DSceneRenderer::OnDpiChanged(winrt::Rect const& bounds)
     {
-        m_onDpiChangedQueued = true;
-        m_queuedBounds = bounds;
+        m_commandChannel.PostDpiChanged({ bounds.X, bounds.Y, bounds.Width, bounds.Height });
+        Wake();
     }
 
     // We queue size changes so that they happen on the right thread.
     void Sample3DSceneRenderer::OnSizeChanged(winrt::Rect const& bounds)
     {
-        m_onSizeChangedQueued = true;
-        m_queuedBounds = bounds;
+        m_commandChannel.PostSizeChanged({ bounds.X, bounds.Y, bounds.Width, bounds.Height });
+        Wake();
+    }
+
+    // While the window is hidden, nothing is rendered.
+    void Sample3DSceneRenderer::OnVisibilityChanged(bool visible)
+    {
+        DX::RenderCommand command{ DX::RenderCommandType::VisibilityChanged };
+        command.visible = visible;
+        m_commandChannel.Post(command);
+        Wake();
+    }
+
+    // Starts recording the frame's command list, which every Direct3D 12 pass of the frame
+    // graph records into (see RenderFrame), and SubmitCommandList executes.
+    void Sample3DSceneRenderer::OpenCommandList()
+    {
+        // A command allocator can be reset only when its command lists have finished execution on the GPU.
+        winrt::check_hresult(m_deviceResources.ID3D12CommandAllocator()->Reset());
+
+        // The command list itself can be reset any time after ExecuteCommandLists is called.
+        winrt::check_hresult(m_pD3D12GraphicsCommandList->Reset(m_deviceResources.ID3D12CommandAllocator(), m_pD3D12PipelineState.get()));
+        m_resourceStates.Begin(m_pD3D12GraphicsCommandList.get());
+        m_deviceResources.BeginGpuFrame(m_pD3D12GraphicsCommandList.get());
+
+        // Every renderable's descriptors are in the device's one shader-visible heap.
+        ID3D12DescriptorHeap* pHeaps{ m_deviceResources.CbvSrvUavHeap() };
+        m_pD3D12GraphicsCommandList->SetDescriptorHeaps(1, &pHeaps);
+
+        // Set the viewport and scissor rectangle.
+        D3D12_VIEWPORT d3d12Viewport{ m_deviceResources.D3D12Viewport() };
+        m_pD3D12GraphicsCommandList->RSSetViewports(1, &d3d12Viewport);
+        D3D12_RECT d3d12ScissorRect{ m_deviceResources.D3D12ScissorRect() };
+        m_pD3D12GraphicsCommandList->RSSetScissorRects(1, &d3d12ScissorRect);
+    }
+
+    // Orbits the camera around the cube (for example, as the pointer is dragged).
+    void Sample3DSceneRenderer::OrbitCamera(float yawRadians, float pitchRadians)
+    {
+        m_commandChannel.Post({ DX::RenderCommandType::CameraOrbit, yawRadians, pitchRadians });
+        Wake();
+    }
+
+    // Sets the number of threads that record the Direct2D overlay (without --native-text) into command
+    // lists, while the render thread records the scene; 0 draws it on the render thread, with
+    // Direct2D single-threaded. Call before StartRenderLoop.
+    void Sample3DSceneRenderer::OverlayThreads(uint32_t overlayThreads)
+    {
+        m_deviceResources.MultithreadedDirect2D(overlayThreads > 0);
+        m_pSampleTextRenderer->OverlayThreads(overlayThreads);
+    }
+
+    // Creates the root signature and the fallback pipeline state, and requests the Phong
+    // pipeline state from the background compiler.
+    void Sample3DSceneRenderer::PipelineSetup()
+    {
+        DX::TraceSpan const span{ m_deviceResources.Trace(), "Sample3DSceneRenderer::PipelineSetup" };
+
+        // Create a root signature with a single constant buffer slot.
+        {
+            CD3DX12_DESCRIPTOR_RANGE range;
+            CD3DX12_ROOT_PARAMETER parameter;
+
+            range.Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0);
+            parameter.InitAsDescriptorTable(1, &range, D3D12_SHADER_VISIBILITY_VERTEX);
+
+            // Only the input assembler stage needs access to the constant buffer.
+            D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags{
+                D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT |
+                D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS |
+                D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS |
+                D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS |
+                D3D12_ROOT_SIGNATURE_FLAG_DENY_PIXEL_SHADER_ROOT_ACCESS };
+
+            CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc;
+            rootSignatureDesc.Init(1, &parameter, 0, nullptr, rootSignatureFlags);
+
+            // Serialized once, and then read back from the pipeline cache.
+            m_pD3D12RootSignature = m_deviceResources.Pipelines().RootSignature(rootSignatureDesc);
+        }
+
+        {
+            // Create the pipeline state now that the shaders are loaded.
+            CD3DX12_RASTERIZER_DESC rasterizerDesc({
+                /*FillMode*/ D3D12_FILL_MODE_SOLID,
+                /*CullMode*/ D3D12_CULL_MODE_BACK,
+                /*FrontCounterClockwise*/ FALSE,
+                /*DepthBias*/ D3D12_DEFAULT_DEPTH_BIAS,
+                /*DepthBiasClamp*/ D3D12_DEFAULT_DEPTH_BIAS_CLAMP,
+                /*SlopeScaledDepthBias*/ D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS,
+                /*DepthClipEnable*/ TRUE,
+                /*MultisampleEnable*/ FALSE,
+                /*AntialiasedLineEnable*/ FALSE,
+                /*ForcedSampleCount*/ 0 });
+
+            CD3DX12_BLEND_DESC blendDesc(D3D12_DEFAULT);
+
+            D3D12_GRAPHICS_PIPELINE_STATE_DESC d3d12GraphicsPipelineStateDesc{};
+            d3d12GraphicsPipelineStateDesc.InputLayout = VertexPositionNormalColor::D3D12InputLayoutDesc();
+            d3d12GraphicsPipelineStateDesc.pRootSignature = m_pD3D12RootSignature.get();
+            d3d12GraphicsPipelineStateDesc.VS = { m_phongVS.pData, m_phongVS.sizeInBytes };
+            d3d12GraphicsPipelineStateDesc.PS = { m_phongPS.pData, m_phongPS.sizeInBytes };
+            d3d12GraphicsPipelineStateDesc.RasterizerState = rasterizerDesc;
+            d3d12GraphicsPipelineStateDesc.BlendState = blendDesc;
+            d3d12GraphicsPipelineStateDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+            d3d12GraphicsPipelineStateDesc.SampleMask = UINT_MAX;
+            d3d12GraphicsPipelineStateDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+            d3d12GraphicsPipelineStateDesc.NumRenderTargets = 1;
+            d3d12GraphicsPipelineStateDesc.RTVFormats[0] = m_deviceResources.RTVFormat();
+            d3d12GraphicsPipelineStateDesc.DSVFormat = m_deviceResources.DSVFormat();
+            d3d12GraphicsPipelineStateDesc.SampleDesc.Count = 1;
+
+            // Compile the Phong pipeline in the background (on a cold start, or after a driver
+            // update, that can take long enough to be seen); meanwhile, the cube is drawn with a
+            // pipeline that's the same but for its small, unlit pixel shader, which is compiled now.
+            // The compile keeps the root signature alive, and saves the pipeline cache when it's done.
+            winrt::com_ptr<::ID3D12RootSignature> pD3D12RootSignature{ m_pD3D12RootSignature };
+            m_deviceResources.PipelineCompiles().Request(s_phongPipelineKey, [this, d3d12GraphicsPipelineStateDesc, pD3D12RootSignature]()
+                {
+                    winrt::com_ptr<::ID3D12PipelineState> pD3D12PipelineState{ m_deviceResources.Pipelines().GraphicsPipelineState(d3d12GraphicsPipelineStateDesc) };
+                    m_deviceResources.Pipelines().Save();
+                    InvalidateContent(); // Render a frame with it, even if nothing else has changed.
+                    return pD3D12PipelineState;
+                });
+
+            D3D12_GRAPHICS_PIPELINE_STATE_DESC fallbackPipelineStateDesc{ d3d12GraphicsPipelineStateDesc };
+            fallbackPipelineStateDesc.PS = { m_fallbackPS.pData, m_fallbackPS.sizeInBytes };
+            m_pD3D12FallbackPipelineState = m_deviceResources.Pipelines().GraphicsPipelineState(fallbackPipelineStateDesc);
+            m_pD3D12PipelineState = m_pD3D12FallbackPipelineState;
+        }
+
+        // The overlay's text pipeline, and its layer's composite.
+        m_pSampleTextRenderer->PipelineSetup(m_glyphVS, m_glyphPS, m_overlayVS, m_overlayPS);
+    }
+
+    // Renders and presents the frame, as a graph of passes (see FrameGraph): the scene clears the
+    // back buffer and draws into it, with a depth buffer that lives only as long as the pass
+    // needs it (so shares memory with any other transient that doesn't overlap it); Direct2D
+    // draws the overlay's text into the overlay layer through the 11On12 device, when it's
+    // changed, and the layer is composited over it (or, with --native-text, the text draws over
+    // it, in the same command list); and the frame is presented. A post-processing pass would read the scene from a
+    // transient, and write the back buffer.
+    // Returns `true` if successful; returns `false` if device lost.
+    bool Sample3DSceneRenderer::RenderFrame()
+    {
+        DX::D3D12TransientResources& transientResources{ m_deviceResources.TransientResources() };
+        SIZE const& renderTargetSize{ m_deviceResources.RenderTargetSize() };
+        bool presented{ false };
+
+        m_frameGraph.Reset();
+        DX::FrameGraphResource const backBuffer{ m_frameGraph.Import("BackBuffer", m_deviceResources.ID3D12RenderTarget(), DX::ResourceStates::Present) };
+        DX::FrameGraphResource depthStencil;
+        m_frameGraph.AddPass("Scene",
+            [&](DX::D3D12FrameGraph::Builder& builder)
+            {
+                builder.Write(backBuffer, DX::ResourceStates::RenderTarget);
+                DX::D3D12TransientDesc const depthDesc{ DX::D3D12TransientDesc::DepthStencil(m_deviceResources.DSVFormat(), (UINT)renderTargetSize.cx, (UINT)renderTargetSize.cy) };
+                D3D12_RESOURCE_ALLOCATION_INFO const allocationInfo{ transientResources.AllocationInfo(depthDesc) };
+                depthStencil = builder.Create("DepthStencil", depthDesc, allocationInfo.SizeInBytes, allocationInfo.Alignment, DX::ResourceStates::DepthWrite);
+            },
+            [&](DX::D3D12FrameGraph::PassContext const& context) { m_pCube->Render(m_pD3D12GraphicsCommandList, context, depthStencil); });
+
+        if (m_nativeText)
+        {
+            // The text's glyphs, in one instanced draw.
+            m_frameGraph.AddPass("Text",
+                [&](DX::D3D12FrameGraph::Builder& builder) { builder.Write(backBuffer, DX::ResourceStates::RenderTarget); },
+                [&](DX::D3D12FrameGraph::PassContext const& context)
+                {
+                    transientResources.BeginPass(context, m_resourceStates);
+                    if (m_labels) m_pSampleTextRenderer->UpdateLabels(m_pCube->Instances(), m_wvpConstantBufferData);
+                    m_pSampleTextRenderer->UpdateAndRender(m_pD3D12GraphicsCommandList.get(), m_resourceStates);
+                    DX::D3D12TransientResources::EndPass(context, m_resourceStates);
+                });
+        }
+        else
+        {
+            // Direct2D's drawing (if any) is submitted now, so it's on the queue ahead of the
+            // frame's command list, whose composite reads the layer. With overlay threads, they
+            // record it while the scene is recorded, and it's played back (and submitted) at the
+            // composite.
+            m_pSampleTextRenderer->UpdateOverlay();
+            DX::FrameGraphResource const overlayLayer{ m_frameGraph.Import("OverlayLayer", m_pSampleTextRenderer->OverlayLayer(), DX::ResourceStates::PixelShaderResource) };
+            m_frameGraph.AddPass("Overlay",
+                [&](DX::D3D12FrameGraph::Builder& builder)
+                {
+                    builder.Read(overlayLayer, DX::ResourceStates::PixelShaderResource);
+                    builder.Write(backBuffer, DX::ResourceStates::RenderTarget);
+                },
+                [&](DX::D3D12FrameGraph::PassContext const& context)
+                {
+                    transientResources.BeginPass(context, m_resourceStates);
+                    m_pSampleTextRenderer->CompositeOverlay(m_pD3D12GraphicsCommandList.get());
+                    DX::D3D12TransientResources::EndPass(context, m_resourceStates);
+                });
+        }
+        m_frameGraph.AddPass("Present",
+            [&](DX::D3D12FrameGraph::Builder& builder)
+            {
+                builder.Read(backBuffer, DX::ResourceStates::Present);
+                builder.SideEffects();
+            },
+            [&](DX::D3D12FrameGraph::PassContext const& context)
+            {
+                transientResources.BeginPass(context, m_resourceStates);
+                m_resourceStates.FlushBarriers();
+                SubmitCommandList();
+                presented = m_deviceResources.Present();
+            });
+
+        m_frameGraph.Compile();
+        transientResources.Realize(m_frameGraph);
+        OpenCommandList();
+        m_frameGraph.Execute();
+        return presented;
     }
 
     void Sample3DSceneRenderer::Reset()
     {
+        DX::TraceSpan const span{ m_deviceResources.Trace(), "Sample3DSceneRenderer::Reset" };
+
         m_renderLoopWorkItem.Cancel();
         m_renderLoopWorkItem = nullptr;
+        m_frameNeeded = true;
         m_deviceResources.MoveToNextFrame();
         WindowDependentReset();
         WindowIndependentReset();
     }
 
-    // We're independent of the main UI thread by this point.
-    winrt::fire_and_forget Sample3DSceneRenderer::SetupAsync()
+    // We're independent of the main UI thread by this point. Setup is a graph of tasks (see
+    // StartupGraph), so that what doesn't depend on the device (mapping the shaders, creating
+    // the factories) is done while it's created, and so on; on a pool of threads that lasts
+    // only as long as setup does.
+    void Sample3DSceneRenderer::Setup()
     {
-        winrt::apartment_context capturedCallingContext;
-        ShaderSetupAsync().get(); // Wait for the shaders to load before continuing setting up.
-        co_await capturedCallingContext; // Switch back to the calling context.
+        m_setupStartNanoseconds = DX::QpcNowNanoseconds();
+        DX::TraceSpan const span{ m_deviceResources.Trace(), "Sample3DSceneRenderer::Setup" };
+
+        DX::StartupGraph startupGraph;
+        DX::DeviceSetupTasks const deviceTasks{ m_deviceResources.WindowIndependentSetup(startupGraph) };
+        DX::StartupGraph::TaskId const shaders{ startupGraph.Add("Shaders", [this] { ShaderSetup(); }) };
+        startupGraph.Add("Pipelines", [this] { PipelineSetup(); }, { deviceTasks.device, shaders });
+        startupGraph.Add("CommandList", [this] { CommandListSetup(); }, { deviceTasks.deviceObjects });
+        DX::StartupGraph::TaskId const geometry{ startupGraph.Add("Geometry", [this] { CreateBuffers(); m_deviceResources.Uploads().Flush(); }, { deviceTasks.deviceObjects }) };
+        DX::StartupGraph::TaskId const text{ startupGraph.Add("Text", [this] { m_pSampleTextRenderer->WindowIndependentSetup(); }, { deviceTasks.d2dDevice }) };
+
+        // The swap chain's setup clears the Direct2D context's target (and Direct2D isn't
+        // free-threaded), and its depth buffer is placed in the shared heaps; so it comes after
+        // the other tasks that use those.
+        startupGraph.Add("SwapChain", [this] { WindowDependentSetup(); }, { text, geometry });
 
-        WindowIndependentSetup();
-        WindowDependentSetup();
+        {
+            DX::WorkerPool startupPool;
+            startupGraph.Run(startupPool);
+        }
+
+        // Save the pipelines created during setup, so the next run (or device) can start from them. (The
+        // Phong pipeline is compiled in the background, and saves again when its compile finishes.)
+        m_deviceResources.Pipelines().Save();
+
+        m_startupReport = startupGraph.Report();
+        m_startupPresentPending = true;
+        m_shaderAndwindowIndependentSetupDone = true;
+        Wake(); // The render loop may be idle, waiting for setup to finish.
     }
 
     void Sample3DSceneRenderer::SetWindowAndSwapChainPanel(winrt::Window const& window, HWND hWnd, winrt::SwapChainPanel const& swapChainPanel)
@@ -75,11 +430,27 @@ namespace winrt::D3D11On12WinUI
         m_deviceResources.SetWindowAndSwapChainPanel(window, hWnd, swapChainPanel);
     }
 
-    // Asynchronously load shaders.
-    winrt::IAsyncAction Sample3DSceneRenderer::ShaderSetupAsync()
+    // Map the shader archive (see ShaderArchive.h), and find the shaders in it. Nothing is read
+    // until pipeline creation touches the bytecode, and nothing is copied. The archive stays
+    // mapped across device resets, so this is done once.
+    void Sample3DSceneRenderer::ShaderSetup()
     {
-        m_fileBufferVS = co_await DX::ReadDataAsync(L"shader_vx_pos3norm3color3_phong.cso");
-        m_fileBufferPS = co_await DX::ReadDataAsync(L"shader_px_pos3norm3color3_phong.cso");
+        DX::TraceSpan const span{ m_deviceResources.Trace(), "Sample3DSceneRenderer::ShaderSetup" };
+
+        if (m_shaderArchiveFile.Data()) return;
+
+        std::filesystem::path const archivePath{ std::wstring{ winrt::Package::Current().InstalledLocation().Path() } + L"\\Shaders.shar" };
+        if (!m_shaderArchiveFile.Open(archivePath)) winrt::throw_last_error();
+        if (m_shaderArchive.Open(m_shaderArchiveFile.Data(), m_shaderArchiveFile.Size()) != DX::ShaderArchiveOpenResult::Opened) winrt::throw_hresult(HRESULT_FROM_WIN32(ERROR_FILE_CORRUPT));
+
+        m_phongVS = m_shaderArchive.Find("shader_vx_pos3norm3color3_phong");
+        m_phongPS = m_shaderArchive.Find("shader_px_pos3norm3color3_phong");
+        m_fallbackPS = m_shaderArchive.Find("shader_px_pos3norm3color3_flat");
+        m_glyphVS = m_shaderArchive.Find("shader_vx_glyph");
+        m_glyphPS = m_shaderArchive.Find("shader_px_glyph");
+        m_overlayVS = m_shaderArchive.Find("shader_vx_overlay");
+        m_overlayPS = m_shaderArchive.Find("shader_px_overlay");
+        if (!m_phongVS || !m_phongPS || !m_fallbackPS || !m_glyphVS || !m_glyphPS || !m_overlayVS || !m_overlayPS) winrt::throw_hresult(HRESULT_FROM_WIN32(ERROR_FILE_CORRUPT));
     }
 
     void Sample3DSceneRenderer::StartRenderLoop(bool settingUp)
@@ -95,7 +466,7 @@ namespace winrt::D3D11On12WinUI
             {
                 if (settingUp)
                 {
-                    SetupAsync();
+                    Setup();
                 }
 
                 // Calculate the updated frame, and render once per vertical blanking interval.
@@ -109,63 +480,110 @@ namespace winrt::D3D11On12WinUI
         m_renderLoopWorkItem = winrt::ThreadPool::RunAsync(workItemHandler, WorkItemPriority::High, WorkItemOptions::TimeSliced);
     }
 
+    // Ends the frame's command list, and executes it, after the barriers that bring its
+    // resources from the states that earlier lists left them in.
+    void Sample3DSceneRenderer::SubmitCommandList()
+    {
+        m_deviceResources.EndGpuFrame(m_pD3D12GraphicsCommandList.get());
+        m_resourceStates.Close();
+        m_deviceResources.ResourceStates().ExecuteCommandList(m_deviceResources.ID3D12CommandQueue(), m_deviceResources.ID3D12CommandAllocator(), m_resourceStates);
+    }
+
     // Update the application state once per frame.
     void Sample3DSceneRenderer::UpdateAndRender()
     {
-        if (m_onDpiChangedQueued)
-        {
-            m_onDpiChangedQueued = false;
-            m_deviceResources.DpiAndOutputSize({ m_queuedBounds.Width, m_queuedBounds.Height });
-            WindowDependentSetup();
-        }
-        if (m_onSizeChangedQueued)
+        if (ApplyCommands()) m_frameNeeded = true;
+
+        if (!m_shaderAndwindowIndependentSetupDone)
         {
-            m_onSizeChangedQueued = false;
-            m_deviceResources.OutputSize({ m_queuedBounds.Width, m_queuedBounds.Height }, true);
-            WindowDependentSetup();
+            ::WaitForSingleObjectEx(m_wakeEvent.get(), 1000, FALSE);
+            return;
         }
 
-        if (m_shaderAndwindowIndependentSetupDone)
+        // Don't present what can't be seen; and, when rendering on demand, don't render a frame
+        // that would be the same as the last one. Once the window can be seen again, render.
+        bool const occluded{ !m_windowVisible || m_deviceResources.Occluded() };
+        if (occluded) m_frameNeeded = true;
+        if (occluded || (m_renderOnDemand && !m_animating && !m_frameNeeded))
         {
-            if (m_animating)
-            {
-                m_pCube->Rotation({ -sinf(m_stepTimer.TotalSeconds() / 3) / 2, sinf(m_stepTimer.TotalSeconds()), -sinf(m_stepTimer.TotalSeconds() / 3) / 4 });
-            }
-
-            m_pCube->Render(m_pD3D12GraphicsCommandList);
+            Idle(occluded);
+            return;
+        }
+        m_frameNeeded = false;
 
-            ::ID3D11Resource* pWrappedRenderTarget = m_deviceResources.AcquireWrappedRenderTarget();
+        // Wait (on the swap chain's frame-latency waitable object) before sampling the
+        // animation and recording, rather than inside Present afterward.
+        m_deviceResources.WaitForNextFrame();
 
-            m_pSampleTextRenderer->UpdateAndRender();
+        if (m_animating)
+        {
+            float const totalSeconds{ m_stepTimer.TotalSeconds() };
+            m_pCube->Rotation({ -sinf(totalSeconds / 3) / 2, sinf(totalSeconds), -sinf(totalSeconds / 3) / 4 });
+            m_pCube->AnimationTime(totalSeconds);
+        }
 
-            if (!m_deviceResources.ReleaseWrappedRenderTargetAndPresent(pWrappedRenderTarget))
-            {
-                m_shaderAndwindowIndependentSetupDone = false;
-                Reset();
-                StartRenderLoop(true);
-            }
+        UpdatePipelineState();
+        if (!RenderFrame())
+        {
+            m_shaderAndwindowIndependentSetupDone = false;
+            Reset();
+            StartRenderLoop(true);
+        }
+        else if (m_startupPresentPending)
+        {
+            // Report what bounded the time to this, the first frame since setup.
+            m_startupPresentPending = false;
+            m_startupReport.firstPresentMilliseconds = (DX::QpcNowNanoseconds() - m_setupStartNanoseconds) / 1e6;
+            ::OutputDebugStringA((m_startupReport.ToString() + "\n").c_str());
+            m_deviceResources.Trace().Instant("FirstPresent");
+            m_deviceResources.SaveTrace();
+            m_pSampleTextRenderer->Startup(m_startupReport);
+            InvalidateContent(); // Show it.
         }
     }
 
+    // Draws with the Phong pipeline once it has compiled, and with the fallback until then. The
+    // render thread never waits for a compile.
+    void Sample3DSceneRenderer::UpdatePipelineState()
+    {
+        DX::D3D12PipelineCompiler& pipelineCompiles{ m_deviceResources.PipelineCompiles() };
+        pipelineCompiles.Poll();
+        winrt::com_ptr<::ID3D12PipelineState> const* ppD3D12PipelineState{ pipelineCompiles.Acquire(s_phongPipelineKey) };
+        m_pD3D12PipelineState = ppD3D12PipelineState ? *ppD3D12PipelineState : m_pD3D12FallbackPipelineState;
+    }
+
     void Sample3DSceneRenderer::UpdateViewMatrix()
     {
+        // The camera orbits the origin, where the cube is.
+        DirectX::XMMATRIX const orbit{ DirectX::XMMatrixRotationRollPitchYaw(m_cameraPitchRadians, m_cameraYawRadians, 0.f) };
+
         DirectX::XMStoreFloat4x4(
             &m_wvpConstantBufferData.view,
             DirectX::XMMatrixTranspose(DirectX::XMMatrixLookToRH(
-                { -.3f, 0.f, 1.7f }, // EyePosition
-                { 0.f, 0.f, -1.f }, // EyeDirection
-                { 0.f, 1.f, 0.f })) // UpDirection
+                DirectX::XMVector3Transform({ -.3f, 0.f, 1.7f }, orbit), // EyePosition
+                DirectX::XMVector3TransformNormal({ 0.f, 0.f, -1.f }, orbit), // EyeDirection
+                DirectX::XMVector3TransformNormal({ 0.f, 1.f, 0.f }, orbit))) // UpDirection
         );
     }
 
+    // Wakes the render loop if it's idle. Call after posting a command.
+    void Sample3DSceneRenderer::Wake()
+    {
+        ::SetEvent(m_wakeEvent.get());
+    }
+
     void Sample3DSceneRenderer::WindowDependentReset()
     {
+        DX::TraceSpan const span{ m_deviceResources.Trace(), "Sample3DSceneRenderer::WindowDependentReset" };
+
         m_deviceResources.WindowDependentReset();
     }
 
     // Initializes view parameters when the window size changes.
     void Sample3DSceneRenderer::WindowDependentSetup()
     {
+        DX::TraceSpan const span{ m_deviceResources.Trace(), "Sample3DSceneRenderer::WindowDependentSetup" };
+
         m_deviceResources.WindowDependentSetup();
         m_deviceResources.SetSwapChainOnSwapChainPanelAsync();
 
@@ -190,127 +608,14 @@ namespace winrt::D3D11On12WinUI
 
     void Sample3DSceneRenderer::WindowIndependentReset()
     {
+        DX::TraceSpan const span{ m_deviceResources.Trace(), "Sample3DSceneRenderer::WindowIndependentReset" };
+
         ReleaseBuffers();
         m_pD3D12GraphicsCommandList = nullptr;
+        m_pD3D12FallbackPipelineState = nullptr;
         m_pD3D12PipelineState = nullptr;
         m_pD3D12RootSignature = nullptr;
         m_pSampleTextRenderer->WindowIndependentReset();
         m_deviceResources.WindowIndependentReset();
     }
-
-    // Does setup work that depends on the D3D device, but doesn't depend on the window.
-    void Sample3DSceneRenderer::WindowIndependentSetup()
-    {
-        m_deviceResources.WindowIndependentSetup();
-        m_pSampleTextRenderer->WindowIndependentSetup();
-
-        auto pD3D12Device{ m_deviceResources.ID3D12Device() };
-
-        // Create a root signature with a single constant buffer slot.
-        {
-            CD3DX12_DESCRIPTOR_RANGE range;
-            CD3DX12_ROOT_PARAMETER parameter;
-
-            range.Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0);
-            parameter.InitAsDescriptorTable(1, &range, D3D12_SHADER_VISIBILITY_VERTEX);
-
-            // Only the input assembler stage needs access to the constant buffer.
-            D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags{
-                D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT |
-                D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS |
-                D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS |
-                D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS |
-                D3D12_ROOT_SIGNATURE_FLAG_DENY_PIXEL_SHADER_ROOT_ACCESS };
-
-            CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc;
-            rootSignatureDesc.Init(1, &parameter, 0, nullptr, rootSignatureFlags);
-
-            winrt::com_ptr<::ID3DBlob> pSignature;
-            winrt::com_ptr<::ID3DBlob> pError;
-
-            winrt::check_hresult(
-                ::D3D12SerializeRootSignature(
-                    &rootSignatureDesc,
-                    D3D_ROOT_SIGNATURE_VERSION_1,
-                    pSignature.put(),
-                    pError.put()
-                )
-            );
-
-            winrt::check_hresult(
-                pD3D12Device->CreateRootSignature(
-                    0,
-                    pSignature->GetBufferPointer(),
-                    pSignature->GetBufferSize(),
-                    _uuidof(m_pD3D12RootSignature),
-                    m_pD3D12RootSignature.put_void()
-                )
-            );
-        }
-
-        {
-            // Create the pipeline state now that the shaders are loaded.
-            CD3DX12_RASTERIZER_DESC rasterizerDesc({
-                /*FillMode*/ D3D12_FILL_MODE_SOLID,
-                /*CullMode*/ D3D12_CULL_MODE_BACK,
-                /*FrontCounterClockwise*/ FALSE,
-                /*DepthBias*/ D3D12_DEFAULT_DEPTH_BIAS,
-                /*DepthBiasClamp*/ D3D12_DEFAULT_DEPTH_BIAS_CLAMP,
-                /*SlopeScaledDepthBias*/ D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS,
-                /*DepthClipEnable*/ TRUE,
-                /*MultisampleEnable*/ FALSE,
-                /*AntialiasedLineEnable*/ FALSE,
-                /*ForcedSampleCount*/ 0 });
-
-            CD3DX12_BLEND_DESC blendDesc(D3D12_DEFAULT);
-
-            D3D12_GRAPHICS_PIPELINE_STATE_DESC d3d12GraphicsPipelineStateDesc{};
-            d3d12GraphicsPipelineStateDesc.InputLayout = VertexPositionNormalColor::D3D12InputLayoutDesc();
-            d3d12GraphicsPipelineStateDesc.pRootSignature = m_pD3D12RootSignature.get();
-            d3d12GraphicsPipelineStateDesc.VS = { m_fileBufferVS.data(), m_fileBufferVS.Length() };
-            d3d12GraphicsPipelineStateDesc.PS = { m_fileBufferPS.data(), m_fileBufferPS.Length() };
-            d3d12GraphicsPipelineStateDesc.RasterizerState = rasterizerDesc;
-            d3d12GraphicsPipelineStateDesc.BlendState = blendDesc;
-            d3d12GraphicsPipelineStateDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
-            d3d12GraphicsPipelineStateDesc.SampleMask = UINT_MAX;
-            d3d12GraphicsPipelineStateDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-            d3d12GraphicsPipelineStateDesc.NumRenderTargets = 1;
-            d3d12GraphicsPipelineStateDesc.RTVFormats[0] = m_deviceResources.RTVFormat();
-            d3d12GraphicsPipelineStateDesc.DSVFormat = m_deviceResources.DSVFormat();
-            d3d12GraphicsPipelineStateDesc.SampleDesc.Count = 1;
-
-            m_pD3D12PipelineState = nullptr;
-            winrt::check_hresult(m_deviceResources.ID3D12Device()->CreateGraphicsPipelineState(&d3d12GraphicsPipelineStateDesc, __uuidof(m_pD3D12PipelineState), m_pD3D12PipelineState.put_void()));
-
-            // Create and upload cube geometry resources to the GPU.
-
-            // Create a command list.
-            m_pD3D12GraphicsCommandList = nullptr;
-            winrt::check_hresult(
-                pD3D12Device->CreateCommandList(
-                    0,
-                    D3D12_COMMAND_LIST_TYPE_DIRECT,
-                    m_deviceResources.ID3D12CommandAllocator(),
-                    m_pD3D12PipelineState.get(),
-                    __uuidof(m_pD3D12GraphicsCommandList),
-                    m_pD3D12GraphicsCommandList.put_void()
-                )
-            );
-        }
-
-        CreateBuffers();
-
-        // Close the command list, and execute it to begin the vertex/index buffer copy into the GPU's default heap.
-        winrt::check_hresult(m_pD3D12GraphicsCommandList->Close());
-
-        ID3D12CommandList* pCommandList{ m_pD3D12GraphicsCommandList.get() };
-        m_deviceResources.ID3D12CommandQueue()->ExecuteCommandLists(1, &pCommandList);
-
-        // Wait for the command list to finish executing, because the vertex/index
-        // buffers need to be uploaded to the GPU before releasing the upload resources.
-        m_deviceResources.WaitForGpu();
-        m_pCube->ReleaseUploadBuffers();
-
-        m_shaderAndwindowIndependentSetupDone = true;
-    }
 }
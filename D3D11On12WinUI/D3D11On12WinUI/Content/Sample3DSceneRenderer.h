@@ -15,40 +15,69 @@ namespace winrt::D3D11On12WinUI
 {
     class Sample3DSceneRenderer final
     {
+        static constexpr uint64_t s_phongPipelineKey{ 1 }; // The cube's pipeline, in the device's PipelineCompiles().
+
         // data members
 
         bool m_animating{ false };
+        bool m_frameNeeded{ true }; // Something has changed since the last frame was presented.
+        float m_cameraPitchRadians{ 0.f };
+        float m_cameraYawRadians{ 0.f };
         UINT m_cbvDescriptorSize{ 0 };
+        DX::RenderCommandChannel m_commandChannel; // From the UI thread to the render thread.
         DX::DeviceResources m_deviceResources;
-        winrt::IBuffer m_fileBufferPS{ nullptr };
-        winrt::IBuffer m_fileBufferVS{ nullptr };
-        bool m_onDpiChangedQueued{ false };
-        bool m_onSizeChangedQueued{ false };
+        DX::ShaderBlob m_fallbackPS; // In m_shaderArchive, as are the Phong shaders.
+        DX::D3D12FrameGraph m_frameGraph; // Rebuilt each frame (see RenderFrame).
+        DX::ShaderBlob m_glyphPS; // The overlay's text, when it's drawn with Direct3D 12 (see D3D12GlyphRenderer).
+        DX::ShaderBlob m_glyphVS;
+        bool m_labels{ false }; // Label the cubes with their numbers, as many as fit without overlapping (with native text).
+        bool m_nativeText{ false }; // Draw the overlay's text with Direct3D 12, rather than with Direct2D through 11On12.
+        DX::ShaderBlob m_overlayPS; // The overlay layer's composite, when the text is drawn with Direct2D (see D3D12OverlayLayer).
+        DX::ShaderBlob m_overlayVS;
+        DX::ShaderBlob m_phongPS;
+        DX::ShaderBlob m_phongVS;
         std::unique_ptr<Cube> m_pCube{ nullptr };
         std::unique_ptr<SampleTextRenderer> m_pSampleTextRenderer{ nullptr };
-        winrt::Rect m_queuedBounds{ 0.f, 0.f, 0.f, 0.f };
         winrt::IAsyncAction m_renderLoopWorkItem{ nullptr };
+        bool m_renderOnDemand{ true }; // Render only when something has changed, rather than every vblank.
+        uint64_t m_setupStartNanoseconds{ 0 };
         bool m_shaderAndwindowIndependentSetupDone{ false };
+        DX::ShaderArchiveReader m_shaderArchive;
+        DX::MappedFile m_shaderArchiveFile; // Mapped for the life of the renderer; the blobs point into it.
+        bool m_startupPresentPending{ false }; // Setup has finished, and no frame has been presented since.
+        DX::StartupReport m_startupReport; // Of the last setup.
         DX::StepTimer m_stepTimer;
+        winrt::handle m_wakeEvent{ ::CreateEventW(nullptr, FALSE, FALSE, nullptr) }; // Set when a command is posted.
+        bool m_windowVisible{ true };
         WorldViewProjectionConstantBuffer m_wvpConstantBufferData;
 
         // Direct3D data members
 
         winrt::com_ptr<::ID3D12GraphicsCommandList> m_pD3D12GraphicsCommandList;
-        winrt::com_ptr<::ID3D12PipelineState> m_pD3D12PipelineState;
+        winrt::com_ptr<::ID3D12PipelineState> m_pD3D12FallbackPipelineState; // Drawn with until the Phong pipeline is compiled.
+        winrt::com_ptr<::ID3D12PipelineState> m_pD3D12PipelineState; // This frame's.
         winrt::com_ptr<::ID3D12RootSignature> m_pD3D12RootSignature;
+        DX::D3D12CommandListStates m_resourceStates; // Of the frame's command list.
 
         // member functions
 
+        bool ApplyCommands();
+        void CommandListSetup();
         void CreateBuffers();
+        void Idle(bool occluded);
+        void OpenCommandList();
+        void PipelineSetup();
         void ReleaseBuffers();
+        bool RenderFrame();
         void Reset();
-        winrt::fire_and_forget SetupAsync();
-        winrt::IAsyncAction ShaderSetupAsync();
+        void Setup();
+        void ShaderSetup();
+        void SubmitCommandList();
         void UpdateAndRender();
+        void UpdatePipelineState();
         void UpdateViewMatrix();
+        void Wake();
         void WindowIndependentReset();
-        void WindowIndependentSetup();
         void WindowDependentReset();
         void WindowDependentSetup();
 
@@ -57,15 +86,24 @@ namespace winrt::D3D11On12WinUI
 
         // member functions
 
+        void AdapterSelection(DX::AdapterPolicy const& adapterPolicy);
         void Animate();
+        void FrameLatency(DX::FrameLatencySettings const& frameLatencySettings);
+        void InstanceCount(uint32_t instanceCount);
+        void InvalidateContent();
         void OnDpiChanged(winrt::Rect const& bounds);
         void OnSizeChanged(winrt::Rect const& bounds);
+        void OnVisibilityChanged(bool visible);
+        void OrbitCamera(float yawRadians, float pitchRadians);
+        void OverlayThreads(uint32_t overlayThreads);
         void SetWindowAndSwapChainPanel(winrt::Window const& window, HWND hWnd, winrt::SwapChainPanel const& swapChainPanel);
         void StartRenderLoop(bool settingUp = true);
 
         // accessors
 
         DX::DeviceResources const& DeviceResources() const { return m_deviceResources; };
+        DX::DeviceResources& DeviceResources() { return m_deviceResources; };
+        DX::D3D12CommandListStates& ResourceStates() { return m_resourceStates; }
         WorldViewProjectionConstantBuffer const& WvpConstantBufferData() { return m_wvpConstantBufferData; }
 
         // Direct3D accessors
@@ -76,6 +114,10 @@ namespace winrt::D3D11On12WinUI
 
         // mutators
 
+        // Call before StartRenderLoop.
+        void Labels(bool labels) { m_labels = labels; }
+        void NativeText(bool nativeText) { m_nativeText = nativeText; }
+        void RenderOnDemand(bool renderOnDemand) { m_renderOnDemand = renderOnDemand; }
         void WorldTransform(DirectX::XMFLOAT4X4 const& worldTransform) { m_wvpConstantBufferData.world = worldTransform; }
     };
 }
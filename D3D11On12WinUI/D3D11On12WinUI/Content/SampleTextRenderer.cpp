@@ -13,39 +13,155 @@
 
 namespace winrt::D3D11On12WinUI
 {
-    SampleTextRenderer::SampleTextRenderer(DX::DeviceResources const& deviceResources) :
-        m_deviceResources{ deviceResources }
+    SampleTextRenderer::SampleTextRenderer(DX::DeviceResources& deviceResources) :
+        m_deviceResources{ deviceResources },
+        m_glyphs{ deviceResources },
+        m_overlay{ deviceResources }
     {
     }
 
-    // Update the text to be displayed, and render a frame to the screen.
-    void SampleTextRenderer::UpdateAndRender()
+    // Each line is laid out on its own, so that only the lines that have changed are laid out
+    // again; the rest (most of them, most frames) come from the cache.
+    template <typename Draw>
+    void SampleTextRenderer::DrawLines(std::wstring_view text, Draw&& draw)
     {
-        std::wstring text{ L"Direct3D 11-on-12 and WinUI XAML sample" };
-        DirectX::XMFLOAT2 outputSizeInDIPs{ m_deviceResources.OutputSizeInDIPs() };
+        DirectX::XMFLOAT2 const outputSizeInDIPs{ m_deviceResources.OutputSizeInDIPs() };
+        m_layouts.LayoutBox({ outputSizeInDIPs.x, outputSizeInDIPs.y, m_deviceResources.Dpi().x });
+        uint64_t const format{ reinterpret_cast<uintptr_t>(m_pDWriteTextFormat.get()) };
+        auto layOut = [&](std::wstring_view line)
+            {
+                winrt::com_ptr<IDWriteTextLayout> pDWriteTextLayout;
+                winrt::check_hresult(
+                    m_deviceResources.IDWriteFactory2()->CreateTextLayout(
+                        line.data(),
+                        (uint32_t)line.length(),
+                        m_pDWriteTextFormat.get(),
+                        outputSizeInDIPs.x, // Max width of the input text.
+                        outputSizeInDIPs.y, // Max height of the input text.
+                        pDWriteTextLayout.put()
+                    )
+                );
+                return pDWriteTextLayout;
+            };
+
+        float top{ 0.f };
+        for (size_t begin{ 0 }; begin <= text.length();)
+        {
+            size_t const end{ std::min(text.find(L'\n', begin), text.length()) };
+            winrt::com_ptr<IDWriteTextLayout> const pDWriteTextLayout{ m_layouts.Find(text.substr(begin, end - begin), format, layOut) };
+            draw(pDWriteTextLayout.get(), top);
+
+            DWRITE_TEXT_METRICS metrics{};
+            winrt::check_hresult(pDWriteTextLayout->GetMetrics(&metrics));
+            top += metrics.height;
+            begin = end + 1;
+        }
+    }
+
+    // Each placed label is drawn as a glyph run, a digit per cell of the widest digit's advance,
+    // with the text's glyphs (and so in the same instanced draw).
+    void SampleTextRenderer::DrawLabels()
+    {
+        std::array<uint16_t, 10> glyphIndices{}; // Enough for any uint32_t.
+        std::array<float, 10> glyphAdvances{};
+        glyphAdvances.fill(m_labelDigitAdvance);
+        for (DX::LabelPlacement const& placement : m_labelDeclutter.Placements())
+        {
+            uint32_t glyphCount{ 0 };
+            uint32_t number{ placement.label };
+            do
+            {
+                glyphIndices[glyphCount++] = m_labelDigitGlyphs[number % 10];
+                number /= 10;
+            } while (number != 0);
+            std::reverse(glyphIndices.begin(), glyphIndices.begin() + glyphCount);
+
+            DWRITE_GLYPH_RUN const glyphRun{ m_pDWriteLabelFontFace.get(), s_labelEmSize, glyphCount, glyphIndices.data(), glyphAdvances.data(), nullptr, FALSE, 0 };
+            m_glyphs.AddGlyphRun(placement.left + s_labelPadding, placement.top + s_labelPadding + m_labelAscent, DWRITE_MEASURING_MODE_NATURAL, glyphRun, 0xff00ffff); // Yellow.
+        }
+    }
 
-        m_pDWriteTextLayout = nullptr;
+    // There are too many different labels (one per cube) to lay out, or to cache the layouts of,
+    // so they're drawn with the text format's font directly, from the digits' glyphs and metrics.
+    void SampleTextRenderer::LabelFontSetup()
+    {
+        winrt::com_ptr<IDWriteFontCollection> pDWriteFontCollection;
+        winrt::check_hresult(m_deviceResources.IDWriteFactory2()->GetSystemFontCollection(pDWriteFontCollection.put(), FALSE));
+
+        wchar_t familyName[LF_FACESIZE]{};
+        winrt::check_hresult(m_pDWriteTextFormat->GetFontFamilyName(familyName, LF_FACESIZE));
+        UINT32 familyIndex{ 0 };
+        BOOL familyExists{ FALSE };
+        winrt::check_hresult(pDWriteFontCollection->FindFamilyName(familyName, &familyIndex, &familyExists));
+        winrt::com_ptr<IDWriteFontFamily> pDWriteFontFamily;
+        winrt::check_hresult(pDWriteFontCollection->GetFontFamily(familyExists ? familyIndex : 0, pDWriteFontFamily.put()));
+        winrt::com_ptr<IDWriteFont> pDWriteFont;
         winrt::check_hresult(
-            m_deviceResources.IDWriteFactory2()->CreateTextLayout(
-                text.c_str(),
-                (uint32_t)text.length(),
-                m_pDWriteTextFormat.get(),
-                outputSizeInDIPs.x, // Max width of the input text.
-                outputSizeInDIPs.y, // Max height of the input text.
-                m_pDWriteTextLayout.put()
+            pDWriteFontFamily->GetFirstMatchingFont(
+                m_pDWriteTextFormat->GetFontWeight(),
+                m_pDWriteTextFormat->GetFontStretch(),
+                m_pDWriteTextFormat->GetFontStyle(),
+                pDWriteFont.put()
             )
         );
+        winrt::check_hresult(pDWriteFont->CreateFontFace(m_pDWriteLabelFontFace.put()));
+
+        std::array<UINT32, 10> codePoints{};
+        for (UINT32 digit{ 0 }; digit < 10; ++digit) codePoints[digit] = L'0' + digit;
+        winrt::check_hresult(m_pDWriteLabelFontFace->GetGlyphIndices(codePoints.data(), 10, m_labelDigitGlyphs.data()));
+        std::array<DWRITE_GLYPH_METRICS, 10> glyphMetrics{};
+        winrt::check_hresult(m_pDWriteLabelFontFace->GetDesignGlyphMetrics(m_labelDigitGlyphs.data(), 10, glyphMetrics.data(), FALSE));
 
-        ID2D1DeviceContext1* pContext{ m_deviceResources.ID2D1DeviceContext1() };
+        DWRITE_FONT_METRICS fontMetrics{};
+        m_pDWriteLabelFontFace->GetMetrics(&fontMetrics);
+        float const dipsPerDesignUnit{ s_labelEmSize / fontMetrics.designUnitsPerEm };
+        UINT32 widestAdvance{ 0 };
+        for (DWRITE_GLYPH_METRICS const& metrics : glyphMetrics) widestAdvance = std::max(widestAdvance, metrics.advanceWidth);
+        m_labelDigitAdvance = widestAdvance * dipsPerDesignUnit;
+        m_labelAscent = fontMetrics.ascent * dipsPerDesignUnit;
+        m_labelHeight = (fontMetrics.ascent + fontMetrics.descent) * dipsPerDesignUnit;
+    }
 
+    // Plays back what the threads recorded before it's composited; recording it is what's off the
+    // render thread, and whatever of it the scene took longer to record than.
+    void SampleTextRenderer::CompositeOverlay(::ID3D12GraphicsCommandList* pD3D12GraphicsCommandList)
+    {
+        if (m_pOverlayRecorder && m_pOverlayRecorder->Recording()) PlayBackOverlay();
+        m_overlay.Composite(pD3D12GraphicsCommandList);
+    }
+
+    // Creates the glyph renderer's pipeline, and the overlay layer's composite (Direct2D has none of its own).
+    void SampleTextRenderer::PipelineSetup(DX::ShaderBlob const& glyphVS, DX::ShaderBlob const& glyphPS, DX::ShaderBlob const& overlayVS, DX::ShaderBlob const& overlayPS)
+    {
+        m_glyphs.PipelineSetup(glyphVS, glyphPS);
+        m_overlay.PipelineSetup(overlayVS, overlayPS);
+    }
+
+    // Draws each thread's command list, in order, into the overlay layer.
+    void SampleTextRenderer::PlayBackOverlay()
+    {
+        uint64_t const startNanoseconds{ DX::QpcNowNanoseconds() };
+        std::vector<winrt::com_ptr<ID2D1CommandList>>& commandLists{ m_pOverlayRecorder->Collect() };
+        uint64_t const playbackNanoseconds{ DX::QpcNowNanoseconds() };
+        RasterizeOverlay([&](ID2D1DeviceContext1* pContext)
+            {
+                for (winrt::com_ptr<ID2D1CommandList> const& pD2D1CommandList : commandLists) pContext->DrawImage(pD2D1CommandList.get());
+            });
+        commandLists.clear();
+
+        uint64_t const endNanoseconds{ DX::QpcNowNanoseconds() };
+        m_pOverlayRecorder->PlayedBack(endNanoseconds - playbackNanoseconds);
+        m_overlayNanoseconds += endNanoseconds - startNanoseconds;
+    }
+
+    template <typename Draw>
+    void SampleTextRenderer::RasterizeOverlay(Draw&& draw)
+    {
+        ID2D1DeviceContext1* pContext{ m_overlay.BeginRasterize() };
         pContext->SaveDrawingState(m_pD2D1StateBlock.get());
         pContext->BeginDraw();
-
-        pContext->DrawTextLayout(
-            D2D1::Point2F(3.f, 0.f),
-            m_pDWriteTextLayout.get(),
-            m_pD2D1WhiteBrush.get()
-        );
+        pContext->Clear(D2D1::ColorF(0.f, 0.f, 0.f, 0.f));
+        draw(pContext);
 
         // Ignore D2DERR_RECREATE_TARGET here. This error indicates that the device
         // is lost. It will be handled during the next call to Present.
@@ -56,11 +172,306 @@ namespace winrt::D3D11On12WinUI
         }
 
         pContext->RestoreDrawingState(m_pD2D1StateBlock.get());
+        m_overlay.EndRasterize();
+    }
+
+    // The text is laid out here (the layout cache is the render thread's), and its lines are
+    // split between the threads, each of which records its share into a command list with its
+    // own context.
+    void SampleTextRenderer::RecordOverlay(std::wstring_view text)
+    {
+        struct Line final
+        {
+            winrt::com_ptr<IDWriteTextLayout> pDWriteTextLayout;
+            float top{ 0.f };
+        };
+        std::vector<Line> lines;
+        DrawLines(text, [&](IDWriteTextLayout* pDWriteTextLayout, float top)
+            {
+                Line& line{ lines.emplace_back() };
+                line.pDWriteTextLayout.copy_from(pDWriteTextLayout);
+                line.top = top;
+            });
+
+        float const dpi{ m_deviceResources.Dpi().x };
+        size_t const partCount{ std::min<size_t>(m_pOverlayRecorder->ThreadCount(), lines.size()) };
+        std::vector<DX::ParallelRecorder<winrt::com_ptr<ID2D1CommandList>>::Part> parts;
+        for (size_t part{ 0 }; part < partCount; ++part)
+        {
+            std::vector<Line> partLines{ lines.begin() + lines.size() * part / partCount, lines.begin() + lines.size() * (part + 1) / partCount };
+            parts.push_back([this, dpi, partLines{ std::move(partLines) }](uint32_t threadIndex)
+                {
+                    ID2D1DeviceContext1* pContext{ m_pD2D1WorkerContexts[threadIndex].get() };
+                    winrt::com_ptr<ID2D1CommandList> pD2D1CommandList;
+                    winrt::check_hresult(pContext->CreateCommandList(pD2D1CommandList.put()));
+                    pContext->SetTarget(pD2D1CommandList.get());
+                    pContext->SetDpi(dpi, dpi);
+                    pContext->BeginDraw();
+                    for (Line const& line : partLines)
+                    {
+                        pContext->DrawTextLayout(D2D1::Point2F(3.f, line.top), line.pDWriteTextLayout.get(), m_pD2D1WorkerBrushes[threadIndex].get());
+                    }
+                    HRESULT const hr{ pContext->EndDraw() };
+                    pContext->SetTarget(nullptr);
+                    winrt::check_hresult(hr);
+                    winrt::check_hresult(pD2D1CommandList->Close());
+                    return pD2D1CommandList;
+                });
+        }
+        m_pOverlayRecorder->Begin(std::move(parts));
+    }
+
+    // The statistics change with every frame, so if the text were made every frame, it would
+    // be drawn differently every frame; and the overlay layer would be rasterized every frame.
+    std::wstring const& SampleTextRenderer::RefreshedText(bool nativeText)
+    {
+        uint64_t const nowNanoseconds{ DX::QpcNowNanoseconds() };
+        if (m_text.empty() || nowNanoseconds - m_textNanoseconds >= s_textRefreshNanoseconds)
+        {
+            m_text = Text(nativeText);
+            m_textNanoseconds = nowNanoseconds;
+        }
+        return m_text;
+    }
+
+    // The text to be displayed: what the sample is running on, and what its optimizations have measured.
+    std::wstring SampleTextRenderer::Text(bool nativeText) const
+    {
+        std::wstring text{ L"Direct3D 11-on-12 and WinUI XAML sample" };
+        text += L"\n" + m_deviceResources.Adapter().description;
+
+        // Report the measured input-to-display latency for the current frame latency settings.
+        DX::FrameLatencySettings const& frameLatency{ m_deviceResources.FrameLatency() };
+        DX::LatencySummary const latency{ m_deviceResources.InputToDisplayLatency() };
+        DX::FramePacer const& framePacer{ m_deviceResources.FramePacing() };
+        wchar_t latencyText[192]{};
+        ::swprintf_s(latencyText, L"\n%u buffers, latency %u%s: input to display p50 %.1f ms, p99 %.1f ms; %llu missed vsyncs",
+            frameLatency.numFramebuffers, frameLatency.maximumFrameLatency, frameLatency.framePacing ? L", paced" : L"",
+            latency.p50Milliseconds, latency.p99Milliseconds, static_cast<unsigned long long>(framePacer.MissedVsyncs()));
+        text += latencyText;
+
+        // And what rendering only on demand (and not while occluded) has saved.
+        DX::RenderLoopStatistics const& renderLoop{ m_deviceResources.RenderLoop() };
+        wchar_t renderLoopText[160]{};
+        ::swprintf_s(renderLoopText, L"\n%llu frames rendered, %llu skipped: saved %.1f s CPU, %.1f s GPU",
+            static_cast<unsigned long long>(renderLoop.FramesRendered()), static_cast<unsigned long long>(renderLoop.FramesSkipped()),
+            renderLoop.CpuNanosecondsSaved() / 1e9, renderLoop.GpuNanosecondsSaved() / 1e9);
+        text += renderLoopText;
+
+        // And how full the shared descriptor heap is.
+        DX::DescriptorAllocator const& descriptors{ m_deviceResources.Descriptors() };
+        DX::DescriptorAllocatorStatistics const& descriptorStatistics{ descriptors.Statistics() };
+        wchar_t descriptorsText[192]{};
+        ::swprintf_s(descriptorsText, L"\nDescriptors: persistent %u of %u (peak %u), transient peak %u of %u; %llu allocated",
+            descriptorStatistics.persistentInUse, descriptors.PersistentCapacity(), descriptorStatistics.persistentPeak,
+            descriptors.TransientPeak(), descriptors.TransientCapacity(),
+            static_cast<unsigned long long>(descriptorStatistics.persistentAllocations + descriptorStatistics.transientDescriptors));
+        text += descriptorsText;
+
+        // And how fast the copy queue has been uploading assets.
+        DX::UploadBatcherStatistics const& uploadStatistics{ m_deviceResources.Uploads().Statistics() };
+        wchar_t uploadsText[160]{};
+        ::swprintf_s(uploadsText, L"\nUploads: %.2f MB in %llu batches (%llu uploads), at least %.0f MB/s; %llu waits for staging",
+            uploadStatistics.bytes / 1e6, static_cast<unsigned long long>(uploadStatistics.batches), static_cast<unsigned long long>(uploadStatistics.uploads),
+            uploadStatistics.MegabytesPerSecond(), static_cast<unsigned long long>(uploadStatistics.stagingWaits));
+        text += uploadsText;
+
+        // And how the placed resources are packed into heaps.
+        DX::HeapAllocatorStatistics const heapStatistics{ m_deviceResources.PlacedResources().Statistics() };
+        wchar_t heapsText[160]{};
+        ::swprintf_s(heapsText, L"\nHeaps: %u placed resources in %u heaps, %.1f of %.1f MB used; fragmentation %.0f%%",
+            heapStatistics.liveAllocations, heapStatistics.blocks, heapStatistics.allocatedBytes / 1e6, heapStatistics.reservedBytes / 1e6,
+            heapStatistics.Fragmentation() * 100.);
+        text += heapsText;
+
+        // And how much of the pipeline setup the on-disk cache answered.
+        DX::PipelineCacheStatistics const pipelineStatistics{ m_deviceResources.Pipelines().Statistics() };
+        static constexpr wchar_t const* s_loadResultNames[]{ L"not loaded", L"loaded", L"missing", L"not an archive", L"older format", L"other device", L"corrupt" };
+        wchar_t pipelinesText[160]{};
+        ::swprintf_s(pipelinesText, L"\nPipeline cache (%s): %.0f%% hits; pipelines %llu hit, %llu missed",
+            s_loadResultNames[static_cast<uint32_t>(pipelineStatistics.loadResult)], pipelineStatistics.HitRate() * 100.,
+            static_cast<unsigned long long>(pipelineStatistics.pipelineHits), static_cast<unsigned long long>(pipelineStatistics.pipelineMisses));
+        text += pipelinesText;
+
+        // And how long pipelines took to compile in the background, and what was drawn meanwhile.
+        DX::PipelineCompilerStatistics const compileStatistics{ m_deviceResources.PipelineCompiles().Statistics() };
+        wchar_t compilesText[192]{};
+        ::swprintf_s(compilesText, L"\nCompiles: %llu done, %u pending; p50 %.1f ms, p99 %.1f ms (ready in p99 %.1f ms); %llu frames on fallback (at most %u)",
+            static_cast<unsigned long long>(compileStatistics.compiled), compileStatistics.pending, compileStatistics.compileP50Milliseconds,
+            compileStatistics.compileP99Milliseconds, compileStatistics.readyP99Milliseconds,
+            static_cast<unsigned long long>(compileStatistics.fallbackFrames), compileStatistics.maxFallbackFrames);
+        text += compilesText;
+
+        // And what bounded the time from setup to the first frame.
+        if (m_startupReport.firstPresentMilliseconds > 0.)
+        {
+            wchar_t startupText[128]{};
+            ::swprintf_s(startupText, L"\nStartup: first present at %.1f ms (%.1f ms of tasks on %u threads); critical path",
+                m_startupReport.firstPresentMilliseconds, m_startupReport.taskMilliseconds, m_startupReport.threadCount);
+            text += startupText;
+            for (DX::StartupStep const& step : m_startupReport.criticalPath)
+            {
+                ::swprintf_s(startupText, L" %s%hs %.1f ms", &step == &m_startupReport.criticalPath.front() ? L"" : L"> ", step.name.c_str(), step.Milliseconds());
+                text += startupText;
+            }
+        }
+
+        // And, when there's more than one cube, what a frame of them costs.
+        if (m_instanceCount > 1)
+        {
+            wchar_t instancesText[128]{};
+            ::swprintf_s(instancesText, L"\n%u cubes (one instanced draw): CPU %.2f ms, GPU %.2f ms per frame",
+                m_instanceCount, renderLoop.AverageCpuFrameNanoseconds() / 1e6, renderLoop.AverageGpuFrameNanoseconds() / 1e6);
+            text += instancesText;
+        }
+
+        // And how much laying out the text the layout cache saved.
+        DX::TextLayoutCacheStatistics const& layoutStatistics{ m_layouts.Statistics() };
+        wchar_t layoutsText[160]{};
+        ::swprintf_s(layoutsText, L"\nText layouts: %zu cached, %.0f%% hits; %llu laid out, %llu evicted, %llu invalidated",
+            m_layouts.Size(), layoutStatistics.HitRate() * 100., static_cast<unsigned long long>(layoutStatistics.misses),
+            static_cast<unsigned long long>(layoutStatistics.evictions), static_cast<unsigned long long>(layoutStatistics.invalidations));
+        text += layoutsText;
+
+        // And, when the text is drawn with Direct3D 12, how well the glyph atlas is working.
+        if (nativeText)
+        {
+            DX::GlyphAtlas const& atlas{ m_glyphs.Batcher().Atlas() };
+            DX::GlyphAtlasStatistics const& atlasStatistics{ atlas.Statistics() };
+            DX::GlyphBatcherStatistics const& batchStatistics{ m_glyphs.Batcher().Statistics() };
+            wchar_t glyphsText[192]{};
+            ::swprintf_s(glyphsText, L"\nGlyphs: %zu in the atlas (%.0f%% full), %.0f%% hits; %llu rasterized, %llu atlas resets; %zu quads in one draw",
+                atlas.GlyphCount(), atlas.Occupancy() * 100.,
+                atlasStatistics.HitRate() * 100.,
+                static_cast<unsigned long long>(batchStatistics.rasterized), static_cast<unsigned long long>(atlasStatistics.resets),
+                m_glyphs.Batcher().Quads().size());
+            text += glyphsText;
+
+            // And, with labels, how many of them fit, and what placing them costs.
+            DX::LabelDeclutterStatistics const& labelStatistics{ m_labelDeclutter.Statistics() };
+            if (labelStatistics.frames > 0)
+            {
+                ::swprintf_s(glyphsText, L"\nLabels: %zu placed of %u on screen (%u cubes); projected %u at a time and decluttered in %.2f ms per frame",
+                    m_labelDeclutter.Placements().size(), m_labelDeclutter.VisibleCount(), m_labelDeclutter.Count(), m_labelDeclutter.SimdWidth(),
+                    m_labelNanoseconds / 1e6 / labelStatistics.frames);
+                text += glyphsText;
+            }
+        }
+
+        // And, when it's drawn with Direct2D, how seldom the overlay layer has to be rasterized,
+        // and what rasterizing it costs the render thread (and, with overlay threads, them).
+        else
+        {
+            DX::OverlayLayerStatistics const& overlayStatistics{ m_overlay.Statistics() };
+            wchar_t overlayText[192]{};
+            ::swprintf_s(overlayText, L"\nOverlay layer: rasterized in %llu of %llu frames (%.1f%%); %llu changes, %llu resizes, %llu invalidations",
+                static_cast<unsigned long long>(overlayStatistics.rasterizations), static_cast<unsigned long long>(overlayStatistics.frames),
+                overlayStatistics.RasterizedFraction() * 100., static_cast<unsigned long long>(overlayStatistics.contentChanges),
+                static_cast<unsigned long long>(overlayStatistics.resizes), static_cast<unsigned long long>(overlayStatistics.invalidations));
+            text += overlayText;
+
+            ::swprintf_s(overlayText, L"\nOverlay 2D: %.2f ms a rasterization on the render thread",
+                m_overlayNanoseconds / 1e6 / std::max<uint64_t>(overlayStatistics.rasterizations, 1));
+            text += overlayText;
+            if (m_pOverlayRecorder)
+            {
+                DX::ParallelRecorderStatistics const& recordStatistics{ m_pOverlayRecorder->Statistics() };
+                double const frames{ static_cast<double>(std::max<uint64_t>(recordStatistics.frames, 1)) };
+                ::swprintf_s(overlayText, L"; recorded in %.2f ms on %u threads, waited for %.2f ms, played back in %.2f ms; render thread %.2f ms a frame",
+                    recordStatistics.recordNanoseconds / 1e6 / frames, m_pOverlayRecorder->ThreadCount(), recordStatistics.waitNanoseconds / 1e6 / frames,
+                    recordStatistics.playbackNanoseconds / 1e6 / frames, renderLoop.AverageCpuFrameNanoseconds() / 1e6);
+                text += overlayText;
+            }
+        }
+        return text;
+    }
+
+    // Update the text to be displayed, and record it into the frame's command list: the glyphs
+    // that aren't in the atlas yet are rasterized and copied into it, and every glyph is drawn
+    // with one instanced draw.
+    void SampleTextRenderer::UpdateAndRender(::ID3D12GraphicsCommandList* pD3D12GraphicsCommandList, DX::D3D12CommandListStates& states)
+    {
+        std::wstring const& text{ RefreshedText(true) };
+        m_glyphs.Begin();
+        DrawLines(text, [&](IDWriteTextLayout* pDWriteTextLayout, float top)
+            {
+                m_glyphs.DrawTextLayout(pDWriteTextLayout, 3.f, top, 0xffffffff); // White.
+            });
+        DrawLabels();
+        m_glyphs.Render(pD3D12GraphicsCommandList, states);
+    }
+
+    void SampleTextRenderer::UpdateLabels(DX::InstanceField const& field, WorldViewProjectionConstantBuffer const& wvpConstantBufferData)
+    {
+        uint64_t const startNanoseconds{ DX::QpcNowNanoseconds() };
+        if (m_labelDeclutter.Count() != field.Count())
+        {
+            // A cube's label is its number, anchored just above it; the more zeros the number
+            // ends in, the sooner it's placed (and the first cube's, first of all).
+            std::vector<DX::LabelCandidate> candidates(field.Count());
+            for (uint32_t index{ 0 }; index < field.Count(); ++index)
+            {
+                DX::LabelCandidate& candidate{ candidates[index] };
+                field.Center(index, candidate.x, candidate.y, candidate.z);
+                candidate.y += field.Scale() / 2;
+                uint32_t digits{ 1 };
+                for (uint32_t number{ index / 10 }; number != 0; number /= 10) ++digits;
+                candidate.width = digits * m_labelDigitAdvance + 2.f * s_labelPadding;
+                candidate.height = m_labelHeight + 2.f * s_labelPadding;
+                for (uint32_t number{ index }; number != 0 && number % 10 == 0; number /= 10) ++candidate.priority;
+                if (index == 0) candidate.priority = 10;
+            }
+            m_labelDeclutter.Labels(candidates);
+        }
+
+        // The rows of projection * view * world, as they're stored; see DX::LabelDeclutter::Update.
+        DirectX::XMFLOAT4X4 clipTransform;
+        DirectX::XMStoreFloat4x4(
+            &clipTransform,
+            DirectX::XMMatrixMultiply(
+                DirectX::XMMatrixMultiply(DirectX::XMLoadFloat4x4(&wvpConstantBufferData.projection), DirectX::XMLoadFloat4x4(&wvpConstantBufferData.view)),
+                DirectX::XMLoadFloat4x4(&wvpConstantBufferData.world)));
+        DirectX::XMFLOAT2 const outputSizeInDIPs{ m_deviceResources.OutputSizeInDIPs() };
+        m_labelDeclutter.Update(clipTransform.m, outputSizeInDIPs.x, outputSizeInDIPs.y);
+        m_labelNanoseconds += DX::QpcNowNanoseconds() - startNanoseconds;
+    }
+
+    // Update the text to be displayed, and, if it (or the layer's size) has changed, render it
+    // with Direct2D into the overlay layer, over transparent black.
+    void SampleTextRenderer::UpdateOverlay()
+    {
+        std::wstring const& text{ RefreshedText(false) };
+        DX::StableHasher hasher;
+        hasher.Add(text.data(), text.length() * sizeof(wchar_t));
+        if (!m_overlay.BeginFrame(hasher.Hash())) return;
+
+        uint64_t const startNanoseconds{ DX::QpcNowNanoseconds() };
+        if (m_pOverlayRecorder)
+        {
+            RecordOverlay(text);
+        }
+        else
+        {
+            RasterizeOverlay([&](ID2D1DeviceContext1* pContext)
+                {
+                    DrawLines(text, [&](IDWriteTextLayout* pDWriteTextLayout, float top)
+                        {
+                            pContext->DrawTextLayout(
+                                D2D1::Point2F(3.f, top),
+                                pDWriteTextLayout,
+                                m_pD2D1WhiteBrush.get()
+                            );
+                        });
+                });
+        }
+        m_overlayNanoseconds += DX::QpcNowNanoseconds() - startNanoseconds;
     }
 
     // Initialize Direct2D resources used for text rendering.
     void SampleTextRenderer::WindowIndependentSetup()
     {
+        DX::TraceSpan const span{ m_deviceResources.Trace(), "SampleTextRenderer::WindowIndependentSetup" };
+
         winrt::check_hresult(
             m_deviceResources.IDWriteFactory2()->CreateTextFormat(
                 L"Segoe UI",
@@ -74,6 +485,8 @@ namespace winrt::D3D11On12WinUI
             )
         );
 
+        LabelFontSetup();
+
         winrt::check_hresult(
             m_deviceResources.ID2D1Factory3()->CreateDrawingStateBlock(m_pD2D1StateBlock.put())
         );
@@ -81,14 +494,39 @@ namespace winrt::D3D11On12WinUI
         winrt::check_hresult(
             m_deviceResources.ID2D1DeviceContext1()->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::White), m_pD2D1WhiteBrush.put())
         );
+
+        // A context (and a brush) for each thread that records the overlay.
+        if (m_overlayThreads > 0)
+        {
+            m_pOverlayRecorder = std::make_unique<DX::ParallelRecorder<winrt::com_ptr<ID2D1CommandList>>>(m_overlayThreads);
+            for (uint32_t thread{ 0 }; thread < m_pOverlayRecorder->ThreadCount(); ++thread)
+            {
+                winrt::check_hresult(
+                    m_deviceResources.ID2D1Device1()->CreateDeviceContext(D2D1_DEVICE_CONTEXT_OPTIONS_NONE, m_pD2D1WorkerContexts.emplace_back().put())
+                );
+                winrt::check_hresult(
+                    m_pD2D1WorkerContexts.back()->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::White), m_pD2D1WorkerBrushes.emplace_back().put())
+                );
+            }
+        }
    }
 
     // Uninitialize Direct2D resources ready for reinitialization.
     void SampleTextRenderer::WindowIndependentReset()
     {
+        DX::TraceSpan const span{ m_deviceResources.Trace(), "SampleTextRenderer::WindowIndependentReset" };
+
+        m_pOverlayRecorder = nullptr; // Waits for what the threads are recording.
+        m_pD2D1WorkerBrushes.clear();
+        m_pD2D1WorkerContexts.clear();
         m_pD2D1WhiteBrush = nullptr;
         m_pD2D1StateBlock = nullptr;
+        m_pDWriteLabelFontFace = nullptr;
         m_pDWriteTextFormat = nullptr;
-        m_pDWriteTextLayout = nullptr;
+        m_labelDeclutter.Labels({}); // They were measured in the font; UpdateLabels makes them again.
+        m_layouts.Clear(); // They were laid out in the text format.
+        m_glyphs.Reset();
+        m_overlay.Reset();
+        m_text.clear();
     }
 }
@@ -13,27 +13,95 @@
 
 namespace winrt::D3D11On12WinUI
 {
-    // Renders a simple string to the screen using Direct2D.
+    // Renders a simple string to the screen, with Direct3D 12 (see D3D12GlyphRenderer), or
+    // with Direct2D through the 11On12 device, into an overlay layer (see D3D12OverlayLayer).
     class SampleTextRenderer final
     {
+        static constexpr float s_labelEmSize{ 12.f }; // In DIPs.
+        static constexpr float s_labelPadding{ 2.f }; // Around a label's digits, in DIPs; so labels that are placed don't quite touch.
+        static constexpr uint64_t s_textRefreshNanoseconds{ 250'000'000 }; // The statistics change every frame; the text, at most this often.
+
         // data members
 
-        DX::DeviceResources const& m_deviceResources;
+        DX::DeviceResources& m_deviceResources;
+        uint32_t m_instanceCount{ 1 };
+        DX::LabelDeclutter m_labelDeclutter; // Of the cubes' labels, when there are any (see UpdateLabels).
+        uint64_t m_labelNanoseconds{ 0 }; // Projecting and decluttering them, over all frames.
+        uint64_t m_overlayNanoseconds{ 0 }; // The render thread's, rasterizing the overlay layer (or dispatching and playing it back).
+        uint32_t m_overlayThreads{ 0 }; // That record the overlay into Direct2D command lists; if 0, the render thread draws it.
+        std::unique_ptr<DX::ParallelRecorder<winrt::com_ptr<ID2D1CommandList>>> m_pOverlayRecorder{ nullptr };
+        DX::StartupReport m_startupReport;
+        std::wstring m_text;
+        uint64_t m_textNanoseconds{ 0 }; // When m_text was last refreshed.
 
         // DirectWrite and Direct2D data members
 
+        DX::D3D12GlyphRenderer m_glyphs;
+        float m_labelAscent{ 0.f }; // In DIPs, as is the advance.
+        float m_labelDigitAdvance{ 0.f }; // The widest digit's; the labels are drawn with each digit in a cell this wide.
+        std::array<uint16_t, 10> m_labelDigitGlyphs{}; // In the labels' font face.
+        float m_labelHeight{ 0.f };
+        DX::TextLayoutCache<winrt::com_ptr<IDWriteTextLayout>> m_layouts; // One per line of text.
+        DX::D3D12OverlayLayer m_overlay; // What Direct2D draws into, when the text is drawn with it.
         winrt::com_ptr<ID2D1DrawingStateBlock> m_pD2D1StateBlock{ nullptr };
         winrt::com_ptr<ID2D1SolidColorBrush> m_pD2D1WhiteBrush{ nullptr };
+        std::vector<winrt::com_ptr<ID2D1SolidColorBrush>> m_pD2D1WorkerBrushes; // One per recording thread, as are the contexts.
+        std::vector<winrt::com_ptr<ID2D1DeviceContext1>> m_pD2D1WorkerContexts;
+        winrt::com_ptr<IDWriteFontFace> m_pDWriteLabelFontFace{ nullptr }; // The text format's font.
         winrt::com_ptr<IDWriteTextFormat> m_pDWriteTextFormat{ nullptr };
-        winrt::com_ptr<IDWriteTextLayout> m_pDWriteTextLayout{ nullptr };
+
+        // member functions
+
+        // Calls draw(pDWriteTextLayout, top) for each line of `text`, from the top down.
+        template <typename Draw>
+        void DrawLines(std::wstring_view text, Draw&& draw);
+        void DrawLabels();
+        void LabelFontSetup();
+        void PlayBackOverlay();
+
+        // Calls draw(pD2D1DeviceContext1) to draw into the overlay layer, cleared to transparent black.
+        template <typename Draw>
+        void RasterizeOverlay(Draw&& draw);
+        void RecordOverlay(std::wstring_view text);
+        std::wstring Text(bool nativeText) const;
+        std::wstring const& RefreshedText(bool nativeText);
 
     public:
-        SampleTextRenderer(DX::DeviceResources const& deviceResources);
+        SampleTextRenderer(DX::DeviceResources& deviceResources);
 
         // member functions
 
-        void UpdateAndRender();
+        // Composites the overlay layer (that UpdateOverlay drew, or is having recorded) into a
+        // command list whose render target is the back buffer.
+        void CompositeOverlay(::ID3D12GraphicsCommandList* pD3D12GraphicsCommandList);
+        void PipelineSetup(DX::ShaderBlob const& glyphVS, DX::ShaderBlob const& glyphPS, DX::ShaderBlob const& overlayVS, DX::ShaderBlob const& overlayPS);
+
+        // Draws with Direct3D 12, into a command list whose render target is the back buffer.
+        void UpdateAndRender(::ID3D12GraphicsCommandList* pD3D12GraphicsCommandList, DX::D3D12CommandListStates& states);
+
+        // Draws with Direct2D into the overlay layer, if the text has changed since it last did;
+        // before the frame's command list is submitted. With overlay threads, it starts them
+        // recording the text, and CompositeOverlay plays back what they recorded.
+        void UpdateOverlay();
+
+        // Places the cubes' labels for this frame (before UpdateAndRender, which draws them with
+        // the text): projects each cube's label to the screen, and keeps those that don't overlap
+        // a label of higher priority. The field's labels are made again when its count changes.
+        void UpdateLabels(DX::InstanceField const& field, WorldViewProjectionConstantBuffer const& wvpConstantBufferData);
         void WindowIndependentSetup();
         void WindowIndependentReset();
+
+        // accessors
+
+        // This frame's overlay layer (after UpdateOverlay), for the frame graph.
+        ::ID3D12Resource* OverlayLayer() const { return m_overlay.Layer(); }
+
+        // mutators
+
+        void InstanceCount(uint32_t instanceCount) { m_instanceCount = instanceCount; }
+
+        // Call before WindowIndependentSetup (and make Direct2D multithreaded; see DeviceResources).
+        void OverlayThreads(uint32_t overlayThreads) { m_overlayThreads = overlayThreads; }
+        void Startup(DX::StartupReport const& startupReport) { m_startupReport = startupReport; }
     };
 }
@@ -14,7 +14,8 @@
 namespace winrt::D3D11On12WinUI
 {
     // Represents a vertex containing position, normal, and color vectors.
-    // Used to send per-vertex data to the vertex shader.
+    // Used to send per-vertex data to the vertex shader. The input layout also describes the
+    // per-instance stream (DX::InstanceData, in input slot 1) that the cube is drawn with.
     struct VertexPositionNormalColor final
     {
         VertexPositionNormalColor(DX::Vector3 const& position,
@@ -35,7 +36,7 @@ namespace winrt::D3D11On12WinUI
         }
 
     private:
-        static const std::array<D3D12_INPUT_ELEMENT_DESC, 3> s_d3d12VertexDesc;
+        static const std::array<D3D12_INPUT_ELEMENT_DESC, 7> s_d3d12VertexDesc;
     };
 
     // Constant buffer used to send world-view-projection matrices to the vertex shader.
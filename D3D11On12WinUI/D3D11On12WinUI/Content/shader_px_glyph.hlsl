@@ -0,0 +1,31 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// For asm, compile with fxc.exe <this_filename>.hlsl /E main /T ps_4_1 /Fc
+
+// The glyph atlas holds each glyph's coverage. Quads are drawn a pixel of the atlas to a pixel
+// of the render target, so the sampler is point-sampling.
+Texture2D<float> Atlas : register(t0);
+SamplerState AtlasSampler : register(s0);
+
+struct PixelShaderInput
+{
+	float4 Position : SV_POSITION;
+	float2 TexCoord : TEXCOORD;
+	float4 Color : COLOR;
+};
+
+// Premultiplied, for the pipeline's ONE, INV_SRC_ALPHA blend.
+float4 main(PixelShaderInput input) : SV_TARGET
+{
+	float coverage = Atlas.Sample(AtlasSampler, input.TexCoord);
+	return float4(input.Color.rgb * input.Color.a, input.Color.a) * coverage;
+}
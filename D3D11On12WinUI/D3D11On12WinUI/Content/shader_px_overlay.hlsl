@@ -0,0 +1,22 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// For asm, compile with fxc.exe <this_filename>.hlsl /E main /T ps_4_1 /Fc
+
+// The overlay layer is the render target's size, so each pixel loads its own texel: no
+// sampler, and no texture coordinates.
+Texture2D<float4> Layer : register(t0);
+
+// Premultiplied (as Direct2D draws), for the pipeline's ONE, INV_SRC_ALPHA blend.
+float4 main(float4 position : SV_POSITION) : SV_TARGET
+{
+	return Layer.Load(int3(position.xy, 0));
+}
@@ -0,0 +1,28 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// For asm, compile with fxc.exe <this_filename>.hlsl /E main /T ps_4_1 /Fc
+
+// The fallback that the cube is drawn with while the Phong pipeline compiles: the vertex
+// color, unlit. It's small enough that its pipeline compiles quickly at setup.
+struct PixelShaderInput
+{
+	float4 Position : SV_POSITION;
+	float3 WorldNormal : NORMAL0;
+	float3 ViewNormal : NORMAL1;
+	float3 Color : COLOR;
+};
+
+float4 main(PixelShaderInput input) : SV_TARGET
+{
+	float3 color = input.Color.rgb * input.Color.rgb;
+	return float4(color * .8f, 1.f);
+}
@@ -0,0 +1,47 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Draws each glyph (an instance) as a quad, a triangle strip of four vertices with no vertex
+// buffer: see D3D12GlyphRenderer.
+cbuffer GlyphConstants : register(b0)
+{
+	float2 InverseTargetSize; // 1 / the render target's size in pixels.
+};
+
+// Per-instance data (DX::GlyphQuad): the quad in pixels from the top left of the render target,
+// its texture coordinates in the atlas, and its color.
+struct GlyphShaderInput
+{
+	float4 Rect : GLYPHRECT;
+	float4 TexRect : GLYPHTEXRECT;
+	float4 Color : GLYPHCOLOR;
+};
+
+struct VertexShaderOutput
+{
+	float4 Position : SV_POSITION;
+	float2 TexCoord : TEXCOORD;
+	float4 Color : COLOR;
+};
+
+VertexShaderOutput main(uint vertexId : SV_VertexID, GlyphShaderInput glyph)
+{
+	VertexShaderOutput output;
+	float2 corner = float2(vertexId & 1, vertexId >> 1);
+
+	// From pixels to clip space, in which y is up.
+	float2 pixel = glyph.Rect.xy + corner * glyph.Rect.zw;
+	output.Position = float4(pixel * InverseTargetSize * float2(2, -2) + float2(-1, 1), 0, 1);
+	output.TexCoord = lerp(glyph.TexRect.xy, glyph.TexRect.zw, corner);
+	output.Color = glyph.Color;
+
+	return output;
+}
@@ -0,0 +1,18 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Draws the overlay layer over the whole render target, as a triangle strip of four vertices
+// with no vertex buffer: see D3D12OverlayLayer.
+float4 main(uint vertexId : SV_VertexID) : SV_POSITION
+{
+	float2 corner = float2(vertexId & 1, vertexId >> 1);
+	return float4(corner * float2(2, -2) + float2(-1, 1), 0, 1);
+}
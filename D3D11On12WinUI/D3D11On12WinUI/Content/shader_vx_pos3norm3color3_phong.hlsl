@@ -24,6 +24,16 @@ struct VertexShaderInput
 	float3 Color : COLOR;
 };
 
+// Per-instance data (DX::InstanceData): the first three rows of the instance's world matrix,
+// in column-vector form, and a color that multiplies the vertex color.
+struct InstanceShaderInput
+{
+	float4 World0 : INSTANCEWORLD0;
+	float4 World1 : INSTANCEWORLD1;
+	float4 World2 : INSTANCEWORLD2;
+	float4 Color : INSTANCECOLOR;
+};
+
 // Per-pixel color data passed through the pixel shader.
 struct VertexShaderOutput
 {
@@ -33,18 +43,22 @@ struct VertexShaderOutput
 	float3 Color : COLOR;
 };
 
-VertexShaderOutput main(VertexShaderInput input)
+VertexShaderOutput main(VertexShaderInput input, InstanceShaderInput instance)
 {
 	VertexShaderOutput output;
 	float4 position = { input.Position, 1 };
 
+	// Place the vertex in the scene with the instance's transform...
+	position = float4(dot(position, instance.World0), dot(position, instance.World1), dot(position, instance.World2), 1);
+
 	// Transform the vertex position into projected space.
 	position = mul(position, World);
 	position = mul(position, View);
 	position = mul(position, Projection);
 	output.Position = position;
 
-	float3 normal = input.Normal;
+	// ...and its normal (the instance's scale is uniform, and the pixel shader normalizes).
+	float3 normal = float3(dot(input.Normal, instance.World0.xyz), dot(input.Normal, instance.World1.xyz), dot(input.Normal, instance.World2.xyz));
 
 	// Transform the vertex normal into world space...
 	normal = mul(normal, (float3x3)World);
@@ -53,8 +67,8 @@ VertexShaderOutput main(VertexShaderInput input)
 	normal = mul(normal, (float3x3)View);
 	output.ViewNormal = normal;
 
-	// Pass the color through without modification.
-	output.Color = input.Color;
+	// Tint the color with the instance's.
+	output.Color = input.Color * instance.Color.rgb;
 
 	return output;
 }
@@ -34,9 +34,24 @@ namespace winrt::D3D11On12WinUI::implementation
         ::SetWindowTextW(m_hWnd, L"D3D11On12WinUI");
 
         m_sample3DSceneRenderer.SetWindowAndSwapChainPanel(*this, m_hWnd, swapChainPanel());
+        // Each deployment can trade latency for throughput with `--buffers N` (2 to 4) and `--latency N`.
+        m_sample3DSceneRenderer.FrameLatency(DX::FrameLatencySettings::Parse(::GetCommandLineW()));
+        // And pick the GPU with `--adapter high-performance` (the default), `low-power`, `first`, `warp`, or an adapter LUID.
+        m_sample3DSceneRenderer.AdapterSelection(DX::AdapterPolicy::Parse(::GetCommandLineW()));
+        // Frames are rendered only when something changes, unless `--continuous` asks for one every vblank.
+        m_sample3DSceneRenderer.RenderOnDemand(std::wstring_view{ ::GetCommandLineW() }.find(L"--continuous") == std::wstring_view::npos);
+        // `--instances N` draws a grid of N cubes, in one instanced draw, to measure how that scales.
+        m_sample3DSceneRenderer.InstanceCount(DX::UnsignedOption(::GetCommandLineW(), L"--instances").value_or(1));
+        // The overlay's text is drawn with Direct2D through 11On12, unless `--native-text` asks for Direct3D 12, in the frame's command list.
+        m_sample3DSceneRenderer.NativeText(std::wstring_view{ ::GetCommandLineW() }.find(L"--native-text") != std::wstring_view::npos);
+        // Without it, `--d2d-threads N` records the overlay into Direct2D command lists on N threads, while the scene is recorded.
+        m_sample3DSceneRenderer.OverlayThreads(DX::UnsignedOption(::GetCommandLineW(), L"--d2d-threads").value_or(0));
+        // With it, `--labels` labels the cubes with their numbers, as many as fit on the screen without overlapping.
+        m_sample3DSceneRenderer.Labels(std::wstring_view{ ::GetCommandLineW() }.find(L"--labels") != std::wstring_view::npos);
         m_sample3DSceneRenderer.StartRenderLoop();
 
         SizeChanged({ this, &MainWindow::OnSizeChanged });
+        VisibilityChanged({ this, &MainWindow::OnVisibilityChanged });
     }
 
     void MainWindow::OnAnimateButtonClick(winrt::IInspectable const& /* sender */, winrt::RoutedEventArgs const& /* args */)
@@ -51,6 +66,32 @@ namespace winrt::D3D11On12WinUI::implementation
         m_sample3DSceneRenderer.OnDpiChanged(Bounds());
     }
 
+    // Dragging orbits the camera around the cube.
+    void MainWindow::OnPointerMoved(winrt::IInspectable const& sender, winrt::PointerRoutedEventArgs const& args)
+    {
+        if (!m_orbiting) return;
+
+        float const radiansPerDip{ .01f };
+        winrt::Point const position{ args.GetCurrentPoint(sender.as<winrt::UIElement>()).Position() };
+        m_sample3DSceneRenderer.OrbitCamera(
+            (m_lastPointerPosition.X - position.X) * radiansPerDip,
+            (m_lastPointerPosition.Y - position.Y) * radiansPerDip);
+        m_lastPointerPosition = position;
+    }
+
+    void MainWindow::OnPointerPressed(winrt::IInspectable const& sender, winrt::PointerRoutedEventArgs const& args)
+    {
+        auto element{ sender.as<winrt::UIElement>() };
+        m_orbiting = element.CapturePointer(args.Pointer());
+        m_lastPointerPosition = args.GetCurrentPoint(element).Position();
+    }
+
+    void MainWindow::OnPointerReleased(winrt::IInspectable const& sender, winrt::PointerRoutedEventArgs const& args)
+    {
+        m_orbiting = false;
+        sender.as<winrt::UIElement>().ReleasePointerCapture(args.Pointer());
+    }
+
     void MainWindow::OnSizeChanged(winrt::IInspectable const& /*sender*/, winrt::WindowSizeChangedEventArgs const& /* args */)
     {
         m_sample3DSceneRenderer.OnSizeChanged(Bounds());
@@ -62,6 +103,11 @@ namespace winrt::D3D11On12WinUI::implementation
         xamlRoot.Changed({ this, &MainWindow::OnXamlRootChanged });
     }
 
+    void MainWindow::OnVisibilityChanged(winrt::IInspectable const& /* sender */, winrt::WindowVisibilityChangedEventArgs const& args)
+    {
+        m_sample3DSceneRenderer.OnVisibilityChanged(args.Visible());
+    }
+
     void MainWindow::OnXamlRootChanged(winrt::XamlRoot const& /* sender */, winrt::XamlRootChangedEventArgs const& /* args */)
     {
         OnDpiChanged();
@@ -24,12 +24,18 @@ namespace winrt::D3D11On12WinUI::implementation
 
         void OnAnimateButtonClick(winrt::IInspectable const& sender, winrt::RoutedEventArgs const& args);
         void OnDpiChanged();
+        void OnPointerMoved(winrt::IInspectable const& sender, winrt::PointerRoutedEventArgs const& args);
+        void OnPointerPressed(winrt::IInspectable const& sender, winrt::PointerRoutedEventArgs const& args);
+        void OnPointerReleased(winrt::IInspectable const& sender, winrt::PointerRoutedEventArgs const& args);
         void OnSizeChanged(winrt::IInspectable const& sender, winrt::WindowSizeChangedEventArgs const& args);
         void OnSwapChainPanelLoaded(winrt::IInspectable const& sender, winrt::RoutedEventArgs const& args);
+        void OnVisibilityChanged(winrt::IInspectable const& sender, winrt::WindowVisibilityChangedEventArgs const& args);
         void OnXamlRootChanged(winrt::XamlRoot const& sender, winrt::XamlRootChangedEventArgs const& args);
 
     private:
         HWND m_hWnd{ 0 };
+        winrt::Point m_lastPointerPosition{ 0.f, 0.f };
+        bool m_orbiting{ false };
         Sample3DSceneRenderer m_sample3DSceneRenderer;
     };
 }
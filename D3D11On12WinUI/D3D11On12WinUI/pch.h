@@ -18,7 +18,7 @@
 #include <d3d11_2.h>
 #include <d3d11on12.h>
 #include <dwrite_2.h>
-#include <dxgi1_4.h>
+#include <dxgi1_6.h>
 #include <microsoft.ui.xaml.media.dxinterop.h>
 #include <microsoft.ui.xaml.window.h>
 #include <pix.h>
@@ -34,17 +34,20 @@
 #include <winrt/Windows.Foundation.h>
 #include <winrt/Windows.Foundation.Collections.h>
 #include <winrt/Windows.Graphics.Display.h>
+#include <winrt/Windows.Storage.h>
 #include <winrt/Windows.Storage.Streams.h>
 #include <winrt/Windows.System.Threading.h>
 #include <winrt/Microsoft.UI.Xaml.h>
 #include <winrt/Microsoft.UI.Xaml.Controls.h>
 #include <winrt/Microsoft.UI.Xaml.Controls.Primitives.h>
+#include <winrt/Microsoft.UI.Xaml.Input.h>
 #include <winrt/Microsoft.UI.Xaml.Markup.h>
 
 namespace winrt
 {
 	using namespace winrt::Microsoft::UI::Xaml;
 	using namespace winrt::Microsoft::UI::Xaml::Controls;
+	using namespace winrt::Microsoft::UI::Xaml::Input;
 	using namespace winrt::Windows::ApplicationModel;
 	using namespace winrt::Windows::Foundation;
 	using namespace winrt::Windows::Storage;
@@ -55,8 +58,50 @@ namespace winrt
 #include "..\Common\d3dx12.h"
 #include "..\Common\DirectXHelper.h"
 #include "..\Common\StepTimer.h"
+#include "..\Common\RenderDevice.h"
+#include "..\Common\CommandLine.h"
+#include "..\Common\AdapterSelection.h"
+#include "..\Common\FrameLatency.h"
+#include "..\Common\FrameSynchronizer.h"
+#include "..\Common\FramePacer.h"
+#include "..\Common\RenderLoopStatistics.h"
+#include "..\Common\DeferredReleaseQueue.h"
+#include "..\Common\UploadRing.h"
+#include "..\Common\DescriptorAllocator.h"
+#include "..\Common\UploadBatcher.h"
+#include "..\Common\HeapAllocator.h"
+#include "..\Common\StableHasher.h"
+#include "..\Common\PipelineCache.h"
+#include "..\Common\PipelineCompiler.h"
+#include "..\Common\MappedFile.h"
+#include "..\Common\ShaderArchive.h"
+#include "..\Common\SpscRing.h"
+#include "..\Common\RenderCommandChannel.h"
+#include "..\Common\WorkerPool.h"
+#include "..\Common\StartupGraph.h"
+#include "..\Common\TraceRecorder.h"
+#include "..\Common\ResourceStateTracker.h"
+#include "..\Common\FrameGraph.h"
+#include "..\Common\TextLayoutCache.h"
+#include "..\Common\GlyphAtlas.h"
+#include "..\Common\GlyphBatcher.h"
+#include "..\Common\OverlayLayer.h"
+#include "..\Common\ParallelRecorder.h"
+#include "..\Common\LabelDeclutter.h"
+#include "..\Common\InstanceTransforms.h"
+#include "..\Common\D3D12RenderDevice.h"
+#include "..\Common\D3D12Adapters.h"
+#include "..\Common\D3D12PipelineCache.h"
+#include "..\Common\D3D12ResourceStateTracker.h"
+#include "..\Common\GpuFrameTimer.h"
+#include "..\Common\CopyUploadQueue.h"
+#include "..\Common\PlacedResourceAllocator.h"
+#include "..\Common\D3D12FrameGraph.h"
+#include "..\Common\D3D12GlyphRenderer.h"
+#include "..\Common\D3D12OverlayLayer.h"
 #include "..\Common\DeviceResources.h"
 #include "..\Content\ShaderStructures.h"
+#include "..\Content\CubeGeometry.h"
 #include "..\Content\Cube.h"
 #include "..\Content\SampleTextRenderer.h"
 #include "..\Content\Sample3DSceneRenderer.h"
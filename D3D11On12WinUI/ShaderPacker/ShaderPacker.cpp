@@ -0,0 +1,150 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Packs compiled shaders (.cso files) into one archive (see ShaderArchive.h) that the app
+// memory-maps at startup, and lists and verifies an archive. It runs wherever the build does.
+//
+// Build (any platform with a C++17 compiler), for example:
+//     g++ -std=c++17 -O2 ShaderPacker.cpp -o ShaderPacker
+//     cl /std:c++17 /O2 /EHsc ShaderPacker.cpp
+//
+// Usage:
+//     ShaderPacker out.shar (file.cso | directory)...
+//     ShaderPacker --list archive.shar
+//
+// Each shader is named by its file name without the extension (shader_vx_pos3norm3color3_phong,
+// say). A directory adds every .cso file in it. --list prints each shader's name and size, and
+// fails if the archive, or any shader in it, is damaged.
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../D3D11On12WinUI/Common/MappedFile.h"
+#include "../D3D11On12WinUI/Common/ShaderArchive.h"
+
+namespace
+{
+    bool ReadFile(std::filesystem::path const& path, std::vector<uint8_t>& bytes)
+    {
+        std::ifstream file{ path, std::ios::binary };
+        if (!file) return false;
+        bytes.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+        return !file.bad();
+    }
+
+    int List(std::filesystem::path const& archivePath)
+    {
+        DX::MappedFile file;
+        if (!file.Open(archivePath))
+        {
+            std::fprintf(stderr, "Couldn't open %s\n", archivePath.string().c_str());
+            return 1;
+        }
+        DX::ShaderArchiveReader archive;
+        DX::ShaderArchiveOpenResult const result{ archive.Open(file.Data(), file.Size()) };
+        if (result != DX::ShaderArchiveOpenResult::Opened)
+        {
+            static char const* const s_resultNames[]{ "opened", "not an archive", "an older format", "corrupt" };
+            std::fprintf(stderr, "%s is %s\n", archivePath.string().c_str(), s_resultNames[static_cast<uint32_t>(result)]);
+            return 1;
+        }
+
+        uint32_t damaged{ 0 };
+        for (uint32_t entry{ 0 }; entry < archive.EntryCount(); ++entry)
+        {
+            std::string_view const name{ archive.Name(entry) };
+            DX::ShaderBlob const blob{ archive.Find(name) };
+            if (!blob) ++damaged;
+            std::printf("%8zu  %.*s%s\n", blob.sizeInBytes, static_cast<int>(name.size()), name.data(), blob ? "" : "  DAMAGED");
+        }
+        std::printf("%u shaders, %zu bytes\n", archive.EntryCount(), file.Size());
+        return damaged == 0 ? 0 : 1;
+    }
+
+    int Pack(std::filesystem::path const& archivePath, std::vector<std::filesystem::path> const& inputs)
+    {
+        // Directories are expanded in name order, so that the same inputs make the same archive.
+        std::vector<std::filesystem::path> shaderPaths;
+        for (std::filesystem::path const& input : inputs)
+        {
+            std::error_code error;
+            if (!std::filesystem::is_directory(input, error))
+            {
+                shaderPaths.push_back(input);
+                continue;
+            }
+            std::vector<std::filesystem::path> directoryShaders;
+            for (auto const& directoryEntry : std::filesystem::directory_iterator{ input, error })
+            {
+                if (directoryEntry.is_regular_file() && directoryEntry.path().extension() == ".cso") directoryShaders.push_back(directoryEntry.path());
+            }
+            std::sort(directoryShaders.begin(), directoryShaders.end());
+            shaderPaths.insert(shaderPaths.end(), directoryShaders.begin(), directoryShaders.end());
+        }
+
+        DX::ShaderArchiveWriter writer;
+        std::vector<uint8_t> bytes;
+        for (std::filesystem::path const& shaderPath : shaderPaths)
+        {
+            if (!ReadFile(shaderPath, bytes))
+            {
+                std::fprintf(stderr, "Couldn't read %s\n", shaderPath.string().c_str());
+                return 1;
+            }
+            std::string const name{ shaderPath.stem().string() };
+            if (!writer.Add(name, bytes.data(), bytes.size()))
+            {
+                std::fprintf(stderr, "%s: there's already a shader named %s\n", shaderPath.string().c_str(), name.c_str());
+                return 1;
+            }
+        }
+
+        auto const [archive, bytesShared] { writer.Serialize() };
+        std::filesystem::path temporaryPath{ archivePath };
+        temporaryPath += ".tmp";
+        {
+            std::ofstream file{ temporaryPath, std::ios::binary | std::ios::trunc };
+            if (!file.write(reinterpret_cast<char const*>(archive.data()), static_cast<std::streamsize>(archive.size())))
+            {
+                std::fprintf(stderr, "Couldn't write %s\n", temporaryPath.string().c_str());
+                return 1;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(temporaryPath, archivePath, error);
+        if (error)
+        {
+            std::fprintf(stderr, "Couldn't replace %s: %s\n", archivePath.string().c_str(), error.message().c_str());
+            return 1;
+        }
+        std::printf("%s: %zu shaders, %zu bytes (%llu bytes of identical shaders stored once)\n",
+            archivePath.string().c_str(), writer.ShaderCount(), archive.size(), static_cast<unsigned long long>(bytesShared));
+        return 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string const first{ argc > 1 ? argv[1] : "" };
+    if (first == "--list" && argc == 3) return List(argv[2]);
+    if (argc >= 3 && first.rfind("--", 0) != 0)
+    {
+        return Pack(argv[1], std::vector<std::filesystem::path>(argv + 2, argv + argc));
+    }
+
+    std::fprintf(stderr, "Usage: ShaderPacker out.shar (file.cso | directory)...\n"
+        "       ShaderPacker --list archive.shar\n");
+    return 1;
+}